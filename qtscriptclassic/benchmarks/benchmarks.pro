@@ -0,0 +1,9 @@
+include(../src/qtscriptclassic.pri)
+# Note: The above line replaces the ordinary 'QT += script'
+
+TARGET = tst_qscriptclassic
+CONFIG += qtestlib
+CONFIG -= app_bundle
+
+RESOURCES += benchmarks.qrc
+SOURCES += tst_qscriptclassic.cpp
@@ -0,0 +1,22 @@
+// Sorts arrays of numbers and of strings, with the default comparison
+// and with a comparison function.
+
+var numbers = [];
+var strings = [];
+var seed = 42;
+for (var i = 0; i < 2000; ++i) {
+    seed = (seed * 16807) % 2147483647;
+    numbers.push(seed % 100000);
+    strings.push("item" + (seed % 5000));
+}
+
+function run()
+{
+    var a = numbers.slice();
+    a.sort(function(x, y) { return x - y; });
+    var b = strings.slice();
+    b.sort();
+    var c = numbers.slice();
+    c.sort(function(x, y) { return y - x; });
+    return a[0] + b.length + c[0];
+}
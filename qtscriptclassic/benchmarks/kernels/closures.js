@@ -0,0 +1,41 @@
+// Creates closures and calls them through captured variables, in the
+// style of callbacks and iterators.
+
+function makeCounter(start)
+{
+    var count = start;
+    return {
+        next: function() { return ++count; },
+        value: function() { return count; }
+    };
+}
+
+function makeAdder(n)
+{
+    return function(x) { return x + n; };
+}
+
+function map(array, fun)
+{
+    var result = [];
+    for (var i = 0; i < array.length; ++i)
+        result.push(fun(array[i]));
+    return result;
+}
+
+function run()
+{
+    var total = 0;
+    for (var i = 0; i < 500; ++i) {
+        var counter = makeCounter(i);
+        counter.next();
+        counter.next();
+        total += counter.value();
+    }
+    var input = [];
+    for (var j = 0; j < 200; ++j)
+        input.push(j);
+    for (var k = 0; k < 20; ++k)
+        total += map(input, makeAdder(k))[199];
+    return total;
+}
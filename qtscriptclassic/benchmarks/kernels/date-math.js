@@ -0,0 +1,19 @@
+// Date arithmetic and formatting, as done by calendar code.
+
+function run()
+{
+    var date = new Date(2009, 0, 1, 12, 0, 0);
+    var day = 24 * 60 * 60 * 1000;
+    var weekdays = 0;
+    var text = "";
+    for (var i = 0; i < 1000; ++i) {
+        var d = new Date(date.getTime() + i * day);
+        var wd = d.getDay();
+        if ((wd != 0) && (wd != 6))
+            ++weekdays;
+        if (d.getDate() == 1)
+            text += d.getFullYear() + "-" + (d.getMonth() + 1) + ";";
+        d.setHours(d.getHours() + 36);
+    }
+    return weekdays + text.length;
+}
@@ -0,0 +1,38 @@
+// Recursive and non-recursive calls of script functions, with and
+// without arguments and a this object.
+
+function fib(n)
+{
+    if (n < 2)
+        return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+function Point(x, y)
+{
+    this.x = x;
+    this.y = y;
+}
+
+Point.prototype.add = function(other)
+{
+    return new Point(this.x + other.x, this.y + other.y);
+};
+
+function ackermann(m, n)
+{
+    if (m == 0)
+        return n + 1;
+    if (n == 0)
+        return ackermann(m - 1, 1);
+    return ackermann(m - 1, ackermann(m, n - 1));
+}
+
+function run()
+{
+    var p = new Point(0, 0);
+    var step = new Point(1, 2);
+    for (var i = 0; i < 1000; ++i)
+        p = p.add(step);
+    return fib(20) + ackermann(2, 3) + p.y;
+}
@@ -0,0 +1,21 @@
+// Allocates many short-lived objects and arrays, and a few that stay
+// alive, so that the collector runs repeatedly.
+
+var survivors = [];
+
+function run()
+{
+    var tree = null;
+    for (var i = 0; i < 20000; ++i) {
+        var node = { value: i, left: tree, right: null, tag: [i, i + 1] };
+        if (i % 100 == 0)
+            tree = node;
+    }
+    survivors.push(tree);
+    if (survivors.length > 50)
+        survivors = [];
+    var depth = 0;
+    for (var n = tree; n; n = n.left)
+        ++depth;
+    return depth;
+}
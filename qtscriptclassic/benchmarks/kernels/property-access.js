@@ -0,0 +1,31 @@
+// Reads and writes properties of objects of the same layout, of
+// objects with a prototype chain, and of arrays.
+
+function Vector(x, y, z)
+{
+    this.x = x;
+    this.y = y;
+    this.z = z;
+}
+
+Vector.prototype.scale = 2;
+
+function run()
+{
+    var vectors = [];
+    for (var i = 0; i < 100; ++i)
+        vectors.push(new Vector(i, i + 1, i + 2));
+
+    var sum = 0;
+    for (var k = 0; k < 50; ++k) {
+        for (var j = 0; j < vectors.length; ++j) {
+            var v = vectors[j];
+            v.x = v.y + v.z;
+            sum += v.x * v.scale;
+        }
+    }
+    var o = {};
+    for (var m = 0; m < 200; ++m)
+        o["key" + (m % 20)] = m;
+    return sum + o.key3;
+}
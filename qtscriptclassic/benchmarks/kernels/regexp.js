@@ -0,0 +1,28 @@
+// Matches, searches and replaces with regular expressions over text
+// like that of log files and markup.
+
+var lines = [];
+for (var i = 0; i < 200; ++i) {
+    lines.push("2009-11-" + (10 + i % 20) + " 12:" + (10 + i % 50)
+               + " [info] request /path/" + i + "/index.html took " + (i * 7) + "ms");
+}
+var text = lines.join("\n");
+var markup = "";
+for (var j = 0; j < 100; ++j)
+    markup += "<p class=\"c" + j + "\">Paragraph <b>" + j + "</b></p>";
+
+function run()
+{
+    var total = 0;
+    var re = /\[(\w+)\] request (\S+) took (\d+)ms/;
+    for (var i = 0; i < lines.length; ++i) {
+        var m = re.exec(lines[i]);
+        if (m)
+            total += parseInt(m[3]);
+    }
+    total += text.match(/index\.html/g).length;
+    total += markup.replace(/<[^>]+>/g, "").length;
+    total += text.split(/\n/).length;
+    total += text.search(/request \/path\/199\//);
+    return total;
+}
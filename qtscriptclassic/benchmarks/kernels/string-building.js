@@ -0,0 +1,28 @@
+// Builds strings piece by piece with +, +=, join() and the String
+// methods used for formatting.
+
+function pad(n, width)
+{
+    var s = "" + n;
+    while (s.length < width)
+        s = "0" + s;
+    return s;
+}
+
+function run()
+{
+    var s = "";
+    for (var i = 0; i < 2000; ++i)
+        s += pad(i, 5) + ",";
+
+    var parts = [];
+    for (var j = 0; j < 1000; ++j)
+        parts.push("<td>" + String(j).toUpperCase() + "</td>");
+    var row = parts.join("");
+
+    var words = s.substring(0, 500).split(",");
+    var t = "";
+    for (var k = 0; k < words.length; ++k)
+        t = t + words[k].charAt(0) + words[k].slice(1).toLowerCase();
+    return s.length + row.length + t.length + s.indexOf("01999");
+}
@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtScript>
+
+QT_BEGIN_NAMESPACE
+// in qscriptenginesnapshot.cpp
+Q_SCRIPT_EXPORT void qt_scriptCreateEnginesFromSnapshot(QScriptEngine *engine, int count,
+                                                        QList<QScriptEngine*> *engines);
+QT_END_NAMESPACE
+
+//
+// Benchmarks for the script engine. Each kernel in kernels/ defines a
+// function run() that is called repeatedly; the other benchmarks
+// measure the cost of creating an engine, with its globals set up by a
+// script or copied from a snapshot, and of the QObject binding.
+// Run with -xml (or another QTestLib output format) to get results
+// that can be compared between builds.
+//
+
+class Receiver : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int value READ value WRITE setValue)
+public:
+    Receiver() : m_value(0) {}
+
+    int value() const { return m_value; }
+    void setValue(int value) { m_value = value; }
+
+    void emitValueChanged(int value) { emit valueChanged(value); }
+
+public slots:
+    int add(int a, int b) { return a + b; }
+
+signals:
+    void valueChanged(int value);
+
+private:
+    int m_value;
+};
+
+class tst_QScriptClassic : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void kernels_data();
+    void kernels();
+    void newEngine();
+    void newConfiguredEngine();
+    void newEngineFromSnapshot();
+    void evaluateStartup();
+    void slotInvocation();
+    void signalDispatch();
+
+private:
+    QString readKernel(const QString &name);
+};
+
+QString tst_QScriptClassic::readKernel(const QString &name)
+{
+    QFile file(QString::fromLatin1(":/kernels/%0.js").arg(name));
+    if (! file.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromUtf8(file.readAll());
+}
+
+void tst_QScriptClassic::kernels_data()
+{
+    QTest::addColumn<QString>("name");
+
+    QTest::newRow("property-access") << QString::fromLatin1("property-access");
+    QTest::newRow("function-calls") << QString::fromLatin1("function-calls");
+    QTest::newRow("closures") << QString::fromLatin1("closures");
+    QTest::newRow("string-building") << QString::fromLatin1("string-building");
+    QTest::newRow("regexp") << QString::fromLatin1("regexp");
+    QTest::newRow("array-sort") << QString::fromLatin1("array-sort");
+    QTest::newRow("date-math") << QString::fromLatin1("date-math");
+    QTest::newRow("gc-allocation") << QString::fromLatin1("gc-allocation");
+}
+
+void tst_QScriptClassic::kernels()
+{
+    QFETCH(QString, name);
+
+    const QString source = readKernel(name);
+    QVERIFY(! source.isEmpty());
+
+    QScriptEngine engine;
+    engine.evaluate(source, name + QLatin1String(".js"));
+    QVERIFY(! engine.hasUncaughtException());
+    QScriptValue run = engine.globalObject().property(QLatin1String("run"));
+    QVERIFY(run.isFunction());
+
+    QBENCHMARK {
+        run.call();
+    }
+    QVERIFY(! engine.hasUncaughtException());
+}
+
+void tst_QScriptClassic::newEngine()
+{
+    QBENCHMARK {
+        QScriptEngine engine;
+    }
+}
+
+// the globals are set up by the function-calls kernel; 16 engines are
+// created per iteration, so that the one snapshot taken per iteration
+// by newEngineFromSnapshot() is shared like it would be by a pool
+void tst_QScriptClassic::newConfiguredEngine()
+{
+    const QString source = readKernel(QLatin1String("function-calls"));
+    QVERIFY(! source.isEmpty());
+
+    QBENCHMARK {
+        QList<QScriptEngine*> engines;
+        for (int i = 0; i < 16; ++i) {
+            QScriptEngine *engine = new QScriptEngine;
+            engine->evaluate(source);
+            engines.append(engine);
+        }
+        qDeleteAll(engines);
+    }
+}
+
+void tst_QScriptClassic::newEngineFromSnapshot()
+{
+    const QString source = readKernel(QLatin1String("function-calls"));
+    QVERIFY(! source.isEmpty());
+
+    QScriptEngine configured;
+    configured.evaluate(source);
+    QVERIFY(! configured.hasUncaughtException());
+
+    QBENCHMARK {
+        QList<QScriptEngine*> engines;
+        qt_scriptCreateEnginesFromSnapshot(&configured, 16, &engines);
+        qDeleteAll(engines);
+    }
+
+    QList<QScriptEngine*> engines;
+    qt_scriptCreateEnginesFromSnapshot(&configured, 1, &engines);
+    QVERIFY(engines.at(0)->globalObject().property(QLatin1String("run")).isFunction());
+    qDeleteAll(engines);
+}
+
+void tst_QScriptClassic::evaluateStartup()
+{
+    const QString source = readKernel(QLatin1String("function-calls"));
+    QVERIFY(! source.isEmpty());
+
+    QBENCHMARK {
+        QScriptEngine engine;
+        engine.evaluate(source);
+        engine.evaluate(QLatin1String("fib(5)"));
+    }
+}
+
+void tst_QScriptClassic::slotInvocation()
+{
+    QScriptEngine engine;
+    Receiver receiver;
+    engine.globalObject().setProperty(QLatin1String("receiver"), engine.newQObject(&receiver));
+    QScriptValue run = engine.evaluate(QLatin1String(
+        "(function() {"
+        "    var sum = 0;"
+        "    for (var i = 0; i < 1000; ++i) {"
+        "        sum = receiver.add(sum, i);"
+        "        receiver.value = i;"
+        "    }"
+        "    return sum;"
+        "})"));
+    QVERIFY(run.isFunction());
+
+    QBENCHMARK {
+        run.call();
+    }
+    QVERIFY(! engine.hasUncaughtException());
+}
+
+void tst_QScriptClassic::signalDispatch()
+{
+    QScriptEngine engine;
+    Receiver receiver;
+    engine.globalObject().setProperty(QLatin1String("receiver"), engine.newQObject(&receiver));
+    engine.evaluate(QLatin1String(
+        "var total = 0;"
+        "receiver.valueChanged.connect(function(value) { total += value; });"));
+    QVERIFY(! engine.hasUncaughtException());
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i)
+            receiver.emitValueChanged(i);
+    }
+    QVERIFY(! engine.hasUncaughtException());
+}
+
+QTEST_MAIN(tst_QScriptClassic)
+#include "tst_qscriptclassic.moc"
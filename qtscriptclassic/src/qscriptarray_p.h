@@ -37,8 +37,6 @@
 ** $QT_END_LICENSE$
 **
 ****************************************************************************/
-
-
 #ifndef QSCRIPTARRAY_P_H
 #define QSCRIPTARRAY_P_H
 
@@ -53,10 +51,11 @@
 // We mean it.
 //
 
-#include <QMap>
+#include <QHash>
 
 
 #include <QVector>
+#include <QPair>
 
 #include "qscriptvalueimplfwd_p.h"
 #include "qscriptenginefwd_p.h"
@@ -68,12 +67,25 @@ namespace QScript {
 class Array
 {
 public:
+    // the element kinds; an array moves down this list as values it
+    // can't represent are stored into it, and never moves back up
+    enum Mode {
+        Int32Mode,  // packed qint32 elements, no holes
+        DoubleMode, // qsreal elements, holes are a reserved NaN
+        VectorMode, // QScriptValueImpl elements
+        HashMode    // sparse, QScriptValueImpl elements keyed by index
+    };
+
     inline Array(QScriptEnginePrivate *engine);
     inline Array(const Array &other);
     inline ~Array();
 
     inline Array &operator = (const Array &other);
 
+    inline Mode mode() const;
+    inline const qint32 *int32Data() const;
+    inline const qsreal *doubleData() const;
+
     inline bool isEmpty() const;
     inline uint size() const;
     inline uint count() const;
@@ -84,25 +96,34 @@ public:
     inline void resize(uint size);
     inline void concat(const Array &other);
     inline QScriptValueImpl pop();
+    inline void reverse();
     inline void sort(const QScriptValueImpl &comparefn);
     inline void splice(qsreal start, qsreal deleteCount,
                        const QVector<QScriptValueImpl> &items,
                        Array &other);
     inline QList<uint> keys() const;
 
+    static inline bool toInt32Element(const QScriptValueImpl &v, qint32 *result);
+    static inline bool isHole(qsreal element);
+    static inline qsreal hole();
+
 private:
-    enum Mode {
-        VectorMode,
-        MapMode
-    };
+    inline void copyElements(const Array &other);
+    inline void freeElements();
+    inline void convertToDouble();
+    inline void convertToVector();
+    inline void convertToHash(uint size);
 
     QScriptEnginePrivate *m_engine;
     Mode m_mode;
     int m_instances;
+    uint m_length; // HashMode only
 
     union {
-        QMap<uint, QScriptValueImpl> *to_map;
+        QVector<qint32> *to_int32;
+        QVector<qsreal> *to_double;
         QVector<QScriptValueImpl> *to_vector;
+        QHash<uint, QScriptValueImpl> *to_hash;
     };
 };
 
@@ -131,77 +152,167 @@ private:
     QScriptValueImpl m_comparefn;
 };
 
+// orders (string, value) pairs by the string alone; used by the
+// default sort of numeric arrays, which converts every element once
+// instead of once per comparison
+class ArrayElementKeyLessThan
+{
+public:
+    inline bool operator()(const QPair<QString, qsreal> &e1,
+                           const QPair<QString, qsreal> &e2) const
+    {
+        return e1.first < e2.first;
+    }
+};
+
 } // namespace QScript
 
 inline QScript::Array::Array(QScriptEnginePrivate *engine):
     m_engine(engine),
-    m_mode(VectorMode),
-    m_instances(0)
+    m_mode(Int32Mode),
+    m_instances(0),
+    m_length(0)
 {
-    to_vector = new QVector<QScriptValueImpl>();
+    to_int32 = new QVector<qint32>();
 }
 
 inline QScript::Array::Array(const Array &other):
     m_engine(other.m_engine),
     m_mode(other.m_mode),
-    m_instances(other.m_instances)
+    m_instances(other.m_instances),
+    m_length(other.m_length)
 {
-    if (m_mode == VectorMode)
-        to_vector = new QVector<QScriptValueImpl> (*other.to_vector);
-    else
-        to_map = new QMap<uint, QScriptValueImpl> (*other.to_map);
+    copyElements(other);
 }
 
 inline QScript::Array::~Array()
 {
-    if (m_mode == VectorMode)
-        delete to_vector;
-    else
-        delete to_map;
+    freeElements();
 }
 
 inline QScript::Array &QScript::Array::operator = (const Array &other)
 {
+    if (this == &other)
+        return *this;
+
+    freeElements();
     m_engine = other.m_engine;
+    m_mode = other.m_mode;
     m_instances = other.m_instances;
-    if (m_mode != other.m_mode) {
-        if (m_mode == VectorMode)
-            delete to_vector;
-        else
-            delete to_map;
-        m_mode = other.m_mode;
+    m_length = other.m_length;
+    copyElements(other);
 
-        if (m_mode == VectorMode)
-            to_vector = new QVector<QScriptValueImpl> (*other.to_vector);
-        else
-            to_map = new QMap<uint, QScriptValueImpl> (*other.to_map);
+    return *this;
+}
+
+// the containers are implicitly shared, so copying is cheap
+inline void QScript::Array::copyElements(const Array &other)
+{
+    switch (m_mode) {
+    case Int32Mode:
+        to_int32 = new QVector<qint32> (*other.to_int32);
+        break;
+    case DoubleMode:
+        to_double = new QVector<qsreal> (*other.to_double);
+        break;
+    case VectorMode:
+        to_vector = new QVector<QScriptValueImpl> (*other.to_vector);
+        break;
+    case HashMode:
+        to_hash = new QHash<uint, QScriptValueImpl> (*other.to_hash);
+        break;
     }
+}
 
-    if (m_mode == VectorMode)
-        *to_vector = *other.to_vector;
-    else
-        *to_map = *other.to_map;
+inline void QScript::Array::freeElements()
+{
+    switch (m_mode) {
+    case Int32Mode:
+        delete to_int32;
+        break;
+    case DoubleMode:
+        delete to_double;
+        break;
+    case VectorMode:
+        delete to_vector;
+        break;
+    case HashMode:
+        delete to_hash;
+        break;
+    }
+}
 
-    return *this;
+inline QScript::Array::Mode QScript::Array::mode() const
+{
+    return m_mode;
 }
 
-inline bool QScript::Array::isEmpty() const
+inline const qint32 *QScript::Array::int32Data() const
+{
+    Q_ASSERT(m_mode == Int32Mode);
+    return to_int32->constData();
+}
+
+inline const qsreal *QScript::Array::doubleData() const
+{
+    Q_ASSERT(m_mode == DoubleMode);
+    return to_double->constData();
+}
+
+// returns true if v is a number that an Int32Mode array can hold
+// without changing its value (-0 and NaN can't be)
+inline bool QScript::Array::toInt32Element(const QScriptValueImpl &v, qint32 *result)
 {
-    if (m_mode == VectorMode)
-        return to_vector->isEmpty();
+    if (! v.isNumber())
+        return false;
+
+    const qsreal d = v.numberValue();
+    if (! (d >= -2147483648.0 && d <= 2147483647.0))
+        return false;
+
+    const qint32 i = qint32(d);
+    if ((qsreal(i) != d) || ((i == 0) && (1 / d < 0)))
+        return false;
+
+    *result = i;
+    return true;
+}
 
-    return to_map->isEmpty();
+// holes in a DoubleMode array are stored as a NaN with a payload that
+// number values never have, since QScriptValueImpl keeps NaN canonical
+inline bool QScript::Array::isHole(qsreal element)
+{
+    union { qsreal d; quint64 bits; } u;
+    u.d = element;
+    return u.bits == Q_UINT64_C(0xFFF8000000000001);
+}
+
+inline qsreal QScript::Array::hole()
+{
+    union { qsreal d; quint64 bits; } u;
+    u.bits = Q_UINT64_C(0xFFF8000000000001);
+    return u.d;
+}
+
+inline bool QScript::Array::isEmpty() const
+{
+    return size() == 0;
 }
 
 inline uint QScript::Array::size() const
 {
-    if (m_mode == VectorMode)
+    switch (m_mode) {
+    case Int32Mode:
+        return to_int32->size();
+    case DoubleMode:
+        return to_double->size();
+    case VectorMode:
         return to_vector->size();
+    case HashMode:
+        break;
+    }
 
-    if (to_map->isEmpty())
-        return 0;
-
-    return (--to_map->constEnd()).key();
+    return m_length;
 }
 
 inline uint QScript::Array::count() const
@@ -211,17 +322,76 @@ inline uint QScript::Array::count() const
 
 inline QScriptValueImpl QScript::Array::at(uint index) const
 {
-    if (m_mode == VectorMode) {
+    switch (m_mode) {
+    case Int32Mode:
+        if (index < uint(to_int32->size()))
+            return QScriptValueImpl(to_int32->at(index));
+        break;
+
+    case DoubleMode:
+        if (index < uint(to_double->size())) {
+            const qsreal d = to_double->at(index);
+            if (! isHole(d))
+                return QScriptValueImpl(d);
+        }
+        break;
+
+    case VectorMode:
         if (index < uint(to_vector->size()))
             return to_vector->at(index);
-        return QScriptValueImpl();
-    } else {
-        return to_map->value(index, QScriptValueImpl());
+        break;
+
+    case HashMode:
+        return to_hash->value(index, QScriptValueImpl());
     }
+
+    return QScriptValueImpl();
 }
 
 inline void QScript::Array::assign(uint index, const QScriptValueImpl &v)
 {
+    if (m_mode == Int32Mode) {
+        qint32 i;
+        if ((index < uint(to_int32->size())) && toInt32Element(v, &i)) {
+            to_int32->replace(index, i);
+            return;
+        } else if ((index == uint(to_int32->size())) && toInt32Element(v, &i)) {
+            to_int32->append(i);
+            if (m_engine)
+                m_engine->adjustBytesAllocated(sizeof(qint32));
+            return;
+        } else if (v.isNumber() || !v.isValid()) {
+            convertToDouble();
+        } else {
+            convertToVector();
+        }
+    }
+
+    if (m_mode == DoubleMode) {
+        if (v.isNumber() || !v.isValid()) {
+            const qsreal d = v.isValid() ? v.numberValue() : hole();
+            if (index < uint(to_double->size())) {
+                to_double->replace(index, d);
+                return;
+            } else if (index == uint(to_double->size())) {
+                to_double->append(d);
+                if (m_engine)
+                    m_engine->adjustBytesAllocated(sizeof(qsreal));
+                return;
+            } else if (! v.isValid()) {
+                resize(index + 1);
+                return;
+            }
+            resize(index + 1);
+            if (m_mode == DoubleMode) {
+                to_double->replace(index, d);
+                return;
+            }
+        } else {
+            convertToVector();
+        }
+    }
+
     if (index >= size()) {
         resize(index + 1);
         if (v.isValid() && m_engine)
@@ -238,22 +408,21 @@ inline void QScript::Array::assign(uint index, const QScriptValueImpl &v)
     if (m_mode == VectorMode) {
         to_vector->replace(index, v);
     } else {
+        Q_ASSERT(m_mode == HashMode);
         if (!v.isValid())
-            to_map->remove(index);
+            to_hash->remove(index);
         else
-            to_map->insert(index, v);
+            to_hash->insert(index, v);
     }
 }
 
 inline void QScript::Array::clear()
 {
+    freeElements();
+    m_mode = Int32Mode;
     m_instances = 0;
-
-    if (m_mode == VectorMode)
-        to_vector->clear();
-
-    else
-        to_map->clear();
+    m_length = 0;
+    to_int32 = new QVector<qint32>();
 }
 
 inline void QScript::Array::mark(int generation)
@@ -264,9 +433,9 @@ inline void QScript::Array::mark(int generation)
     if (m_mode == VectorMode) {
         for (int i = 0; i < to_vector->size(); ++i)
             to_vector->at(i).mark(generation);
-    } else {
-        QMap<uint, QScriptValueImpl>::const_iterator it = to_map->constBegin();
-        for (; it != to_map->constEnd(); ++it)
+    } else if (m_mode == HashMode) {
+        QHash<uint, QScriptValueImpl>::const_iterator it = to_hash->constBegin();
+        for (; it != to_hash->constEnd(); ++it)
             it.value().mark(generation);
     }
 }
@@ -279,94 +448,232 @@ inline void QScript::Array::resize(uint s)
 
     const uint N = 10 * 1024;
 
+    // growing by more than the current size past N makes the array
+    // sparse enough to be better off hashed
+    const bool sparse = (s >= N) && (s > oldSize) && (s - oldSize > oldSize);
+
+    if (m_mode == Int32Mode) {
+        if (s < oldSize) {
+            to_int32->resize(s);
+            return;
+        }
+        convertToDouble();
+    }
+
+    if (m_mode == DoubleMode) {
+        if (! sparse) {
+            if (s < oldSize)
+                to_double->resize(s);
+            else
+                to_double->insert(to_double->end(), s - oldSize, hole());
+            return;
+        }
+        convertToVector();
+    }
+
     if (m_mode == VectorMode) {
-        if (s < N) {
-            to_vector->resize (s);
-        } else {
-            // switch to MapMode
-            QMap<uint, QScriptValueImpl> *m = new QMap<uint, QScriptValueImpl>();
-            for (uint i = 0; i < oldSize; ++i) {
-                if (to_vector->at(i).isValid())
-                    m->insert(i, to_vector->at(i));
+        if (! sparse)
+            to_vector->resize(s);
+        else
+            convertToHash(s);
+    }
+
+    else {
+        if (s < oldSize) {
+            QHash<uint, QScriptValueImpl>::iterator it = to_hash->begin();
+            while (it != to_hash->end()) {
+                if (it.key() >= s)
+                    it = to_hash->erase(it);
+                else
+                    ++it;
             }
-            m->insert(s, QScriptValueImpl());
-            delete to_vector;
-            to_map = m;
-            m_mode = MapMode;
         }
+        m_length = s;
+        if (s < N)
+            convertToVector();
     }
+}
 
-    else {
-        if (s < N) {
-            // switch to VectorMode
-            QVector<QScriptValueImpl> *v = new QVector<QScriptValueImpl> (s);
-            QMap<uint, QScriptValueImpl>::const_iterator it = to_map->constBegin();
-            for ( ; (it != to_map->constEnd()) && (it.key() < s); ++it)
+inline void QScript::Array::convertToDouble()
+{
+    Q_ASSERT(m_mode == Int32Mode);
+    const int n = to_int32->size();
+    QVector<qsreal> *d = new QVector<qsreal> (n);
+    const qint32 *src = to_int32->constData();
+    qsreal *dst = d->data();
+    for (int i = 0; i < n; ++i)
+        dst[i] = src[i];
+    delete to_int32;
+    to_double = d;
+    m_mode = DoubleMode;
+    if (m_engine)
+        m_engine->adjustBytesAllocated(int(sizeof(qsreal) - sizeof(qint32)) * n);
+}
+
+inline void QScript::Array::convertToVector()
+{
+    Q_ASSERT(m_mode != VectorMode);
+    const uint n = size();
+    QVector<QScriptValueImpl> *v = new QVector<QScriptValueImpl> (n);
+    if (m_mode == HashMode) {
+        QHash<uint, QScriptValueImpl>::const_iterator it = to_hash->constBegin();
+        for ( ; it != to_hash->constEnd(); ++it) {
+            if (it.key() < n)
                 (*v) [it.key()] = it.value();
-            delete to_map;
-            to_vector = v;
-            m_mode = VectorMode;
-        } else {
-            if (!to_map->isEmpty()) {
-                QMap<uint, QScriptValueImpl>::iterator it = --to_map->end();
-                if (oldSize > s) {
-                    // shrink
-                    while ((it != to_map->end()) && (it.key() >= s)) {
-                        it = to_map->erase(it);
-                        --it;
-                    }
-                } else {
-                    if ((it.key() == oldSize) && !it.value().isValid())
-                        to_map->erase(it);
-                }
-            }
-            to_map->insert(s, QScriptValueImpl());
         }
+        delete to_hash;
+    } else {
+        for (uint i = 0; i < n; ++i)
+            (*v) [i] = at(i);
+        if (m_mode == Int32Mode)
+            delete to_int32;
+        else
+            delete to_double;
+    }
+    to_vector = v;
+    m_mode = VectorMode;
+}
+
+inline void QScript::Array::convertToHash(uint s)
+{
+    Q_ASSERT(m_mode == VectorMode);
+    QHash<uint, QScriptValueImpl> *h = new QHash<uint, QScriptValueImpl>();
+    for (int i = 0; i < to_vector->size(); ++i) {
+        if (to_vector->at(i).isValid())
+            h->insert(i, to_vector->at(i));
     }
+    delete to_vector;
+    to_hash = h;
+    m_length = s;
+    m_mode = HashMode;
 }
 
 inline void QScript::Array::concat(const QScript::Array &other)
 {
-    uint k = size();
-    resize (k + other.size());
-    for (uint i = 0; i < other.size(); ++i) {
+    const uint k = size();
+    const uint n = other.size();
+
+    if ((other.m_mode == Int32Mode) && ((m_mode == Int32Mode) || (m_mode == DoubleMode))) {
+        if (m_mode == Int32Mode)
+            *to_int32 += *other.to_int32;
+        else {
+            const qint32 *src = other.int32Data();
+            to_double->resize(k + n);
+            qsreal *dst = to_double->data() + k;
+            for (uint i = 0; i < n; ++i)
+                dst[i] = src[i];
+        }
+        if (m_engine)
+            m_engine->adjustBytesAllocated(int(m_mode == Int32Mode ? sizeof(qint32) : sizeof(qsreal)) * n);
+        return;
+    }
+
+    for (uint i = 0; i < n; ++i) {
         QScriptValueImpl v = other.at(i);
         if (! v.isValid())
             continue;
 
         assign(k + i, v);
     }
+    resize(k + n);
 }
 
 inline QScriptValueImpl QScript::Array::pop()
 {
-    if (isEmpty())
+    const uint n = size();
+    if (n == 0)
         return QScriptValueImpl();
 
-    QScriptValueImpl v;
-
-    if (m_mode == VectorMode)
-        v = to_vector->last();
-    else
-        v = *--to_map->end();
-
-    resize(size() - 1);
+    QScriptValueImpl v = at(n - 1);
+    resize(n - 1);
 
     return v;
 }
 
+inline void QScript::Array::reverse()
+{
+    switch (m_mode) {
+    case Int32Mode: {
+        qint32 *d = to_int32->data();
+        for (int lo = 0, hi = to_int32->size() - 1; lo < hi; ++lo, --hi)
+            qSwap(d[lo], d[hi]);
+    }   break;
+
+    case DoubleMode: {
+        qsreal *d = to_double->data();
+        for (int lo = 0, hi = to_double->size() - 1; lo < hi; ++lo, --hi)
+            qSwap(d[lo], d[hi]);
+    }   break;
+
+    case VectorMode: {
+        QScriptValueImpl *d = to_vector->data();
+        for (int lo = 0, hi = to_vector->size() - 1; lo < hi; ++lo, --hi)
+            qSwap(d[lo], d[hi]);
+    }   break;
+
+    case HashMode: {
+        QHash<uint, QScriptValueImpl> *h = new QHash<uint, QScriptValueImpl>();
+        QHash<uint, QScriptValueImpl>::const_iterator it = to_hash->constBegin();
+        for ( ; it != to_hash->constEnd(); ++it)
+            h->insert(m_length - 1 - it.key(), it.value());
+        delete to_hash;
+        to_hash = h;
+    }   break;
+    }
+}
+
 inline void QScript::Array::sort(const QScriptValueImpl &comparefn)
 {
     ArrayElementLessThan lessThan(comparefn);
-    if (m_mode == VectorMode) {
+
+    switch (m_mode) {
+    case Int32Mode:
+    case DoubleMode: {
+        // the elements are sorted as a copy, since the compare function
+        // may well modify the array
+        const uint len = size();
+        if (comparefn.isUndefined()) {
+            QVector<QPair<QString, qsreal> > elements;
+            elements.reserve(len);
+            for (uint i = 0; i < len; ++i) {
+                const QScriptValueImpl v = at(i);
+                if (! v.isValid())
+                    continue;
+                const QString key = (m_mode == Int32Mode)
+                                    ? QString::number(to_int32->at(i))
+                                    : v.toString();
+                elements.append(qMakePair(key, v.numberValue()));
+            }
+            qStableSort(elements.begin(), elements.end(), ArrayElementKeyLessThan());
+            for (int i = 0; i < elements.size(); ++i)
+                assign(i, QScriptValueImpl(elements.at(i).second));
+            for (uint i = elements.size(); i < len; ++i)
+                assign(i, QScriptValueImpl());
+        } else {
+            QVector<QScriptValueImpl> values(len);
+            for (uint i = 0; i < len; ++i)
+                values[i] = at(i);
+            qSort(values.begin(), values.end(), lessThan);
+            for (uint i = 0; i < len; ++i)
+                assign(i, values.at(i));
+        }
+    }   break;
+
+    case VectorMode:
         qSort(to_vector->begin(), to_vector->end(), lessThan);
-    } else {
-        QList<uint> keys = to_map->keys();
-        QList<QScriptValueImpl> values = to_map->values();
+        break;
+
+    case HashMode: {
+        QList<uint> keys = to_hash->keys();
+        qSort(keys);
+        QList<QScriptValueImpl> values;
+        for (int i = 0; i < keys.size(); ++i)
+            values.append(to_hash->value(keys.at(i)));
         qStableSort(values.begin(), values.end(), lessThan);
         const uint len = keys.size();
         for (uint i = 0; i < len; ++i)
-            to_map->insert(keys.at(i), values.at(i));
+            to_hash->insert(keys.at(i), values.at(i));
+    }   break;
     }
 }
 
@@ -383,41 +690,93 @@ inline void QScript::Array::splice(qsreal start, qsreal deleteCount,
 
     const uint st = uint(start);
     const uint dc = uint(deleteCount);
+
+    for (uint i = 0; i < dc; ++i) {
+        QScriptValueImpl v = at(st + i);
+        if (v.isValid())
+            other.assign(i, v);
+    }
     other.resize(dc);
 
     const uint itemsSize = uint(items.size());
 
-    if (m_mode == VectorMode) {
-        for (uint i = 0; i < dc; ++i)
-            other.assign(i, to_vector->at(st + i));
+    if ((m_mode == Int32Mode) || (m_mode == DoubleMode)) {
+        for (uint i = 0; (i < itemsSize) && (m_mode != VectorMode); ++i) {
+            qint32 dummy;
+            if (! items.at(i).isNumber())
+                convertToVector();
+            else if ((m_mode == Int32Mode) && ! toInt32Element(items.at(i), &dummy))
+                convertToDouble();
+        }
+    }
+
+    for (uint i = 0; i < itemsSize; ++i) {
+        if (items.at(i).isObject() || items.at(i).isString())
+            ++m_instances;
+    }
+
+    switch (m_mode) {
+    case Int32Mode:
+        if (itemsSize > dc)
+            to_int32->insert(st, itemsSize - dc, 0);
+        else if (itemsSize < dc)
+            to_int32->remove(st, dc - itemsSize);
+        for (uint i = 0; i < itemsSize; ++i)
+            toInt32Element(items.at(i), to_int32->data() + st + i);
+        break;
+
+    case DoubleMode:
+        if (itemsSize > dc)
+            to_double->insert(st, itemsSize - dc, hole());
+        else if (itemsSize < dc)
+            to_double->remove(st, dc - itemsSize);
+        for (uint i = 0; i < itemsSize; ++i)
+            to_double->replace(st + i, items.at(i).numberValue());
+        break;
+
+    case VectorMode:
         if (itemsSize > dc)
             to_vector->insert(st, itemsSize - dc, QScriptValueImpl());
         else if (itemsSize < dc)
             to_vector->remove(st, dc - itemsSize);
         for (uint i = 0; i < itemsSize; ++i)
             to_vector->replace(st + i, items.at(i));
-    } else {
-        for (uint i = 0; i < dc; ++i)
-            other.assign(i, to_map->take(st + i));
-        uint del = itemsSize - dc;
-        if (del != 0) {
-            for (uint i = st; i < uint(len); ++i) {
-                if (to_map->contains(i))
-                    to_map->insert(i + del, to_map->take(i));
+        break;
+
+    case HashMode: {
+        // move the elements after the deleted ones into place
+        QHash<uint, QScriptValueImpl> moved;
+        QHash<uint, QScriptValueImpl>::iterator it = to_hash->begin();
+        while (it != to_hash->end()) {
+            if (it.key() < st) {
+                ++it;
+                continue;
             }
-            resize(uint(len) + del);
+            if (it.key() >= st + dc)
+                moved.insert(it.key() - dc + itemsSize, it.value());
+            it = to_hash->erase(it);
         }
-        for (uint i = 0; i < itemsSize; ++i)
-            to_map->insert(st + i, items.at(i));
+        for (uint i = 0; i < itemsSize; ++i) {
+            if (items.at(i).isValid())
+                to_hash->insert(st + i, items.at(i));
+        }
+        to_hash->unite(moved);
+        m_length = uint(len) - dc + itemsSize;
+    }   break;
     }
 }
 
+// the keys of a sparse array, in ascending order and followed by the
+// length, so that the list is never empty
 inline QList<uint> QScript::Array::keys() const
 {
-    if (m_mode == VectorMode)
+    if (m_mode != HashMode)
         return QList<uint>();
-    else
-        return to_map->keys();
+
+    QList<uint> result = to_hash->keys();
+    qSort(result);
+    result.append(m_length);
+    return result;
 }
 
 QT_END_NAMESPACE
@@ -48,6 +48,7 @@
 #include "qscriptcontext_p.h"
 #include "qscriptmember_p.h"
 #include "qscriptobject_p.h"
+#include "qscriptinlinecache_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -80,13 +81,23 @@ Code::Code():
     optimized(false),
     firstInstruction(0),
     lastInstruction(0),
-    astPool(0)
+    astPool(0),
+    inlineCaches(0),
+    capturesActivation(false)
+#ifdef Q_SCRIPT_JIT
+    , hotness(0),
+    jitCode(0)
+#endif
 {
 }
 
 Code::~Code()
 {
     delete[] firstInstruction;
+    delete[] inlineCaches;
+#ifdef Q_SCRIPT_JIT
+    delete jitCode;
+#endif
 }
 
 void Code::init(const CompilationUnit &compilation, NodePool *pool)
@@ -98,6 +109,33 @@ void Code::init(const CompilationUnit &compilation, NodePool *pool)
     qCopy(ilist.begin(), ilist.end(), firstInstruction);
     exceptionHandlers = compilation.exceptionHandlers();
     astPool = pool;
+
+    // give every property access its own inline cache, and find out
+    // whether the activation can outlive a call
+    int cacheCount = 0;
+    capturesActivation = false;
+    for (QScriptInstruction *current = firstInstruction; current != lastInstruction; ++current) {
+        switch (current->op) {
+        case QScriptInstruction::OP_Fetch:
+        case QScriptInstruction::OP_FetchLocalField:
+        case QScriptInstruction::OP_FetchField:
+        case QScriptInstruction::OP_PutField:
+        case QScriptInstruction::OP_Assign:
+            current->inlineCache = cacheCount++;
+            break;
+        case QScriptInstruction::OP_NewClosure:
+        case QScriptInstruction::OP_LoadActivation:
+        case QScriptInstruction::OP_LazyArguments:
+            capturesActivation = true;
+            current->inlineCache = -1;
+            break;
+        default:
+            current->inlineCache = -1;
+            break;
+        }
+    }
+    if (cacheCount)
+        inlineCaches = new InlineCache[cacheCount];
 }
 
 } // namespace QScript
@@ -59,6 +59,7 @@
 #include <qvector.h>
 
 #include "qscriptvalueimplfwd_p.h"
+#include "qscriptjit_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -76,6 +77,7 @@ public:
 
 public:
     Operator op;
+    int inlineCache; // index in Code::inlineCaches, or -1
     QScriptValueImpl operand[2];
 #if defined(Q_SCRIPT_DIRECT_CODE)
     void *code;
@@ -89,6 +91,7 @@ public:
 namespace QScript {
 
 class NodePool;
+class InlineCache;
 
 class ExceptionHandlerDescriptor
 {
@@ -168,6 +171,12 @@ public: // attributes
     QScriptInstruction *lastInstruction;
     QVector<ExceptionHandlerDescriptor> exceptionHandlers;
     NodePool *astPool;
+    InlineCache *inlineCaches;
+    bool capturesActivation; // creates closures or uses its activation as a value
+#ifdef Q_SCRIPT_JIT
+    int hotness; // entries and backward branches until compiled
+    JitCode *jitCode;
+#endif
 
 private:
     Q_DISABLE_COPY(Code)
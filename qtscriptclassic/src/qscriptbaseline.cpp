@@ -0,0 +1,280 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptbaseline_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptcontext_p.h"
+#include "qscriptmember_p.h"
+#include "qscriptobject_p.h"
+#include "qscriptecmaarray_p.h"
+#include "qscriptextvariant_p.h"
+#ifndef QT_NO_QOBJECT
+#include "qscriptextqobject_p.h"
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+Baseline::Baseline(QScriptEnginePrivate *engine)
+    : m_engine(engine), m_lastBlock(0), m_stringCount(0), m_tempStringCount(0)
+{
+}
+
+Baseline::~Baseline()
+{
+    clear();
+}
+
+void Baseline::clear()
+{
+    while (! m_journal.isEmpty()) {
+        Entry *e = m_journal.takeLast();
+        GCBlock::get(e->object)->journaled = 0;
+        if (e->shape)
+            e->shape->deref();
+        delete e->array;
+        delete e->variant;
+        delete e->qobject;
+        delete e;
+    }
+}
+
+// makes everything that is alive in the engine the baseline; the
+// caller has just run a major collection, so that all of it is tenured
+void Baseline::record()
+{
+    Q_ASSERT(! m_engine->objectAllocator.blocked());
+
+    clear();
+
+    GCAlloc<QScriptObject> &allocator = m_engine->objectAllocator;
+    for (GCBlock *blk = allocator.head(); blk != 0; blk = blk->next) {
+        Q_ASSERT(blk->tenured);
+        blk->baseline = 1;
+        blk->journaled = 0;
+    }
+
+    m_lastBlock = allocator.lastTenured();
+
+    QScriptContextPrivate *context = m_engine->currentContext();
+    m_globalObject = m_engine->m_globalObject;
+    m_thisObject = context->m_thisObject;
+    m_activation = context->m_activation;
+    m_scopeChain = context->m_scopeChain;
+
+    m_stringCount = m_engine->m_stringRepository.size();
+    m_tempStringCount = m_engine->m_tempStringRepository.size();
+    m_connectedObjects.clear();
+}
+
+void Baseline::save(QScriptObject *object)
+{
+    Entry *e = new Entry;
+    e->object = object;
+
+    // a dictionary layout is modified in place, so it's the members
+    // that have to be saved
+    e->shape = object->m_shape;
+    if (e->shape && e->shape->isDictionary())
+        e->shape = Shape::createDictionary(e->shape);
+    if (e->shape)
+        e->shape->ref();
+
+    const int count = object->m_values.size();
+    e->values.resize(count);
+    for (int i = 0; i < count; ++i)
+        e->values[i] = object->m_values.at(i);
+
+    e->prototype = object->m_prototype;
+    e->scope = object->m_scope;
+    e->internalValue = object->m_internalValue;
+
+    e->array = 0;
+    if (object->m_data && (object->m_class == m_engine->arrayConstructor->classInfo())) {
+        Ecma::Array::Instance *instance = static_cast<Ecma::Array::Instance*>(object->m_data);
+        e->array = new Array(instance->value);
+    }
+
+    // the private data of the wrapper classes can be changed too
+    e->variant = 0;
+    e->qobject = 0;
+    if (object->m_data) {
+        QScriptEnginePrivate *eng = m_engine;
+        if (eng->m_variantConstructor && (object->m_class == eng->m_variantConstructor->classInfo())) {
+            Ext::Variant::Instance *instance = static_cast<Ext::Variant::Instance*>(object->m_data);
+            e->variant = new QVariant(instance->value);
+        }
+#ifndef QT_NO_QOBJECT
+        else if (eng->m_qobjectConstructor && (object->m_class == eng->m_qobjectConstructor->classInfo())) {
+            ExtQObject::Instance *instance = static_cast<ExtQObject::Instance*>(object->m_data);
+            e->qobject = new QPointer<QObject>(instance->value);
+        } else if (eng->m_qmetaObjectConstructor
+                   && (object->m_class == eng->m_qmetaObjectConstructor->classInfo())) {
+            ExtQMetaObject::Instance *instance = static_cast<ExtQMetaObject::Instance*>(object->m_data);
+            e->metaPrototype = instance->prototype;
+        }
+#endif
+    }
+
+    m_journal.append(e);
+}
+
+// puts the objects that were changed since the baseline was recorded
+// back into their recorded state, and empties the journal
+void Baseline::restore()
+{
+    // QScriptEngine::setGlobalObject() may have been called since
+    QScriptContextPrivate *context = m_engine->currentContext();
+    m_engine->m_globalObject = m_globalObject;
+    context->m_thisObject = m_thisObject;
+    context->m_activation = m_activation;
+    context->m_scopeChain = m_scopeChain;
+
+    while (! m_journal.isEmpty()) {
+        Entry *e = m_journal.takeLast();
+        QScriptObject *object = e->object;
+
+        if (e->shape) {
+            object->changeShape(e->shape);
+            e->shape->deref();
+        } else if (object->m_shape) {
+            object->m_shape->deref();
+            object->m_shape = 0;
+        }
+
+        const int count = e->values.size();
+        object->m_values.resize(count);
+        for (int i = 0; i < count; ++i)
+            object->m_values[i] = e->values.at(i);
+
+        object->m_prototype = e->prototype;
+        object->m_scope = e->scope;
+        object->m_internalValue = e->internalValue;
+
+        if (e->array) {
+            Ecma::Array::Instance *instance = static_cast<Ecma::Array::Instance*>(object->m_data);
+            instance->value = *e->array;
+            delete e->array;
+        }
+        if (e->variant) {
+            Ext::Variant::Instance *instance = static_cast<Ext::Variant::Instance*>(object->m_data);
+            instance->value = *e->variant;
+            delete e->variant;
+        }
+#ifndef QT_NO_QOBJECT
+        if (e->qobject) {
+            ExtQObject::Instance *instance = static_cast<ExtQObject::Instance*>(object->m_data);
+            instance->value = *e->qobject;
+            delete e->qobject;
+        }
+        if (e->metaPrototype.isValid()) {
+            ExtQMetaObject::Instance *instance = static_cast<ExtQMetaObject::Instance*>(object->m_data);
+            instance->prototype = e->metaPrototype;
+        }
+#endif
+
+        GCBlock::get(object)->journaled = 0;
+        delete e;
+    }
+}
+
+static inline void markValue(QScriptEnginePrivate *eng, const QScriptValueImpl &value,
+                             int generation)
+{
+    if (value.isObject())
+        eng->markObject(value, generation);
+    else if (value.isString())
+        eng->markString(value.stringValue(), generation);
+}
+
+// keeps the baseline alive through a major collection, including the
+// values that only the journal refers to
+void Baseline::mark(int generation)
+{
+    if (m_lastBlock) {
+        for (GCBlock *blk = m_engine->objectAllocator.head(); ; blk = blk->next) {
+            QScriptValueImpl object;
+            object.setObjectValue(reinterpret_cast<QScriptObject*>(blk->data()));
+            m_engine->markObject(object, generation);
+            if (blk == m_lastBlock)
+                break;
+        }
+    }
+
+    for (int i = 0; i < m_journal.size(); ++i) {
+        const Entry *e = m_journal.at(i);
+        if (e->shape) {
+            for (int j = 0; j < e->shape->size(); ++j) {
+                if (QScriptNameIdImpl *nameId = e->shape->at(j).nameId())
+                    m_engine->markString(nameId, generation);
+            }
+        }
+        for (int j = 0; j < e->values.size(); ++j)
+            markValue(m_engine, e->values.at(j), generation);
+        markValue(m_engine, e->prototype, generation);
+        markValue(m_engine, e->scope, generation);
+        markValue(m_engine, e->internalValue, generation);
+        if (e->array)
+            e->array->mark(generation);
+        markValue(m_engine, e->metaPrototype, generation);
+    }
+}
+
+QList<QObject*> Baseline::takeConnectedObjects()
+{
+    QList<QObject*> result = m_connectedObjects.toList();
+    m_connectedObjects.clear();
+    return result;
+}
+
+} // namespace QScript
+
+// slow path of QScriptObject::aboutToChange()
+void QScriptObject::saveBaseline()
+{
+    QScript::GCBlock::get(this)->journaled = 1;
+    m_class->engine()->m_baseline->save(this);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,152 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTBASELINE_P_H
+#define QSCRIPTBASELINE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QList>
+#include <QPointer>
+#include <QSet>
+#include <QVariant>
+#include <QVector>
+
+#include "qscriptvalueimplfwd_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QObject;
+class QScriptEnginePrivate;
+class QScriptObject;
+
+namespace QScript {
+
+class Array;
+class GCBlock;
+class Shape;
+
+//
+// The state of an engine that QScriptEnginePrivate::resetToBaseline()
+// brings it back to, so that an engine can be handed out again without
+// creating a new one (see EnginePool).
+//
+// Recording the baseline doesn't copy anything: the objects alive at
+// that point are the tenured blocks up to lastBlock(), and the strings
+// are the first stringCount() entries of the string repository. An
+// object of the baseline is saved in the journal the first time it is
+// changed afterwards (see QScriptObject::aboutToChange()), so resetting
+// the engine only restores the objects that were actually changed and
+// lets a minor collection free everything that was allocated since.
+//
+class Baseline
+{
+public:
+    Baseline(QScriptEnginePrivate *engine);
+    ~Baseline();
+
+    inline GCBlock *lastBlock() const { return m_lastBlock; }
+    inline int stringCount() const { return m_stringCount; }
+    inline int tempStringCount() const { return m_tempStringCount; }
+    inline int journalSize() const { return m_journal.size(); }
+
+    void record();
+
+    void save(QScriptObject *object);
+    void restore();
+
+    void mark(int generation);
+
+    // called while the string repositories are compacted, with the
+    // number of entries that were kept before the removed one
+    inline void stringRemoved(int index)
+    { if (index < m_stringCount) --m_stringCount; }
+    inline void tempStringRemoved(int index)
+    { if (index < m_tempStringCount) --m_tempStringCount; }
+
+    inline void addConnectedObject(QObject *object)
+    { m_connectedObjects.insert(object); }
+    QList<QObject*> takeConnectedObjects();
+
+private:
+    struct Entry {
+        QScriptObject *object;
+        Shape *shape;
+        QVector<QScriptValueImpl> values;
+        QScriptValueImpl prototype;
+        QScriptValueImpl scope;
+        QScriptValueImpl internalValue;
+        Array *array; // the elements, for array objects
+        QVariant *variant; // the value, for variant objects
+        QPointer<QObject> *qobject; // the wrapped object, for QObject wrappers
+        QScriptValueImpl metaPrototype; // the prototype, for QMetaObject wrappers
+    };
+
+    void clear();
+
+    QScriptEnginePrivate *m_engine;
+    GCBlock *m_lastBlock;
+    int m_stringCount;
+    int m_tempStringCount;
+    QScriptValueImpl m_globalObject;
+    QScriptValueImpl m_thisObject;
+    QScriptValueImpl m_activation;
+    QScriptValueImpl m_scopeChain;
+    QList<Entry*> m_journal;
+    QSet<QObject*> m_connectedObjects;
+
+private:
+    Q_DISABLE_COPY(Baseline)
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTBASELINE_P_H
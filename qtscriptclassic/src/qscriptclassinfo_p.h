@@ -58,6 +58,7 @@
 #endif
 
 #include "qscriptclassdata_p.h"
+#include "qscriptshape_p.h"
 
 
 #include <qstring.h>
@@ -94,8 +95,13 @@ public:
     };
 
     inline QScriptClassInfo(QScriptEnginePrivate *engine, Type type, const QString &name)
-        : m_engine(engine), m_type(type), m_name(name), m_data(0) { }
-    inline ~QScriptClassInfo() { delete m_data; }
+        : m_engine(engine), m_type(type), m_name(name), m_data(0), m_rootShape(0) { }
+    inline ~QScriptClassInfo()
+    {
+        delete m_data;
+        if (m_rootShape)
+            m_rootShape->deref();
+    }
 
     inline QScriptEnginePrivate *engine() const
         { return m_engine; }
@@ -109,11 +115,22 @@ public:
     QScriptClassData *data() const
         { return m_data; }
 
+    // the empty layout that all the shapes of this class derive from
+    inline QScript::Shape *rootShape()
+    {
+        if (! m_rootShape) {
+            m_rootShape = new QScript::Shape();
+            m_rootShape->ref();
+        }
+        return m_rootShape;
+    }
+
 private:
     QScriptEnginePrivate *m_engine;
     Type m_type;
     QString m_name;
     QScriptClassData *m_data;
+    QScript::Shape *m_rootShape;
 
 private:
     Q_DISABLE_COPY(QScriptClassInfo)
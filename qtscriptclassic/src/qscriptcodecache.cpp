@@ -0,0 +1,1017 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qscriptcodecache_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptast_p.h"
+#include "qscriptnodepool_p.h"
+#include "qscriptcompiler_p.h"
+#include "qscriptprettypretty_p.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QTextStream>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+//
+// A cache file consists of a header, a string table, a function table
+// and the code of the program followed by the code of each function.
+// All fields are 32-bit integers in the byte order of the machine that
+// wrote the file, numbers are stored as 8 bytes and strings as UTF-16
+// padded to a multiple of 4 bytes. Operands that refer to a function
+// hold its index in the function table; those that hold a name, its
+// index in the string table. An entry of the function table holds the
+// offset of the function's code from the start of the program's code,
+// so that it can be decoded without decoding the functions before it.
+//
+
+namespace {
+
+enum {
+    ByteOrderMark = 0x01020304,
+    HashSize = 20 // SHA-1, a multiple of 4
+};
+
+class CodeCacheWriter
+{
+public:
+    CodeCacheWriter(NodePool *pool):
+        m_pool(pool), m_valid(true) {}
+
+    inline void addFunction(AST::FunctionExpression *expr) { functionIndex(expr); }
+    bool write(Code *program, QByteArray *out);
+
+private:
+    void writeInt(QByteArray *out, int value);
+    void writeNumber(QByteArray *out, qsreal value);
+    void writeString(QByteArray *out, const QString &s);
+    int stringIndex(QScriptNameIdImpl *id);
+    int functionIndex(AST::FunctionExpression *expr);
+    void writeFunction(QByteArray *out, AST::FunctionExpression *expr, int codeOffset);
+    void writeCode(QByteArray *out, Code *code);
+
+private:
+    NodePool *m_pool;
+    bool m_valid;
+    QHash<QScriptNameIdImpl*, int> m_stringIndexes;
+    QList<QScriptNameIdImpl*> m_strings;
+    QHash<AST::FunctionExpression*, int> m_functionIndexes;
+    QList<AST::FunctionExpression*> m_functions;
+};
+
+class CodeCacheReader
+{
+public:
+    CodeCacheReader(QScriptEnginePrivate *eng, const uchar *data, qint64 size):
+        m_eng(eng), m_begin(data), m_data(data), m_end(data + size), m_valid(true) {}
+
+    inline bool isValid() const { return m_valid; }
+    inline int offset() const { return m_data - m_begin; }
+    void seek(qint64 offset);
+
+    int readInt();
+    qsreal readNumber();
+    QString readString();
+    void skipString();
+    QScriptNameIdImpl *readNameId();
+    const uchar *readBytes(int count);
+    bool readInstructions(QVector<QScriptInstruction> *instructions, int functionCount);
+    bool readExceptionHandlers(QVector<ExceptionHandlerDescriptor> *handlers,
+                               int instructionCount);
+
+    QList<QScriptNameIdImpl*> strings;
+
+private:
+    QScriptEnginePrivate *m_eng;
+    const uchar *m_begin;
+    const uchar *m_data;
+    const uchar *m_end;
+    bool m_valid;
+};
+
+struct FunctionRecord
+{
+    QScriptNameIdImpl *name;
+    QList<QScriptNameIdImpl*> formals;
+    int startLine;
+    int endLine;
+    int codeOffset;
+    int textOffset;
+};
+
+// the kinds of operand an instruction is generated with, which are the
+// ones the interpreter reads without checking
+enum OperandKind {
+    NoOperand,
+    IntOperand,
+    CountOperand, // an integer that is not negative
+    OptionalIntOperand,
+    NumberOperand,
+    NameOperand,
+    FunctionOperand
+};
+
+void operandKinds(QScriptInstruction::Operator op, OperandKind *first,
+                  OperandKind *second)
+{
+    *first = NoOperand;
+    *second = NoOperand;
+    switch (op) {
+    case QScriptInstruction::OP_LoadNumber:
+    case QScriptInstruction::OP_AddNumber:
+    case QScriptInstruction::OP_SubNumber:
+    case QScriptInstruction::OP_MulNumber:
+    case QScriptInstruction::OP_LessThanNumber:
+    case QScriptInstruction::OP_LessOrEqualNumber:
+    case QScriptInstruction::OP_GreatThanNumber:
+    case QScriptInstruction::OP_GreatOrEqualNumber:
+        *first = NumberOperand;
+        break;
+
+    case QScriptInstruction::OP_LoadString:
+    case QScriptInstruction::OP_NewString:
+    case QScriptInstruction::OP_Fetch:
+    case QScriptInstruction::OP_Resolve:
+    case QScriptInstruction::OP_BeginCatch:
+    case QScriptInstruction::OP_FetchLocalField:
+    case QScriptInstruction::OP_IncrLocal:
+    case QScriptInstruction::OP_DecrLocal:
+        *first = NameOperand;
+        break;
+
+    case QScriptInstruction::OP_NewRegExp:
+        *first = NameOperand;
+        *second = OptionalIntOperand;
+        break;
+
+    case QScriptInstruction::OP_DeclareLocal:
+        *first = NameOperand;
+        *second = IntOperand;
+        break;
+
+    case QScriptInstruction::OP_Call:
+    case QScriptInstruction::OP_New:
+    case QScriptInstruction::OP_Receive:
+        *first = CountOperand;
+        break;
+
+    case QScriptInstruction::OP_Branch:
+    case QScriptInstruction::OP_BranchTrue:
+    case QScriptInstruction::OP_BranchFalse:
+        *first = IntOperand;
+        break;
+
+    case QScriptInstruction::OP_Line:
+        *first = IntOperand;
+        *second = IntOperand;
+        break;
+
+    case QScriptInstruction::OP_NewClosure:
+        *first = FunctionOperand;
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool hasOperandKind(const QScriptValueImpl &operand, OperandKind kind)
+{
+    switch (kind) {
+    case NoOperand:
+        return ! operand.isValid();
+    case IntOperand:
+        return operand.type() == IntegerType;
+    case CountOperand:
+        return (operand.type() == IntegerType) && (operand.intValue() >= 0);
+    case OptionalIntOperand:
+        return ! operand.isValid() || (operand.type() == IntegerType);
+    case NumberOperand:
+        return operand.type() == NumberType;
+    case NameOperand:
+        return operand.type() == StringType;
+    case FunctionOperand:
+        return operand.type() == PointerType;
+    }
+    return false;
+}
+
+// the instructions that a superinstruction stands for, which the
+// interpreter runs or skips as they are; see QScript::Optimizer
+bool hasFusedInstructions(const QVector<QScriptInstruction> &instructions, int i)
+{
+    const int count = instructions.size();
+    QScriptInstruction::Operator next = QScriptInstruction::OP_Dummy;
+    QScriptInstruction::Operator nextButOne = QScriptInstruction::OP_Dummy;
+    if (i + 1 < count)
+        next = instructions.at(i + 1).op;
+    if (i + 2 < count)
+        nextButOne = instructions.at(i + 2).op;
+
+    switch (instructions.at(i).op) {
+    case QScriptInstruction::OP_FetchLocalField:
+        return (next == QScriptInstruction::OP_LoadString)
+            && (nextButOne == QScriptInstruction::OP_FetchField);
+    case QScriptInstruction::OP_AddNumber:
+        return next == QScriptInstruction::OP_Add;
+    case QScriptInstruction::OP_SubNumber:
+        return next == QScriptInstruction::OP_Sub;
+    case QScriptInstruction::OP_MulNumber:
+        return next == QScriptInstruction::OP_Mul;
+    case QScriptInstruction::OP_LessThanNumber:
+        return next == QScriptInstruction::OP_LessThan;
+    case QScriptInstruction::OP_LessOrEqualNumber:
+        return next == QScriptInstruction::OP_LessOrEqual;
+    case QScriptInstruction::OP_GreatThanNumber:
+        return next == QScriptInstruction::OP_GreatThan;
+    case QScriptInstruction::OP_GreatOrEqualNumber:
+        return next == QScriptInstruction::OP_GreatOrEqual;
+    case QScriptInstruction::OP_LessThanBranchFalse:
+    case QScriptInstruction::OP_LessOrEqualBranchFalse:
+    case QScriptInstruction::OP_GreatThanBranchFalse:
+    case QScriptInstruction::OP_GreatOrEqualBranchFalse:
+    case QScriptInstruction::OP_EqualBranchFalse:
+    case QScriptInstruction::OP_NotEqualBranchFalse:
+    case QScriptInstruction::OP_StrictEqualBranchFalse:
+    case QScriptInstruction::OP_StrictNotEqualBranchFalse:
+        return next == QScriptInstruction::OP_BranchFalse;
+    case QScriptInstruction::OP_IncrLocal:
+        return ((next == QScriptInstruction::OP_Incr) || (next == QScriptInstruction::OP_PostIncr))
+            && (nextButOne == QScriptInstruction::OP_Pop);
+    case QScriptInstruction::OP_DecrLocal:
+        return ((next == QScriptInstruction::OP_Decr) || (next == QScriptInstruction::OP_PostDecr))
+            && (nextButOne == QScriptInstruction::OP_Pop);
+    default:
+        return true;
+    }
+}
+
+// the interpreter doesn't check where control goes, so the code has to
+// end with Halt or Ret, branches have to stay inside the code, and
+// superinstructions have to be followed by what they were fused from
+bool isWellFormed(const QVector<QScriptInstruction> &instructions)
+{
+    const int count = instructions.size();
+    if (count == 0)
+        return false;
+    const QScriptInstruction::Operator last = instructions.at(count - 1).op;
+    if ((last != QScriptInstruction::OP_Halt) && (last != QScriptInstruction::OP_Ret))
+        return false;
+
+    for (int i = 0; i < count; ++i) {
+        const QScriptInstruction &ins = instructions.at(i);
+        if ((ins.op == QScriptInstruction::OP_Branch)
+            || (ins.op == QScriptInstruction::OP_BranchTrue)
+            || (ins.op == QScriptInstruction::OP_BranchFalse)) {
+            const qint64 target = qint64(i) + ins.operand[0].intValue();
+            if ((target < 0) || (target >= count))
+                return false;
+        }
+        if (! hasFusedInstructions(instructions, i))
+            return false;
+    }
+    return true;
+}
+
+// operands of NewClosure hold the index of a function in the function
+// table until the functions have been created
+void resolveClosures(QScriptEnginePrivate *eng, QVector<QScriptInstruction> *instructions,
+                     const QVector<CodeCacheFile::Function> &functions)
+{
+    for (int k = 0; k < instructions->size(); ++k) {
+        QScriptValueImpl &operand = (*instructions)[k].operand[0];
+        if (operand.type() == PointerType) {
+            const int index = int(quintptr(operand.pointerValue()));
+            eng->newPointer(&operand, functions.at(index).expression);
+        }
+    }
+}
+
+} // anonymous namespace
+
+void CodeCacheWriter::writeInt(QByteArray *out, int value)
+{
+    const qint32 v = value;
+    out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void CodeCacheWriter::writeNumber(QByteArray *out, qsreal value)
+{
+    out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void CodeCacheWriter::writeString(QByteArray *out, const QString &s)
+{
+    writeInt(out, s.length());
+    out->append(reinterpret_cast<const char*>(s.constData()), s.length() * sizeof(QChar));
+    if (s.length() & 1)
+        out->append(QByteArray(sizeof(QChar), '\0'));
+}
+
+int CodeCacheWriter::stringIndex(QScriptNameIdImpl *id)
+{
+    if (! id)
+        return -1;
+    QHash<QScriptNameIdImpl*, int>::const_iterator it = m_stringIndexes.constFind(id);
+    if (it != m_stringIndexes.constEnd())
+        return it.value();
+    const int index = m_strings.count();
+    m_strings.append(id);
+    m_stringIndexes.insert(id, index);
+    return index;
+}
+
+int CodeCacheWriter::functionIndex(AST::FunctionExpression *expr)
+{
+    QHash<AST::FunctionExpression*, int>::const_iterator it = m_functionIndexes.constFind(expr);
+    if (it != m_functionIndexes.constEnd())
+        return it.value();
+    const int index = m_functions.count();
+    m_functions.append(expr);
+    m_functionIndexes.insert(expr, index);
+    return index;
+}
+
+void CodeCacheWriter::writeFunction(QByteArray *out, AST::FunctionExpression *expr,
+                                    int codeOffset)
+{
+    writeInt(out, stringIndex(expr->name));
+
+    int formalCount = 0;
+    for (AST::FormalParameterList *it = expr->formals; it != 0; it = it->next)
+        ++formalCount;
+    writeInt(out, formalCount);
+    for (AST::FormalParameterList *it = expr->formals; it != 0; it = it->next)
+        writeInt(out, stringIndex(it->name));
+
+    writeInt(out, expr->startLine);
+    writeInt(out, expr->endLine);
+    writeInt(out, codeOffset);
+
+    // a function restored from a cache only has the text it was saved with
+    QString text = m_pool->functionText(expr);
+    if (text.isNull()) {
+        AST::FunctionExpression *definition = m_pool->parsedFunction(expr);
+        if (! definition)
+            definition = expr;
+
+        QTextStream stream(&text, QIODevice::WriteOnly);
+        PrettyPretty pp(stream);
+        pp(definition, /*indent=*/ 0);
+        stream.flush();
+    }
+    writeString(out, text);
+}
+
+void CodeCacheWriter::writeCode(QByteArray *out, Code *code)
+{
+    writeInt(out, code->lastInstruction - code->firstInstruction);
+
+    for (const QScriptInstruction *i = code->firstInstruction; i != code->lastInstruction; ++i) {
+        writeInt(out, i->op);
+
+        for (int k = 0; k < 2; ++k) {
+            const QScriptValueImpl &operand = i->operand[k];
+            writeInt(out, operand.type());
+
+            switch (operand.type()) {
+            case InvalidType:
+            case UndefinedType:
+            case NullType:
+                break;
+
+            case BooleanType:
+                writeInt(out, operand.boolValue());
+                break;
+
+            case IntegerType:
+                writeInt(out, operand.intValue());
+                break;
+
+            case NumberType:
+                writeNumber(out, operand.numberValue());
+                break;
+
+            case StringType:
+                writeInt(out, stringIndex(operand.stringValue()));
+                break;
+
+            case PointerType:
+                if (i->op != QScriptInstruction::OP_NewClosure) {
+                    m_valid = false;
+                    return;
+                }
+                writeInt(out, functionIndex(static_cast<AST::FunctionExpression*>(operand.pointerValue())));
+                break;
+
+            default:
+                m_valid = false;
+                return;
+            }
+        }
+    }
+
+    writeInt(out, code->exceptionHandlers.count());
+    for (int k = 0; k < code->exceptionHandlers.count(); ++k) {
+        const ExceptionHandlerDescriptor &e = code->exceptionHandlers.at(k);
+        writeInt(out, e.startInstruction());
+        writeInt(out, e.endInstruction());
+        writeInt(out, e.handlerInstruction());
+    }
+}
+
+bool CodeCacheWriter::write(Code *program, QByteArray *out)
+{
+    QScriptEnginePrivate *eng = m_pool->engine();
+
+    QByteArray codes;
+    if (program) {
+        writeCode(&codes, program);
+    } else {
+        // a program that does nothing, for a file that only holds functions
+        writeInt(&codes, 1);
+        writeInt(&codes, QScriptInstruction::OP_Halt);
+        writeInt(&codes, InvalidType);
+        writeInt(&codes, InvalidType);
+        writeInt(&codes, 0);
+    }
+
+    // function bodies are compiled on their first call, so compile the
+    // ones that haven't run yet; writing a body can add more functions
+    QByteArray functions;
+    for (int i = 0; m_valid && (i < m_functions.count()); ++i) {
+        AST::FunctionExpression *expr = m_functions.at(i);
+
+        Code *code = m_pool->compiledCode(expr->body);
+        if (! code) {
+            QList<QScriptNameIdImpl*> formals;
+            for (AST::FormalParameterList *it = expr->formals; it != 0; it = it->next)
+                formals.append(it->name);
+
+            AST::FunctionExpression *definition = m_pool->parsedFunction(expr);
+            if (! definition)
+                return false;
+
+            Compiler compiler(eng);
+            compiler.setKeepLines(true);
+            CompilationUnit unit = compiler.compile(definition->body, formals);
+            if (! unit.isValid())
+                return false;
+            code = m_pool->createCompiledCode(expr->body, unit);
+        }
+
+        writeFunction(&functions, expr, codes.size());
+        writeCode(&codes, code);
+    }
+
+    if (! m_valid)
+        return false;
+
+    QByteArray strings;
+    for (int i = 0; i < m_strings.count(); ++i)
+        writeString(&strings, m_strings.at(i)->s);
+
+    writeInt(out, m_strings.count());
+    writeInt(out, m_functions.count());
+    out->append(strings);
+    out->append(functions);
+    out->append(codes);
+    return true;
+}
+
+const uchar *CodeCacheReader::readBytes(int count)
+{
+    if (! m_valid || (count < 0) || (count > m_end - m_data)) {
+        m_valid = false;
+        return 0;
+    }
+    const uchar *bytes = m_data;
+    m_data += count;
+    return bytes;
+}
+
+void CodeCacheReader::seek(qint64 offset)
+{
+    if ((offset < 0) || (offset > m_end - m_begin))
+        m_valid = false;
+    else
+        m_data = m_begin + offset;
+}
+
+int CodeCacheReader::readInt()
+{
+    qint32 value = 0;
+    if (const uchar *bytes = readBytes(sizeof(value)))
+        ::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+qsreal CodeCacheReader::readNumber()
+{
+    qsreal value = 0;
+    if (const uchar *bytes = readBytes(sizeof(value)))
+        ::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+QString CodeCacheReader::readString()
+{
+    const int length = readInt();
+    if (length < 0) {
+        m_valid = false;
+        return QString();
+    }
+    const uchar *bytes = readBytes(((length + 1) & ~1) * sizeof(QChar));
+    if (! bytes)
+        return QString();
+    return QString(reinterpret_cast<const QChar*>(bytes), length);
+}
+
+void CodeCacheReader::skipString()
+{
+    const int length = readInt();
+    if (length < 0)
+        m_valid = false;
+    else
+        readBytes(((length + 1) & ~1) * sizeof(QChar));
+}
+
+// names in the file are indexes in the string table, which has been
+// interned in this engine
+QScriptNameIdImpl *CodeCacheReader::readNameId()
+{
+    const int index = readInt();
+    if ((index < 0) || (index >= strings.count())) {
+        m_valid = false;
+        return 0;
+    }
+    return strings.at(index);
+}
+
+bool CodeCacheReader::readInstructions(QVector<QScriptInstruction> *instructions,
+                                       int functionCount)
+{
+    const int count = readInt();
+    if (! m_valid || (count < 0) || (count > (m_end - m_data) / 12))
+        return false;
+    instructions->resize(count);
+
+    for (int i = 0; i < count; ++i) {
+        QScriptInstruction &ins = (*instructions)[i];
+        const int op = readInt();
+        if ((op < 0) || (op >= QScriptInstruction::OP_Dummy))
+            return false;
+        ins.op = QScriptInstruction::Operator(op);
+        ins.inlineCache = -1;
+
+        OperandKind kinds[2];
+        operandKinds(ins.op, &kinds[0], &kinds[1]);
+
+        for (int k = 0; k < 2; ++k) {
+            QScriptValueImpl &operand = ins.operand[k];
+            const int type = readInt();
+
+            switch (type) {
+            case InvalidType:
+                operand.invalidate();
+                break;
+
+            case UndefinedType:
+                operand = m_eng->undefinedValue();
+                break;
+
+            case NullType:
+                operand = m_eng->nullValue();
+                break;
+
+            case BooleanType:
+                operand = QScriptValueImpl(readInt() != 0);
+                break;
+
+            case IntegerType:
+                m_eng->newInteger(&operand, readInt());
+                break;
+
+            case NumberType:
+                operand = QScriptValueImpl(readNumber());
+                break;
+
+            case StringType:
+                m_eng->newNameId(&operand, readNameId());
+                break;
+
+            case PointerType: {
+                // fixed up once the functions have been created
+                const int index = readInt();
+                if ((index < 0) || (index >= functionCount))
+                    return false;
+                m_eng->newPointer(&operand, reinterpret_cast<void*>(quintptr(index)));
+            }   break;
+
+            default:
+                return false;
+            }
+
+            if (! hasOperandKind(operand, kinds[k]))
+                return false;
+        }
+
+        if (! m_valid)
+            return false;
+    }
+
+    return isWellFormed(*instructions);
+}
+
+bool CodeCacheReader::readExceptionHandlers(QVector<ExceptionHandlerDescriptor> *handlers,
+                                            int instructionCount)
+{
+    const int count = readInt();
+    if (! m_valid || (count < 0) || (count > (m_end - m_data) / 12))
+        return false;
+
+    for (int i = 0; i < count; ++i) {
+        const int start = readInt();
+        const int end = readInt();
+        const int handler = readInt();
+        if ((start < 0) || (end < start) || (end > instructionCount)
+            || (handler < 0) || (handler >= instructionCount)) {
+            return false;
+        }
+        handlers->append(ExceptionHandlerDescriptor(start, end, handler));
+    }
+
+    return m_valid;
+}
+
+CodeCache::CodeCache(const QString &directory, const QString &sourceCode,
+                     int firstLineNumber):
+    m_sourceCode(sourceCode), m_firstLineNumber(firstLineNumber)
+{
+    // line numbers are part of the generated code
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(reinterpret_cast<const char*>(sourceCode.constData()),
+                 sourceCode.length() * sizeof(QChar));
+    const qint32 line = firstLineNumber;
+    hash.addData(reinterpret_cast<const char*>(&line), sizeof(line));
+    m_sourceHash = hash.result();
+
+    m_filePath = QDir(directory).filePath(QString::fromLatin1(m_sourceHash.toHex())
+                                          + QLatin1String(".qsc"));
+}
+
+Code *CodeCache::load(QScriptEnginePrivate *eng, const QString &fileName,
+                      QExplicitlySharedDataPointer<NodePool> *pool) const
+{
+    CodeCacheFile *file = new CodeCacheFile(eng);
+    if (! file->open(m_filePath)) {
+        delete file;
+        return 0;
+    }
+    return restore(eng, file, fileName, pool);
+}
+
+// loads code that serialize() returned, e.g. on another thread
+Code *CodeCache::load(QScriptEnginePrivate *eng, const QByteArray &data,
+                      const QString &fileName,
+                      QExplicitlySharedDataPointer<NodePool> *pool) const
+{
+    CodeCacheFile *file = new CodeCacheFile(eng);
+    file->setData(data);
+    return restore(eng, file, fileName, pool);
+}
+
+Code *CodeCache::restore(QScriptEnginePrivate *eng, CodeCacheFile *file,
+                         const QString &fileName,
+                         QExplicitlySharedDataPointer<NodePool> *pool) const
+{
+    CodeCacheReader reader(eng, file->data(), file->size());
+
+    bool ok = (reader.readInt() == Magic)
+              && (reader.readInt() == FormatVersion)
+              && (reader.readInt() == ByteOrderMark)
+              && (reader.readInt() == QScriptInstruction::OP_Dummy)
+              && (reader.readInt() == int(sizeof(qsreal)));
+    if (ok) {
+        const uchar *hash = reader.readBytes(HashSize);
+        ok = hash && (::memcmp(hash, m_sourceHash.constData(), HashSize) == 0)
+             && (reader.readInt() == m_firstLineNumber);
+    }
+
+    const int stringCount = ok ? reader.readInt() : -1;
+    const int functionCount = ok ? reader.readInt() : -1;
+    ok = ok && reader.isValid() && (stringCount >= 0) && (functionCount >= 0);
+
+    for (int i = 0; ok && (i < stringCount); ++i) {
+        const QString s = reader.readString();
+        ok = reader.isValid();
+        if (ok)
+            reader.strings.append(eng->nameId(s, /*persistent=*/true));
+    }
+
+    QVector<FunctionRecord> functions;
+    for (int i = 0; ok && (i < functionCount); ++i) {
+        FunctionRecord f;
+        const int nameIndex = reader.readInt();
+        if (nameIndex == -1)
+            f.name = 0;
+        else if ((nameIndex >= 0) && (nameIndex < stringCount))
+            f.name = reader.strings.at(nameIndex);
+        else
+            ok = false;
+        const int formalCount = reader.readInt();
+        ok = ok && reader.isValid() && (formalCount >= 0) && (formalCount <= stringCount);
+        for (int k = 0; ok && (k < formalCount); ++k)
+            f.formals.append(reader.readNameId());
+        f.startLine = reader.readInt();
+        f.endLine = reader.readInt();
+        f.codeOffset = reader.readInt();
+        f.textOffset = reader.offset();
+        reader.skipString();
+        ok = ok && reader.isValid();
+        functions.append(f);
+    }
+
+    // only the code of the program is decoded now; the code of the
+    // functions is checked when it is decoded on their first call
+    const int codeStart = reader.offset();
+    QVector<QScriptInstruction> instructions;
+    QVector<ExceptionHandlerDescriptor> handlers;
+    ok = ok && reader.readInstructions(&instructions, functionCount)
+         && reader.readExceptionHandlers(&handlers, instructions.size());
+    for (int i = 0; ok && (i < functionCount); ++i) {
+        const int offset = functions.at(i).codeOffset;
+        ok = (offset >= reader.offset() - codeStart) && (offset < file->size() - codeStart);
+    }
+
+    if (! ok) {
+        delete file;
+        return 0;
+    }
+
+    *pool = new NodePool(fileName, eng);
+    NodePool *p = pool->data();
+    p->setKeepLines(true);
+
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+    eng->notifyScriptLoad(p->id(), m_sourceCode, fileName, m_firstLineNumber);
+#endif
+
+    // the functions get a syntax tree without statements, which is
+    // enough for creating closures since their code is in the file
+    file->strings = reader.strings;
+    file->codeStart = codeStart;
+    file->functions.resize(functionCount);
+    for (int i = 0; i < functionCount; ++i) {
+        const FunctionRecord &f = functions.at(i);
+        AST::FormalParameterList *formals = 0;
+        for (int k = 0; k < f.formals.count(); ++k) {
+            if (! formals)
+                formals = makeAstNode<AST::FormalParameterList>(p, f.formals.at(k));
+            else
+                formals = makeAstNode<AST::FormalParameterList>(p, formals, f.formals.at(k));
+        }
+        if (formals)
+            formals = formals->finish();
+
+        AST::FunctionBody *body = makeAstNode<AST::FunctionBody>(
+            p, static_cast<AST::SourceElements*>(0));
+        AST::FunctionExpression *expr = makeAstNode<AST::FunctionExpression>(
+            p, f.name, formals, body);
+        expr->startLine = f.startLine;
+        expr->endLine = f.endLine;
+
+        CodeCacheFile::Function &entry = file->functions[i];
+        entry.expression = expr;
+        entry.codeOffset = f.codeOffset;
+        entry.textOffset = f.textOffset;
+        file->bodyIndexes.insert(body, i);
+        file->expressionIndexes.insert(expr, i);
+    }
+    p->setCacheFile(file);
+
+    resolveClosures(eng, &instructions, file->functions);
+    CompilationUnit unit;
+    unit.setInstructions(instructions);
+    unit.setExceptionHandlers(handlers);
+
+    AST::Program *program = makeAstNode<AST::Program>(p, static_cast<AST::SourceElements*>(0));
+    return p->createCompiledCode(program, unit);
+}
+
+// returns the contents of a cache file for the program, or an empty
+// array if the program can't be cached
+QByteArray CodeCache::serialize(Code *program) const
+{
+    CodeCacheWriter writer(program->astPool);
+
+    QByteArray data;
+    if (! writer.write(program, &data))
+        return QByteArray();
+    return withHeader(data);
+}
+
+// returns the contents of a cache file for the given functions of a
+// pool and the functions nested in them, or an empty array if one of
+// them can't be cached; the program of the file does nothing, and the
+// functions are the first entries of its function table, in order
+QByteArray CodeCache::serialize(NodePool *pool,
+                                const QList<AST::FunctionExpression*> &functions) const
+{
+    CodeCacheWriter writer(pool);
+    for (int i = 0; i < functions.count(); ++i)
+        writer.addFunction(functions.at(i));
+
+    QByteArray data;
+    if (! writer.write(/*program=*/0, &data))
+        return QByteArray();
+    return withHeader(data);
+}
+
+QByteArray CodeCache::withHeader(const QByteArray &data) const
+{
+    const qint32 fields[] = { Magic, FormatVersion, ByteOrderMark,
+                              QScriptInstruction::OP_Dummy, sizeof(qsreal) };
+    QByteArray result;
+    result.reserve(sizeof(fields) + HashSize + sizeof(qint32) + data.size());
+    result.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+    result.append(m_sourceHash);
+    const qint32 line = m_firstLineNumber;
+    result.append(reinterpret_cast<const char*>(&line), sizeof(line));
+    result.append(data);
+    return result;
+}
+
+bool CodeCache::save(Code *program) const
+{
+    const QByteArray data = serialize(program);
+    if (data.isEmpty())
+        return false;
+
+    // write to a temporary file of our own, so that a reader never sees
+    // a partial file and engines saving the same program at the same
+    // time don't write into each other's file
+    QTemporaryFile file(m_filePath + QLatin1String(".XXXXXX"));
+    if (! file.open())
+        return false;
+    file.setAutoRemove(false);
+    const QString tmpPath = file.fileName();
+    bool ok = (file.write(data) == data.size())
+              && file.setPermissions(QFile::ReadOwner | QFile::WriteOwner
+                                     | QFile::ReadGroup | QFile::ReadOther);
+    file.close();
+
+    if (ok) {
+        QFile::remove(m_filePath);
+        ok = QFile::rename(tmpPath, m_filePath);
+    }
+    if (! ok)
+        QFile::remove(tmpPath);
+    return ok;
+}
+
+CodeCacheFile::CodeCacheFile(QScriptEnginePrivate *engine):
+    codeStart(0), m_engine(engine), m_mapped(0), m_data(0), m_size(0)
+{
+}
+
+CodeCacheFile::~CodeCacheFile()
+{
+    if (m_mapped)
+        m_file.unmap(m_mapped);
+}
+
+// the file stays mapped for as long as the program's functions exist
+bool CodeCacheFile::open(const QString &filePath)
+{
+    m_file.setFileName(filePath);
+    if (! m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_size = m_file.size();
+    m_mapped = m_file.map(0, m_size);
+    if (m_mapped) {
+        m_data = m_mapped;
+    } else {
+        m_buffer = m_file.readAll();
+        m_data = reinterpret_cast<const uchar*>(m_buffer.constData());
+        m_size = m_buffer.size();
+        m_file.close();
+    }
+    return true;
+}
+
+void CodeCacheFile::setData(const QByteArray &data)
+{
+    Q_ASSERT(! m_mapped);
+    m_buffer = data;
+    m_data = reinterpret_cast<const uchar*>(m_buffer.constData());
+    m_size = m_buffer.size();
+}
+
+Code *CodeCacheFile::loadCode(NodePool *pool, AST::Node *body)
+{
+    const int index = bodyIndexes.value(body, -1);
+    if (index == -1)
+        return 0;
+
+    CodeCacheReader reader(m_engine, m_data, m_size);
+    reader.strings = strings;
+    reader.seek(qint64(codeStart) + functions.at(index).codeOffset);
+
+    QVector<QScriptInstruction> instructions;
+    QVector<ExceptionHandlerDescriptor> handlers;
+    if (! reader.readInstructions(&instructions, functions.count())
+        || ! reader.readExceptionHandlers(&handlers, instructions.size())) {
+        return 0;
+    }
+
+    resolveClosures(m_engine, &instructions, functions);
+    CompilationUnit unit;
+    unit.setInstructions(instructions);
+    unit.setExceptionHandlers(handlers);
+    return pool->createCompiledCode(body, unit);
+}
+
+QString CodeCacheFile::loadText(AST::Node *expr)
+{
+    const int index = expressionIndexes.value(expr, -1);
+    if (index == -1)
+        return QString();
+
+    CodeCacheReader reader(m_engine, m_data, m_size);
+    reader.seek(functions.at(index).textOffset);
+    const QString text = reader.readString();
+    return reader.isValid() ? text : QString();
+}
+
+void NodePool::setCacheFile(CodeCacheFile *file)
+{
+    Q_ASSERT(! m_cacheFile);
+    m_cacheFile = file;
+}
+
+Code *NodePool::loadCompiledCode(AST::Node *node)
+{
+    return m_cacheFile->loadCode(this, node);
+}
+
+QString NodePool::loadFunctionText(AST::Node *node)
+{
+    const QString text = m_cacheFile->loadText(node);
+    if (! text.isNull())
+        m_functionText.insert(node, text);
+    return text;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
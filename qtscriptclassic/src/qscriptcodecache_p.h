@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QSCRIPTCODECACHE_P_H
+#define QSCRIPTCODECACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qbytearray.h>
+#include <qfile.h>
+#include <qhash.h>
+#include <qlist.h>
+#include <qshareddata.h>
+#include <qstring.h>
+#include <qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+class QScriptEnginePrivate;
+class QScriptNameIdImpl;
+
+namespace QScript {
+
+namespace AST {
+class Node;
+class FunctionExpression;
+} // namespace AST
+
+class Code;
+class CodeCacheFile;
+class NodePool;
+
+//
+// Stores the compiled code of a program in a directory, so that a later
+// run can skip the lexer, parser and compiler. A cache file is named
+// after a hash of the source code and holds the instructions of the
+// program and of every function nested in it, with names stored as
+// strings that are interned again when the file is loaded. Functions
+// restored from a cache have no syntax tree, only the source text that
+// Function.prototype.toString() returns. Loading decodes the code of
+// the program only; the code and text of a function are decoded when
+// it is first called or converted to a string.
+//
+class CodeCache
+{
+public:
+    enum {
+        Magic = 0x43425351, // "QSBC"
+        FormatVersion = 2
+    };
+
+    CodeCache(const QString &directory, const QString &sourceCode,
+              int firstLineNumber);
+
+    inline QString filePath() const { return m_filePath; }
+
+    Code *load(QScriptEnginePrivate *eng, const QString &fileName,
+               QExplicitlySharedDataPointer<NodePool> *pool) const;
+    Code *load(QScriptEnginePrivate *eng, const QByteArray &data, const QString &fileName,
+               QExplicitlySharedDataPointer<NodePool> *pool) const;
+    bool save(Code *program) const;
+    QByteArray serialize(Code *program) const;
+    QByteArray serialize(NodePool *pool,
+                         const QList<AST::FunctionExpression*> &functions) const;
+
+private:
+    QByteArray withHeader(const QByteArray &data) const;
+
+    Code *restore(QScriptEnginePrivate *eng, CodeCacheFile *file, const QString &fileName,
+                  QExplicitlySharedDataPointer<NodePool> *pool) const;
+
+private:
+    QString m_filePath;
+    QByteArray m_sourceHash;
+    QString m_sourceCode;
+    int m_firstLineNumber;
+};
+
+//
+// The contents of a cache file that a program was restored from, kept
+// by the NodePool of the program for decoding its functions on demand.
+// The contents are either mapped from a file or held in memory.
+//
+class CodeCacheFile
+{
+public:
+    CodeCacheFile(QScriptEnginePrivate *engine);
+    ~CodeCacheFile();
+
+    bool open(const QString &filePath);
+    void setData(const QByteArray &data);
+    inline const uchar *data() const { return m_data; }
+    inline qint64 size() const { return m_size; }
+
+    Code *loadCode(NodePool *pool, AST::Node *body);
+    QString loadText(AST::Node *expr);
+
+    struct Function
+    {
+        AST::FunctionExpression *expression;
+        int codeOffset;
+        int textOffset;
+    };
+
+    QList<QScriptNameIdImpl*> strings;
+    QVector<Function> functions;
+    QHash<AST::Node*, int> bodyIndexes;
+    QHash<AST::Node*, int> expressionIndexes;
+    int codeStart;
+
+private:
+    QScriptEnginePrivate *m_engine;
+    QFile m_file;
+    uchar *m_mapped;
+    QByteArray m_buffer;
+    const uchar *m_data;
+    qint64 m_size;
+
+private:
+    Q_DISABLE_COPY(CodeCacheFile)
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTCODECACHE_P_H
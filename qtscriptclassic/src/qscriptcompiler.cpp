@@ -48,6 +48,7 @@
 #include "qscriptcontext_p.h"
 #include "qscriptmember_p.h"
 #include "qscriptobject_p.h"
+#include "qscriptoptimizer_p.h"
 
 #include <QtDebug>
 
@@ -309,6 +310,7 @@ Compiler::Compiler(QScriptEnginePrivate *eng):
     m_generateLeaveWithOnBreak(0), m_generateFastArgumentLookup(0),
     m_parseStatements(0), m_pad(0),
     m_topLevelCompiler(false),
+    m_keepLines(false),
     m_activeLoop(0)
 {
 }
@@ -327,6 +329,16 @@ void Compiler::setTopLevelCompiler(bool b)
     m_topLevelCompiler = b;
 }
 
+bool Compiler::keepLines() const
+{
+    return m_keepLines;
+}
+
+void Compiler::setKeepLines(bool keep)
+{
+    m_keepLines = keep;
+}
+
  CompilationUnit Compiler::compile(AST::Node *node, const QList<QScriptNameIdImpl *> &formals)
 {
     m_formals = formals;
@@ -355,6 +367,11 @@ void Compiler::setTopLevelCompiler(bool b)
         iRet();
     }
 
+    if (m_compilationUnit.isValid()) {
+        Optimizer optimize(m_eng, m_keepLines);
+        optimize(&m_instructions, &m_exceptionHandlers);
+    }
+
     m_compilationUnit.setInstructions(m_instructions);
     m_compilationUnit.setExceptionHandlers(m_exceptionHandlers);
     return m_compilationUnit;
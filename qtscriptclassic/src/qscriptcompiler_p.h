@@ -78,6 +78,11 @@ public:
     bool topLevelCompiler() const;
     void setTopLevelCompiler(bool b);
 
+    // whether all the Line instructions are kept, for code that is cached
+    // or shared, and so may run with an agent attached later
+    bool keepLines() const;
+    void setKeepLines(bool keep);
+
     CompilationUnit compile(AST::Node *node, const QList<QScriptNameIdImpl *> &formals
                             = QList<QScriptNameIdImpl *>());
 
@@ -340,6 +345,7 @@ private:
     uint m_pad: 25;
 
     bool m_topLevelCompiler; // bit
+    bool m_keepLines;
     QVector<QScriptInstruction> m_instructions;
     QVector<ExceptionHandlerDescriptor> m_exceptionHandlers;
     QList<QScriptNameIdImpl *> m_formals;
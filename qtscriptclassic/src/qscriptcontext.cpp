@@ -208,9 +208,8 @@ QScriptValue QScriptContext::throwError(const QString &text)
   \internal
 */
 QScriptContext::QScriptContext():
-    d_ptr(new QScriptContextPrivate())
+    d_ptr(0)
 {
-    d_ptr->q_ptr = this;
 }
 
 /*!
@@ -218,7 +217,8 @@ QScriptContext::QScriptContext():
 */
 QScriptContext::~QScriptContext()
 {
-    delete d_ptr;
+    // the private context is a frame of the engine's stack, which
+    // owns it
     d_ptr = 0;
 }
 
@@ -534,7 +534,7 @@ void QScriptContext::pushScope(const QScriptValue &object)
     } else {
         QScriptValueImpl withObject;
         eng_p->newObject(&withObject, eng_p->toImpl(object), eng_p->m_class_with);
-        withObject.m_object_value->m_scope = d->m_scopeChain;
+        withObject.objectValue()->m_scope = d->m_scopeChain;
         withObject.setInternalValue(1); // to differentiate from with-statement objects
         d->m_scopeChain = withObject;
     }
@@ -561,7 +561,7 @@ QScriptValue QScriptContext::popScope()
         result = d->m_scopeChain;
     else
         result = d->m_scopeChain.prototype();
-    d->m_scopeChain = d->m_scopeChain.m_object_value->m_scope;
+    d->m_scopeChain = d->m_scopeChain.objectValue()->m_scope;
     return eng_p->toPublic(result);
 }
 
@@ -52,6 +52,7 @@
 #include "qscriptnodepool_p.h"
 #include "qscriptcompiler_p.h"
 #include "qscriptextenumeration_p.h"
+#include "qscriptinlinecache_p.h"
 
 #include <math.h> // floor & friends...
 
@@ -107,10 +108,10 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
 {
     if (v.isNumber()) {
         quint32 ui = v.toUInt32();
-        if (qsreal(ui) == v.m_number_value)
+        if (qsreal(ui) == v.numberValue())
             return ui;
     } else if (v.isString()) {
-        QByteArray bytes = v.m_string_value->s.toUtf8();
+        QByteArray bytes = v.stringValue()->string().toUtf8();
         char *eptr;
         quint32 pos = strtoul(bytes.constData(), &eptr, 10);
         if ((eptr == bytes.constData() + bytes.size())
@@ -128,7 +129,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
 
 #define BEGIN_PREFIX_OPERATOR \
     QScriptValue::ResolveFlags mode; \
-    mode = QScriptValue::ResolveFlags(stackPtr[0].m_int_value) \
+    mode = QScriptValue::ResolveFlags(stackPtr[0].intValue()) \
     | QScriptValue::ResolvePrototype; \
     --stackPtr; \
     QScriptValueImpl object = eng->toObject(stackPtr[-1]); \
@@ -138,8 +139,8 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         HandleException(); \
     } \
     QScriptNameIdImpl *memberName = 0; \
-    if (stackPtr[0].isString() && stackPtr[0].m_string_value->unique) \
-        memberName = stackPtr[0].m_string_value; \
+    if (stackPtr[0].isString() && stackPtr[0].stringValue()->unique) \
+        memberName = stackPtr[0].stringValue(); \
     else \
         memberName = eng->nameId(stackPtr[0].toString(), /*persistent=*/false); \
     QScript::Member member; \
@@ -147,7 +148,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
     QScriptValueImpl value; \
     QScriptValueImpl getter; \
     QScriptValueImpl setter; \
-    const bool isMemberAssignment = (object.m_object_value != m_scopeChain.m_object_value); \
+    const bool isMemberAssignment = (object.objectValue() != m_scopeChain.objectValue()); \
     if (object.resolve(memberName, &member, &base, mode, QScript::ReadWrite)) {  \
         base.get(member, &value); \
         if (hasUncaughtException()) { \
@@ -156,7 +157,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         } else if (member.isGetterOrSetter()) { \
             if (member.isGetter()) { \
                 getter = value; \
-                if (!member.isSetter() && !base.m_object_value->findSetter(&member)) { \
+                if (!member.isSetter() && !base.objectValue()->findSetter(&member)) { \
                     stackPtr -= 2; \
                     throwError(QLatin1String("No setter defined")); \
                     HandleException(); \
@@ -165,7 +166,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
             } else { \
                 setter = value; \
                 QScript::Member tmp = member; \
-                if (!base.m_object_value->findGetter(&member)) { \
+                if (!base.objectValue()->findGetter(&member)) { \
                     stackPtr -= 2; \
                     throwError(QLatin1String("No getter defined")); \
                     HandleException(); \
@@ -198,7 +199,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         } \
     } else { \
         if (member.isWritable()) { \
-            if (isMemberAssignment && (base.m_object_value != object.m_object_value)) { \
+            if (isMemberAssignment && (base.objectValue() != object.objectValue())) { \
                 base = object; \
                 CREATE_MEMBER(base, memberName, &member, /*flags=*/0); \
             } \
@@ -219,7 +220,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         HandleException(); \
     } \
     QScriptValue::ResolveFlags mode; \
-    mode = QScriptValue::ResolveFlags(stackPtr[-1].m_int_value) \
+    mode = QScriptValue::ResolveFlags(stackPtr[-1].intValue()) \
            | QScriptValue::ResolvePrototype; \
     QScriptValueImpl object = eng->toObject(stackPtr[-3]); \
     if (! object.isValid()) { \
@@ -228,8 +229,8 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         HandleException(); \
     } \
     QScriptNameIdImpl *memberName = 0; \
-    if (stackPtr[-2].isString() && stackPtr[-2].m_string_value->unique) \
-        memberName = stackPtr[-2].m_string_value; \
+    if (stackPtr[-2].isString() && stackPtr[-2].stringValue()->unique) \
+        memberName = stackPtr[-2].stringValue(); \
     else \
         memberName = eng->nameId(stackPtr[-2].toString(), /*persistent=*/false); \
     QScriptValueImpl lhs; \
@@ -237,7 +238,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
     QScript::Member member; \
     QScriptValueImpl getter; \
     QScriptValueImpl setter; \
-    const bool isMemberAssignment = (object.m_object_value != m_scopeChain.m_object_value); \
+    const bool isMemberAssignment = (object.objectValue() != m_scopeChain.objectValue()); \
     if (object.resolve(memberName, &member, &base, mode, QScript::ReadWrite)) {  \
         base.get(member, &lhs); \
         if (hasUncaughtException()) { \
@@ -246,7 +247,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         } else if (member.isGetterOrSetter()) { \
             if (member.isGetter()) { \
                 getter = lhs; \
-                if (!member.isSetter() && !base.m_object_value->findSetter(&member)) { \
+                if (!member.isSetter() && !base.objectValue()->findSetter(&member)) { \
                     stackPtr -= 4; \
                     throwError(QLatin1String("No setter defined")); \
                     HandleException(); \
@@ -255,7 +256,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
             } else { \
                 setter = lhs; \
                 QScript::Member tmp = member; \
-                if (!base.m_object_value->findGetter(&member)) { \
+                if (!base.objectValue()->findGetter(&member)) { \
                     stackPtr -= 4; \
                     throwError(QLatin1String("No getter defined")); \
                     HandleException(); \
@@ -289,7 +290,7 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
         } \
     } else { \
         if (member.isWritable()) { \
-            if (isMemberAssignment && (base.m_object_value != object.m_object_value)) { \
+            if (isMemberAssignment && (base.objectValue() != object.objectValue())) { \
                 base = object; \
                 CREATE_MEMBER(base, memberName, &member, /*flags=*/0); \
             } \
@@ -302,15 +303,60 @@ static inline quint32 toArrayIndex(const QScriptValueImpl &v)
     } \
     ++iPtr;
 
+// a comparison followed by a BranchFalse; the offset is relative to the
+// BranchFalse
+#define COMPARE_AND_BRANCH_FALSE(__result__) \
+    QScriptValueImpl v1 = stackPtr[-1]; \
+    QScriptValueImpl v2 = stackPtr[0]; \
+    stackPtr -= 2; \
+    if (__result__) \
+        iPtr += 2; \
+    else \
+        iPtr += 1 + iPtr[1].operand[0].intValue();
+
+// Resolve, [Post]Incr or [Post]Decr, Pop of a number stored in the head
+// of the scope chain; anything else is left to the generic instructions
+#define UPDATE_LOCAL(__delta__) \
+    QScriptNameIdImpl *memberName = iPtr->operand[0].stringValue(); \
+    QScriptObject *instance = m_scopeChain.objectValue(); \
+    QScript::Member member; \
+    if (! instance->findMember(memberName, &member) || ! member.isObjectProperty() \
+        || member.isGetterOrSetter() || ! member.isWritable()) { \
+        Fallback(Resolve); \
+    } \
+    QScriptValueImpl value; \
+    instance->get(member, &value); \
+    if (! value.isNumber()) \
+        Fallback(Resolve); \
+    instance->put(member, QScriptValueImpl(value.numberValue() + (__delta__))); \
+    iPtr += 3;
+
 namespace QScript {
 
 void ScriptFunction::execute(QScriptContextPrivate *context)
 {
+    if (! m_compiledCode)
+        m_compiledCode = m_astPool->compiledCode(m_definition->body);
+
+    if (! m_compiledCode && m_astPool->isRestored()) {
+        // the function has no statements to compile
+        context->throwError(QLatin1String("could not load the code of a cached function"));
+        return;
+    }
+
     if (! m_compiledCode) {
+        // the body may only have been checked for syntax errors so far
+        AST::FunctionExpression *definition = m_astPool->parsedFunction(m_definition);
+        if (! definition) {
+            context->throwError(QLatin1String("could not parse the body of the function"));
+            return;
+        }
+
         QScriptEnginePrivate *eng = context->engine();
         Compiler compiler(eng);
+        compiler.setKeepLines(m_astPool->keepsLines());
 
-        CompilationUnit unit = compiler.compile(m_definition->body, formals);
+        CompilationUnit unit = compiler.compile(definition->body, formals);
         if (! unit.isValid()) {
             context->throwError(unit.errorMessage());
             return;
@@ -324,10 +370,17 @@ void ScriptFunction::execute(QScriptContextPrivate *context)
 
 QString ScriptFunction::toString(QScriptContextPrivate *) const
 {
-    QString str;
+    QString str = m_astPool->functionText(m_definition);
+    if (! str.isNull())
+        return str;
+
+    AST::FunctionExpression *definition = m_astPool->parsedFunction(m_definition);
+    if (! definition)
+        definition = m_definition;
+
     QTextStream out(&str, QIODevice::WriteOnly);
     PrettyPretty pp(out);
-    pp(m_definition, /*indent=*/ 0);
+    pp(definition, /*indent=*/ 0);
     return str;
 }
 
@@ -388,7 +441,7 @@ bool QScriptContextPrivate::resolveField(QScriptEnginePrivate *eng,
         }
     }
 
-    QScriptNameIdImpl *nameId = m.isString() ? m.m_string_value : 0;
+    QScriptNameIdImpl *nameId = m.isString() ? m.stringValue() : 0;
 
     if (! nameId || ! nameId->unique)
         nameId = eng->nameId(QScriptEnginePrivate::convertToNativeString(m), /*persistent=*/false); // ### slow!
@@ -412,7 +465,7 @@ bool QScriptContextPrivate::resolveField(QScriptEnginePrivate *eng,
         if (member.isGetter()) {
             getter = *value;
         } else {
-            if (!base.m_object_value->findGetter(&member)) {
+            if (!base.objectValue()->findGetter(&member)) {
                 *value = eng->undefinedValue();
                 return true;
             }
@@ -430,6 +483,8 @@ void QScriptContextPrivate::execute(QScript::Code *code)
     int oldCurrentColumn = currentColumn;
     QScript::Code *oldCode = m_code;
     m_code = code;
+    if (code->capturesActivation)
+        m_activationCaptured = true;
 
 #ifndef Q_SCRIPT_NO_PRINT_GENERATED_CODE
     qout << QLatin1String("function:") << endl;
@@ -443,10 +498,25 @@ void QScriptContextPrivate::execute(QScript::Code *code)
 
     QScriptEnginePrivate *eng = engine();
 
+#ifdef Q_SCRIPT_OPCODE_STATISTICS
+    QScript::OpcodeStatistics *opcodeStatistics = eng->m_opcodeStatistics.isEnabled()
+                                                  ? &eng->m_opcodeStatistics : 0;
+#  define RecordOpcode() do { \
+        if (opcodeStatistics) \
+            opcodeStatistics->record(iPtr->op); \
+    } while (0)
+#else
+#  define RecordOpcode()
+#endif
+
     bool wasEvaluating = eng->m_evaluating;
     if (!wasEvaluating) {
         eng->setupProcessEvents();
         eng->resetAbortFlag();
+        // the profiler's ticks since the last evaluation are idle time,
+        // which doesn't belong to the first sample of this one
+        if (eng->m_sampleTicks)
+            eng->m_sampleTicks.fetchAndStoreRelaxed(0);
     }
     eng->m_evaluating = true;
 
@@ -477,6 +547,8 @@ void QScriptContextPrivate::execute(QScript::Code *code)
 #  define Done() goto Ldone
 #  define HandleException() goto Lhandle_exception
 #  define Abort() goto Labort
+#  define Fallback(opc) goto Lgeneric_##opc
+#  define CountHotness()
 
 Lfetch:
 
@@ -484,10 +556,15 @@ Lfetch:
 #else
 
 #  define I(opc) qscript_execute_##opc
-#  define Next() goto *iPtr->code
+#  ifdef Q_SCRIPT_OPCODE_STATISTICS
+#    define Next() do { RecordOpcode(); goto *iPtr->code; } while (0)
+#  else
+#    define Next() goto *iPtr->code
+#  endif
 #  define Done() goto Ldone
 #  define HandleException() goto Lhandle_exception
 #  define Abort() goto Labort
+#  define Fallback(opc) goto Lgeneric_##opc
 
     static void * const jump_table[] = {
 
@@ -505,8 +582,29 @@ Lfetch:
         code->optimized = true;
     }
 
+#  ifdef Q_SCRIPT_JIT
+    // once the code is hot, the instructions that have native code
+    // continue at Ljit_enter instead of their own label
+#    define CountHotness() do { \
+        if ((code->hotness < QScript::JitCode::HotnessThreshold) \
+            && (++code->hotness == QScript::JitCode::HotnessThreshold)) { \
+            code->jitCode = QScript::JitCode::compile(code); \
+            for (QScriptInstruction *current = code->firstInstruction; \
+                 code->jitCode && (current != code->lastInstruction); ++current) { \
+                if (code->jitCode->hasEntry(current)) \
+                    current->code = &&Ljit_enter; \
+            } \
+        } \
+    } while (0)
+#  else
+#    define CountHotness()
+#  endif
+
 #endif
+    CountHotness();
+
 Ltop:
+    RecordOpcode();
 
 #ifndef Q_SCRIPT_DIRECT_CODE
     switch (iPtr->op) {
@@ -563,6 +661,7 @@ Ltop:
     }   Next();
 
     I(LoadNumber):
+    Lgeneric_LoadNumber:
     {
         CHECK_TEMPSTACK(1);
         *++stackPtr = iPtr->operand[0];
@@ -580,7 +679,7 @@ Ltop:
     I(NewString):
     {
         CHECK_TEMPSTACK(1);
-        eng->newNameId(++stackPtr, iPtr->operand[0].m_string_value);
+        eng->newNameId(++stackPtr, iPtr->operand[0].stringValue());
         ++iPtr;
     }   Next();
 
@@ -603,7 +702,7 @@ Ltop:
     
     I(Receive):
     {
-        int n = iPtr->operand[0].m_int_value;
+        int n = iPtr->operand[0].intValue();
 
         if (n >= argc) {
             throwError(QLatin1String("invalid argument"));
@@ -616,15 +715,23 @@ Ltop:
     }   Next();
 
     I(Fetch):
+    Lgeneric_Fetch:
     {
         CHECK_TEMPSTACK(1);
 
-        QScriptNameIdImpl *memberName = iPtr->operand[0].m_string_value;
+        QScriptNameIdImpl *memberName = iPtr->operand[0].stringValue();
 
         QScriptValueImpl base;
         QScript::Member member;
 
-        QScriptObject *instance = m_scopeChain.m_object_value;
+        QScriptObject *instance = m_scopeChain.objectValue();
+        QScript::InlineCache *cache = &code->inlineCaches[iPtr->inlineCache];
+        if (QScriptObject *holder = cache->lookup(instance, memberName, QScript::InlineCache::ScopeLink, &member)) {
+            holder->get(member, ++stackPtr);
+            ++iPtr;
+            Next();
+        }
+
         if (instance->findMember(memberName, &member)) {
             instance->get(member, ++stackPtr);
             base = m_scopeChain;
@@ -640,13 +747,17 @@ Ltop:
                 HandleException();
             }
         }
+        if (member.isObjectProperty() && ! member.isGetterOrSetter()) {
+            cache->update(instance, memberName, QScript::InlineCache::ScopeLink,
+                          base.objectValue(), member, eng->idTable()->id___proto__);
+        }
         if (member.isGetterOrSetter()) {
             // locate the getter function
             QScriptValueImpl getter;
             if (member.isGetter()) {
                 getter = *stackPtr;
             } else {
-                if (!base.m_object_value->findGetter(&member)) {
+                if (!base.objectValue()->findGetter(&member)) {
                     stackPtr -= 1;
                     throwError(QLatin1String("No getter defined"));
                     HandleException();
@@ -671,6 +782,7 @@ Ltop:
     }   Next();
 
     I(Resolve):
+    Lgeneric_Resolve:
     {
         Q_ASSERT(iPtr->operand[0].isString());
 
@@ -686,18 +798,35 @@ Ltop:
         Q_ASSERT(stackPtr[-1].isReference());
 
         const QScriptValueImpl &object = stackPtr[-3];
-        QScriptNameIdImpl *memberName = stackPtr[-2].m_string_value;
+        QScriptNameIdImpl *memberName = stackPtr[-2].stringValue();
         const QScriptValueImpl &value = stackPtr[0];
 
         QScript::Member member;
         QScriptValueImpl base;
 
-        if (! object.resolve(memberName, &member, &base, QScriptValue::ResolveLocal, QScript::Write)) {
-            base = object;
-            CREATE_MEMBER(base, memberName, &member, /*flags=*/0);
-        }
+        QScriptObject *instance = object.objectValue();
+        QScript::InlineCache *cache = &code->inlineCaches[iPtr->inlineCache];
+        QScript::Shape *transition;
+
+        if (cache->lookup(instance, memberName, QScript::InlineCache::PrototypeLink, &member) == instance) {
+            instance->put(member, value);
+        } else if ((transition = cache->lookupTransition(instance, memberName)) != 0) {
+            instance->addMember(transition, &member);
+            eng->adjustBytesAllocated(sizeof(QScript::Member) + sizeof(QScriptValueImpl));
+            instance->put(member, value);
+        } else {
+            if (! object.resolve(memberName, &member, &base, QScriptValue::ResolveLocal, QScript::Write)) {
+                base = object;
+                QScript::Shape *oldShape = instance->shape();
+                CREATE_MEMBER(base, memberName, &member, /*flags=*/0);
+                cache->updateTransition(instance, memberName, oldShape, eng->idTable()->id___proto__);
+            } else if (base.objectValue() == instance) {
+                cache->update(instance, memberName, QScript::InlineCache::PrototypeLink,
+                              instance, member, eng->idTable()->id___proto__);
+            }
 
-        base.put(member, value);
+            base.put(member, value);
+        }
         stackPtr -= 4;
         if (hasUncaughtException())
             HandleException();
@@ -706,7 +835,7 @@ Ltop:
 
     I(Call):
     {
-        int argc = iPtr->operand[0].m_int_value;
+        int argc = iPtr->operand[0].intValue();
         QScriptValueImpl *argp = stackPtr - argc;
 
         QScriptValueImpl base;
@@ -758,32 +887,32 @@ Ltop:
             HandleException();
         }
 
+        // the callee can keep the object it's called on, which may be
+        // the activation or a scope object that refers to it
+        if ((base.objectValue() == m_scopeChain.objectValue())
+            || (base.objectValue() == m_activation.objectValue())) {
+            m_activationCaptured = true;
+        }
+
         QScriptContextPrivate *nested_data = eng->pushContext();
         nested_data->m_thisObject = base;
         nested_data->m_callee = callee;
 
         // create the activation
-        eng->newActivation(&nested_data->m_activation);
-        QScriptObject *activation_data = nested_data->m_activation.m_object_value;
+        eng->newActivation(nested_data, function);
+        QScriptObject *activation_data = nested_data->m_activation.objectValue();
 
         int formalCount = function->formals.count();
         int mx = qMax(formalCount, argc);
-        activation_data->m_members.resize(mx);
-        activation_data->m_values.resize(mx);
-        for (int i = 0; i < mx; ++i) {
-            QScriptNameIdImpl *nameId = 0;
-            if (i < formalCount)
-                nameId = function->formals.at(i);
-
-            activation_data->m_members[i].object(nameId, i,
-                                                 QScriptValue::Undeletable
-                                                 | QScriptValue::SkipInEnumeration);
+        activation_data->setShape(function->activationShape(activation_data->m_class, mx,
+                                                            QScriptValue::Undeletable
+                                                            | QScriptValue::SkipInEnumeration));
+        for (int i = 0; i < mx; ++i)
             activation_data->m_values[i] = (i < argc) ? argp[i + 1] : undefined;
-        }
 
         nested_data->argc = argc;
-        if (callee.m_object_value->m_scope.isValid())
-            activation_data->m_scope = callee.m_object_value->m_scope;
+        if (callee.objectValue()->m_scope.isValid())
+            activation_data->m_scope = callee.objectValue()->m_scope;
         else
             activation_data->m_scope = eng->m_globalObject;
         nested_data->tempStack = stackPtr;
@@ -831,36 +960,19 @@ Ltop:
     {
         CHECK_TEMPSTACK(1);
 
-        QString pattern = eng->toString(iPtr->operand[0].m_string_value);
-#ifndef QT_NO_REGEXP
-        QString literal = pattern;
-#endif
+        QString pattern = eng->toString(iPtr->operand[0].stringValue());
         int flags = 0;
-        if (iPtr->operand[1].isValid()) {
-            flags = iPtr->operand[1].m_int_value;
-#ifndef QT_NO_REGEXP
-            if (flags != 0) {
-                literal += QLatin1Char('/');
-                literal += QString::number(flags);
-            }
-#endif
-        }
+        if (iPtr->operand[1].isValid())
+            flags = iPtr->operand[1].intValue();
 
-#ifndef QT_NO_REGEXP
-        QRegExp rx;
         // lazy compilation of regexp literals
-        QHash<QString, QRegExp>::const_iterator it;
-        it = eng->m_regExpLiterals.constFind(literal);
-        if (it == eng->m_regExpLiterals.constEnd()) {
-            rx = QScript::Ecma::RegExp::toRegExp(pattern, flags);
-            eng->m_regExpLiterals.insert(literal, rx);
-        } else {
-            rx = *it;
+        QString errorMessage;
+        QScript::RegExpProgram *program = eng->regexpConstructor->compiledRegExp(pattern, flags, &errorMessage);
+        if (! program) {
+            throwSyntaxError(errorMessage);
+            HandleException();
         }
-        eng->regexpConstructor->newRegExp(++stackPtr, rx, flags);
-#else
-        eng->regexpConstructor->newRegExp(++stackPtr, pattern, flags);
-#endif
+        eng->regexpConstructor->newRegExp(++stackPtr, pattern, flags, program);
         ++iPtr;
     }   Next();
 
@@ -873,7 +985,7 @@ Ltop:
 
     I(New):
     {
-        int argc = iPtr->operand[0].m_int_value;
+        int argc = iPtr->operand[0].intValue();
         QScriptValueImpl *argp = stackPtr - argc;
 
         // QScriptValueImpl base;
@@ -930,35 +1042,28 @@ Ltop:
         nested_data->m_calledAsConstructor = true;
 
         // create the activation
-        eng->newActivation(&nested_data->m_activation);
-        QScriptObject *activation_data = nested_data->m_activation.m_object_value;
+        eng->newActivation(nested_data, function);
+        QScriptObject *activation_data = nested_data->m_activation.objectValue();
 
         int formalCount = function->formals.count();
         int mx = qMax(formalCount, argc);
-        activation_data->m_members.resize(mx);
-        activation_data->m_values.resize(mx);
-        for (int i = 0; i < mx; ++i) {
-            QScriptNameIdImpl *nameId = 0;
-            if (i < formalCount)
-                nameId = function->formals.at(i);
-
-            activation_data->m_members[i].object(nameId, i,
-                                                 QScriptValue::Undeletable
-                                                 | QScriptValue::SkipInEnumeration);
+        activation_data->setShape(function->activationShape(activation_data->m_class, mx,
+                                                            QScriptValue::Undeletable
+                                                            | QScriptValue::SkipInEnumeration));
+        for (int i = 0; i < mx; ++i)
             activation_data->m_values[i] = (i < argc) ? argp[i + 1] : undefined;
-        }
 
         eng->objectConstructor->newObject(&nested_data->m_thisObject);
         nested_data->argc = argc;
-        if (callee.m_object_value->m_scope.isValid())
-            activation_data->m_scope = callee.m_object_value->m_scope;
+        if (callee.objectValue()->m_scope.isValid())
+            activation_data->m_scope = callee.objectValue()->m_scope;
         else
             activation_data->m_scope = eng->m_globalObject;
         nested_data->tempStack = stackPtr;
         nested_data->args = &argp[1];
         nested_data->m_result = undefined;
 
-        QScriptObject *instance = nested_data->m_thisObject.m_object_value;
+        QScriptObject *instance = nested_data->m_thisObject.objectValue();
 
         // set [[prototype]]
         QScriptValueImpl dummy;
@@ -1005,6 +1110,7 @@ Ltop:
     }   Next();
 
     I(FetchField):
+    Lgeneric_FetchField:
     {
         QScriptValueImpl object = eng->toObject(stackPtr[-1]);
         if (! object.isValid()) {
@@ -1017,7 +1123,7 @@ Ltop:
 
         QScript::Ecma::Array::Instance *arrayInstance = 0;
         if (object.classInfo() == eng->arrayConstructor->classInfo())
-            arrayInstance = static_cast<QScript::Ecma::Array::Instance *> (object.m_object_value->m_data);
+            arrayInstance = static_cast<QScript::Ecma::Array::Instance *> (object.objectValue()->m_data);
 
         if (arrayInstance) {
             quint32 pos = toArrayIndex(m);
@@ -1031,13 +1137,13 @@ Ltop:
             }
         }
 
-        QScriptNameIdImpl *nameId = m.isString() ? m.m_string_value : 0;
+        QScriptNameIdImpl *nameId = m.isString() ? m.stringValue() : 0;
 
         if (! nameId || ! nameId->unique) {
             QString str;
 
             if (m.isNumber())
-                qscript_uint_to_string(m.m_number_value, str);
+                qscript_uint_to_string(m.numberValue(), str);
 
             if (str.isEmpty())
                 str = QScriptEnginePrivate::convertToNativeString(m);
@@ -1048,7 +1154,18 @@ Ltop:
         QScript::Member member;
         QScriptValueImpl base;
 
+        QScript::InlineCache *cache = &code->inlineCaches[iPtr->inlineCache];
+        if (QScriptObject *holder = cache->lookup(object.objectValue(), nameId, QScript::InlineCache::PrototypeLink, &member)) {
+            holder->get(member, --stackPtr);
+            ++iPtr;
+            Next();
+        }
+
         if (object.resolve(nameId, &member, &base, QScriptValue::ResolvePrototype, QScript::Read)) {
+            if (member.isObjectProperty() && ! member.isGetterOrSetter()) {
+                cache->update(object.objectValue(), nameId, QScript::InlineCache::PrototypeLink,
+                              base.objectValue(), member, eng->idTable()->id___proto__);
+            }
             base.get(member, --stackPtr);
             if (hasUncaughtException()) {
                 stackPtr -= 1;
@@ -1059,7 +1176,7 @@ Ltop:
                 if (member.isGetter()) {
                     getter = *stackPtr;
                 } else {
-                    if (!base.m_object_value->findGetter(&member)) {
+                    if (!base.objectValue()->findGetter(&member)) {
                         stackPtr -= 1;
                         throwError(QLatin1String("No getter defined"));
                         HandleException();
@@ -1101,8 +1218,8 @@ Ltop:
     {
         QScriptValueImpl &act = m_activation;
 
-        QScriptNameIdImpl *memberName = iPtr->operand[0].m_string_value;
-        bool readOnly = iPtr->operand[1].m_int_value != 0;
+        QScriptNameIdImpl *memberName = iPtr->operand[0].stringValue();
+        bool readOnly = iPtr->operand[1].intValue() != 0;
         QScript::Member member;
         QScriptValueImpl object;
 
@@ -1125,7 +1242,7 @@ Ltop:
         }
 
         QScriptValue::ResolveFlags mode;
-        mode = QScriptValue::ResolveFlags(stackPtr[-1].m_int_value)
+        mode = QScriptValue::ResolveFlags(stackPtr[-1].intValue())
                | QScriptValue::ResolvePrototype;
 
         QScriptValueImpl object = eng->toObject(stackPtr[-3]);
@@ -1146,38 +1263,72 @@ Ltop:
 
         stackPtr -= 3;
 
-        if (pos != 0xFFFFFFFF)
+        if (pos != 0xFFFFFFFF) {
+            object.objectValue()->aboutToChange();
             arrayInstance->value.assign(pos, value);
+            object.objectValue()->writeBarrier(value);
+        }
 
         else {
             QScriptNameIdImpl *memberName;
 
-            if (m.isString() && m.m_string_value->unique)
-                memberName = m.m_string_value;
+            if (m.isString() && m.stringValue()->unique)
+                memberName = m.stringValue();
             else
                 memberName = eng->nameId(QScriptEnginePrivate::convertToNativeString(m), /*persistent=*/false);
 
             QScriptValueImpl base;
             QScript::Member member;
 
-            const bool isMemberAssignment = (object.m_object_value != m_scopeChain.m_object_value);
+            const bool isMemberAssignment = (object.objectValue() != m_scopeChain.objectValue());
+
+            if (value.isString() && ! value.stringValue()->unique)
+                eng->newNameId(&value, value.stringValue()->string());
+
+            QScriptObject *instance = object.objectValue();
+            QScript::InlineCache *cache = &code->inlineCaches[iPtr->inlineCache];
+            const QScript::InlineCache::Link link = isMemberAssignment
+                                                    ? QScript::InlineCache::PrototypeLink
+                                                    : QScript::InlineCache::ScopeLink;
+
+            QScriptObject *holder = cache->lookup(instance, memberName, link, &member);
+            if (holder && member.isWritable() && (! isMemberAssignment || (holder == instance))) {
+                holder->put(member, value);
+                *stackPtr = value;
+                ++iPtr;
+                Next();
+            } else if (isMemberAssignment) {
+                if (QScript::Shape *transition = cache->lookupTransition(instance, memberName)) {
+                    instance->addMember(transition, &member);
+                    eng->adjustBytesAllocated(sizeof(QScript::Member) + sizeof(QScriptValueImpl));
+                    instance->put(member, value);
+                    *stackPtr = value;
+                    ++iPtr;
+                    Next();
+                }
+            }
+
             if (! object.resolve(memberName, &member, &base, mode, QScript::Write)) {
                 if (isMemberAssignment)
                     base = object;
                 else
                     base = eng->m_globalObject;
 
+                QScript::Shape *oldShape = base.objectValue()->shape();
                 CREATE_MEMBER(base, memberName, &member, /*flags=*/0);
+                if (isMemberAssignment)
+                    cache->updateTransition(instance, memberName, oldShape, eng->idTable()->id___proto__);
+            } else if (member.isObjectProperty() && member.isWritable() && ! member.isGetterOrSetter()
+                       && (! isMemberAssignment || (base.objectValue() == instance))) {
+                cache->update(instance, memberName, link, base.objectValue(),
+                              member, eng->idTable()->id___proto__);
             }
 
-            if (value.isString() && ! value.m_string_value->unique)
-                eng->newNameId(&value, value.m_string_value->s);
-
             if (member.isGetterOrSetter()) {
                 // find and call setter(value)
                 QScriptValueImpl setter;
                 if (!member.isSetter()) {
-                    if (!base.m_object_value->findSetter(&member)) {
+                    if (!base.objectValue()->findSetter(&member)) {
                         stackPtr -= 1;
                         throwError(QLatin1String("no setter defined"));
                         HandleException();
@@ -1204,7 +1355,7 @@ Ltop:
                     object = object.prototype();
 
                 if (member.isWritable()) {
-                    if (isMemberAssignment && (base.m_object_value != object.m_object_value)) {
+                    if (isMemberAssignment && (base.objectValue() != object.objectValue())) {
                         base = object;
                         CREATE_MEMBER(base, memberName, &member, /*flags=*/0);
                     }
@@ -1212,8 +1363,8 @@ Ltop:
                 } else if (member.isUninitializedConst()) {
                     base.put(member, value);
                     if (member.isObjectProperty()) {
-                        base.m_object_value->m_members[member.id()]
-                            .unsetFlags(QScript::Member::UninitializedConst);
+                        base.objectValue()->setMemberFlags(
+                            member, member.flags() & ~QScript::Member::UninitializedConst);
                     }
                 }
                 if (hasUncaughtException()) {
@@ -1335,10 +1486,20 @@ Ltop:
 
     I(Add):
     {
+        if (stackPtr[-1].isNumber() && stackPtr[0].isNumber()) {
+            const qsreal tmp = stackPtr[-1].numberValue() + stackPtr[0].numberValue();
+            *(--stackPtr) = QScriptValueImpl(tmp);
+            ++iPtr;
+            Next();
+        }
+
         QScriptValueImpl lhs = eng->toPrimitive(stackPtr[-1], QScriptValueImpl::NoTypeHint);
         QScriptValueImpl rhs = eng->toPrimitive(stackPtr[0], QScriptValueImpl::NoTypeHint);
 
-        if (lhs.isString() || rhs.isString()) {
+        if (lhs.type() == QScript::StringType) {
+            eng->newConcatenation(--stackPtr, lhs.stringValue(),
+                                  QScriptEnginePrivate::convertToNativeString(rhs));
+        } else if (lhs.isString() || rhs.isString()) {
             QString tmp = QScriptEnginePrivate::convertToNativeString(lhs);
             tmp += QScriptEnginePrivate::convertToNativeString(rhs);
             eng->newString(--stackPtr, tmp);
@@ -1456,17 +1617,20 @@ Ltop:
     I(Branch):
     {
         eng->maybeProcessEvents();
+        eng->maybeSample(this);
         if (hasUncaughtException())
             HandleException();
         if (eng->shouldAbort())
             Abort();
-        iPtr += iPtr->operand[0].m_int_value;
+        if (iPtr->operand[0].intValue() < 0)
+            CountHotness();
+        iPtr += iPtr->operand[0].intValue();
     }   Next();
 
     I(BranchFalse):
     {
         if (! QScriptEnginePrivate::convertToNativeBoolean(*stackPtr--))
-            iPtr += iPtr->operand[0].m_int_value;
+            iPtr += iPtr->operand[0].intValue();
         else
             ++iPtr;
     }   Next();
@@ -1474,7 +1638,7 @@ Ltop:
     I(BranchTrue):
     {
         if (eng->convertToNativeBoolean(*stackPtr--))
-            iPtr += iPtr->operand[0].m_int_value;
+            iPtr += iPtr->operand[0].intValue();
         else
             ++iPtr;
     }   Next();
@@ -1483,17 +1647,17 @@ Ltop:
     {
         CHECK_TEMPSTACK(1);
 
-        QScript::AST::FunctionExpression *expr = static_cast<QScript::AST::FunctionExpression *> (iPtr->operand[0].m_ptr_value);
+        QScript::AST::FunctionExpression *expr = static_cast<QScript::AST::FunctionExpression *> (iPtr->operand[0].pointerValue());
 
 #ifndef Q_SCRIPT_NO_JOINED_FUNCTION
         if (QScript::Code *code = eng->findCode(functionBody)) {
             QScriptValueImpl value = code->value;
 
             if (isValid(value)) {
-                QScriptObject *instance = value.m_object_value;
+                QScriptObject *instance = value.objectValue();
                 Q_ASSERT(instance != 0);
 
-                if (instance->m_scope.m_object_value == m_scopeChain.m_object_value)
+                if (instance->m_scope.objectValue() == m_scopeChain.objectValue())
                 {
                     *++stackPtr = value;
                     ++iPtr;
@@ -1513,7 +1677,7 @@ Ltop:
 
         eng->functionConstructor->newFunction(++stackPtr, function);
 
-        QScriptObject *instance = stackPtr->m_object_value;
+        QScriptObject *instance = stackPtr->objectValue();
         // initialize [[scope]]
         instance->m_scope = m_scopeChain;
 
@@ -1575,7 +1739,7 @@ Ltop:
         }
 
         QScriptValue::ResolveFlags mode;
-        mode = QScriptValue::ResolveFlags(stackPtr[0].m_int_value)
+        mode = QScriptValue::ResolveFlags(stackPtr[0].intValue())
                | QScriptValue::ResolvePrototype;
 
         --stackPtr;
@@ -1588,21 +1752,21 @@ Ltop:
         }
 
         QScriptNameIdImpl *memberName = 0;
-        if (stackPtr[0].isString() && stackPtr[0].m_string_value->unique)
-            memberName = stackPtr[0].m_string_value;
+        if (stackPtr[0].isString() && stackPtr[0].stringValue()->unique)
+            memberName = stackPtr[0].stringValue();
         else
             memberName = eng->nameId(stackPtr[0].toString(), /*persistent=*/false);
 
         QScript::Member member;
         QScriptValueImpl base;
         QScriptValueImpl value;
-        QScriptObject *instance = object.m_object_value;
-        const bool isMemberAssignment = (instance != m_scopeChain.m_object_value);
+        QScriptObject *instance = object.objectValue();
+        const bool isMemberAssignment = (instance != m_scopeChain.objectValue());
         if (instance->findMember(memberName, &member)) {
             if (!member.isGetterOrSetter()) {
                 QScriptValueImpl &r = instance->reference(member);
                 if (r.isNumber()) {
-                    *(--stackPtr) = QScriptValueImpl(r.m_number_value);
+                    *(--stackPtr) = QScriptValueImpl(r.numberValue());
                     r.incr();
                     ++iPtr;
                     Next();
@@ -1629,7 +1793,7 @@ Ltop:
         } else if (member.isGetterOrSetter()) {
             if (member.isGetter()) {
                 getter = value;
-                if (!member.isSetter() && !base.m_object_value->findSetter(&member)) {
+                if (!member.isSetter() && !base.objectValue()->findSetter(&member)) {
                     stackPtr -= 2;
                     throwError(QLatin1String("No setter defined"));
                     HandleException();
@@ -1638,7 +1802,7 @@ Ltop:
             } else {
                 setter = value;
                 QScript::Member tmp = member;
-                if (!base.m_object_value->findGetter(&member)) {
+                if (!base.objectValue()->findGetter(&member)) {
                     stackPtr -= 2;
                     throwError(QLatin1String("No getter defined"));
                     HandleException();
@@ -1664,7 +1828,7 @@ Ltop:
                 Done();
             }
         } else {
-            if (isMemberAssignment && (base.m_object_value != object.m_object_value)) {
+            if (isMemberAssignment && (base.objectValue() != object.objectValue())) {
                 base = object;
                 CREATE_MEMBER(base, memberName, &member, /*flags=*/0);
             }
@@ -1691,7 +1855,7 @@ Ltop:
             HandleException();
         }
 
-        QScriptValue::ResolveFlags mode = QScriptValue::ResolveFlags(stackPtr[0].m_int_value)
+        QScriptValue::ResolveFlags mode = QScriptValue::ResolveFlags(stackPtr[0].intValue())
                                           | QScriptValue::ResolvePrototype;
 
         --stackPtr;
@@ -1704,21 +1868,21 @@ Ltop:
         }
 
         QScriptNameIdImpl *memberName = 0;
-        if (stackPtr[0].isString() && stackPtr[0].m_string_value->unique)
-            memberName = stackPtr[0].m_string_value;
+        if (stackPtr[0].isString() && stackPtr[0].stringValue()->unique)
+            memberName = stackPtr[0].stringValue();
         else
             memberName = eng->nameId(stackPtr[0].toString(), /*persistent=*/false);
 
         QScript::Member member;
         QScriptValueImpl base;
         QScriptValueImpl value;
-        QScriptObject *instance = object.m_object_value;
-        const bool isMemberAssignment = (instance != m_scopeChain.m_object_value);
+        QScriptObject *instance = object.objectValue();
+        const bool isMemberAssignment = (instance != m_scopeChain.objectValue());
         if (instance->findMember(memberName, &member)) {
             if (!member.isGetterOrSetter()) {
                 QScriptValueImpl &r = instance->reference(member);
                 if (r.isNumber()) {
-                    *(--stackPtr) = QScriptValueImpl(r.m_number_value);
+                    *(--stackPtr) = QScriptValueImpl(r.numberValue());
                     r.decr();
                     ++iPtr;
                     Next();
@@ -1745,7 +1909,7 @@ Ltop:
         } else if (member.isGetterOrSetter()) {
             if (member.isGetter()) {
                 getter = value;
-                if (!member.isSetter() && !base.m_object_value->findSetter(&member)) {
+                if (!member.isSetter() && !base.objectValue()->findSetter(&member)) {
                     stackPtr -= 2;
                     throwError(QLatin1String("No setter defined"));
                     HandleException();
@@ -1754,7 +1918,7 @@ Ltop:
             } else {
                 setter = value;
                 QScript::Member tmp = member;
-                if (!base.m_object_value->findGetter(&member)) {
+                if (!base.objectValue()->findGetter(&member)) {
                     stackPtr -= 2;
                     throwError(QLatin1String("No getter defined"));
                     HandleException();
@@ -1780,7 +1944,7 @@ Ltop:
                 Done();
             }
         } else {
-            if (isMemberAssignment && (base.m_object_value != object.m_object_value)) {
+            if (isMemberAssignment && (base.objectValue() != object.objectValue())) {
                 base = object;
                 CREATE_MEMBER(base, memberName, &member, /*flags=*/0);
             }
@@ -1805,10 +1969,10 @@ Ltop:
         lhs = eng->toPrimitive(lhs);
         rhs = eng->toPrimitive(rhs);
         if (lhs.isString() || rhs.isString()) {
-            if (lhs.isString() && !lhs.m_string_value->unique) {
-                lhs.m_string_value->s += QScriptEnginePrivate::convertToNativeString(rhs);
+            if (lhs.type() == QScript::StringType) {
+                const QString tmp = QScriptEnginePrivate::convertToNativeString(rhs);
                 stackPtr -= 3;
-                *stackPtr = lhs;
+                eng->newConcatenation(stackPtr, lhs.stringValue(), tmp);
             } else {
                 QString tmp = QScriptEnginePrivate::convertToNativeString(lhs);
                 tmp += QScriptEnginePrivate::convertToNativeString(rhs);
@@ -2034,12 +2198,13 @@ Ltop:
     {
         eng->maybeGC();
         eng->maybeProcessEvents();
+        eng->maybeSample(this);
         if (hasUncaughtException())
             HandleException();
         if (eng->shouldAbort())
             Abort();
-        currentLine = iPtr->operand[0].m_int_value;
-        currentColumn = iPtr->operand[1].m_int_value;
+        currentLine = iPtr->operand[0].intValue();
+        currentColumn = iPtr->operand[1].intValue();
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
         if (eng->shouldNotify()) {
             eng->notifyPositionChange(this);
@@ -2064,8 +2229,8 @@ Ltop:
                 object = eng->toObject(object);
 
             QScriptNameIdImpl *nameId = 0;
-            if (stackPtr[-1].isString() && stackPtr[-1].m_string_value->unique) {
-                nameId = stackPtr[-1].m_string_value;
+            if (stackPtr[-1].isString() && stackPtr[-1].stringValue()->unique) {
+                nameId = stackPtr[-1].stringValue();
             } else {
                 nameId = eng->nameId(QScriptEnginePrivate::convertToNativeString(stackPtr[-1]),
                                      /*persistent=*/false);
@@ -2085,14 +2250,14 @@ Ltop:
     I(NewEnumeration): {
         QScriptValueImpl e;
         QScriptValueImpl object = eng->toObject(stackPtr[0]);
-        eng->enumerationConstructor->newEnumeration(&e, object);
+        eng->enumerationConstructor()->newEnumeration(&e, object);
         *stackPtr = e;
         ++iPtr;
     }   Next();
 
 
     I(ToFirstElement): {
-        QScript::Ext::Enumeration::Instance *e = eng->enumerationConstructor->get(stackPtr[0]);
+        QScript::Ext::Enumeration::Instance *e = eng->enumerationConstructor()->get(stackPtr[0]);
         Q_ASSERT(e != 0);
         e->toFront();
         --stackPtr;
@@ -2101,7 +2266,7 @@ Ltop:
 
 
     I(HasNextElement): {
-        QScript::Ext::Enumeration::Instance *e = eng->enumerationConstructor->get(stackPtr[0]);
+        QScript::Ext::Enumeration::Instance *e = eng->enumerationConstructor()->get(stackPtr[0]);
         Q_ASSERT(e != 0);
         e->hasNext(this, stackPtr);
         ++iPtr;
@@ -2115,7 +2280,7 @@ Ltop:
             HandleException();
         }
 
-        QScript::Ext::Enumeration::Instance *e = eng->enumerationConstructor->get(stackPtr[-3]);
+        QScript::Ext::Enumeration::Instance *e = eng->enumerationConstructor()->get(stackPtr[-3]);
         if (! e) {
             throwTypeError(QLatin1String("QScript.VM.NextElement"));
             HandleException();
@@ -2171,7 +2336,7 @@ Ltop:
         }
         QScriptValueImpl withObject;
         eng->newObject(&withObject, object, eng->m_class_with);
-        withObject.m_object_value->m_scope = m_scopeChain;
+        withObject.objectValue()->m_scope = m_scopeChain;
         m_scopeChain = withObject;
         ++iPtr;
     }   Next();
@@ -2179,7 +2344,7 @@ Ltop:
     I(LeaveWith):
     {
         QScriptValueImpl withObject = m_scopeChain;
-        m_scopeChain = withObject.m_object_value->m_scope;
+        m_scopeChain = withObject.objectValue()->m_scope;
         ++iPtr;
     }   Next();
 
@@ -2189,10 +2354,10 @@ Ltop:
         QScriptValueImpl object;
         eng->newObject(&object, undefined); // ### prototype
         QScript::Member member;
-        CREATE_MEMBER(object, iPtr->operand[0].m_string_value, &member, /*flags=*/0);
+        CREATE_MEMBER(object, iPtr->operand[0].stringValue(), &member, /*flags=*/0);
         object.put(member, m_result);
         // make catch-object head of scopechain
-        object.m_object_value->m_scope = m_scopeChain;
+        object.objectValue()->m_scope = m_scopeChain;
         m_scopeChain = object;
 
         catching = true;
@@ -2203,7 +2368,7 @@ Ltop:
     {
         // remove catch-object from scopechain
         QScriptValueImpl object = m_scopeChain;
-        m_scopeChain = object.m_object_value->m_scope;
+        m_scopeChain = object.objectValue()->m_scope;
 
         catching = false;
         ++iPtr;
@@ -2217,6 +2382,150 @@ Ltop:
         ++iPtr;
     }   Next();
 
+    // superinstructions; see QScript::Optimizer
+
+    I(FetchLocalField):
+    {
+        // Fetch, LoadString, FetchField
+        CHECK_TEMPSTACK(2);
+
+        QScriptNameIdImpl *memberName = iPtr->operand[0].stringValue();
+        QScript::Member member;
+        QScriptObject *holder = code->inlineCaches[iPtr->inlineCache].lookup(
+            m_scopeChain.objectValue(), memberName, QScript::InlineCache::ScopeLink, &member);
+        if (! holder)
+            Fallback(Fetch);
+        holder->get(member, ++stackPtr);
+
+        const QScriptInstruction *field = iPtr + 1;
+        if (stackPtr->isObject()) {
+            holder = code->inlineCaches[field[1].inlineCache].lookup(
+                stackPtr->objectValue(), field->operand[0].stringValue(),
+                QScript::InlineCache::PrototypeLink, &member);
+            if (holder) {
+                holder->get(member, stackPtr);
+                iPtr += 3;
+                Next();
+            }
+        }
+
+        *++stackPtr = field->operand[0];
+        iPtr += 2;
+    }   Fallback(FetchField);
+
+    I(AddNumber):
+    {
+        // LoadNumber, Add
+        if (! stackPtr->isNumber())
+            Fallback(LoadNumber);
+        *stackPtr = QScriptValueImpl(stackPtr->numberValue() + iPtr->operand[0].numberValue());
+        iPtr += 2;
+    }   Next();
+
+    I(SubNumber):
+    {
+        qsreal v1 = QScriptEnginePrivate::convertToNativeDouble(*stackPtr);
+        *stackPtr = QScriptValueImpl(v1 - iPtr->operand[0].numberValue());
+        iPtr += 2;
+    }   Next();
+
+    I(MulNumber):
+    {
+        qsreal v1 = QScriptEnginePrivate::convertToNativeDouble(*stackPtr);
+        *stackPtr = QScriptValueImpl(v1 * iPtr->operand[0].numberValue());
+        iPtr += 2;
+    }   Next();
+
+    I(LessThanNumber):
+    {
+        QScriptValueImpl v1 = *stackPtr;
+        *stackPtr = QScriptValueImpl(lt_cmp(v1, iPtr->operand[0]));
+        iPtr += 2;
+    }   Next();
+
+    I(LessOrEqualNumber):
+    {
+        QScriptValueImpl v1 = *stackPtr;
+        *stackPtr = QScriptValueImpl(le_cmp(v1, iPtr->operand[0]));
+        iPtr += 2;
+    }   Next();
+
+    I(GreatThanNumber):
+    {
+        QScriptValueImpl v1 = *stackPtr;
+        *stackPtr = QScriptValueImpl(lt_cmp(iPtr->operand[0], v1));
+        iPtr += 2;
+    }   Next();
+
+    I(GreatOrEqualNumber):
+    {
+        QScriptValueImpl v1 = *stackPtr;
+        *stackPtr = QScriptValueImpl(le_cmp(iPtr->operand[0], v1));
+        iPtr += 2;
+    }   Next();
+
+    I(LessThanBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(lt_cmp(v1, v2))
+    }   Next();
+
+    I(LessOrEqualBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(le_cmp(v1, v2))
+    }   Next();
+
+    I(GreatThanBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(lt_cmp(v2, v1))
+    }   Next();
+
+    I(GreatOrEqualBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(le_cmp(v2, v1))
+    }   Next();
+
+    I(EqualBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(eq_cmp(v1, v2))
+    }   Next();
+
+    I(NotEqualBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(! eq_cmp(v1, v2))
+    }   Next();
+
+    I(StrictEqualBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(strict_eq_cmp(v1, v2))
+    }   Next();
+
+    I(StrictNotEqualBranchFalse):
+    {
+        COMPARE_AND_BRANCH_FALSE(! strict_eq_cmp(v1, v2))
+    }   Next();
+
+    I(IncrLocal):
+    {
+        UPDATE_LOCAL(1)
+    }   Next();
+
+    I(DecrLocal):
+    {
+        UPDATE_LOCAL(-1)
+    }   Next();
+
+#ifdef Q_SCRIPT_JIT
+Ljit_enter:
+    // the native code returns the first instruction it can't handle,
+    // which the interpreter executes itself
+#  ifdef Q_SCRIPT_OPCODE_STATISTICS
+    if (opcodeStatistics)
+        goto *jump_table[iPtr->op];
+#  endif
+    iPtr = code->jitCode->run(this, iPtr);
+    goto *jump_table[iPtr->op];
+#endif
+
 #ifndef Q_SCRIPT_DIRECT_CODE
     I(Dummy):
     { ; }
@@ -2234,7 +2543,7 @@ Ldone:
         if (catching) {
             // exception thrown in catch -- clean up scopechain
             QScriptValueImpl object = m_scopeChain;
-            m_scopeChain = object.m_object_value->m_scope;
+            m_scopeChain = object.objectValue()->m_scope;
             catching = false;
         }
 
@@ -2251,7 +2560,7 @@ Ldone:
                         --withLevel;
                         if (withLevel < 0) {
                             QScriptValueImpl withObject = m_scopeChain;
-                            m_scopeChain = withObject.m_object_value->m_scope;
+                            m_scopeChain = withObject.objectValue()->m_scope;
                         }
                     }
                 }
@@ -2270,7 +2579,7 @@ Ldone:
                 while ((m_scopeChain.classInfo() == eng->m_class_with)
                        && !m_scopeChain.internalValue().isValid()) {
                     QScriptValueImpl withObject = m_scopeChain;
-                    m_scopeChain = withObject.m_object_value->m_scope;
+                    m_scopeChain = withObject.objectValue()->m_scope;
                 }
             }
         }
@@ -2483,13 +2792,13 @@ bool QScriptContextPrivate::lt_cmp(QScriptValueImpl lhs, QScriptValueImpl rhs)
             return false;
 
         case QScript::NumberType:
-            return lhs.m_number_value < rhs.m_number_value;
+            return lhs.numberValue() < rhs.numberValue();
 
         case QScript::IntegerType:
-            return lhs.m_int_value < rhs.m_int_value;
+            return lhs.intValue() < rhs.intValue();
 
         case QScript::BooleanType:
-            return lhs.m_bool_value < rhs.m_bool_value;
+            return lhs.boolValue() < rhs.boolValue();
 
         default:
             break;
@@ -2500,7 +2809,7 @@ bool QScriptContextPrivate::lt_cmp_helper(QScriptValueImpl lhs, QScriptValueImpl
 {
 #endif
     if ((lhs.type() == rhs.type()) && (lhs.type() == QScript::StringType))
-        return lhs.m_string_value->s < rhs.m_string_value->s;
+        return lhs.stringValue()->string() < rhs.stringValue()->string();
 
     if (lhs.isObject())
         lhs = lhs.engine()->toPrimitive(lhs, QScriptValueImpl::NumberTypeHint);
@@ -2523,7 +2832,7 @@ bool QScriptContextPrivate::lt_cmp_helper(QScriptValueImpl lhs, QScriptValueImpl
 bool QScriptContextPrivate::le_cmp_helper(QScriptValueImpl lhs, QScriptValueImpl rhs)
 {
     if ((lhs.type() == rhs.type()) && (lhs.type() == QScript::StringType))
-        return lhs.m_string_value->s <= rhs.m_string_value->s;
+        return lhs.stringValue()->string() <= rhs.stringValue()->string();
 
     if (lhs.isObject())
         lhs = lhs.engine()->toPrimitive(lhs, QScriptValueImpl::NumberTypeHint);
@@ -2585,11 +2894,26 @@ QScriptContextPrivate *QScriptContextPrivate::exceptionHandlerContext() const
     return 0;
 }
 
+QScriptContextPrivate::~QScriptContextPrivate()
+{
+    delete q_ptr;
+}
+
+// the frames of the engine's stack are private contexts; the public
+// QScriptContext of a frame is only created once it's asked for, and
+// then kept with the frame. Whoever asks for it can get to the
+// activation through it
 QScriptContext *QScriptContextPrivate::get(QScriptContextPrivate *d)
 {
-    if (d)
-        return d->q_func();
-    return 0;
+    if (! d)
+        return 0;
+    d->m_activationCaptured = true;
+    if (! d->q_ptr) {
+        QScriptContext *q = new QScriptContext;
+        q->d_ptr = d;
+        d->q_ptr = q;
+    }
+    return d->q_func();
 }
 
 QT_END_NAMESPACE
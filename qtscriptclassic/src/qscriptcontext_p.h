@@ -80,6 +80,8 @@ inline QScriptContextPrivate::QScriptContextPrivate()
       catching(false),
       m_calledAsConstructor(false),
       calleeMetaIndex(0),
+      m_activationCaptured(true),
+      m_spareActivation(0),
       q_ptr(0)
 {
 }
@@ -98,11 +100,6 @@ inline const QScriptContextPrivate *QScriptContextPrivate::get(const QScriptCont
     return 0;
 }
 
-inline QScriptContext *QScriptContextPrivate::create()
-{
-    return new QScriptContext;
-}
-
 inline QScriptEnginePrivate *QScriptContextPrivate::engine() const
 {
     return m_activation.engine();
@@ -132,6 +129,7 @@ inline void QScriptContextPrivate::init(QScriptContextPrivate *parent)
     currentColumn = -1;
     errorLineNumber = -1;
     m_calledAsConstructor = false;
+    m_activationCaptured = true;
 }
 
 inline QScriptValueImpl QScriptContextPrivate::argument(int index) const
@@ -150,6 +148,7 @@ inline int QScriptContextPrivate::argumentCount() const
 
 inline QScriptValueImpl QScriptContextPrivate::argumentsObject() const
 {
+    m_activationCaptured = true; // the arguments object refers to it
     if (!m_arguments.isValid() && m_activation.isValid()) {
         QScriptContextPrivate *dd = const_cast<QScriptContextPrivate*>(this);
         engine()->newArguments(&dd->m_arguments, m_activation,
@@ -189,6 +188,9 @@ inline bool QScriptContextPrivate::isNumerical(const QScriptValueImpl &v)
 
 inline bool QScriptContextPrivate::eq_cmp(const QScriptValueImpl &lhs, const QScriptValueImpl &rhs)
 {
+    if (lhs.isNumber() && rhs.isNumber())
+        return lhs.numberValue() == rhs.numberValue();
+
     if (lhs.type() == rhs.type()) {
         switch (lhs.type()) {
         case QScript::InvalidType:
@@ -197,35 +199,35 @@ inline bool QScriptContextPrivate::eq_cmp(const QScriptValueImpl &lhs, const QSc
             return true;
 
         case QScript::NumberType:
-            return lhs.m_number_value == rhs.m_number_value;
+            return lhs.numberValue() == rhs.numberValue();
 
         case QScript::ReferenceType:
         case QScript::IntegerType:
-            return lhs.m_int_value == rhs.m_int_value;
+            return lhs.intValue() == rhs.intValue();
 
         case QScript::BooleanType:
-            return lhs.m_bool_value == rhs.m_bool_value;
+            return lhs.boolValue() == rhs.boolValue();
 
         case QScript::StringType:
-            if (lhs.m_string_value->unique && rhs.m_string_value->unique)
-                return lhs.m_string_value == rhs.m_string_value;
-            return lhs.m_string_value->s == rhs.m_string_value->s;
+            if (lhs.stringValue()->unique && rhs.stringValue()->unique)
+                return lhs.stringValue() == rhs.stringValue();
+            return lhs.stringValue()->string() == rhs.stringValue()->string();
 
         case QScript::PointerType:
-            return lhs.m_ptr_value == rhs.m_ptr_value;
+            return lhs.pointerValue() == rhs.pointerValue();
 
         case QScript::ObjectType:
             if (lhs.isVariant())
-                return lhs.m_object_value == rhs.m_object_value || lhs.toVariant() == rhs.toVariant();
+                return lhs.objectValue() == rhs.objectValue() || lhs.toVariant() == rhs.toVariant();
 #ifndef QT_NO_QOBJECT
             else if (lhs.isQObject())
-                return lhs.m_object_value == rhs.m_object_value || lhs.toQObject() == rhs.toQObject();
+                return lhs.objectValue() == rhs.objectValue() || lhs.toQObject() == rhs.toQObject();
 #endif
             else
-                return lhs.m_object_value == rhs.m_object_value;
+                return lhs.objectValue() == rhs.objectValue();
 
         case QScript::LazyStringType:
-            return *lhs.m_lazy_string_value == *rhs.m_lazy_string_value;
+            return *lhs.lazyStringValue() == *rhs.lazyStringValue();
         }
     }
 
@@ -234,6 +236,12 @@ inline bool QScriptContextPrivate::eq_cmp(const QScriptValueImpl &lhs, const QSc
 
 inline bool QScriptContextPrivate::strict_eq_cmp( const QScriptValueImpl &lhs, const QScriptValueImpl &rhs)
 {
+    if (lhs.isNumber() && rhs.isNumber()) {
+        if (qIsNaN(lhs.numberValue()) || qIsNaN(rhs.numberValue()))
+            return false;
+        return lhs.numberValue() == rhs.numberValue();
+    }
+
     if (lhs.type() != rhs.type())
         return false;
 
@@ -244,32 +252,32 @@ inline bool QScriptContextPrivate::strict_eq_cmp( const QScriptValueImpl &lhs, c
         return true;
 
     case QScript::NumberType:
-        if (qIsNaN(lhs.m_number_value) || qIsNaN(rhs.m_number_value))
+        if (qIsNaN(lhs.numberValue()) || qIsNaN(rhs.numberValue()))
             return false;
-        return lhs.m_number_value == rhs.m_number_value;
+        return lhs.numberValue() == rhs.numberValue();
 
     case QScript::IntegerType:
-        return lhs.m_int_value == rhs.m_int_value;
+        return lhs.intValue() == rhs.intValue();
 
     case QScript::BooleanType:
-        return lhs.m_bool_value == rhs.m_bool_value;
+        return lhs.boolValue() == rhs.boolValue();
 
     case QScript::StringType:
-        if (lhs.m_string_value->unique && rhs.m_string_value->unique)
-            return lhs.m_string_value == rhs.m_string_value;
-        return lhs.m_string_value->s == rhs.m_string_value->s;
+        if (lhs.stringValue()->unique && rhs.stringValue()->unique)
+            return lhs.stringValue() == rhs.stringValue();
+        return lhs.stringValue()->string() == rhs.stringValue()->string();
 
     case QScript::ObjectType:
-        return lhs.m_object_value == rhs.m_object_value;
+        return lhs.objectValue() == rhs.objectValue();
 
     case QScript::ReferenceType:
-        return lhs.m_int_value == rhs.m_int_value;
+        return lhs.intValue() == rhs.intValue();
 
     case QScript::PointerType:
-        return lhs.m_ptr_value == rhs.m_ptr_value;
+        return lhs.pointerValue() == rhs.pointerValue();
 
     case QScript::LazyStringType:
-        return *lhs.m_lazy_string_value == *rhs.m_lazy_string_value;
+        return *lhs.lazyStringValue() == *rhs.lazyStringValue();
     }
 
     return false;
@@ -317,6 +325,7 @@ inline void QScriptContextPrivate::setReturnValue(const QScriptValueImpl &value)
 
 inline QScriptValueImpl QScriptContextPrivate::activationObject() const
 {
+    m_activationCaptured = true;
     if (previous && !m_activation.property(QLatin1String("arguments")).isValid()) {
         QScriptContextPrivate *dd = const_cast<QScriptContextPrivate*>(this);
         dd->m_activation.setProperty(QLatin1String("arguments"), argumentsObject());
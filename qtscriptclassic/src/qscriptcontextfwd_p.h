@@ -80,13 +80,12 @@ class QScriptContextPrivate
     Q_DECLARE_PUBLIC(QScriptContext)
 public:
     inline QScriptContextPrivate();
+    ~QScriptContextPrivate();
 
     static inline QScriptContextPrivate *get(QScriptContext *q);
     static inline const QScriptContextPrivate *get(const QScriptContext *q);
     static QScriptContext *get(QScriptContextPrivate *d);
 
-    static inline QScriptContext *create();
-
     inline QScriptEnginePrivate *engine() const;
     inline QScriptContextPrivate *parentContext() const;
 
@@ -115,6 +114,14 @@ public:
 #else
     static bool lt_cmp(const QScriptValueImpl &lhs, const QScriptValueImpl &rhs)
     {
+        if (lhs.isNumber() && rhs.isNumber()) {
+#if defined Q_CC_MSVC && !defined Q_CC_MSVC_NET
+            if (qIsNaN(lhs.numberValue()) || qIsNaN(rhs.numberValue()))
+                return false;
+#endif
+            return lhs.numberValue() < rhs.numberValue();
+        }
+
         if (lhs.type() == rhs.type()) {
             switch (lhs.type()) {
             case QScript::UndefinedType:
@@ -123,16 +130,16 @@ public:
 
             case QScript::NumberType:
 #if defined Q_CC_MSVC && !defined Q_CC_MSVC_NET
-                if (qIsNaN(lhs.m_number_value) || qIsNaN(rhs.m_number_value))
+                if (qIsNaN(lhs.numberValue()) || qIsNaN(rhs.numberValue()))
                     return false;
 #endif
-                return lhs.m_number_value < rhs.m_number_value;
+                return lhs.numberValue() < rhs.numberValue();
 
             case QScript::IntegerType:
-                return lhs.m_int_value < rhs.m_int_value;
+                return lhs.intValue() < rhs.intValue();
 
             case QScript::BooleanType:
-                return lhs.m_bool_value < rhs.m_bool_value;
+                return lhs.boolValue() < rhs.boolValue();
 
             default:
                 break;
@@ -147,6 +154,9 @@ public:
 
     static bool le_cmp(const QScriptValueImpl &lhs, const QScriptValueImpl &rhs)
     {
+        if (lhs.isNumber() && rhs.isNumber())
+            return lhs.numberValue() <= rhs.numberValue();
+
         if (lhs.type() == rhs.type()) {
             switch (lhs.type()) {
             case QScript::UndefinedType:
@@ -154,13 +164,13 @@ public:
                 return true;
 
             case QScript::NumberType:
-                return lhs.m_number_value <= rhs.m_number_value;
+                return lhs.numberValue() <= rhs.numberValue();
 
             case QScript::IntegerType:
-                return lhs.m_int_value <= rhs.m_int_value;
+                return lhs.intValue() <= rhs.intValue();
 
             case QScript::BooleanType:
-                return lhs.m_bool_value <= rhs.m_bool_value;
+                return lhs.boolValue() <= rhs.boolValue();
 
             default:
                 break;
@@ -247,6 +257,12 @@ public:
 
     int calleeMetaIndex;
 
+    // whether anything but the call itself may refer to the activation,
+    // and the activation the last call in this frame left for the next
+    // one when nothing could (see QScriptEnginePrivate::newActivation())
+    mutable bool m_activationCaptured;
+    QScriptObject *m_spareActivation;
+
     QScriptContext *q_ptr;
 };
 
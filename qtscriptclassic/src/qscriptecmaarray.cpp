@@ -202,6 +202,7 @@ bool ArrayClassData::put(QScriptValueImpl *object,
         return false;
 
     QScriptEnginePrivate *eng_p = object->engine();
+    object->objectValue()->aboutToChange();
 
     if (member.nameId() == eng_p->idTable()->id_length) {
         qsreal length = value.toNumber();
@@ -212,6 +213,7 @@ bool ArrayClassData::put(QScriptValueImpl *object,
     else if (member.nameId() == 0) {
         quint32 pos = quint32 (member.id());
         instance->value.assign(pos, value);
+        object->objectValue()->writeBarrier(value);
     }
 
     return true;
@@ -228,8 +230,10 @@ bool ArrayClassData::removeMember(const QScriptValueImpl &object,
         return false;
 
     quint32 pos = quint32 (member.id());
-    if (instance->value.at(pos).isValid())
+    if (instance->value.at(pos).isValid()) {
+        object.objectValue()->aboutToChange();
         instance->value.assign(pos, QScriptValueImpl());
+    }
     return true;
 }
 
@@ -432,7 +436,7 @@ QScriptValueImpl Array::method_concat(QScriptContextPrivate *context,
 
 QScriptValueImpl Array::method_join(QScriptContextPrivate *context,
                                     QScriptEnginePrivate *eng,
-                                    QScriptClassInfo *)
+                                    QScriptClassInfo *classInfo)
 {
     QScriptValueImpl arg = context->argument(0);
 
@@ -460,18 +464,46 @@ QScriptValueImpl Array::method_join(QScriptContextPrivate *context,
 
     QString R;
 
-    QScriptValueImpl r6 = self.property(QLatin1String("0"));
-    if (r6.isValid() && !(r6.isUndefined() || r6.isNull()))
-        R = r6.toString();
+    Instance *instance = Instance::get(self, classInfo);
+    if (instance && (instance->value.size() == r2)
+        && (instance->value.mode() == QScript::Array::Int32Mode)) {
+        const qint32 *elements = instance->value.int32Data();
+        R.reserve(int(r2) * (r4.length() + 4));
+        for (quint32 k = 0; k < r2; ++k) {
+            if (k != 0)
+                R += r4;
+            R += QString::number(elements[k]);
+        }
+        eng->visitedArrayElements.remove(self.objectValue());
+        return QScriptValueImpl(eng, R);
+    }
 
-    for (quint32 k = 1; k < r2; ++k) {
-        R += r4;
+    // convert the elements first, so that the result can be built in a
+    // buffer of the right size
+    QVector<QString> parts(r2);
+    int totalLength = r4.length() * int(r2 - 1);
+    for (quint32 k = 0; k < r2; ++k) {
+        QScriptValueImpl r12;
+        if (instance) {
+            r12 = instance->value.at(k);
+            if (! r12.isValid()) // the prototype may provide the element
+                r12 = self.property(k);
+        } else {
+            QScriptNameIdImpl *name = eng->nameId(QScriptValueImpl(k).toString());
+            r12 = self.property(name);
+        }
 
-        QScriptNameIdImpl *name = eng->nameId(QScriptValueImpl(k).toString());
-        QScriptValueImpl r12 = self.property(name);
+        if (r12.isValid() && ! (r12.isUndefined() || r12.isNull())) {
+            parts[k] = r12.toString();
+            totalLength += parts.at(k).length();
+        }
+    }
 
-        if (r12.isValid() && ! (r12.isUndefined() || r12.isNull()))
-            R += r12.toString();
+    R.reserve(totalLength);
+    for (quint32 k = 0; k < r2; ++k) {
+        if (k != 0)
+            R += r4;
+        R += parts.at(k);
     }
 
     eng->visitedArrayElements.remove(self.objectValue());
@@ -484,6 +516,7 @@ QScriptValueImpl Array::method_pop(QScriptContextPrivate *context,
 {
     QScriptValueImpl self = context->thisObject();
     if (Instance *instance = Instance::get(self, classInfo)) {
+        self.objectValue()->aboutToChange();
         QScriptValueImpl elt = instance->value.pop();
         if (! elt.isValid())
             elt = eng->undefinedValue();
@@ -514,6 +547,7 @@ QScriptValueImpl Array::method_push(QScriptContextPrivate *context,
 {
     QScriptValueImpl self = context->thisObject();
     if (Instance *instance = Instance::get(self, classInfo)) {
+        self.objectValue()->aboutToChange();
         uint pos = instance->value.size();
         for (int i = 0; i < context->argumentCount(); ++i) {
             QScriptValueImpl val = context->argument(i);
@@ -522,6 +556,7 @@ QScriptValueImpl Array::method_push(QScriptContextPrivate *context,
                 self.setProperty(eng->idTable()->id_length, 0);
             } else {
                 instance->value.assign(pos++, val);
+                self.objectValue()->writeBarrier(val);
             }
         }
         return QScriptValueImpl(pos);
@@ -546,14 +581,8 @@ QScriptValueImpl Array::method_reverse(QScriptContextPrivate *context,
 {
     QScriptValueImpl self = context->thisObject();
     if (Instance *instance = Instance::get(self, classInfo)) {
-        int lo = 0, hi = instance->value.count () - 1;
-
-        for (; lo < hi; ++lo, --hi) {
-            QScriptValueImpl tmp = instance->value.at(lo);
-            instance->value.assign(lo, instance->value.at(hi));
-            instance->value.assign(hi, tmp);
-        }
-
+        self.objectValue()->aboutToChange();
+        instance->value.reverse();
     } else {
         QScriptNameIdImpl *id_length = eng->idTable()->id_length;
 
@@ -657,7 +686,7 @@ QScriptValueImpl Array::method_shift(QScriptContextPrivate *context,
 
 QScriptValueImpl Array::method_slice(QScriptContextPrivate *context,
                                      QScriptEnginePrivate *eng,
-                                     QScriptClassInfo *)
+                                     QScriptClassInfo *classInfo)
 {
     QScript::Array result(eng);
 
@@ -674,6 +703,17 @@ QScriptValueImpl Array::method_slice(QScriptContextPrivate *context,
     qint32 r7 = end.isUndefined() ? r3 : qint32 (end.toInteger());
     quint32 r8 = r7 < 0 ? qMax(quint32(r3 + r7), quint32(0)) : qMin(quint32(r7), r3);
     quint32 n = 0;
+    if (Instance *instance = Instance::get(self, classInfo)) {
+        // copies the elements directly, so packed arrays stay packed
+        for (; k < r8; ++k) {
+            QScriptValueImpl v = instance->value.at(k);
+            if (! v.isValid())
+                v = self.property(k);
+            if (v.isValid())
+                result.assign(n++, v);
+        }
+        return eng->newArray(result);
+    }
     for (; k < r8; ++k) {
         QString r11 = QScriptValueImpl(k).toString();
         QScriptValueImpl v = self.property(r11);
@@ -690,6 +730,7 @@ QScriptValueImpl Array::method_sort(QScriptContextPrivate *context,
     QScriptValueImpl self = context->thisObject();
     QScriptValueImpl comparefn = context->argument(0);
     if (Instance *instance = Instance::get(self, classInfo)) {
+        self.objectValue()->aboutToChange();
         instance->value.sort(comparefn);
         return context->thisObject();
     }
@@ -712,9 +753,12 @@ QScriptValueImpl Array::method_splice(QScriptContextPrivate *context,
     QScriptValueImpl a = arrayCtor.construct();
 
     if (Instance *instance = Instance::get(self, classInfo)) {
+        self.objectValue()->aboutToChange();
         QVector<QScriptValueImpl> items;
-        for (int i = 2; i < context->argumentCount(); ++i)
+        for (int i = 2; i < context->argumentCount(); ++i) {
             items << context->argument(i);
+            self.objectValue()->writeBarrier(items.last());
+        }
         Instance *otherInstance = Instance::get(a, classInfo);
         Q_ASSERT(otherInstance);
         instance->value.splice(start, deleteCount, items, otherInstance->value);
@@ -86,6 +86,9 @@ void Core::addFunction(QScriptValueImpl &object, const QString &name,
                        QScriptInternalFunctionSignature fun, int length,
                        const QScriptValue::PropertyFlags flags)
 {
+    // the members are copied from the snapshot, if there is one
+    if (m_engine->isRestoringSnapshot())
+        return;
     QScriptValueImpl val = engine()->createFunction(fun, length, m_classInfo, name);
     object.setProperty(name, val, flags);
 }
@@ -170,6 +170,17 @@ void Function::initialize()
     addPrototypeFunction(QLatin1String("connect"), method_connect, 1);
     addPrototypeFunction(QLatin1String("disconnect"), method_disconnect, 1);
 
+    // the modes accepted by the third argument of connect()
+    QScriptValue::PropertyFlags flags = QScriptValue::Undeletable
+                                        | QScriptValue::ReadOnly
+                                        | QScriptValue::SkipInEnumeration;
+    ctor.setProperty(QLatin1String("NoCoalescing"),
+                     QScriptValueImpl(int(QScriptEnginePrivate::NoCoalescing)), flags);
+    ctor.setProperty(QLatin1String("CoalesceLatest"),
+                     QScriptValueImpl(int(QScriptEnginePrivate::CoalesceLatest)), flags);
+    ctor.setProperty(QLatin1String("CoalesceBatch"),
+                     QScriptValueImpl(int(QScriptEnginePrivate::CoalesceBatch)), flags);
+
     classInfo()->setData(new FunctionClassData(classInfo()));
 }
 
@@ -435,7 +446,29 @@ QScriptValueImpl Function::method_connect(QScriptContextPrivate *context, QScrip
             QLatin1String("Function.prototype.connect: target is not a function"));
     }
 
-    bool ok = eng->scriptConnect(self, receiver, slot, Qt::AutoConnection);
+    // an optional third argument, one of Function.NoCoalescing,
+    // Function.CoalesceLatest or Function.CoalesceBatch, asks for the
+    // emissions to be coalesced into one call per event loop turn
+    QScriptEnginePrivate::SignalCoalescing coalescing = QScriptEnginePrivate::NoCoalescing;
+    if (context->argumentCount() > 2) {
+        QScriptValueImpl mode = context->argument(2);
+        qsreal m = mode.isNumber() ? mode.toNumber() : -1;
+        if (m == QScriptEnginePrivate::NoCoalescing) {
+            coalescing = QScriptEnginePrivate::NoCoalescing;
+        } else if (m == QScriptEnginePrivate::CoalesceLatest) {
+            coalescing = QScriptEnginePrivate::CoalesceLatest;
+        } else if (m == QScriptEnginePrivate::CoalesceBatch) {
+            coalescing = QScriptEnginePrivate::CoalesceBatch;
+        } else {
+            return context->throwError(
+                QScriptContext::TypeError,
+                QString::fromLatin1("Function.prototype.connect: unknown coalescing mode `%0'; "
+                                    "use Function.CoalesceLatest or Function.CoalesceBatch")
+                .arg(mode.toString()));
+        }
+    }
+
+    bool ok = eng->scriptConnect(self, receiver, slot, Qt::AutoConnection, coalescing);
     if (!ok) {
         return context->throwError(
             QString::fromLatin1("Function.prototype.connect: failed to connect to %0::%1")
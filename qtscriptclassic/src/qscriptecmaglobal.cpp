@@ -559,6 +559,9 @@ void Global::addFunction(QScriptValueImpl &object, const QString &name,
                          const QScriptValue::PropertyFlags flags)
 {
     QScriptEnginePrivate *eng_p = object.engine();
+    // see QScript::EngineSnapshot::installObjects()
+    if (eng_p->isRestoringSnapshot())
+        return;
     QScriptValueImpl val = eng_p->createFunction(fun, length, object.classInfo(), name);
     object.setProperty(name, val, flags);
 }
@@ -0,0 +1,939 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptecmajson_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptcontext_p.h"
+#include "qscriptmember_p.h"
+#include "qscriptobject_p.h"
+#include "qscriptvalueiteratorimpl_p.h"
+
+#include <QVarLengthArray>
+#include <qnumeric.h>
+
+QT_BEGIN_NAMESPACE
+
+extern double qstrtod(const char *s00, char const **se, bool *ok);
+
+namespace QScript {
+
+extern QString numberToString(qsreal value);
+
+namespace Ecma {
+
+// how deeply JSON text, or a structure being serialized, may nest
+enum { JsonMaxDepth = 1024 };
+
+// keeps values reachable by the garbage collector while script code
+// (toJSON(), a replacer or a reviver) runs, by pushing them onto the
+// temp stack of the native call's frame, which markFrame() scans;
+// everything pushed is dropped when the roots go out of scope
+class JsonRoots
+{
+public:
+    inline JsonRoots(QScriptEnginePrivate *engine, QScriptContextPrivate *context)
+        : m_engine(engine), m_context(context), m_base(context->stackPtr)
+    { Q_ASSERT(m_base != 0); }
+    inline ~JsonRoots()
+    { pop(m_context->stackPtr - m_base); }
+
+    inline bool push(const QScriptValueImpl &value)
+    {
+        if (m_context->stackPtr + 1 >= m_engine->tempStackEnd) {
+            m_context->throwError(QScriptContext::RangeError,
+                                  QLatin1String("JSON: out of stack space"));
+            return false;
+        }
+        *++m_context->stackPtr = value;
+        return true;
+    }
+    inline void pop(int count = 1)
+    {
+        Q_ASSERT(m_context->stackPtr - count >= m_base);
+        for (int i = 0; i < count; ++i)
+            (m_context->stackPtr--)->invalidate();
+    }
+
+private:
+    QScriptEnginePrivate *m_engine;
+    QScriptContextPrivate *m_context;
+    QScriptValueImpl *m_base;
+};
+
+// reads JSON text in a single pass; objects and arrays are built as
+// their closing bracket is reached, and member names are looked up in
+// the engine's string table straight from the text
+class JsonParser
+{
+public:
+    JsonParser(QScriptEnginePrivate *engine, const QString &text);
+
+    bool parse(QScriptValueImpl *result);
+
+    inline QString errorMessage() const
+    { return m_errorMessage; }
+
+private:
+    bool parseValue(QScriptValueImpl *result);
+    bool parseObject(QScriptValueImpl *result);
+    bool parseArray(QScriptValueImpl *result);
+    bool parseString(QScriptValueImpl *result, QScriptNameIdImpl **nameId);
+    bool parseNumber(QScriptValueImpl *result);
+    bool parseLiteral(const char *literal);
+
+    inline void skipWhitespace();
+    inline bool at(char c) const
+    { return (m_pos < m_end) && (m_pos->unicode() == c); }
+    bool error(const QString &message);
+
+    QScriptEnginePrivate *m_engine;
+    const QChar *m_begin;
+    const QChar *m_pos;
+    const QChar *m_end;
+    int m_depth;
+    QString m_buffer;
+    QString m_errorMessage;
+};
+
+JsonParser::JsonParser(QScriptEnginePrivate *engine, const QString &text)
+    : m_engine(engine),
+      m_begin(text.constData()),
+      m_pos(m_begin),
+      m_end(m_begin + text.length()),
+      m_depth(0)
+{
+}
+
+bool JsonParser::parse(QScriptValueImpl *result)
+{
+    skipWhitespace();
+    if (! parseValue(result))
+        return false;
+    skipWhitespace();
+    if (m_pos != m_end)
+        return error(QLatin1String("unexpected character"));
+    return true;
+}
+
+inline void JsonParser::skipWhitespace()
+{
+    while (m_pos < m_end) {
+        const ushort c = m_pos->unicode();
+        if ((c != ' ') && (c != '\n') && (c != '\r') && (c != '\t'))
+            break;
+        ++m_pos;
+    }
+}
+
+bool JsonParser::error(const QString &message)
+{
+    m_errorMessage = QString::fromLatin1("JSON.parse: %0 at position %1")
+                     .arg(message).arg(m_pos - m_begin);
+    return false;
+}
+
+bool JsonParser::parseValue(QScriptValueImpl *result)
+{
+    if (m_pos == m_end)
+        return error(QLatin1String("unexpected end of input"));
+
+    switch (m_pos->unicode()) {
+    case '{':
+        return parseObject(result);
+    case '[':
+        return parseArray(result);
+    case '"':
+        return parseString(result, 0);
+    case 't':
+        *result = QScriptValueImpl(true);
+        return parseLiteral("true");
+    case 'f':
+        *result = QScriptValueImpl(false);
+        return parseLiteral("false");
+    case 'n':
+        *result = m_engine->nullValue();
+        return parseLiteral("null");
+    default:
+        break;
+    }
+    return parseNumber(result);
+}
+
+bool JsonParser::parseLiteral(const char *literal)
+{
+    for (const char *c = literal; *c; ++c, ++m_pos) {
+        if (! at(*c))
+            return error(QLatin1String("unexpected character"));
+    }
+    return true;
+}
+
+bool JsonParser::parseObject(QScriptValueImpl *result)
+{
+    if (++m_depth > JsonMaxDepth)
+        return error(QLatin1String("too deeply nested"));
+    ++m_pos; // '{'
+
+    m_engine->objectConstructor->newObject(result);
+    QScriptObject *object = result->objectValue();
+
+    skipWhitespace();
+    if (at('}')) {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    QScriptValueImpl value;
+    while (true) {
+        if (! at('"'))
+            return error(QLatin1String("expected property name"));
+        QScriptNameIdImpl *nameId = 0;
+        if (! parseString(0, &nameId))
+            return false;
+        skipWhitespace();
+        if (! at(':'))
+            return error(QLatin1String("expected ':'"));
+        ++m_pos;
+        skipWhitespace();
+        if (! parseValue(&value))
+            return false;
+
+        // a name that occurs more than once keeps the last value
+        QScript::Member member;
+        if (! object->findMember(nameId, &member)) {
+            result->createMember(nameId, &member, /*flags=*/0);
+            m_engine->adjustBytesAllocated(sizeof(QScript::Member) + sizeof(QScriptValueImpl));
+        }
+        result->put(member, value);
+
+        skipWhitespace();
+        if (at(',')) {
+            ++m_pos;
+            skipWhitespace();
+        } else if (at('}')) {
+            ++m_pos;
+            break;
+        } else {
+            return error(QLatin1String("expected ',' or '}'"));
+        }
+    }
+    --m_depth;
+    return true;
+}
+
+bool JsonParser::parseArray(QScriptValueImpl *result)
+{
+    if (++m_depth > JsonMaxDepth)
+        return error(QLatin1String("too deeply nested"));
+    ++m_pos; // '['
+
+    QScript::Array elements(m_engine);
+    skipWhitespace();
+    if (at(']')) {
+        ++m_pos;
+    } else {
+        QScriptValueImpl value;
+        uint count = 0;
+        while (true) {
+            if (! parseValue(&value))
+                return false;
+            elements.assign(count++, value);
+            skipWhitespace();
+            if (at(',')) {
+                ++m_pos;
+                skipWhitespace();
+            } else if (at(']')) {
+                ++m_pos;
+                break;
+            } else {
+                return error(QLatin1String("expected ',' or ']'"));
+            }
+        }
+    }
+    *result = m_engine->newArray(elements);
+    --m_depth;
+    return true;
+}
+
+static inline int hexValue(ushort c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    return -1;
+}
+
+// stores either a string value in result or a member name in nameId;
+// a string without escapes is taken from the text as it is
+bool JsonParser::parseString(QScriptValueImpl *result, QScriptNameIdImpl **nameId)
+{
+    ++m_pos; // '"'
+    const QChar *start = m_pos;
+    while (m_pos < m_end) {
+        const ushort c = m_pos->unicode();
+        if ((c == '"') || (c == '\\') || (c < 0x20))
+            break;
+        ++m_pos;
+    }
+    if (at('"')) {
+        const int length = m_pos - start;
+        ++m_pos;
+        if (nameId)
+            *nameId = m_engine->nameId(start, length);
+        else
+            *result = QScriptValueImpl(m_engine, QString(start, length));
+        return true;
+    }
+
+    m_buffer = QString(start, m_pos - start);
+    while (true) {
+        if (m_pos == m_end)
+            return error(QLatin1String("unterminated string"));
+        ushort c = m_pos->unicode();
+        if (c == '"') {
+            ++m_pos;
+            break;
+        }
+        if (c < 0x20)
+            return error(QLatin1String("control character in string"));
+        if (c == '\\') {
+            if (++m_pos == m_end)
+                return error(QLatin1String("unterminated string"));
+            switch (m_pos->unicode()) {
+            case '"': c = '"'; break;
+            case '\\': c = '\\'; break;
+            case '/': c = '/'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u': {
+                if (m_end - m_pos < 5)
+                    return error(QLatin1String("invalid escape sequence"));
+                c = 0;
+                for (int i = 1; i <= 4; ++i) {
+                    const int d = hexValue(m_pos[i].unicode());
+                    if (d == -1)
+                        return error(QLatin1String("invalid escape sequence"));
+                    c = (c << 4) | d;
+                }
+                m_pos += 4;
+            }   break;
+            default:
+                return error(QLatin1String("invalid escape sequence"));
+            }
+        }
+        m_buffer.append(QChar(c));
+        ++m_pos;
+    }
+
+    if (nameId)
+        *nameId = m_engine->nameId(m_buffer);
+    else
+        *result = QScriptValueImpl(m_engine, m_buffer);
+    return true;
+}
+
+static inline bool isDigit(const QChar *p, const QChar *end)
+{
+    return (p < end) && (p->unicode() >= '0') && (p->unicode() <= '9');
+}
+
+bool JsonParser::parseNumber(QScriptValueImpl *result)
+{
+    const QChar *start = m_pos;
+    const bool negative = at('-');
+    if (negative)
+        ++m_pos;
+
+    if (at('0')) {
+        ++m_pos;
+    } else if (isDigit(m_pos, m_end)) {
+        while (isDigit(m_pos, m_end))
+            ++m_pos;
+    } else {
+        return error(QLatin1String("unexpected character"));
+    }
+
+    bool integer = true;
+    if (at('.')) {
+        integer = false;
+        ++m_pos;
+        if (! isDigit(m_pos, m_end))
+            return error(QLatin1String("invalid number"));
+        while (isDigit(m_pos, m_end))
+            ++m_pos;
+    }
+    if (at('e') || at('E')) {
+        integer = false;
+        ++m_pos;
+        if (at('+') || at('-'))
+            ++m_pos;
+        if (! isDigit(m_pos, m_end))
+            return error(QLatin1String("invalid number"));
+        while (isDigit(m_pos, m_end))
+            ++m_pos;
+    }
+
+    const int length = m_pos - start;
+    const int digits = negative ? length - 1 : length;
+    if (integer && (digits <= 9)) {
+        int value = 0;
+        for (const QChar *p = negative ? start + 1 : start; p != m_pos; ++p)
+            value = value * 10 + (p->unicode() - '0');
+        // -0 has to stay a double
+        if (! negative || (value != 0)) {
+            *result = QScriptValueImpl(negative ? -value : value);
+            return true;
+        }
+    }
+
+    QVarLengthArray<char, 32> latin1(length + 1);
+    for (int i = 0; i < length; ++i)
+        latin1[i] = char(start[i].unicode());
+    latin1[length] = '\0';
+    const char *eptr = 0;
+    *result = QScriptValueImpl(qsreal(qstrtod(latin1.constData(), &eptr, 0)));
+    return true;
+}
+
+// writes JSON text into a buffer that grows geometrically and is only
+// cut to size once at the end; members whose value turns out not to be
+// serializable are dropped by moving the write position back
+class JsonStringifier
+{
+public:
+    JsonStringifier(QScriptEnginePrivate *engine, QScriptContextPrivate *context);
+
+    void setReplacer(const QScriptValueImpl &replacer);
+    void setSpace(const QScriptValueImpl &space);
+
+    bool stringify(const QScriptValueImpl &value, QString *result);
+
+private:
+    bool serialize(const QScriptValueImpl &holder, QScriptNameIdImpl *nameId,
+                   quint32 index, QScriptValueImpl value);
+    void serializeObject(const QScriptValueImpl &object);
+    void serializeArray(const QScriptValueImpl &array);
+    bool enter(const QScriptValueImpl &object);
+    void newline();
+    void quote(const QChar *s, int length);
+
+    inline void reserve(int count)
+    {
+        if (m_size + count > m_buffer.size())
+            m_buffer.resize(qMax(m_buffer.size() * 2, m_size + count));
+    }
+    inline void write(char c)
+    {
+        reserve(1);
+        m_buffer.data()[m_size++] = QLatin1Char(c);
+    }
+    inline void write(const char *s)
+    {
+        while (*s)
+            write(*s++);
+    }
+    inline void write(const QString &s)
+    {
+        reserve(s.length());
+        QChar *d = m_buffer.data() + m_size;
+        const QChar *p = s.constData();
+        for (int i = 0; i < s.length(); ++i)
+            d[i] = p[i];
+        m_size += s.length();
+    }
+    inline bool failed() const
+    { return m_context->state() == QScriptContext::ExceptionState; }
+    inline QScriptValueImpl key(QScriptNameIdImpl *nameId, quint32 index) const
+    {
+        if (nameId)
+            return QScriptValueImpl(nameId);
+        return QScriptValueImpl(m_engine, QScript::numberToString(index));
+    }
+
+    QScriptEnginePrivate *m_engine;
+    QScriptContextPrivate *m_context;
+    QScriptNameIdImpl *m_toJSONId;
+    QScriptNameIdImpl *m_lengthId;
+    QScriptValueImpl m_replacerFunction;
+    QVector<QScriptNameIdImpl*> m_propertyList;
+    bool m_hasPropertyList;
+    QString m_gap;
+    QString m_indent;
+    QVector<QScriptObject*> m_stack;
+    JsonRoots m_roots;
+    QString m_buffer;
+    int m_size;
+};
+
+JsonStringifier::JsonStringifier(QScriptEnginePrivate *engine, QScriptContextPrivate *context)
+    : m_engine(engine),
+      m_context(context),
+      m_toJSONId(engine->nameId(QLatin1String("toJSON"))),
+      m_lengthId(engine->idTable()->id_length),
+      m_hasPropertyList(false),
+      m_roots(engine, context),
+      m_size(0)
+{
+    m_buffer.resize(1024);
+}
+
+void JsonStringifier::setReplacer(const QScriptValueImpl &replacer)
+{
+    if (replacer.isFunction()) {
+        m_replacerFunction = replacer;
+    } else if (replacer.isArray()) {
+        m_hasPropertyList = true;
+        // the names may not be referenced from anywhere else
+        QScript::Array names(m_engine);
+        const quint32 length = m_engine->toUint32(replacer.property(m_lengthId).toNumber());
+        for (quint32 i = 0; i < length; ++i) {
+            const QScriptValueImpl v = replacer.property(i);
+            QScriptNameIdImpl *nameId = 0;
+            if (v.isString()
+                || (v.classInfo() == m_engine->stringConstructor->classInfo())) {
+                nameId = m_engine->nameId(v.toString());
+            } else if (v.isNumber()
+                       || (v.classInfo() == m_engine->numberConstructor->classInfo())) {
+                nameId = m_engine->nameId(QScript::numberToString(v.toNumber()));
+            }
+            if (nameId && ! m_propertyList.contains(nameId)) {
+                names.assign(m_propertyList.size(), QScriptValueImpl(nameId));
+                m_propertyList.append(nameId);
+            }
+        }
+        m_roots.push(m_engine->newArray(names));
+    }
+}
+
+void JsonStringifier::setSpace(const QScriptValueImpl &space)
+{
+    QScriptValueImpl s = space;
+    if (s.classInfo() == m_engine->numberConstructor->classInfo())
+        s = QScriptValueImpl(s.toNumber());
+    else if (s.classInfo() == m_engine->stringConstructor->classInfo())
+        s = QScriptValueImpl(m_engine, s.toString());
+
+    if (s.isNumber()) {
+        const int count = int (qMin(qsreal(10), s.toInteger()));
+        if (count > 0)
+            m_gap = QString(count, QLatin1Char(' '));
+    } else if (s.isString()) {
+        m_gap = s.toString().left(10);
+    }
+}
+
+bool JsonStringifier::stringify(const QScriptValueImpl &value, QString *result)
+{
+    QScriptValueImpl holder;
+    QScriptNameIdImpl *emptyId = m_engine->nameId(QString());
+    if (m_replacerFunction.isValid()) {
+        m_engine->objectConstructor->newObject(&holder);
+        holder.setProperty(emptyId, value);
+        if (! m_roots.push(holder))
+            return false;
+    }
+    const bool defined = serialize(holder, emptyId, 0, value);
+    if (! defined || failed())
+        return false;
+    m_buffer.truncate(m_size);
+    *result = m_buffer;
+    return true;
+}
+
+// ECMA-262 5th edition, 15.12.3, Str(); the key is either nameId, or
+// index when nameId is 0. Returns false if the value is not written.
+// The holder is kept reachable by the caller; a value returned by
+// toJSON() or the replacer is pushed onto the roots for as long as it's
+// being serialized
+bool JsonStringifier::serialize(const QScriptValueImpl &holder, QScriptNameIdImpl *nameId,
+                                quint32 index, QScriptValueImpl value)
+{
+    int rooted = 0;
+    if (value.isObject()) {
+        QScriptValueImpl toJSON = value.property(m_toJSONId);
+        if (toJSON.isFunction()) {
+            value = toJSON.call(value, QScriptValueImplList() << key(nameId, index));
+            if (failed() || ! m_roots.push(value))
+                return false;
+            ++rooted;
+        }
+    }
+    if (m_replacerFunction.isValid()) {
+        value = m_replacerFunction.call(holder, QScriptValueImplList() << key(nameId, index) << value);
+        if (failed() || ! m_roots.push(value))
+            return false;
+        ++rooted;
+    }
+
+    if (value.isObject()) {
+        QScriptClassInfo *classInfo = value.classInfo();
+        if (classInfo == m_engine->numberConstructor->classInfo())
+            value = QScriptValueImpl(value.toNumber());
+        else if (classInfo == m_engine->stringConstructor->classInfo())
+            value = QScriptValueImpl(m_engine, value.toString());
+        else if (classInfo == m_engine->booleanConstructor->classInfo())
+            value = value.internalValue();
+        if (failed())
+            return false;
+    }
+
+    if (value.isNull()) {
+        write("null");
+    } else if (value.isBoolean()) {
+        write(value.boolValue() ? "true" : "false");
+    } else if (value.isString()) {
+        const QString s = value.toString();
+        quote(s.constData(), s.length());
+    } else if (value.isNumber()) {
+        const qsreal n = value.toNumber();
+        if (qIsFinite(n))
+            write(QScript::numberToString(n));
+        else
+            write("null");
+    } else if (value.isObject() && ! value.isFunction()) {
+        if (value.isArray())
+            serializeArray(value);
+        else
+            serializeObject(value);
+    } else {
+        m_roots.pop(rooted);
+        return false;
+    }
+    m_roots.pop(rooted);
+    return true;
+}
+
+bool JsonStringifier::enter(const QScriptValueImpl &object)
+{
+    if (m_stack.size() >= JsonMaxDepth) {
+        m_context->throwError(QScriptContext::RangeError,
+                              QLatin1String("JSON.stringify: structure too deeply nested"));
+        return false;
+    }
+    QScriptObject *o = object.objectValue();
+    if (m_stack.contains(o)) {
+        m_context->throwError(QScriptContext::TypeError,
+                              QLatin1String("JSON.stringify: cyclic structure"));
+        return false;
+    }
+    m_stack.append(o);
+    return true;
+}
+
+void JsonStringifier::newline()
+{
+    write('\n');
+    write(m_indent);
+}
+
+void JsonStringifier::serializeObject(const QScriptValueImpl &object)
+{
+    if (! enter(object))
+        return;
+    const QString stepback = m_indent;
+    m_indent += m_gap;
+
+    QVector<QScriptNameIdImpl*> keys;
+    bool rooted = false;
+    if (m_hasPropertyList) {
+        keys = m_propertyList;
+    } else {
+        // a toJSON() or replacer function may remove members, and with
+        // them the last reference to their names
+        QScript::Array names(m_engine);
+        QScriptValueIteratorImpl it(object);
+        it.setIgnoresDontEnum(false);
+        while (it.hasNext()) {
+            it.next();
+            names.assign(keys.size(), QScriptValueImpl(it.nameId()));
+            keys.append(it.nameId());
+        }
+        if (! m_roots.push(m_engine->newArray(names)))
+            return;
+        rooted = true;
+    }
+
+    write('{');
+    bool empty = true;
+    for (int i = 0; i < keys.count(); ++i) {
+        QScriptNameIdImpl *nameId = keys.at(i);
+        const int mark = m_size;
+        if (! empty)
+            write(',');
+        if (! m_gap.isEmpty())
+            newline();
+        quote(nameId->s.constData(), nameId->s.length());
+        write(':');
+        if (! m_gap.isEmpty())
+            write(' ');
+        if (serialize(object, nameId, 0, object.property(nameId)))
+            empty = false;
+        else
+            m_size = mark;
+        if (failed())
+            return;
+    }
+    m_indent = stepback;
+    if (! empty && ! m_gap.isEmpty())
+        newline();
+    write('}');
+    m_stack.pop_back();
+    if (rooted)
+        m_roots.pop();
+}
+
+void JsonStringifier::serializeArray(const QScriptValueImpl &array)
+{
+    if (! enter(array))
+        return;
+    const QString stepback = m_indent;
+    m_indent += m_gap;
+
+    const quint32 length = m_engine->toUint32(array.property(m_lengthId).toNumber());
+    write('[');
+    for (quint32 i = 0; i < length; ++i) {
+        if (i != 0)
+            write(',');
+        if (! m_gap.isEmpty())
+            newline();
+        if (! serialize(array, 0, i, array.property(i)))
+            write("null");
+        if (failed())
+            return;
+    }
+    m_indent = stepback;
+    if ((length != 0) && ! m_gap.isEmpty())
+        newline();
+    write(']');
+    m_stack.pop_back();
+}
+
+// ECMA-262 5th edition, 15.12.3, Quote(); runs of characters that need
+// no escaping are copied as they are
+void JsonStringifier::quote(const QChar *s, int length)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+
+    reserve(length + 2);
+    write('"');
+    int i = 0;
+    while (i < length) {
+        const int start = i;
+        while (i < length) {
+            const ushort c = s[i].unicode();
+            if ((c < 0x20) || (c == '"') || (c == '\\'))
+                break;
+            ++i;
+        }
+        if (i != start) {
+            reserve(i - start);
+            QChar *d = m_buffer.data() + m_size;
+            for (int j = start; j < i; ++j)
+                *d++ = s[j];
+            m_size += i - start;
+        }
+        if (i == length)
+            break;
+
+        const ushort c = s[i++].unicode();
+        write('\\');
+        switch (c) {
+        case '"': write('"'); break;
+        case '\\': write('\\'); break;
+        case '\b': write('b'); break;
+        case '\f': write('f'); break;
+        case '\n': write('n'); break;
+        case '\r': write('r'); break;
+        case '\t': write('t'); break;
+        default:
+            write('u');
+            write('0');
+            write('0');
+            write(hexdigits[c >> 4]);
+            write(hexdigits[c & 0xf]);
+            break;
+        }
+    }
+    write('"');
+}
+
+// ECMA-262 5th edition, 15.12.2, Walk(); the holder is kept reachable
+// by the caller, and the value and its member names are pushed onto the
+// roots while the reviver runs
+static QScriptValueImpl walk(QScriptContextPrivate *context, QScriptEnginePrivate *eng,
+                             JsonRoots *roots, const QScriptValueImpl &reviver,
+                             QScriptValueImpl &holder, QScriptNameIdImpl *nameId, int depth)
+{
+    QScriptValueImpl value = holder.property(nameId);
+    if (! roots->push(value))
+        return value;
+    if (value.isObject()) {
+        // the reviver may have added structure that wasn't parsed
+        if (depth >= JsonMaxDepth) {
+            return context->throwError(QScriptContext::RangeError,
+                                       QLatin1String("JSON.parse: structure too deeply nested"));
+        }
+        QScript::Array keys(eng);
+        if (value.isArray()) {
+            const quint32 length = eng->toUint32(value.property(eng->idTable()->id_length).toNumber());
+            for (quint32 i = 0; i < length; ++i)
+                keys.assign(i, QScriptValueImpl(eng->nameId(QScript::numberToString(i))));
+        } else {
+            QScriptValueIteratorImpl it(value);
+            it.setIgnoresDontEnum(false);
+            quint32 count = 0;
+            while (it.hasNext()) {
+                it.next();
+                keys.assign(count++, QScriptValueImpl(it.nameId()));
+            }
+        }
+        if (! roots->push(eng->newArray(keys)))
+            return value;
+        for (quint32 i = 0; i < keys.count(); ++i) {
+            QScriptNameIdImpl *key = keys.at(i).stringValue();
+            const QScriptValueImpl element = walk(context, eng, roots, reviver, value, key, depth + 1);
+            if (context->state() == QScriptContext::ExceptionState)
+                return element;
+            if (element.isUndefined())
+                value.deleteProperty(key);
+            else
+                value.setProperty(key, element);
+        }
+        roots->pop();
+    }
+    const QScriptValueImpl result =
+        reviver.call(holder, QScriptValueImplList() << QScriptValueImpl(nameId) << value);
+    roots->pop();
+    return result;
+}
+
+Json::Json(QScriptEnginePrivate *engine, QScriptClassInfo *classInfo):
+    m_engine(engine),
+    m_classInfo(classInfo)
+{
+}
+
+Json::~Json()
+{
+}
+
+void Json::construct(QScriptValueImpl *object, QScriptEnginePrivate *eng)
+{
+    QScriptClassInfo *classInfo = eng->registerClass(QLatin1String("JSON"));
+
+    Json *instance = new Json(eng, classInfo);
+    eng->newObject(object, classInfo);
+    object->setObjectData(instance);
+
+    const QScriptValue::PropertyFlags flags = QScriptValue::SkipInEnumeration;
+    addFunction(*object, QLatin1String("parse"), method_parse, 2, flags);
+    addFunction(*object, QLatin1String("stringify"), method_stringify, 3, flags);
+}
+
+QScriptValueImpl Json::method_parse(QScriptContextPrivate *context,
+                                    QScriptEnginePrivate *eng,
+                                    QScriptClassInfo *)
+{
+    const QString text = context->argument(0).toString();
+    if (context->state() == QScriptContext::ExceptionState)
+        return context->returnValue();
+
+    QScriptValueImpl result;
+    JsonParser parser(eng, text);
+    if (! parser.parse(&result))
+        return context->throwError(QScriptContext::SyntaxError, parser.errorMessage());
+
+    const QScriptValueImpl reviver = context->argument(1);
+    if (reviver.isFunction()) {
+        JsonRoots roots(eng, context);
+        QScriptValueImpl root;
+        eng->objectConstructor->newObject(&root);
+        QScriptNameIdImpl *emptyId = eng->nameId(QString());
+        root.setProperty(emptyId, result);
+        if (! roots.push(root))
+            return context->returnValue();
+        result = walk(context, eng, &roots, reviver, root, emptyId, 0);
+        if (context->state() == QScriptContext::ExceptionState)
+            return context->returnValue();
+    }
+    return result;
+}
+
+QScriptValueImpl Json::method_stringify(QScriptContextPrivate *context,
+                                        QScriptEnginePrivate *eng,
+                                        QScriptClassInfo *)
+{
+    JsonStringifier stringifier(eng, context);
+    stringifier.setReplacer(context->argument(1));
+    stringifier.setSpace(context->argument(2));
+
+    QString result;
+    if (! stringifier.stringify(context->argument(0), &result)) {
+        if (context->state() == QScriptContext::ExceptionState)
+            return context->returnValue();
+        return eng->undefinedValue();
+    }
+    return QScriptValueImpl(eng, result);
+}
+
+void Json::addFunction(QScriptValueImpl &object, const QString &name,
+                       QScriptInternalFunctionSignature fun, int length,
+                       const QScriptValue::PropertyFlags flags)
+{
+    QScriptEnginePrivate *eng_p = object.engine();
+    if (eng_p->isRestoringSnapshot())
+        return;
+    QScriptValueImpl val = eng_p->createFunction(fun, length, object.classInfo(), name);
+    object.setProperty(name, val, flags);
+}
+
+} } // namespace QScript::Ecma
+
+QT_END_NAMESPACE
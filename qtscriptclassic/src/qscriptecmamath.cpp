@@ -379,6 +379,8 @@ void Math::addFunction(QScriptValueImpl &object, const QString &name,
                        const QScriptValue::PropertyFlags flags)
 {
     QScriptEnginePrivate *eng_p = object.engine();
+    if (eng_p->isRestoringSnapshot())
+        return;
     QScriptValueImpl val = eng_p->createFunction(fun, length, object.classInfo(), name);
     object.setProperty(name, val, flags);
 }
@@ -47,6 +47,7 @@
 #include "qscriptcontext_p.h"
 #include "qscriptmember_p.h"
 #include "qscriptobject_p.h"
+#include "qscriptfunction_p.h"
 
 #include <QStringList>
 #include <QRegExp>
@@ -101,11 +102,7 @@ void RegExp::execute(QScriptContextPrivate *context)
             goto Lout;
         }
         Instance *data = Instance::get(pattern, classInfo());
-#ifndef QT_NO_REGEXP
-        P = data->value.pattern();
-#else
         P = data->pattern;
-#endif
         F = data->flags;
     } else {
         if (!pattern.isUndefined())
@@ -126,17 +123,21 @@ void RegExp::execute(QScriptContextPrivate *context)
             }
         }
     }
-    if (context->isCalledAsConstructor()) {
-        QScriptValueImpl &object = context->m_thisObject;
-        object.setClassInfo(classInfo());
-        object.setPrototype(publicPrototype);
-#ifndef QT_NO_REGEXP
-        initRegExp(&object, toRegExp(P, F), F);
-#else
-        initRegExp(&object, P, F);
-#endif
-    } else {
-        newRegExp(&context->m_result, P, F);
+    {
+        QString errorMessage;
+        RegExpProgram *program = compiledRegExp(P, F, &errorMessage);
+        if (! program) {
+            context->throwError(QScriptContext::SyntaxError, errorMessage);
+            goto Lout;
+        }
+        if (context->isCalledAsConstructor()) {
+            QScriptValueImpl &object = context->m_thisObject;
+            object.setClassInfo(classInfo());
+            object.setPrototype(publicPrototype);
+            initRegExp(&object, P, F, program);
+        } else {
+            newRegExp(&context->m_result, P, F, program);
+        }
     }
  Lout: ;
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
@@ -144,36 +145,35 @@ void RegExp::execute(QScriptContextPrivate *context)
 #endif
 }
 
+// a pattern that is not valid gives a RegExp that never matches
 void RegExp::newRegExp(QScriptValueImpl *result, const QString &pattern, int flags)
 {
-#ifndef QT_NO_REGEXP
-    QRegExp rx = toRegExp(pattern, flags);
-    newRegExp_helper(result, rx, flags);
-#else
-    engine()->newObject(result, publicPrototype, classInfo());
-    initRegExp(result, pattern, flags);
-#endif // QT_NO_REGEXP
+    RegExpProgram *program = compiledRegExp(pattern, flags);
+    if (! program)
+        program = compiledRegExp(QLatin1String("(?!)"), flags);
+    newRegExp(result, pattern, flags, program);
 }
 
-#ifndef QT_NO_REGEXP
-void RegExp::newRegExp(QScriptValueImpl *result, const QRegExp &rx, int flags)
+void RegExp::newRegExp(QScriptValueImpl *result, const QString &pattern, int flags,
+                       RegExpProgram *program)
 {
-    Q_ASSERT(!(flags & IgnoreCase) || (rx.caseSensitivity() == Qt::CaseInsensitive));
-    newRegExp_helper(result, rx, flags);
+    engine()->newObject(result, publicPrototype, classInfo());
+    initRegExp(result, pattern, flags, program);
 }
 
-void RegExp::newRegExp_helper(QScriptValueImpl *result, const QRegExp &rx,
-                              int flags)
+#ifndef QT_NO_REGEXP
+void RegExp::newRegExp(QScriptValueImpl *result, const QRegExp &rx, int flags)
 {
-    engine()->newObject(result, publicPrototype, classInfo());
-    initRegExp(result, rx, flags);
+    if (rx.caseSensitivity() == Qt::CaseInsensitive)
+        flags |= IgnoreCase;
+    newRegExp(result, rx.pattern(), flags);
 }
 
 QRegExp RegExp::toRegExp(const QScriptValueImpl &value) const
 {
     Instance *rx_data = Instance::get(value, classInfo());
     Q_ASSERT(rx_data != 0);
-    return rx_data->value;
+    return toRegExp(rx_data->pattern, rx_data->flags);
 }
 
 QRegExp RegExp::toRegExp(const QString &pattern, int flags)
@@ -183,24 +183,54 @@ QRegExp RegExp::toRegExp(const QString &pattern, int flags)
                    (ignoreCase ? Qt::CaseInsensitive: Qt::CaseSensitive),
                    QRegExp::RegExp2);
 }
-
 #endif // QT_NO_REGEXP
 
-void RegExp::initRegExp(QScriptValueImpl *result,
-#ifndef QT_NO_REGEXP
-                        const QRegExp &rx,
-#else
-                        const QString &pattern,
-#endif
-                        int flags)
+// RegExp objects with the same pattern and flags share the compiled
+// program, whether they come from literals, the constructor or the
+// String functions; since patterns built at runtime may all differ,
+// the cache is emptied when it gets too large. Returns 0 if the pattern
+// is not valid.
+RegExpProgram *RegExp::compiledRegExp(const QString &pattern, int flags,
+                                      QString *errorMessage)
+{
+    QHash<QPair<QString, int>, QExplicitlySharedDataPointer<RegExpProgram> > &cache
+        = engine()->m_regExpCache;
+    const QPair<QString, int> key(pattern, flags & (IgnoreCase | Multiline));
+    QHash<QPair<QString, int>, QExplicitlySharedDataPointer<RegExpProgram> >::const_iterator it;
+    it = cache.constFind(key);
+    if (it != cache.constEnd())
+        return it.value().data();
+
+    RegExpProgram *program = RegExpProgram::compile(pattern, flags, errorMessage);
+    if (! program)
+        return 0;
+    if (cache.size() >= MaxCachedRegExps)
+        cache.clear();
+    cache.insert(key, QExplicitlySharedDataPointer<RegExpProgram>(program));
+    return program;
+}
+
+// true if function is RegExp.prototype.exec as installed by the engine,
+// so that its effects can be computed without calling it
+bool RegExp::isBuiltInExec(const QScriptValueImpl &function)
+{
+    QScriptFunction *fun = function.toFunction();
+    return fun && (fun->type() == QScriptFunction::C2)
+        && (static_cast<C2Function*>(fun)->function() == method_exec);
+}
+
+QScriptValueImpl RegExp::throwMatchOverflow(QScriptContextPrivate *context)
+{
+    return context->throwError(QLatin1String("regular expression is too complex to match"));
+}
+
+void RegExp::initRegExp(QScriptValueImpl *result, const QString &pattern,
+                        int flags, RegExpProgram *program)
 {
     Instance *instance = new Instance();
-#ifndef QT_NO_REGEXP
-    instance->value = rx;
-#else
     instance->pattern = pattern;
-#endif
     instance->flags = flags;
+    instance->program = program;
     result->setObjectData(instance);
 
     bool global = (flags & Global) != 0;
@@ -217,9 +247,6 @@ void RegExp::initRegExp(QScriptValueImpl *result,
                         propertyFlags);
     result->setProperty(QLatin1String("multiline"), QScriptValueImpl(multiline),
                         propertyFlags);
-#ifndef QT_NO_REGEXP
-    const QString &pattern = rx.pattern();
-#endif
     result->setProperty(QLatin1String("source"), QScriptValueImpl(engine(), pattern),
                         propertyFlags);
     result->setProperty(QLatin1String("lastIndex"), QScriptValueImpl(0),
@@ -268,30 +295,35 @@ QScriptValueImpl RegExp::method_exec(QScriptContextPrivate *context, QScriptEngi
     QScriptValueImpl lastIndex = self.property(QLatin1String("lastIndex"));
 
     int i = lastIndex.isValid() ? int (lastIndex.toInteger()) : 0;
-    bool global = self.property(QLatin1String("global")).toBoolean();
+    // the global property is read-only and can't be deleted
+    bool global = (rx_data->flags & Global) != 0;
 
     if (! global)
         i = 0;
 
-    if (i < 0 || i >= length)
-        return (eng->nullValue());
-
-#ifndef QT_NO_REGEXP
-    int index = rx_data->value.indexIn(S, i);
-    if (index == -1)
-#endif // QT_NO_REGEXP
+    QVector<int> captures;
+    int index = -1;
+    if (i >= 0 && i <= length)
+        index = rx_data->program->match(S, i, &captures);
+    if (index == RegExpProgram::MatchOverflow)
+        return throwMatchOverflow(context);
+    if (index == -1) {
+        if (global)
+            self.setProperty(QLatin1String("lastIndex"), QScriptValueImpl(0));
         return eng->nullValue();
-
-#ifndef QT_NO_REGEXP
-    int e = index + rx_data->value.matchedLength();
+    }
 
     if (global)
-        self.setProperty(QLatin1String("lastIndex"), QScriptValueImpl(e));
+        self.setProperty(QLatin1String("lastIndex"), QScriptValueImpl(captures.at(1)));
 
     QScript::Array elts(eng);
-    QStringList capturedTexts = rx_data->value.capturedTexts();
-    for (int i = 0; i < capturedTexts.count(); ++i)
-        elts.assign(i, QScriptValueImpl(eng, capturedTexts.at(i)));
+    for (int i = 0; i < captures.size(); i += 2) {
+        const int start = captures.at(i);
+        if (start == -1)
+            elts.assign(i / 2, eng->undefinedValue());
+        else
+            elts.assign(i / 2, QScriptValueImpl(eng, S.mid(start, captures.at(i + 1) - start)));
+    }
 
     QScriptValueImpl r = eng->newArray(elts);
 
@@ -299,7 +331,6 @@ QScriptValueImpl RegExp::method_exec(QScriptContextPrivate *context, QScriptEngi
     r.setProperty(QLatin1String("input"), QScriptValueImpl(eng, S));
 
     return r;
-#endif // QT_NO_REGEXP
 }
 
 QScriptValueImpl RegExp::method_test(QScriptContextPrivate *context, QScriptEnginePrivate *eng, QScriptClassInfo *classInfo)
@@ -313,11 +344,7 @@ QScriptValueImpl RegExp::method_toString(QScriptContextPrivate *context, QScript
     if (Instance *instance = Instance::get(context->thisObject(), classInfo)) {
         QString result;
         result += QLatin1Char('/');
-#ifndef QT_NO_REGEXP
-        const QString &pattern = instance->value.pattern();
-#else
         const QString &pattern = instance->pattern;
-#endif
         if (pattern.isEmpty())
             result += QLatin1String("(?:)");
         else
@@ -57,6 +57,7 @@
 
 
 #include "qscriptecmacore_p.h"
+#include "qscriptregexpcompiler_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -85,12 +86,9 @@ public:
                              QScriptClassInfo *klass);
 
     public: // attributes
-#ifndef QT_NO_REGEXP
-        QRegExp value;
-#else
         QString pattern;
-#endif
         int flags;
+        QExplicitlySharedDataPointer<RegExpProgram> program;
     };
 
     inline Instance *get(const QScriptValueImpl &object) const
@@ -98,12 +96,21 @@ public:
 
     void newRegExp(QScriptValueImpl *result, const QString &pattern,
                    int flags);
+    void newRegExp(QScriptValueImpl *result, const QString &pattern,
+                   int flags, RegExpProgram *program);
 #ifndef QT_NO_REGEXP
     void newRegExp(QScriptValueImpl *result, const QRegExp &rx,
                    int flags = 0);
     QRegExp toRegExp(const QScriptValueImpl &value) const;
     static QRegExp toRegExp(const QString &pattern, int flags);
 #endif
+    RegExpProgram *compiledRegExp(const QString &pattern, int flags,
+                                  QString *errorMessage = 0);
+
+    static bool isBuiltInExec(const QScriptValueImpl &function);
+
+    // for RegExpProgram::MatchOverflow
+    static QScriptValueImpl throwMatchOverflow(QScriptContextPrivate *context);
 
     static int flagFromChar(const QChar &ch);
     static QString flagsToString(int flags);
@@ -120,17 +127,12 @@ protected:
                                             QScriptClassInfo *classInfo);
 
 private:
-#ifndef QT_NO_REGEXP
-    void newRegExp_helper(QScriptValueImpl *result, const QRegExp &rx,
-                          int flags);
-#endif
-    void initRegExp(QScriptValueImpl *result,
-#ifndef QT_NO_REGEXP
-                    const QRegExp &rx,
-#else
-                    const QString &pattern,
-#endif
-                    int flags);
+    enum {
+        MaxCachedRegExps = 256
+    };
+
+    void initRegExp(QScriptValueImpl *result, const QString &pattern,
+                    int flags, RegExpProgram *program);
 };
 
 } } // namespace QScript::Ecma
@@ -49,6 +49,7 @@
 #include "qscriptobject_p.h"
 #include "qscriptclassdata_p.h"
 
+#include <QRegExp>
 #include <QStringList>
 #include <QtDebug>
 #include <qnumeric.h>
@@ -136,7 +137,7 @@ bool StringClassData::resolve(const QScriptValueImpl &object,
         return false;
 
     QScriptNameIdImpl *ref = object.internalValue().stringValue();
-    if (index >= ref->s.length())
+    if (index >= ref->size())
         return false;
 
     member->native(nameId, index, QScriptValue::Undeletable | QScriptValue::ReadOnly);
@@ -157,13 +158,13 @@ bool StringClassData::get(const QScriptValueImpl &object,
         return false;
 
     QScriptNameIdImpl *ref = object.internalValue().stringValue();
-    int len = ref->s.length();
+    int len = ref->size();
 
     if (member.nameId() == eng->idTable()->id_length)
         *result = QScriptValueImpl(len);
 
     else if (member.id() >= 0 && member.id() < len)
-        eng->newString(result, ref->s.at(member.id()));
+        eng->newString(result, ref->string().at(member.id()));
 
     else
         *result = eng->undefinedValue();
@@ -181,7 +182,7 @@ bool StringClassData::put(QScriptValueImpl *, const Member &,
 QScriptClassDataIterator *StringClassData::newIterator(const QScriptValueImpl &object)
 {
     QScriptNameIdImpl *id = object.internalValue().stringValue();
-    return new StringClassDataIterator(id->s.length());
+    return new StringClassDataIterator(id->size());
 }
 
 StringClassDataIterator::StringClassDataIterator(int length)
@@ -347,10 +348,18 @@ QScriptValueImpl String::method_charCodeAt(QScriptContextPrivate *context, QScri
 
 QScriptValueImpl String::method_concat(QScriptContextPrivate *context, QScriptEnginePrivate *eng, QScriptClassInfo *)
 {
+    const int count = context->argumentCount();
+    QVector<QString> parts(count);
     QString value = context->thisObject().toString();
+    int totalLength = value.length();
+    for (int i = 0; i < count; ++i) {
+        parts[i] = context->argument(i).toString();
+        totalLength += parts.at(i).length();
+    }
 
-    for (int i = 0; i < context->argumentCount(); ++i)
-        value += context->argument(i).toString();
+    value.reserve(totalLength);
+    for (int i = 0; i < count; ++i)
+        value += parts.at(i);
 
     return (QScriptValueImpl(eng, value));
 }
@@ -402,8 +411,14 @@ QScriptValueImpl String::method_match(QScriptContextPrivate *context, QScriptEng
 {
     QScriptValueImpl pattern = context->argument(0);
 
-    if (! eng->regexpConstructor->get(pattern))
-        eng->regexpConstructor->newRegExp(&pattern, context->argument(0).toString(), /*flags=*/0);
+    if (! eng->regexpConstructor->get(pattern)) {
+        const QString source = context->argument(0).toString();
+        QString errorMessage;
+        QScript::RegExpProgram *program = eng->regexpConstructor->compiledRegExp(source, /*flags=*/0, &errorMessage);
+        if (! program)
+            return context->throwError(QScriptContext::SyntaxError, errorMessage);
+        eng->regexpConstructor->newRegExp(&pattern, source, /*flags=*/0, program);
+    }
 
     QScriptValueImpl rx_exec = pattern.property(QLatin1String("exec"), QScriptValue::ResolvePrototype);
     if (! (rx_exec.isValid() && rx_exec.isFunction())) {
@@ -423,6 +438,28 @@ QScriptValueImpl String::method_match(QScriptContextPrivate *context, QScriptEng
     QScriptNameIdImpl *lastIndexId = eng->nameId(QLatin1String("lastIndex"));
     QScriptNameIdImpl *zeroId = eng->nameId(QLatin1String("0"));
 
+    if (Ecma::RegExp::isBuiltInExec(rx_exec)) {
+        // what the loop below does, without a call and a match object
+        // per match
+        const QScript::RegExpProgram *program = eng->regexpConstructor->get(pattern)->program.data();
+        const QString input = context->thisObject().toString();
+        QVector<int> captures;
+        int lastIndex = 0;
+        int n = 0;
+        while (lastIndex <= input.length()) {
+            const int index = program->match(input, lastIndex, &captures);
+            if (index == QScript::RegExpProgram::MatchOverflow)
+                return Ecma::RegExp::throwMatchOverflow(context);
+            if (index == -1)
+                break;
+            const int end = captures.at(1);
+            lastIndex = (end == index) ? end + 1 : end;
+            result.assign(n++, QScriptValueImpl(eng, input.mid(index, end - index)));
+        }
+        pattern.setProperty(lastIndexId, QScriptValueImpl(0));
+        return eng->newArray(result);
+    }
+
     pattern.setProperty(lastIndexId, QScriptValueImpl(0));
     int n = 0;
     while (true) {
@@ -439,6 +476,112 @@ QScriptValueImpl String::method_match(QScriptContextPrivate *context, QScriptEng
     return (eng->newArray(result));
 }
 
+struct RegExpMatch {
+    int index;
+    QVector<int> captures;
+};
+
+// String.prototype.replace() for a RegExp whose exec function is the
+// built-in one; the matches are found directly instead of through exec
+// and a match object per match. Returns false if the matcher ran out of
+// room
+bool String::replaceMatches(QScriptEnginePrivate *eng, const QString &input,
+                            QScriptValueImpl &searchValue,
+                            const QScriptValueImpl &replaceValue, QString *result)
+{
+    Ecma::RegExp::Instance *rx_data = eng->regexpConstructor->get(searchValue);
+    const QScript::RegExpProgram *program = rx_data->program.data();
+    const bool global = (rx_data->flags & Ecma::RegExp::Global) != 0;
+
+    // all the matches are found before a replacement function runs,
+    // since it may use the same RegExp
+    QVector<RegExpMatch> matches;
+    int lastIndex = 0;
+    while (lastIndex <= input.length()) {
+        RegExpMatch m;
+        m.index = program->match(input, lastIndex, &m.captures);
+        if (m.index == QScript::RegExpProgram::MatchOverflow)
+            return false;
+        if (m.index == -1)
+            break;
+        matches.append(m);
+        if (! global)
+            break;
+        const int end = m.captures.at(1);
+        lastIndex = (end == m.index) ? end + 1 : end;
+    }
+    if (global)
+        searchValue.setProperty(eng->nameId(QLatin1String("lastIndex")), QScriptValueImpl(0));
+
+    QString &output = *result;
+    int pos = 0;
+    if (replaceValue.isFunction()) {
+        QScriptValueImplList args;
+        for (int i = 0; i < matches.count(); ++i) {
+            const RegExpMatch &m = matches.at(i);
+            output += input.mid(pos, m.index - pos);
+            args.clear();
+            for (int j = 0; j < m.captures.count(); j += 2) {
+                const int start = m.captures.at(j);
+                if (start == -1)
+                    args << eng->undefinedValue();
+                else
+                    args << QScriptValueImpl(eng, input.mid(start, m.captures.at(j + 1) - start));
+            }
+            args << QScriptValueImpl(m.index);
+            args << QScriptValueImpl(eng, input);
+            QScriptValueImpl ret = replaceValue.call(eng->nullValue(), args);
+            output += ret.toString();
+            pos = m.captures.at(1);
+        }
+    } else {
+        // use string representation of replaceValue
+        const QString replaceString = replaceValue.toString();
+        const QLatin1Char dollar = QLatin1Char('$');
+        for (int i = 0; i < matches.count(); ++i) {
+            const RegExpMatch &m = matches.at(i);
+            output += input.mid(pos, m.index - pos);
+            int j = 0;
+            while (j < replaceString.length()) {
+                const QChar c = replaceString.at(j++);
+                if ((c == dollar) && (j < replaceString.length())) {
+                    const QChar nc = replaceString.at(j);
+                    if (nc == dollar) {
+                        ++j;
+                    } else if (nc == QLatin1Char('`')) {
+                        ++j;
+                        output += input.left(m.index);
+                        continue;
+                    } else if (nc == QLatin1Char('\'')) {
+                        ++j;
+                        output += input.mid(m.captures.at(1));
+                        continue;
+                    } else if (nc.isDigit()) {
+                        ++j;
+                        int cap = nc.toLatin1() - '0';
+                        if ((j < replaceString.length()) && replaceString.at(j).isDigit()) {
+                            cap = cap * 10;
+                            cap = replaceString.at(j++).toLatin1() - '0';
+                        }
+                        if (2 * cap < m.captures.count()) {
+                            const int start = m.captures.at(2 * cap);
+                            if (start != -1)
+                                output += input.mid(start, m.captures.at(2 * cap + 1) - start);
+                        } else {
+                            output += QLatin1String("undefined");
+                        }
+                        continue;
+                    }
+                }
+                output += c;
+            }
+            pos = m.captures.at(1);
+        }
+    }
+    output += input.mid(pos);
+    return true;
+}
+
 QScriptValueImpl String::method_replace(QScriptContextPrivate *context, QScriptEnginePrivate *eng, QScriptClassInfo *)
 {
     QString input = context->thisObject().toString();
@@ -453,6 +596,11 @@ QScriptValueImpl String::method_replace(QScriptContextPrivate *context, QScriptE
             return context->throwError(QScriptContext::TypeError,
                                        QLatin1String("String.prototype.replace"));
         }
+        if (Ecma::RegExp::isBuiltInExec(rx_exec)) {
+            if (! replaceMatches(eng, input, searchValue, replaceValue, &output))
+                return Ecma::RegExp::throwMatchOverflow(context);
+            return QScriptValueImpl(eng, output);
+        }
         QVector<QScriptValueImpl> occurrences;
         QScriptValueImpl global = searchValue.property(QLatin1String("global"));
         QScriptValueImplList args;
@@ -591,16 +739,21 @@ QScriptValueImpl String::method_search(QScriptContextPrivate *context, QScriptEn
 
     Ecma::RegExp::Instance *rx_data = 0;
     if (0 == (rx_data = eng->regexpConstructor->get(pattern))) {
-        eng->regexpConstructor->newRegExp(&pattern, context->argument(0).toString(), /*flags=*/0);
+        const QString source = context->argument(0).toString();
+        QString errorMessage;
+        QScript::RegExpProgram *program = eng->regexpConstructor->compiledRegExp(source, /*flags=*/0, &errorMessage);
+        if (! program)
+            return context->throwError(QScriptContext::SyntaxError, errorMessage);
+        eng->regexpConstructor->newRegExp(&pattern, source, /*flags=*/0, program);
         rx_data = eng->regexpConstructor->get(pattern);
     }
 
     QString value = context->thisObject().toString();
-#ifndef QT_NO_REGEXP
-    return (QScriptValueImpl(value.indexOf(rx_data->value)));
-#else
-    return eng->nullValue();
-#endif
+    QVector<int> captures;
+    const int index = rx_data->program->match(value, 0, &captures);
+    if (index == QScript::RegExpProgram::MatchOverflow)
+        return Ecma::RegExp::throwMatchOverflow(context);
+    return (QScriptValueImpl(index));
 }
 
 QScriptValueImpl String::method_slice(QScriptContextPrivate *context, QScriptEnginePrivate *eng, QScriptClassInfo *)
@@ -626,6 +779,57 @@ QScriptValueImpl String::method_slice(QScriptContextPrivate *context, QScriptEng
     return (QScriptValueImpl(eng, text.mid(start, count)));
 }
 
+// String.prototype.split() for a RegExp separator (ECMA-262 15.5.4.14);
+// the captures of each match go into the result between the parts.
+// Returns false if the matcher ran out of room
+bool String::splitMatches(QScriptEnginePrivate *eng, const QString &input,
+                          const QScript::RegExpProgram *program, quint32 limit,
+                          QScript::Array *result)
+{
+    QVector<int> captures;
+    quint32 count = 0;
+    const int size = input.length();
+    if (size == 0) {
+        const int index = program->match(input, 0, &captures);
+        if (index == QScript::RegExpProgram::MatchOverflow)
+            return false;
+        if ((index == -1) || (captures.at(1) != 0))
+            result->assign(count, QScriptValueImpl(eng, input));
+        return true;
+    }
+
+    int p = 0;
+    int q = 0;
+    while (q < size) {
+        const int index = program->match(input, q, &captures);
+        if (index == QScript::RegExpProgram::MatchOverflow)
+            return false;
+        if ((index == -1) || (index >= size))
+            break;
+        const int e = captures.at(1);
+        if (e == p) {
+            q = index + 1;
+            continue;
+        }
+        result->assign(count++, QScriptValueImpl(eng, input.mid(p, index - p)));
+        if (count == limit)
+            return true;
+        for (int i = 2; i < captures.size(); i += 2) {
+            const int start = captures.at(i);
+            if (start == -1)
+                result->assign(count++, eng->undefinedValue());
+            else
+                result->assign(count++, QScriptValueImpl(eng, input.mid(start, captures.at(i + 1) - start)));
+            if (count == limit)
+                return true;
+        }
+        p = e;
+        q = p;
+    }
+    result->assign(count, QScriptValueImpl(eng, input.mid(p)));
+    return true;
+}
+
 QScriptValueImpl String::method_split(QScriptContextPrivate *context, QScriptEnginePrivate *eng, QScriptClassInfo *)
 {
     QScriptValueImpl l = context->argument(1);
@@ -643,13 +847,12 @@ QScriptValueImpl String::method_split(QScriptContextPrivate *context, QScriptEng
     if (separator.isUndefined() && (context->argumentCount() == 0)) {
         A.assign(0, QScriptValueImpl(eng, S));
     } else {
-        QStringList matches;
-#ifndef QT_NO_REGEXP
         if (Ecma::RegExp::Instance *rx = eng->regexpConstructor->get(separator)) {
-            matches = S.split(rx->value, rx->value.pattern().isEmpty()
-                              ? QString::SkipEmptyParts : QString::KeepEmptyParts);
-        } else
-#endif // QT_NO_REGEXP
+            if (! splitMatches(eng, S, rx->program.data(), lim, &A))
+                return Ecma::RegExp::throwMatchOverflow(context);
+            return eng->newArray(A);
+        }
+        QStringList matches;
         {
             QString sep = separator.toString();
             matches = S.split(sep, sep.isEmpty()
@@ -58,7 +58,12 @@
 
 QT_BEGIN_NAMESPACE
 
-namespace QScript { namespace Ecma {
+namespace QScript {
+
+class Array;
+class RegExpProgram;
+
+namespace Ecma {
 
 class String: public Core
 {
@@ -112,6 +117,14 @@ protected:
     static QScriptValueImpl method_fromCharCode(QScriptContextPrivate *context, QScriptEnginePrivate *eng,
                                             QScriptClassInfo *classInfo);
 
+private:
+    static bool replaceMatches(QScriptEnginePrivate *eng, const QString &input,
+                               QScriptValueImpl &searchValue,
+                               const QScriptValueImpl &replaceValue, QString *result);
+    static bool splitMatches(QScriptEnginePrivate *eng, const QString &input,
+                             const RegExpProgram *program, quint32 limit,
+                             Array *result);
+
 public:
     // Qt extensions
     static QScriptValueImpl method_ext_arg(QScriptContextPrivate *context, QScriptEnginePrivate *eng,
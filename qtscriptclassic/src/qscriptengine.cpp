@@ -48,6 +48,7 @@
 #include "qscriptmember_p.h"
 #include "qscriptobject_p.h"
 #include "qscriptsyntaxcheckresult_p.h"
+#include "qscriptprogram_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -327,7 +328,6 @@ QScriptEngine::QScriptEngine(QScriptEnginePrivate &dd, QObject *parent)
 QScriptEngine::~QScriptEngine()
 {
     Q_D(QScriptEngine);
-    d->m_frameRepository.release(currentContext());
     d->objectAllocator.destruct();
 #ifdef QT_NO_QOBJECT
     delete d_ptr;
@@ -588,7 +588,7 @@ QScriptValue QScriptEngine::newQObject(const QScriptValue &scriptObject,
         return newQObject(qtObject, ownership, options);
     if (p->value.isQObject()) {
         QScript::ExtQObject::Instance *data;
-        data = d->qobjectConstructor->get(p->value);
+        data = d->qobjectConstructor()->get(p->value);
         Q_ASSERT(data != 0);
         data->value = qtObject;
         data->ownership = ownership;
@@ -799,7 +799,7 @@ QScriptValue QScriptEngine::newQMetaObject(
 {
     Q_D(QScriptEngine);
     QScriptValueImpl v;
-    d->qmetaObjectConstructor->newQMetaObject(&v, metaObject, d->toImpl(ctor));
+    d->qmetaObjectConstructor()->newQMetaObject(&v, metaObject, d->toImpl(ctor));
     return d->toPublic(v);
 }
 
@@ -944,6 +944,30 @@ QScriptValue QScriptEngine::evaluate(const QString &program, const QString &file
     return d->toPublic(ctx_p->m_result);
 }
 
+/*!
+  Evaluates the given \a program and returns the result of the
+  evaluation.
+
+  The program is compiled only the first time it is evaluated by this
+  engine; subsequent evaluations reuse the compiled code. If a code
+  cache directory has been set, the compiled code is also kept on disk
+  for later runs.
+
+  Evaluating a null program returns an invalid QScriptValue.
+
+  \sa QScriptProgram, setCodeCacheDirectory()
+*/
+QScriptValue QScriptEngine::evaluate(const QScriptProgram &program)
+{
+    Q_D(QScriptEngine);
+    QScriptProgramPrivate *program_d = QScriptProgramPrivate::get(program);
+    if (!program_d)
+        return QScriptValue();
+    QScriptContextPrivate *ctx_p = d->currentContext();
+    d->evaluate(ctx_p, program_d);
+    return d->toPublic(ctx_p->m_result);
+}
+
 /*!
   Returns the current context.
 
@@ -1554,6 +1578,44 @@ int QScriptEngine::processEventsInterval() const
     return d->m_processEventsInterval;
 }
 
+/*!
+  Sets the directory in which the engine caches the compiled code of
+  QScriptProgram objects to \a path.
+
+  When a program is evaluated by this engine for the first time, the
+  engine looks in this directory for code that was compiled from the
+  same source code before, and uses it instead of compiling the program
+  again. Code that is not found is written to the directory after
+  compilation, so that later runs of the application start faster. The
+  cache files are named after a hash of the source code; the directory
+  must exist and be writable.
+
+  Cached code only stores the names and values the program uses, not
+  its syntax tree; Function.prototype.toString() still returns the
+  source text of functions defined by a cached program.
+
+  The default is an empty path, which disables the cache.
+
+  \sa codeCacheDirectory(), evaluate()
+*/
+void QScriptEngine::setCodeCacheDirectory(const QString &path)
+{
+    Q_D(QScriptEngine);
+    d->m_codeCacheDirectory = path;
+}
+
+/*!
+  Returns the directory in which the engine caches compiled code, or
+  an empty string if the cache is disabled.
+
+  \sa setCodeCacheDirectory()
+*/
+QString QScriptEngine::codeCacheDirectory() const
+{
+    Q_D(const QScriptEngine);
+    return d->m_codeCacheDirectory;
+}
+
 /*!
   \since 4.4
 
@@ -56,6 +56,7 @@
 #include "qscriptvalue.h"
 #include "qscriptcontext.h"
 #include "qscriptstring.h"
+#include "qscriptprogram.h"
 
 QT_BEGIN_HEADER
 
@@ -164,6 +165,7 @@ public:
     static QScriptSyntaxCheckResult checkSyntax(const QString &program);
 
     QScriptValue evaluate(const QString &program, const QString &fileName = QString(), int lineNumber = 1);
+    QScriptValue evaluate(const QScriptProgram &program);
 
     bool isEvaluating() const;
     void abortEvaluation(const QScriptValue &result = QScriptValue());
@@ -250,6 +252,9 @@ public:
     void setProcessEventsInterval(int interval);
     int processEventsInterval() const;
 
+    void setCodeCacheDirectory(const QString &path);
+    QString codeCacheDirectory() const;
+
     void setAgent(QScriptEngineAgent *agent);
     QScriptEngineAgent *agent() const;
 
@@ -40,23 +40,29 @@
 
 
 #include "qscriptengine_p.h"
+#include "qscriptbaseline_p.h"
+#include "qscriptprofiler_p.h"
 
 
 #include "qscriptvalueimpl_p.h"
 #include "qscriptcontext_p.h"
 #include "qscriptmember_p.h"
 #include "qscriptobject_p.h"
+#include "qscriptast_p.h"
 #include "qscriptlexer_p.h"
 #include "qscriptnodepool_p.h"
 #include "qscriptparser_p.h"
 #include "qscriptcompiler_p.h"
 #include "qscriptvalueiteratorimpl_p.h"
 #include "qscriptecmaglobal_p.h"
+#include "qscriptecmajson_p.h"
 #include "qscriptecmamath_p.h"
 #include "qscriptecmaarray_p.h"
 #include "qscriptextenumeration_p.h"
 #include "qscriptsyntaxchecker_p.h"
 #include "qscriptsyntaxcheckresult_p.h"
+#include "qscriptprogram_p.h"
+#include "qscriptcodecache_p.h"
 #include "qscriptclass.h"
 #include "qscriptclass_p.h"
 #include "qscriptengineagent.h"
@@ -64,7 +70,9 @@
 #include <QDate>
 #include <QDateTime>
 #include <QRegExp>
+#include <QMutex>
 #include <QStringList>
+#include <QThreadStorage>
 #include <QVariant>
 
 #ifndef QT_NO_QOBJECT
@@ -261,7 +269,7 @@ qsreal numberFromString(const QString &repr)
 }
 
 NodePool::NodePool(const QString &fileName, QScriptEnginePrivate *engine)
-    : m_fileName(fileName), m_engine(engine)
+    : m_cacheFile(0), m_keepLines(false), m_fileName(fileName), m_engine(engine)
 {
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
     m_id = engine->nextScriptId();
@@ -272,6 +280,7 @@ NodePool::~NodePool()
 {
     qDeleteAll(m_codeCache);
     m_codeCache.clear();
+    delete m_cacheFile;
 
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
     m_engine->notifyScriptUnload(id());
@@ -291,6 +300,50 @@ Code *NodePool::createCompiledCode(AST::Node *node, CompilationUnit &compilation
     return code;
 }
 
+AST::FunctionExpression *NodePool::parseFunction(AST::FunctionExpression *function)
+{
+    QHash<AST::FunctionExpression*, LazyFunction>::const_iterator it;
+    it = m_lazyFunctions.constFind(function);
+    if (it == m_lazyFunctions.constEnd())
+        return function;
+    if (it->parsed)
+        return it->parsed;
+
+    // the parentheses make the parser accept the function as an
+    // expression; its own body is kept, the ones of the functions nested
+    // in it are dropped again
+    const int offset = it->offset;
+    QString text = QLatin1Char('(') + m_source.mid(offset, it->length) + QLatin1Char(')');
+
+    MemoryPool *previousPool = m_engine->nodePool();
+    m_engine->setNodePool(this);
+    Lexer lex(m_engine);
+    m_engine->setLexer(&lex);
+    lex.setCode(text, it->line, it->column - 1);
+
+    QScriptParser parser;
+    parser.setLazyFunctions(this, /*depth=*/ 1, /*offset=*/ offset - 1);
+    AST::FunctionExpression *parsed = 0;
+    if (parser.parse(m_engine)) {
+        AST::Program *program = static_cast<AST::Program*>(m_engine->abstractSyntaxTree());
+        AST::SourceElement *element = program->elements ? program->elements->element : 0;
+        if (element && (element->kind == AST::Node::Kind_StatementSourceElement)) {
+            AST::Statement *statement = static_cast<AST::StatementSourceElement*>(element)->statement;
+            if (statement->kind == AST::Node::Kind_ExpressionStatement) {
+                AST::ExpressionNode *expression = static_cast<AST::ExpressionStatement*>(statement)->expression;
+                if (expression->kind == AST::Node::Kind_FunctionExpression)
+                    parsed = static_cast<AST::FunctionExpression*>(expression);
+            }
+        }
+    }
+    m_engine->setLexer(0);
+    m_engine->setNodePool(previousPool);
+
+    // the hash may have grown while parsing
+    m_lazyFunctions[function].parsed = parsed;
+    return parsed;
+}
+
 class EvalFunction : public QScriptFunction
 {
 public:
@@ -305,54 +358,88 @@ public:
         QScriptEnginePrivate *eng_p = context->engine();
 
         QExplicitlySharedDataPointer<NodePool> pool;
-        pool = new NodePool(fileName, eng_p);
-        eng_p->setNodePool(pool.data());
-
         QString errorMessage;
         int errorLineNumber;
+        Code *code = compile(eng_p, contents, lineNo, fileName, /*keepLines=*/ false,
+                             &pool, &errorMessage, &errorLineNumber);
+
+        if (!code) {
+            throwSyntaxError(context, pool.data(), errorMessage, errorLineNumber);
+            return;
+        }
+
+        run(context, code, calledFromScript);
+    }
+
+    // parses and compiles \a contents into a new node pool; returns 0
+    // and sets the error if that fails. \a keepLines is set for code
+    // that is cached or shared; see QScript::Optimizer
+    static Code *compile(QScriptEnginePrivate *eng_p, const QString &contents,
+                         int lineNo, const QString &fileName, bool keepLines,
+                         QExplicitlySharedDataPointer<NodePool> *pool,
+                         QString *errorMessage, int *errorLineNumber)
+    {
+        *pool = new NodePool(fileName, eng_p);
+        (*pool)->setKeepLines(keepLines);
+        eng_p->setNodePool(pool->data());
+
+#ifndef Q_SCRIPT_NO_LAZY_FUNCTIONS
+        NodePool *lazyFunctions = pool->data();
+#else
+        NodePool *lazyFunctions = 0;
+#endif
         AST::Node *program = eng_p->createAbstractSyntaxTree(
-            contents, lineNo, &errorMessage, &errorLineNumber);
+            contents, lineNo, errorMessage, errorLineNumber, lazyFunctions);
 
         eng_p->setNodePool(0);
 
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
-        eng_p->notifyScriptLoad(pool->id(), contents, fileName, lineNo);
+        eng_p->notifyScriptLoad((*pool)->id(), contents, fileName, lineNo);
 #endif
 
         Code *code = 0;
         if (program) {
             Compiler compiler(eng_p);
             compiler.setTopLevelCompiler(true);
+            compiler.setKeepLines(keepLines);
             CompilationUnit compilation = compiler.compile(program);
             if (!compilation.isValid()) {
-                errorMessage = compilation.errorMessage();
-                errorLineNumber = compilation.errorLineNumber();
+                *errorMessage = compilation.errorMessage();
+                *errorLineNumber = compilation.errorLineNumber();
             } else {
-                code = pool->createCompiledCode(program, compilation);
+                code = (*pool)->createCompiledCode(program, compilation);
             }
         }
+        return code;
+    }
 
-        if (!code) {
-            context->errorLineNumber = errorLineNumber;
-            context->currentLine = errorLineNumber;
+    static void throwSyntaxError(QScriptContextPrivate *context, NodePool *pool,
+                                 const QString &errorMessage, int errorLineNumber)
+    {
+        context->errorLineNumber = errorLineNumber;
+        context->currentLine = errorLineNumber;
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
-            Code *oldCode = context->m_code;
-            Code dummy;
-            dummy.astPool = pool.data();
-            context->m_code = &dummy; // so agents get the script ID
-            bool wasEvaluating = eng_p->m_evaluating;
-            eng_p->m_evaluating = true;
-            eng_p->notifyFunctionEntry(context);
+        QScriptEnginePrivate *eng_p = context->engine();
+        Code *oldCode = context->m_code;
+        Code dummy;
+        dummy.astPool = pool;
+        context->m_code = &dummy; // so agents get the script ID
+        bool wasEvaluating = eng_p->m_evaluating;
+        eng_p->m_evaluating = true;
+        eng_p->notifyFunctionEntry(context);
+#else
+        Q_UNUSED(pool);
 #endif
-            context->throwError(QScriptContext::SyntaxError, errorMessage);
+        context->throwError(QScriptContext::SyntaxError, errorMessage);
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
-            eng_p->notifyFunctionExit(context);
-            eng_p->m_evaluating = wasEvaluating;
-            context->m_code = oldCode;
+        eng_p->notifyFunctionExit(context);
+        eng_p->m_evaluating = wasEvaluating;
+        context->m_code = oldCode;
 #endif
-            return;
-        }
+    }
 
+    static void run(QScriptContextPrivate *context, Code *code, bool calledFromScript)
+    {
         if (calledFromScript) {
             if (QScriptContextPrivate *pc = context->parentContext()) {
                 context->setActivationObject(pc->activationObject());
@@ -474,7 +561,9 @@ bool ArgumentsClassData::put(QScriptValueImpl *object, const QScript::Member &me
     Q_ASSERT(member.nameId() == 0);
     QScript::ArgumentsObjectData *data = ArgumentsClassData::get(*object);
     QScriptObject *activation_data = data->activation.objectValue();
+    activation_data->aboutToChange();
     activation_data->m_values[member.id()] = value;
+    activation_data->writeBarrier(value);
     return true;
 }
 
@@ -546,6 +635,14 @@ const qsreal QScriptEnginePrivate::D32 = 4294967296.0;
 
 QScriptEnginePrivate::~QScriptEnginePrivate()
 {
+    delete m_baseline;
+    m_baseline = 0;
+    delete m_profiler;
+    m_profiler = 0;
+
+    // drop the code that programs have compiled for this engine
+    QScriptProgramPrivate::releaseAll(this);
+
     while (!m_agents.isEmpty())
         delete m_agents.takeFirst();
 
@@ -573,7 +670,6 @@ QScriptEnginePrivate::~QScriptEnginePrivate()
             it.value()->nameId = 0;
     }
 
-    delete[] m_string_hash_base;
     qDeleteAll(m_stringRepository);
     qDeleteAll(m_tempStringRepository);
 
@@ -598,14 +694,22 @@ QScript::AST::Node *QScriptEnginePrivate::changeAbstractSyntaxTree(QScript::AST:
     return was;
 }
 
+// parses \a source into the current node pool; if \a lazyFunctions is
+// set, the bodies of the functions are only checked for syntax errors,
+// and parsed again from \a source on their first call
 QScript::AST::Node *QScriptEnginePrivate::createAbstractSyntaxTree(
-    const QString &source, int lineNumber, QString *errorMessage, int *errorLineNumber)
+    const QString &source, int lineNumber, QString *errorMessage, int *errorLineNumber,
+    QScript::NodePool *lazyFunctions)
 {
     QScript::Lexer lex(this);
     setLexer(&lex);
     lex.setCode(source, lineNumber);
 
     QScriptParser parser;
+    if (lazyFunctions) {
+        lazyFunctions->setSource(source);
+        parser.setLazyFunctions(lazyFunctions, /*depth=*/ 0, /*offset=*/ 0);
+    }
 
     if (! parser.parse(this)) {
         if (errorMessage)
@@ -625,7 +729,12 @@ void QScriptEnginePrivate::markObject(const QScriptValueImpl &object, int genera
 
     enum { MAX_GC_DEPTH = 32 };
 
-    if (block->generation + 1 != generation)
+    if (int(block->generation) == generation)
+        return;
+
+    // tenured objects can only reach the nursery through the
+    // remembered set, so a minor collection stops at them
+    if (m_gc_minor && block->tenured)
         return;
 
     if (m_gc_depth >= MAX_GC_DEPTH) {
@@ -634,8 +743,15 @@ void QScriptEnginePrivate::markObject(const QScriptValueImpl &object, int genera
         return;
     }
 
-    ++block->generation;
+    block->generation = generation;
     ++m_gc_depth;
+    markChildren(object, generation);
+    --m_gc_depth;
+}
+
+void QScriptEnginePrivate::markChildren(const QScriptValueImpl &object, int generation)
+{
+    QScriptObject *instance = object.objectValue();
 
     if (QScriptClassData *data = object.classInfo()->data())
         data->mark(object, generation);
@@ -653,7 +769,7 @@ void QScriptEnginePrivate::markObject(const QScriptValueImpl &object, int genera
             markObject(internalValue, generation);
 
         else if (internalValue.isString())
-            markString(internalValue.m_string_value, generation);
+            markString(internalValue.stringValue(), generation);
     }
 
     int garbage = 0;
@@ -682,30 +798,27 @@ void QScriptEnginePrivate::markObject(const QScriptValueImpl &object, int genera
             markObject(child, generation);
 
         else if (child.isString())
-            markString(child.m_string_value, generation);
+            markString(child.stringValue(), generation);
     }
 
-    --m_gc_depth;
-
     if (garbage < 128) // ###
         return;
 
-    int j = 0;
-    for (int i = 0; i < instance->memberCount(); ++i) {
-        QScript::Member m;
-        instance->member(i, &m);
+    // only dictionary layouts can contain removed members
+    QScript::Shape *shape = instance->shape();
+    Q_ASSERT(shape->isDictionary());
 
-        if (! m.isValid())
+    int j = 0;
+    for (int i = 0; i < shape->size(); ++i) {
+        if (! shape->at(i).isValid())
             continue;
 
-        if (i != j) {
-            instance->m_members[j].object(m.nameId(), j, m.flags());
+        if (i != j)
             instance->m_values[j] = instance->m_values[i];
-        }
         ++j;
     }
-    //qDebug() << "==> old:" << instance->m_members.size() << "new:" << j;
-    instance->m_members.resize(j);
+    //qDebug() << "==> old:" << shape->size() << "new:" << j;
+    shape->compact();
     instance->m_values.resize(j);
 }
 
@@ -737,7 +850,7 @@ void QScriptEnginePrivate::markFrame(QScriptContextPrivate *context, int generat
             markObject(context->returnValue(), generation);
 
         else if (context->returnValue().isString())
-            markString(context->returnValue().m_string_value, generation);
+            markString(context->returnValue().stringValue(), generation);
     }
 
     if (context->baseStackPointer() != context->currentStackPointer()) {
@@ -756,7 +869,7 @@ void QScriptEnginePrivate::markFrame(QScriptContextPrivate *context, int generat
                 markObject(*it, generation);
 
             else if (it->isString())
-                markString(it->m_string_value, generation);
+                markString(it->stringValue(), generation);
         }
     }
 }
@@ -767,15 +880,32 @@ bool QScriptEnginePrivate::isCollecting() const
 }
 
 void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
+{
+    // the strings are only marked completely by a major collection
+    collect(/*minor=*/! do_string_gc && ! objectAllocator.pollMajor(), do_string_gc);
+}
+
+void QScriptEnginePrivate::collect(bool minor, bool do_string_gc)
 {
     // qDebug() << "==>" << objectAllocator.newAllocatedBlocks() << "free:" << objectAllocator.freeBlocks();
     Q_ASSERT(m_gc_depth == -1);
+    Q_ASSERT(! minor || ! do_string_gc);
     ++m_gc_depth;
 
-    int generation = m_objectGeneration + 1;
+    int generation = (m_objectGeneration + 1) & QScript::GCBlock::GenerationMask;
+
+    m_gc_minor = minor;
+
+    // the spare activations aren't referenced; they are left to be
+    // collected, so that the ones kept afterwards are all young
+    for (int i = 0; i < m_frameStack.capacity(); ++i)
+        m_frameStack.at(i)->m_spareActivation = 0;
 
     markObject(m_globalObject, generation);
 
+    if (m_baseline && ! m_gc_minor)
+        m_baseline->mark(generation);
+
     objectConstructor->mark(this, generation);
     numberConstructor->mark(this, generation);
     booleanConstructor->mark(this, generation);
@@ -785,11 +915,15 @@ void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
     arrayConstructor->mark(this, generation);
     regexpConstructor->mark(this, generation);
     errorConstructor->mark(this, generation);
-    enumerationConstructor->mark(this, generation);
-    variantConstructor->mark(this, generation);
+    if (m_enumerationConstructor)
+        m_enumerationConstructor->mark(this, generation);
+    if (m_variantConstructor)
+        m_variantConstructor->mark(this, generation);
 #ifndef QT_NO_QOBJECT
-    qobjectConstructor->mark(this, generation);
-    qmetaObjectConstructor->mark(this, generation);
+    if (m_qobjectConstructor)
+        m_qobjectConstructor->mark(this, generation);
+    if (m_qmetaObjectConstructor)
+        m_qmetaObjectConstructor->mark(this, generation);
 #endif
 
     {
@@ -800,6 +934,16 @@ void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
         }
     }
 
+    if (m_gc_minor) {
+        const QVector<QScript::GCBlock*> &remembered = objectAllocator.rememberedSet();
+        for (int i = 0; i < remembered.size(); ++i) {
+            QScriptValueImpl object;
+            object.setObjectValue(reinterpret_cast<QScriptObject*>(remembered.at(i)->data()));
+            markChildren(object, generation);
+        }
+        m_gcStatistics.rememberedObjects += remembered.size();
+    }
+
     {
         QHash<QScriptObject*, QScriptValuePrivate*>::const_iterator it;
         for (it = m_objectHandles.constBegin(); it != m_objectHandles.constEnd(); ++it)
@@ -852,8 +996,18 @@ void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
     Q_ASSERT(m_gc_depth == 0);
     --m_gc_depth;
 
-    objectAllocator.sweep(generation);
+    const int tenured = objectAllocator.tenuredBlocks();
+    objectAllocator.sweep(generation, m_gc_minor);
+
+    if (m_gc_minor) {
+        ++m_gcStatistics.minorCollections;
+        m_gcStatistics.promotedObjects += objectAllocator.tenuredBlocks() - tenured;
+    } else {
+        ++m_gcStatistics.majorCollections;
+    }
+    m_gcStatistics.tenuredObjects = objectAllocator.tenuredBlocks();
 
+    m_gc_minor = false;
     m_objectGeneration = generation;
 
     //qDebug() << "free blocks:" << objectAllocator.freeBlocks();
@@ -891,13 +1045,15 @@ void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
 
         else {
             //qDebug() << "deleted unique:" << entry->s;
+            if (m_baseline)
+                m_baseline->stringRemoved(compressed.size());
             delete entry;
       }
     }
 
-    // qDebug() << "before:" << m_stringRepository.size() << "after:" << compressed.size() << globalObject.objectValue()->m_members.size();
+    // qDebug() << "before:" << m_stringRepository.size() << "after:" << compressed.size() << globalObject.objectValue()->memberCount();
     m_stringRepository = compressed;
-    rehashStringRepository(/*resize=*/ false);
+    m_stringTable.rebuild(m_stringRepository);
     m_oldStringRepositorySize = m_stringRepository.size();
     m_newAllocatedStringRepositoryChars = 0;
 
@@ -912,6 +1068,8 @@ void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
 
         else {
           //qDebug() << "deleted:" << entry->s;
+            if (m_baseline)
+                m_baseline->tempStringRemoved(compressed.size());
             delete entry;
       }
     }
@@ -923,6 +1081,16 @@ void QScriptEnginePrivate::maybeGC_helper(bool do_string_gc)
     m_newAllocatedTempStringRepositoryChars = 0;
 }
 
+// slow path of QScriptObject::writeBarrier()
+void QScriptObject::remember()
+{
+    QScriptEnginePrivate *eng = m_class->engine();
+    // whatever survives a collection is tenured, so stores made while
+    // it runs don't have to be remembered
+    if (! eng->isCollecting())
+        eng->objectAllocator.remember(this);
+}
+
 void QScriptEnginePrivate::processMarkStack(int generation)
 {
     // mark the objects we couldn't process due to recursion depth
@@ -937,6 +1105,120 @@ void QScriptEnginePrivate::evaluate(QScriptContextPrivate *context, const QStrin
     evalFunction->evaluate(context, contents, lineNumber, fileName, /*calledFromScript=*/ false);
 }
 
+void QScriptEnginePrivate::evaluate(QScriptContextPrivate *context, QScriptProgramPrivate *program)
+{
+    // free the code of programs that were dropped or moved to another
+    // engine since the last time
+    QList<QExplicitlySharedDataPointer<QScript::NodePool> > releasedPools;
+    {
+        QMutexLocker locker(QScriptProgramPrivate::engineMutex());
+        releasedPools = m_releasedPools;
+        m_releasedPools.clear();
+    }
+    releasedPools.clear();
+
+    // the program may be evaluated by other engines meanwhile, so work on
+    // a copy of what was compiled for this one; the pool keeps the code
+    // alive even if the program is dropped while it runs
+    QScriptProgramPrivate::Compiled compiled;
+    bool found;
+    {
+        QMutexLocker locker(QScriptProgramPrivate::engineMutex());
+        QHash<QScriptEnginePrivate*, QScriptProgramPrivate::Compiled>::const_iterator it;
+        it = program->compiled.constFind(this);
+        found = (it != program->compiled.constEnd());
+        if (found)
+            compiled = it.value();
+    }
+
+    if (!found) {
+        QByteArray precompiled;
+        {
+            QMutexLocker locker(&program->mutex);
+            precompiled = program->precompiled;
+        }
+        if (!precompiled.isEmpty()) {
+            QScript::CodeCache cache(QString(), program->sourceCode, program->firstLineNumber);
+            compiled.code = cache.load(this, precompiled, program->fileName, &compiled.pool);
+        }
+
+        if (compiled.code) {
+            // no need to compile or look in the cache directory
+        } else if (m_codeCacheDirectory.isEmpty()) {
+            compiled.code = QScript::EvalFunction::compile(
+                this, program->sourceCode, program->firstLineNumber, program->fileName,
+                /*keepLines=*/ true, &compiled.pool, &compiled.errorMessage, &compiled.errorLineNumber);
+        } else {
+            QScript::CodeCache cache(m_codeCacheDirectory, program->sourceCode,
+                                     program->firstLineNumber);
+            compiled.code = cache.load(this, program->fileName, &compiled.pool);
+            if (!compiled.code) {
+                compiled.code = QScript::EvalFunction::compile(
+                    this, program->sourceCode, program->firstLineNumber, program->fileName,
+                    /*keepLines=*/ true, &compiled.pool, &compiled.errorMessage, &compiled.errorLineNumber);
+                if (compiled.code)
+                    cache.save(compiled.code);
+            }
+        }
+
+        QMutexLocker locker(QScriptProgramPrivate::engineMutex());
+        program->compiled.insert(this, compiled);
+        m_compiledPrograms.insert(program);
+    }
+
+    if (!compiled.code) {
+        QScript::EvalFunction::throwSyntaxError(context, compiled.pool.data(), compiled.errorMessage,
+                                                compiled.errorLineNumber);
+        return;
+    }
+
+    QScript::EvalFunction::run(context, compiled.code, /*calledFromScript=*/ false);
+}
+
+Q_GLOBAL_STATIC(QThreadStorage<QScriptEngine*>, compilerEngines)
+
+// compiles a program with an engine that belongs to the calling thread,
+// and returns it in the format of the code cache, which any engine can
+// load; returns an empty array if the program has a syntax error
+QByteArray QScriptEnginePrivate::precompile(const QString &sourceCode,
+                                            const QString &fileName,
+                                            int firstLineNumber)
+{
+    QThreadStorage<QScriptEngine*> *engines = compilerEngines();
+    if (!engines)
+        return QByteArray();
+    if (!engines->hasLocalData())
+        engines->setLocalData(new QScriptEngine());
+    QScriptEnginePrivate *eng_p = QScriptEnginePrivate::get(engines->localData());
+
+    // the compiler makes the names it interns persistent for the sake of
+    // the code, which is thrown away once it is serialized; the names are
+    // released and collected afterwards, so that the engine of a thread
+    // that compiles many programs doesn't keep all their names
+    const bool wasBlocked = eng_p->blockGC(true);
+    const int nameCount = eng_p->m_stringRepository.size();
+
+    QByteArray data;
+    {
+        QExplicitlySharedDataPointer<QScript::NodePool> pool;
+        QString errorMessage;
+        int errorLineNumber = -1;
+        QScript::Code *code = QScript::EvalFunction::compile(
+            eng_p, sourceCode, firstLineNumber, fileName, /*keepLines=*/ true,
+            &pool, &errorMessage, &errorLineNumber);
+        if (code) {
+            QScript::CodeCache cache(QString(), sourceCode, firstLineNumber);
+            data = cache.serialize(code);
+        }
+    }
+
+    for (int i = nameCount; i < eng_p->m_stringRepository.size(); ++i)
+        eng_p->m_stringRepository.at(i)->persistent = false;
+    eng_p->blockGC(wasBlocked);
+    eng_p->gc();
+    return data;
+}
+
 qsreal QScriptEnginePrivate::convertToNativeDouble_helper(const QScriptValueImpl &value)
 {
     switch (value.type()) {
@@ -952,17 +1234,17 @@ qsreal QScriptEnginePrivate::convertToNativeDouble_helper(const QScriptValueImpl
         return 0;
 
     case QScript::BooleanType:
-        return value.m_bool_value;
+        return value.boolValue();
 
     case QScript::IntegerType:
     case QScript::ReferenceType:
-        return value.m_int_value;
+        return value.intValue();
 
     case QScript::NumberType:
-        return value.m_number_value;
+        return value.numberValue();
 
     case QScript::StringType:
-        return QScript::numberFromString(toString(value.m_string_value));
+        return QScript::numberFromString(toString(value.stringValue()));
 
     case QScript::ObjectType: {
         QScriptValueImpl p = value.engine()->toPrimitive(value, QScriptValueImpl::NumberTypeHint);
@@ -973,7 +1255,7 @@ qsreal QScriptEnginePrivate::convertToNativeDouble_helper(const QScriptValueImpl
     }
 
     case QScript::LazyStringType:
-        return QScript::numberFromString(*value.m_lazy_string_value);
+        return QScript::numberFromString(*value.lazyStringValue());
 
     } // switch
 
@@ -994,22 +1276,22 @@ bool QScriptEnginePrivate::convertToNativeBoolean_helper(const QScriptValueImpl
         return false;
 
     case QScript::BooleanType:
-        return value.m_bool_value;
+        return value.boolValue();
 
     case QScript::IntegerType:
-        return value.m_int_value != 0;
+        return value.intValue() != 0;
 
     case QScript::NumberType:
-        return value.m_number_value != 0 && !qIsNaN(value.m_number_value);
+        return value.numberValue() != 0 && !qIsNaN(value.numberValue());
 
     case QScript::StringType:
-        return toString(value.m_string_value).length() != 0;
+        return toString(value.stringValue()).length() != 0;
 
     case QScript::ObjectType:
         return true;
 
     case QScript::LazyStringType:
-        return value.m_lazy_string_value->length() != 0;
+        return value.lazyStringValue()->length() != 0;
 
     } // switch
 
@@ -1039,19 +1321,19 @@ QString QScriptEnginePrivate::convertToNativeString_helper(const QScriptValueImp
         return predefined.at(1);
 
     case QScript::BooleanType:
-        return value.m_bool_value ? predefined.at(2) : predefined.at(3);
+        return value.boolValue() ? predefined.at(2) : predefined.at(3);
 
     case QScript::IntegerType:
-        return QString::number(value.m_int_value);
+        return QString::number(value.intValue());
 
     case QScript::NumberType:
-        return QScript::numberToString(value.m_number_value);
+        return QScript::numberToString(value.numberValue());
 
     case QScript::PointerType:
         return predefined.at(4);
 
     case QScript::StringType:
-        return toString(value.m_string_value);
+        return toString(value.stringValue());
 
     case QScript::ReferenceType:
         return QString();
@@ -1066,7 +1348,7 @@ QString QScriptEnginePrivate::convertToNativeString_helper(const QScriptValueImp
     }
 
     case QScript::LazyStringType:
-        return *value.m_lazy_string_value;
+        return *value.lazyStringValue();
 
     } // switch
 
@@ -1078,19 +1360,19 @@ QScriptValueImpl QScriptEnginePrivate::toObject_helper(const QScriptValueImpl &v
     QScriptValueImpl result;
     switch (value.type()) {
     case QScript::BooleanType:
-        booleanConstructor->newBoolean(&result, value.m_bool_value);
+        booleanConstructor->newBoolean(&result, value.boolValue());
         break;
 
     case QScript::NumberType:
-        numberConstructor->newNumber(&result, value.m_number_value);
+        numberConstructor->newNumber(&result, value.numberValue());
         break;
 
     case QScript::StringType:
-        stringConstructor->newString(&result, value.m_string_value->s);
+        stringConstructor->newString(&result, value.stringValue()->string());
         break;
 
     case QScript::LazyStringType:
-        stringConstructor->newString(&result, *value.m_lazy_string_value);
+        stringConstructor->newString(&result, *value.lazyStringValue());
         break;
 
     case QScript::InvalidType:
@@ -1155,41 +1437,14 @@ QScriptValueImpl QScriptEnginePrivate::toPrimitive_helper(const QScriptValueImpl
     return object;
 }
 
-void QScriptEnginePrivate::rehashStringRepository(bool resize)
-{
-    if (resize) {
-        delete[] m_string_hash_base;
-        m_string_hash_size <<= 1; // ### use primes
-
-        m_string_hash_base = new QScriptNameIdImpl* [m_string_hash_size];
-    }
-
-    memset(m_string_hash_base, 0, sizeof(QScriptNameIdImpl*) * m_string_hash_size);
-
-    for (int index = 0; index < m_stringRepository.size(); ++index) {
-        QScriptNameIdImpl *entry = m_stringRepository.at(index);
-        uint h = _q_scriptHash(entry->s) % m_string_hash_size;
-        entry->h = h;
-        entry->next = m_string_hash_base[h];
-        m_string_hash_base[h] = entry;
-    }
-}
-
-QScriptNameIdImpl *QScriptEnginePrivate::insertStringEntry(const QString &s)
+QScriptNameIdImpl *QScriptEnginePrivate::insertStringEntry(const QString &s, uint hash)
 {
     QScriptNameIdImpl *entry = new QScriptNameIdImpl(s);
     entry->unique = true;
+    entry->h = hash;
     m_stringRepository.append(entry);
     m_newAllocatedStringRepositoryChars += s.length();
-
-    uint h = _q_scriptHash(s) % m_string_hash_size;
-    entry->h = h;
-    entry->next = m_string_hash_base[h];
-    m_string_hash_base[h] = entry;
-
-    if (m_stringRepository.count() == m_string_hash_size)
-        rehashStringRepository();
-
+    m_stringTable.insert(entry);
     return entry;
 }
 
@@ -1211,25 +1466,20 @@ QScriptValueImpl QScriptEnginePrivate::call(const QScriptValueImpl &callee,
     if (! nested->tempStack)
         nested->stackPtr = nested->tempStack = tempStackBegin;
 
-    newActivation(&nested->m_activation);
-    if (callee.m_object_value->m_scope.isValid())
-        nested->m_activation.m_object_value->m_scope = callee.m_object_value->m_scope;
+    newActivation(nested, function);
+    if (callee.objectValue()->m_scope.isValid())
+        nested->m_activation.objectValue()->m_scope = callee.objectValue()->m_scope;
     else
-        nested->m_activation.m_object_value->m_scope = m_globalObject;
+        nested->m_activation.objectValue()->m_scope = m_globalObject;
 
-    QScriptObject *activation_data = nested->m_activation.m_object_value;
+    QScriptObject *activation_data = nested->m_activation.objectValue();
 
     int formalCount = function->formals.count();
     int argc = args.count();
     int mx = qMax(formalCount, argc);
-    activation_data->m_members.resize(mx);
-    activation_data->m_values.resize(mx);
+    activation_data->setShape(function->activationShape(activation_data->m_class, mx,
+                                                        QScriptValue::SkipInEnumeration));
     for (int i = 0; i < mx; ++i) {
-        QScriptNameIdImpl *nameId = 0;
-        if (i < formalCount)
-            nameId = function->formals.at(i);
-
-        activation_data->m_members[i].object(nameId, i, QScriptValue::SkipInEnumeration);
         QScriptValueImpl arg = (i < argc) ? args.at(i) : m_undefinedValue;
         if (arg.isValid() && arg.engine() && (arg.engine() != this)) {
             qWarning("QScriptValue::call() failed: "
@@ -1594,6 +1844,8 @@ bool QScriptEnginePrivate::convert(const QScriptValueImpl &value,
         int valueType = QMetaType::type(name.left(name.size()-1));
         QVariant &var = value.variantValue();
         if (valueType == var.userType()) {
+            // the caller gets to change the value through the pointer
+            value.objectValue()->aboutToChange();
             *reinterpret_cast<void* *>(ptr) = var.data();
             return true;
         } else {
@@ -1713,6 +1965,7 @@ QScriptEnginePrivate::QScriptEnginePrivate()
 #else
     m_maxCallDepth = 512;
 #endif
+    m_baseline = 0;
     m_oldStringRepositorySize = 0;
     m_oldTempStringRepositorySize = 0;
     m_newAllocatedStringRepositoryChars = 0;
@@ -1726,6 +1979,12 @@ QScriptEnginePrivate::QScriptEnginePrivate()
     m_class_prev_id = QScriptClassInfo::CustomType;
     m_next_object_id = 0;
     m_gc_depth = -1;
+    m_gc_minor = false;
+    m_gcStatistics.minorCollections = 0;
+    m_gcStatistics.majorCollections = 0;
+    m_gcStatistics.promotedObjects = 0;
+    m_gcStatistics.rememberedObjects = 0;
+    m_gcStatistics.tenuredObjects = 0;
 
     objectConstructor = 0;
     numberConstructor = 0;
@@ -1736,19 +1995,17 @@ QScriptEnginePrivate::QScriptEnginePrivate()
     arrayConstructor = 0;
     regexpConstructor = 0;
     errorConstructor = 0;
-    enumerationConstructor = 0;
-    variantConstructor = 0;
-    qobjectConstructor = 0;
-    qmetaObjectConstructor = 0;
+    m_enumerationConstructor = 0;
+    m_variantConstructor = 0;
+    m_qobjectConstructor = 0;
+    m_qmetaObjectConstructor = 0;
 
     m_processEventsInterval = -1;
     m_nextProcessEvents = 0;
     m_processEventIncr = 0;
+    m_profiler = 0;
 
     m_stringRepository.reserve(DefaultHashSize);
-    m_string_hash_size = DefaultHashSize;
-    m_string_hash_base = new QScriptNameIdImpl* [m_string_hash_size];
-    memset(m_string_hash_base, 0, sizeof(QScriptNameIdImpl*) * m_string_hash_size);
 
     tempStackBegin = 0;
 }
@@ -1761,6 +2018,9 @@ void QScriptEnginePrivate::init()
     qMetaTypeId<QObjectList>();
 #endif
 
+    if (! m_snapshot.isNull())
+        m_snapshot.loadStrings(this);
+
     m_class_prev_id = QScriptClassInfo::CustomType;
     m_class_object = registerClass(QLatin1String("Object"), QScriptClassInfo::ObjectType);
     m_class_function = registerClass(QLatin1String("Function"), QScriptClassInfo::FunctionType);
@@ -1858,14 +2118,20 @@ void QScriptEnginePrivate::init()
     QScript::Ecma::Math::construct(&mathObject, this);
     m_globalObject.setProperty(QLatin1String("Math"), mathObject, flags);
 
-    enumerationConstructor = new QScript::Ext::Enumeration(this);
+    QScriptValueImpl jsonObject;
+    QScript::Ecma::Json::construct(&jsonObject, this);
+    m_globalObject.setProperty(QLatin1String("JSON"), jsonObject, flags);
 
-    variantConstructor = new QScript::Ext::Variant(this);
+    // the Enumeration, QVariant, QObject and QMetaObject constructors
+    // are created on first use; see enumerationConstructor() and friends
 
-#ifndef QT_NO_QOBJECT
-    qobjectConstructor = new QScript::ExtQObject(this);
-    qmetaObjectConstructor = new QScript::ExtQMetaObject(this);
-#endif
+    // with a snapshot, the objects created so far have none of the
+    // functions of the built-in objects yet; their members and everything
+    // they refer to are copied from the snapshot
+    if (! m_snapshot.isNull()) {
+        m_snapshot.installObjects(this);
+        m_snapshot = QScript::EngineSnapshot();
+    }
 
     objectAllocator.blockGC(false);
 
@@ -1874,6 +2140,196 @@ void QScriptEnginePrivate::init()
     context_p->setThisObject(m_globalObject);
 }
 
+// returns a null snapshot if the engine holds something that a snapshot
+// can't describe, and sets errorMessage to what that is
+QScript::EngineSnapshot QScriptEnginePrivate::takeSnapshot(QString *errorMessage)
+{
+    return QScript::EngineSnapshot::capture(this, errorMessage);
+}
+
+// makes the current state of the engine the one that resetToBaseline()
+// returns to
+void QScriptEnginePrivate::recordBaseline()
+{
+    Q_ASSERT(! m_evaluating);
+    Q_ASSERT(! objectAllocator.blocked());
+
+    if (! m_baseline)
+        m_baseline = new QScript::Baseline(this);
+
+    // everything that survives a major collection is tenured and
+    // becomes part of the baseline
+    collect(/*minor=*/false, /*do_string_gc=*/true);
+    m_baseline->record();
+
+#ifndef QT_NO_QOBJECT
+    {
+        QHash<QObject*, QScriptQObjectData*>::const_iterator it;
+        for (it = m_qobjectData.constBegin(); it != m_qobjectData.constEnd(); ++it)
+            it.value()->markBaseline();
+    }
+#endif
+}
+
+// brings the engine back to the state it had when recordBaseline() was
+// called; the work done is proportional to what was changed since then,
+// not to the size of the baseline
+void QScriptEnginePrivate::resetToBaseline()
+{
+    Q_ASSERT(m_baseline != 0);
+    Q_ASSERT(! m_evaluating);
+    Q_ASSERT(currentContext() && ! currentContext()->parentContext());
+
+    m_baseline->restore();
+
+    clearExceptions();
+    currentContext()->setReturnValue(m_undefinedValue);
+
+#ifndef QT_NO_QOBJECT
+    {
+        const QList<QObject*> senders = m_baseline->takeConnectedObjects();
+        for (int i = 0; i < senders.size(); ++i) {
+            QObject *sender = senders.at(i);
+            if (QScriptQObjectData *data = m_qobjectData.value(sender))
+                data->resetToBaseline(sender);
+        }
+    }
+#endif
+
+    // the baseline objects now only refer to each other, so a minor
+    // collection over everything allocated since finds what is still
+    // referenced from outside the engine
+    objectAllocator.untenureAfter(m_baseline->lastBlock());
+
+    for (int i = m_baseline->stringCount(); i < m_stringRepository.size(); ++i)
+        m_stringRepository.at(i)->used = false;
+    for (int i = m_baseline->tempStringCount(); i < m_tempStringRepository.size(); ++i)
+        m_tempStringRepository.at(i)->used = false;
+
+    collect(/*minor=*/true, /*do_string_gc=*/false);
+
+    {
+        QHash<QScriptNameIdImpl*, QScriptStringPrivate*>::const_iterator it;
+        for (it = m_internedStrings.constBegin(); it != m_internedStrings.constEnd(); ++it)
+            it.value()->nameId->used = true;
+    }
+
+    // the strings created since the baseline go away unless they're
+    // still in use; persistent ones may be referenced by compiled code
+    int j = m_baseline->stringCount();
+    for (int i = j; i < m_stringRepository.size(); ++i) {
+        QScriptNameIdImpl *entry = m_stringRepository.at(i);
+        if (entry->used || entry->persistent) {
+            entry->used = false;
+            m_stringRepository[j++] = entry;
+        } else {
+            m_stringTable.remove(entry);
+            delete entry;
+        }
+    }
+    m_stringRepository.resize(j);
+    m_oldStringRepositorySize = qMin(m_oldStringRepositorySize, j);
+
+    j = m_baseline->tempStringCount();
+    for (int i = j; i < m_tempStringRepository.size(); ++i) {
+        QScriptNameIdImpl *entry = m_tempStringRepository.at(i);
+        if (entry->used || entry->persistent) {
+            entry->used = false;
+            m_tempStringRepository[j++] = entry;
+        } else {
+            delete entry;
+        }
+    }
+    m_tempStringRepository.resize(j);
+    m_oldTempStringRepositorySize = qMin(m_oldTempStringRepositorySize, j);
+}
+
+void QScriptEnginePrivate::dropBaseline()
+{
+    if (! m_baseline)
+        return;
+
+    if (QScript::GCBlock *last = m_baseline->lastBlock()) {
+        for (QScript::GCBlock *blk = objectAllocator.head(); ; blk = blk->next) {
+            blk->baseline = 0;
+            if (blk == last)
+                break;
+        }
+    }
+
+    delete m_baseline;
+    m_baseline = 0;
+}
+
+namespace QScript {
+
+// gives access to the constructor that takes the private object
+class SnapshotEngine: public QScriptEngine
+{
+public:
+#ifdef QT_NO_QOBJECT
+    SnapshotEngine(QScriptEnginePrivate &dd)
+        : QScriptEngine(dd) { }
+#else
+    SnapshotEngine(QScriptEnginePrivate &dd, QObject *parent)
+        : QScriptEngine(dd, parent) { }
+#endif
+};
+
+} // namespace QScript
+
+// creates an engine that starts out with the interned strings and the
+// objects recorded in the given snapshot
+#ifdef QT_NO_QOBJECT
+QScriptEngine *QScriptEnginePrivate::createEngine(const QScript::EngineSnapshot &snapshot)
+{
+    QScriptEnginePrivate *d = new QScriptEnginePrivate;
+    d->m_snapshot = snapshot;
+    return new QScript::SnapshotEngine(*d);
+}
+#else
+QScriptEngine *QScriptEnginePrivate::createEngine(const QScript::EngineSnapshot &snapshot,
+                                                  QObject *parent)
+{
+    QScriptEnginePrivate *d = new QScriptEnginePrivate;
+    d->m_snapshot = snapshot;
+    return new QScript::SnapshotEngine(*d, parent);
+}
+#endif
+
+// the objects created by a constructor are only reachable through it
+// until it has been stored, so the collector must not run in between
+
+void QScriptEnginePrivate::createEnumerationConstructor()
+{
+    const bool wasBlocked = blockGC(true);
+    m_enumerationConstructor = new QScript::Ext::Enumeration(this);
+    blockGC(wasBlocked);
+}
+
+void QScriptEnginePrivate::createVariantConstructor()
+{
+    const bool wasBlocked = blockGC(true);
+    m_variantConstructor = new QScript::Ext::Variant(this);
+    blockGC(wasBlocked);
+}
+
+#ifndef QT_NO_QOBJECT
+void QScriptEnginePrivate::createQObjectConstructor()
+{
+    const bool wasBlocked = blockGC(true);
+    m_qobjectConstructor = new QScript::ExtQObject(this);
+    blockGC(wasBlocked);
+}
+
+void QScriptEnginePrivate::createQMetaObjectConstructor()
+{
+    const bool wasBlocked = blockGC(true);
+    m_qmetaObjectConstructor = new QScript::ExtQMetaObject(this);
+    blockGC(wasBlocked);
+}
+#endif
+
 #if !defined(QT_NO_QOBJECT) && !defined(QT_NO_LIBRARY)
 static QScriptValueImpl __setupPackage__(QScriptContextPrivate *ctx,
                                          QScriptEnginePrivate *eng,
@@ -2017,24 +2473,23 @@ QScriptValueImpl QScriptEnginePrivate::importExtension(const QString &extension)
         QScriptContextPrivate *ctx_p = pushContext();
         ctx_p->setThisObject(globalObject());
         newActivation(&ctx_p->m_activation);
-        QScriptObject *activation_data = ctx_p->m_activation.m_object_value;
+        QScriptObject *activation_data = ctx_p->m_activation.objectValue();
         activation_data->m_scope = globalObject();
 
-        activation_data->m_members.resize(4);
-        activation_data->m_values.resize(4);
-        activation_data->m_members[0].object(
-            nameId(QLatin1String("__extension__")), 0,
+        QScript::Member member;
+        activation_data->createMember(
+            nameId(QLatin1String("__extension__")), &member,
             QScriptValue::ReadOnly | QScriptValue::Undeletable);
-        activation_data->m_values[0] = QScriptValueImpl(this, ext);
-        activation_data->m_members[1].object(
-            nameId(QLatin1String("__setupPackage__")), 1, 0);
-        activation_data->m_values[1] = createFunction(__setupPackage__, 0, 0);
-        activation_data->m_members[2].object(
-            nameId(QLatin1String("__all__")), 2, 0);
-        activation_data->m_values[2] = undefinedValue();
-        activation_data->m_members[3].object(
-            nameId(QLatin1String("__postInit__")), 3, 0);
-        activation_data->m_values[3] = undefinedValue();
+        activation_data->put(member, QScriptValueImpl(this, ext));
+        activation_data->createMember(
+            nameId(QLatin1String("__setupPackage__")), &member, 0);
+        activation_data->put(member, createFunction(__setupPackage__, 0, 0));
+        activation_data->createMember(
+            nameId(QLatin1String("__all__")), &member, 0);
+        activation_data->put(member, undefinedValue());
+        activation_data->createMember(
+            nameId(QLatin1String("__postInit__")), &member, 0);
+        activation_data->put(member, undefinedValue());
 
         // the script is evaluated first
         if (!initjsContents.isEmpty()) {
@@ -2213,6 +2668,20 @@ void QScriptEnginePrivate::setupProcessEvents()
     }
 }
 
+QScript::Profiler *QScriptEnginePrivate::profiler()
+{
+    if (! m_profiler)
+        m_profiler = new QScript::Profiler(this);
+    return m_profiler;
+}
+
+void QScriptEnginePrivate::takeSample(QScriptContextPrivate *context)
+{
+    const int ticks = m_sampleTicks.fetchAndStoreRelaxed(0);
+    if ((ticks > 0) && m_profiler)
+        m_profiler->sample(context, ticks);
+}
+
 void QScriptEnginePrivate::abortEvaluation(const QScriptValueImpl &result)
 {
     m_abort = true;
@@ -2230,7 +2699,6 @@ void QScriptEnginePrivate::newQObject(QScriptValueImpl *out, QObject *object,
         *out = m_nullValue;
         return;
     }
-    Q_ASSERT(qobjectConstructor != 0);
     QScriptQObjectData *data = qobjectData(object);
     bool preferExisting = (options & QScriptEngine::PreferExistingWrapperObject) != 0;
     QScriptEngine::QObjectWrapOptions opt = options & ~QScriptEngine::PreferExistingWrapperObject;
@@ -2240,11 +2708,11 @@ void QScriptEnginePrivate::newQObject(QScriptValueImpl *out, QObject *object,
         if (hasExisting) {
             *out = existingWrapper;
         } else {
-            qobjectConstructor->newQObject(out, object, ownership, opt);
+            qobjectConstructor()->newQObject(out, object, ownership, opt);
             data->registerWrapper(*out, ownership, opt);
         }
     } else {
-        qobjectConstructor->newQObject(out, object, ownership, opt);
+        qobjectConstructor()->newQObject(out, object, ownership, opt);
         if (!hasExisting)
             data->registerWrapper(*out, ownership, opt);
     }
@@ -2340,10 +2808,14 @@ bool QScriptEnginePrivate::scriptConnect(QObject *sender, int signalIndex,
                                          const QScriptValueImpl &receiver,
                                          const QScriptValueImpl &function,
                                          const QScriptValueImpl &senderWrapper,
-                                         Qt::ConnectionType type)
+                                         Qt::ConnectionType type,
+                                         SignalCoalescing coalescing)
 {
     QScriptQObjectData *data = qobjectData(sender);
-    return data->addSignalHandler(sender, signalIndex, receiver, function, senderWrapper, type);
+    if (m_baseline)
+        m_baseline->addConnectedObject(sender);
+    return data->addSignalHandler(sender, signalIndex, receiver, function, senderWrapper,
+                                  type, coalescing);
 }
 
 bool QScriptEnginePrivate::scriptDisconnect(QObject *sender, int signalIndex,
@@ -2359,11 +2831,13 @@ bool QScriptEnginePrivate::scriptDisconnect(QObject *sender, int signalIndex,
 bool QScriptEnginePrivate::scriptConnect(const QScriptValueImpl &signal,
                                          const QScriptValueImpl &receiver,
                                          const QScriptValueImpl &function,
-                                         Qt::ConnectionType type)
+                                         Qt::ConnectionType type,
+                                         SignalCoalescing coalescing)
 {
     QScript::QtFunction *fun = static_cast<QScript::QtFunction*>(signal.toFunction());
     int index = fun->mostGeneralMethod();
-    return scriptConnect(fun->qobject(), index, receiver, function, fun->object(), type);
+    return scriptConnect(fun->qobject(), index, receiver, function, fun->object(),
+                         type, coalescing);
 }
 
 bool QScriptEnginePrivate::scriptDisconnect(const QScriptValueImpl &signal,
@@ -2528,7 +3002,7 @@ QScriptValueImpl QScriptEnginePrivate::toImpl_helper(const QScriptValue &value)
     QScriptValuePrivate *p = QScriptValuePrivate::get(value);
     Q_ASSERT(p != 0);
     Q_ASSERT(p->value.type() == QScript::LazyStringType);
-    QString str = *p->value.m_lazy_string_value;
+    QString str = *p->value.lazyStringValue();
     if (!p->ref.deref())
         delete p;
     QScriptValueImpl v;
@@ -2571,8 +3045,7 @@ QScriptValueImpl QScriptEnginePrivate::objectById(qint64 id) const
         const QScriptObject *obj = it.data();
         if (obj->m_id == id) {
             QScriptValueImpl ret;
-            ret.m_type = QScript::ObjectType;
-            ret.m_object_value = const_cast<QScriptObject*>(obj);
+            ret.setObjectValue(const_cast<QScriptObject*>(obj));
             return ret;
         }
     }
@@ -65,6 +65,7 @@
 #include "qscriptecmanumber_p.h"
 #include "qscriptecmastring_p.h"
 #include "qscriptecmafunction_p.h"
+#include "qscriptfunction_p.h"
 #include "qscriptextvariant_p.h"
 #include "qscriptextqobject_p.h"
 #include "qscriptvalue_p.h"
@@ -124,7 +125,7 @@ inline QString QScriptEnginePrivate::toString(QScriptNameIdImpl *id)
     if (! id)
         return QString();
 
-    return id->s;
+    return id->string();
 }
 
 inline QString QScriptEnginePrivate::memberName(const QScript::Member &member) const
@@ -135,8 +136,7 @@ inline QString QScriptEnginePrivate::memberName(const QScript::Member &member) c
 inline void QScriptEnginePrivate::newReference(QScriptValueImpl *o, int mode)
 {
     Q_ASSERT(o);
-    o->m_type = QScript::ReferenceType;
-    o->m_int_value = (mode);
+    o->setReferenceValue(mode);
 }
 
 inline void QScriptEnginePrivate::newActivation(QScriptValueImpl *o)
@@ -145,42 +145,84 @@ inline void QScriptEnginePrivate::newActivation(QScriptValueImpl *o)
     newObject(o, nullValue(), m_class_activation);
 }
 
+// the activation of a call in the given frame. A call to a script function
+// takes over the activation the previous call in the frame left behind,
+// if any; popContext() leaves it when nothing but that call could refer
+// to it
+inline void QScriptEnginePrivate::newActivation(QScriptContextPrivate *context,
+                                                QScriptFunction *function)
+{
+    if (function->type() != QScriptFunction::Script) {
+        newActivation(&context->m_activation);
+        return;
+    }
+    context->m_activationCaptured = false;
+    if (QScriptObject *spare = context->m_spareActivation) {
+        context->m_spareActivation = 0;
+        spare->m_id = ++m_next_object_id;
+        context->m_activation.setObjectValue(spare);
+    } else {
+        newActivation(&context->m_activation);
+    }
+}
+
 inline void QScriptEnginePrivate::newPointer(QScriptValueImpl *o, void *ptr)
 {
     Q_ASSERT(o);
-    o->m_type = QScript::PointerType;
-    o->m_ptr_value = ptr;
+    o->setPointerValue(ptr);
 }
 
 inline void QScriptEnginePrivate::newInteger(QScriptValueImpl *o, int i)
 {
     Q_ASSERT(o);
-    o->m_type = QScript::IntegerType;
-    o->m_int_value = (i);
+    o->setIntegerValue(i);
 }
 
 inline void QScriptEnginePrivate::newNameId(QScriptValueImpl *o, const QString &s)
 {
     Q_ASSERT(o);
-    o->m_type = QScript::StringType;
-    o->m_string_value = (nameId(s, /*persistent=*/false));
+    o->setStringValue(nameId(s, /*persistent=*/false));
 }
 
 inline void QScriptEnginePrivate::newString(QScriptValueImpl *o, const QString &s)
 {
     Q_ASSERT(o);
-    o->m_type = QScript::StringType;
     QScriptNameIdImpl *entry = new QScriptNameIdImpl(s);
     m_tempStringRepository.append(entry);
-    o->m_string_value = (entry);
+    o->setStringValue(entry);
     m_newAllocatedTempStringRepositoryChars += s.length();
 }
 
+// creates the string lhs + rhs without copying lhs when lhs is the
+// last string appended to its buffer, so that a loop appending to a
+// string runs in linear time; the result is flattened when its
+// characters are needed
+inline void QScriptEnginePrivate::newConcatenation(QScriptValueImpl *o, QScriptNameIdImpl *lhs,
+                                                   const QString &rhs)
+{
+    Q_ASSERT(o);
+    QScriptNameIdImpl *entry = new QScriptNameIdImpl(QString());
+    if (lhs->buffer && (lhs->length == lhs->buffer->data.length())) {
+        entry->buffer = lhs->buffer;
+    } else {
+        entry->buffer = new QScript::StringBuffer();
+        entry->buffer->data.reserve(2 * (lhs->size() + rhs.length()));
+        if (lhs->buffer)
+            entry->buffer->data.append(QStringRef(&lhs->buffer->data, 0, lhs->length));
+        else
+            entry->buffer->data.append(lhs->s);
+    }
+    entry->buffer->data.append(rhs);
+    entry->length = entry->buffer->data.length();
+    m_tempStringRepository.append(entry);
+    o->setStringValue(entry);
+    m_newAllocatedTempStringRepositoryChars += rhs.length();
+}
+
 inline void QScriptEnginePrivate::newNameId(QScriptValueImpl *o, QScriptNameIdImpl *id)
 {
     Q_ASSERT(o);
-    o->m_type = QScript::StringType;
-    o->m_string_value = (id);
+    o->setStringValue(id);
 }
 
 inline const QScript::IdTable *QScriptEnginePrivate::idTable() const
@@ -193,7 +235,7 @@ inline qsreal QScriptEnginePrivate::convertToNativeDouble(const QScriptValueImpl
     Q_ASSERT (value.isValid());
 
     if (value.isNumber())
-        return value.m_number_value;
+        return value.numberValue();
 
     return convertToNativeDouble_helper(value);
 }
@@ -211,7 +253,7 @@ inline bool QScriptEnginePrivate::convertToNativeBoolean(const QScriptValueImpl
     Q_ASSERT (value.isValid());
 
     if (value.isBoolean())
-        return value.m_bool_value;
+        return value.boolValue();
 
     return convertToNativeBoolean_helper(value);
 }
@@ -221,7 +263,7 @@ inline QString QScriptEnginePrivate::convertToNativeString(const QScriptValueImp
     Q_ASSERT (value.isValid());
 
     if (value.isString())
-        return value.m_string_value->s;
+        return value.stringValue()->string();
 
     return convertToNativeString_helper(value);
 }
@@ -327,8 +369,7 @@ inline QScriptContextPrivate *QScriptEnginePrivate::currentContext() const
 
 inline QScriptContextPrivate *QScriptEnginePrivate::pushContext()
 {
-    QScriptContext *context = m_frameRepository.get();
-    QScriptContextPrivate *ctx_p = QScriptContextPrivate::get(context);
+    QScriptContextPrivate *ctx_p = m_frameStack.push();
     ctx_p->init(m_context);
     m_context = ctx_p;
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
@@ -362,7 +403,18 @@ inline void QScriptEnginePrivate::popContext()
             }
         }
     }
-    m_frameRepository.release(QScriptContextPrivate::get(context));
+
+    // an activation that is still young has only been used by this call
+    // since the last collection, which drops the spare activations (see
+    // collect()); so it needs no write barrier when it's taken over
+    if (! context->m_activationCaptured && context->m_activation.isObject()) {
+        QScriptObject *activation = context->m_activation.objectValue();
+        if ((activation->m_class == m_class_activation)
+            && ! QScript::GCBlock::get(activation)->tenured) {
+            context->m_spareActivation = activation;
+        }
+    }
+    m_frameStack.pop();
 }
 
 inline void QScriptEnginePrivate::maybeGC()
@@ -381,6 +433,46 @@ inline void QScriptEnginePrivate::maybeGC()
     maybeGC_helper(do_string_gc);
 }
 
+inline bool QScriptEnginePrivate::hasBaseline() const
+{
+    return (m_baseline != 0);
+}
+
+inline bool QScriptEnginePrivate::isRestoringSnapshot() const
+{
+    return ! m_snapshot.isNull();
+}
+
+inline QScript::Ext::Enumeration *QScriptEnginePrivate::enumerationConstructor()
+{
+    if (! m_enumerationConstructor)
+        createEnumerationConstructor();
+    return m_enumerationConstructor;
+}
+
+inline QScript::Ext::Variant *QScriptEnginePrivate::variantConstructor()
+{
+    if (! m_variantConstructor)
+        createVariantConstructor();
+    return m_variantConstructor;
+}
+
+#ifndef QT_NO_QOBJECT
+inline QScript::ExtQObject *QScriptEnginePrivate::qobjectConstructor()
+{
+    if (! m_qobjectConstructor)
+        createQObjectConstructor();
+    return m_qobjectConstructor;
+}
+
+inline QScript::ExtQMetaObject *QScriptEnginePrivate::qmetaObjectConstructor()
+{
+    if (! m_qmetaObjectConstructor)
+        createQMetaObjectConstructor();
+    return m_qmetaObjectConstructor;
+}
+#endif
+
 inline void QScriptEnginePrivate::adjustBytesAllocated(int bytes)
 {
     objectAllocator.adjustBytesAllocated(bytes);
@@ -396,6 +488,14 @@ inline void QScriptEnginePrivate::markString(QScriptNameIdImpl *id, int /*genera
     id->used = true;
 }
 
+inline bool QScriptEnginePrivate::isMarked(QScriptObject *object, int generation) const
+{
+    const QScript::GCBlock *block = QScript::GCBlock::get(object);
+    // minor collections don't trace tenured objects, they just survive
+    return (int(block->generation) == generation)
+        || (m_gc_minor && block->tenured);
+}
+
 inline QScriptValueImpl QScriptEnginePrivate::createFunction(QScriptFunction *fun)
 {
     QScriptValueImpl v;
@@ -565,9 +665,8 @@ inline void QScriptEnginePrivate::newObject(QScriptValueImpl *o, const QScriptVa
         od->m_prototype = objectConstructor->publicPrototype;
     }
 
-    o->m_type = QScript::ObjectType;
     od->m_class = (oc ? oc : m_class_object);
-    o->m_object_value = od;
+    o->setObjectValue(od);
 }
 
 inline void QScriptEnginePrivate::newObject(QScriptValueImpl *o, QScriptClassInfo *oc)
@@ -586,8 +685,7 @@ inline void QScriptEnginePrivate::newVariant(QScriptValueImpl *out,
                                              const QVariant &value,
                                              bool setDefaultPrototype)
 {
-    Q_ASSERT(variantConstructor != 0);
-    variantConstructor->newVariant(out, value);
+    variantConstructor()->newVariant(out, value);
     if (setDefaultPrototype) {
         QScriptValueImpl proto = defaultPrototype(value.userType());
         if (proto.isValid())
@@ -611,9 +709,10 @@ inline QScriptMetaObject *QScriptEnginePrivate::cachedMetaObject(const QMetaObje
 
 inline QScriptNameIdImpl *QScriptEnginePrivate::nameId(const QString &str, bool persistent)
 {
-    QScriptNameIdImpl *entry = toStringEntry(str);
+    const uint h = QScript::StringTable::hash(str.unicode(), str.length());
+    QScriptNameIdImpl *entry = m_stringTable.find(str.unicode(), str.length(), h);
     if (! entry)
-        entry = insertStringEntry(str);
+        entry = insertStringEntry(str, h);
 
     Q_ASSERT(entry->unique);
 
@@ -623,10 +722,22 @@ inline QScriptNameIdImpl *QScriptEnginePrivate::nameId(const QString &str, bool
     return entry;
 }
 
+// looks the span up without building a QString first, which is only
+// needed for names that haven't been seen yet
+inline QScriptNameIdImpl *QScriptEnginePrivate::nameId(const QChar *u, int s)
+{
+    const uint h = QScript::StringTable::hash(u, s);
+    QScriptNameIdImpl *entry = m_stringTable.find(u, s, h);
+    if (! entry)
+        entry = insertStringEntry(QString(u, s), h);
+    return entry;
+}
+
 inline QScriptNameIdImpl *QScriptEnginePrivate::intern(const QChar *u, int s)
 {
-    QString tmp(u, s);
-    return nameId(tmp, /*persistent=*/ true);
+    QScriptNameIdImpl *entry = nameId(u, s);
+    entry->persistent = true;
+    return entry;
 }
 
 inline QScriptValueImpl QScriptEnginePrivate::valueFromVariant(const QVariant &v)
@@ -659,34 +770,6 @@ inline void QScriptEnginePrivate::setDefaultPrototype(int metaTypeId, const QScr
     m_customTypes.insert(metaTypeId, info);
 }
 
-inline uint _q_scriptHash(const QString &key)
-{
-    const QChar *p = key.unicode();
-    int n = qMin(key.size(), 128);
-    uint h = key.size();
-    uint g;
-
-    while (n--) {
-        h = (h << 4) + (*p++).unicode();
-        if ((g = (h & 0xf0000000)) != 0)
-            h ^= g >> 23;
-        h &= ~g;
-    }
-    return h;
-}
-
-inline QScriptNameIdImpl *QScriptEnginePrivate::toStringEntry(const QString &s)
-{
-    uint h = _q_scriptHash(s) % m_string_hash_size;
-
-    for (QScriptNameIdImpl *entry = m_string_hash_base[h]; entry && entry->h == h; entry = entry->next) {
-        if (entry->s == s)
-            return entry;
-    }
-
-    return 0;
-}
-
 inline bool QScriptEnginePrivate::lessThan(const QScriptValueImpl &lhs, const QScriptValueImpl &rhs)
 {
     return QScriptContextPrivate::lt_cmp(lhs, rhs);
@@ -745,6 +828,13 @@ inline void QScriptEnginePrivate::maybeProcessEvents()
     }
 }
 
+// called where the interpreter polls for events; see QScript::Profiler
+inline void QScriptEnginePrivate::maybeSample(QScriptContextPrivate *context)
+{
+    if (m_sampleTicks)
+        takeSample(context);
+}
+
 inline bool QScriptEnginePrivate::shouldAbort() const
 {
     return m_abort;
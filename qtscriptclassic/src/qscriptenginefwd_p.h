@@ -49,6 +49,7 @@
 
 #include <qobjectdefs.h>
 
+#include <QAtomicInt>
 #include <QHash>
 #include <QList>
 #include <QRegExp>
@@ -58,11 +59,16 @@
 #include <QVector>
 
 #include "qscriptengine.h"
+#include "qscriptframestack_p.h"
 #include "qscriptrepository_p.h"
 #include "qscriptgc_p.h"
 #include "qscriptobjectfwd_p.h"
 #include "qscriptclassinfo_p.h"
 #include "qscriptstring_p.h"
+#include "qscriptstringtable_p.h"
+#include "qscriptenginesnapshot_p.h"
+#include "qscriptopcodestatistics_p.h"
+#include "qscriptregexpcompiler_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -92,6 +98,7 @@ namespace Ecma {
     class Boolean;
     class String;
     class Math;
+    class Json;
     class Date;
     class Function;
     class Array;
@@ -108,11 +115,14 @@ class ExtQObject;
 class ExtQMetaObject;
 
 class Array;
+class Baseline;
 class Lexer;
+class Profiler;
 class Code;
 class CompilationUnit;
 class IdTable;
 class MemoryPool;
+class NodePool;
 
 class IdTable
 {
@@ -151,6 +161,8 @@ class QScriptQObjectData;
 class QScriptMetaObject;
 #endif
 
+class QScriptProgramPrivate;
+
 class QScriptCustomTypeInfo
 {
 public:
@@ -181,13 +193,46 @@ public:
     void init();
     void initStringRepository();
 
+    QScript::EngineSnapshot takeSnapshot(QString *errorMessage = 0);
+
+    // whether init() copies the members of the built-in objects from a
+    // snapshot instead of creating them
+    inline bool isRestoringSnapshot() const;
+
+    // an engine with a baseline can be brought back to the state it
+    // had when the baseline was recorded, see QScript::EnginePool
+    void recordBaseline();
+    void resetToBaseline();
+    void dropBaseline();
+    inline bool hasBaseline() const;
+#ifdef QT_NO_QOBJECT
+    static QScriptEngine *createEngine(const QScript::EngineSnapshot &snapshot);
+#else
+    static QScriptEngine *createEngine(const QScript::EngineSnapshot &snapshot,
+                                       QObject *parent = 0);
+#endif
+
+    // the constructors that can't be reached from the global object are
+    // only created when they are first needed
+    inline QScript::Ext::Enumeration *enumerationConstructor();
+    inline QScript::Ext::Variant *variantConstructor();
+    void createEnumerationConstructor();
+    void createVariantConstructor();
+#ifndef QT_NO_QOBJECT
+    inline QScript::ExtQObject *qobjectConstructor();
+    inline QScript::ExtQMetaObject *qmetaObjectConstructor();
+    void createQObjectConstructor();
+    void createQMetaObjectConstructor();
+#endif
+
     static inline QScriptEnginePrivate *get(QScriptEngine *q);
     static inline const QScriptEnginePrivate *get(const QScriptEngine *q);
     static inline QScriptEngine *get(QScriptEnginePrivate *d);
 
     QScript::AST::Node *createAbstractSyntaxTree(
         const QString &source, int lineNumber,
-        QString *errorMessage, int *errorLineNumber);
+        QString *errorMessage, int *errorLineNumber,
+        QScript::NodePool *lazyFunctions = 0);
     QScript::AST::Node *changeAbstractSyntaxTree(QScript::AST::Node *program);
 
     inline QScript::AST::Node *abstractSyntaxTree() const;
@@ -213,6 +258,7 @@ public:
     inline void maybeGC();
 
     void maybeGC_helper(bool do_string_gc);
+    void collect(bool minor, bool do_string_gc);
 
     inline bool blockGC(bool block);
 
@@ -223,7 +269,9 @@ public:
     inline void adjustBytesAllocated(int bytes);
 
     void markObject(const QScriptValueImpl &object, int generation);
+    void markChildren(const QScriptValueImpl &object, int generation);
     void markFrame(QScriptContextPrivate *context, int generation);
+    inline bool isMarked(QScriptObject *object, int generation) const;
 
     inline void markString(QScriptNameIdImpl *id, int generation);
 
@@ -233,6 +281,9 @@ public:
 
     void evaluate(QScriptContextPrivate *context, const QString &contents,
                   int lineNumber, const QString &fileName = QString());
+    void evaluate(QScriptContextPrivate *context, QScriptProgramPrivate *program);
+    static QByteArray precompile(const QString &sourceCode, const QString &fileName,
+                                 int firstLineNumber);
 
     inline void setLexer(QScript::Lexer *lexer);
 
@@ -252,6 +303,7 @@ public:
     inline QString memberName(const QScript::Member &member) const;
     inline void newReference(QScriptValueImpl *object, int mode);
     inline void newActivation(QScriptValueImpl *object);
+    inline void newActivation(QScriptContextPrivate *context, QScriptFunction *function);
     inline void newFunction(QScriptValueImpl *object, QScriptFunction *function);
     inline void newConstructor(QScriptValueImpl *ctor, QScriptFunction *function,
                         QScriptValueImpl &proto);
@@ -260,6 +312,7 @@ public:
     inline void newNameId(QScriptValueImpl *object, const QString &s);
     inline void newNameId(QScriptValueImpl *object, QScriptNameIdImpl *id);
     inline void newString(QScriptValueImpl *object, const QString &s);
+    inline void newConcatenation(QScriptValueImpl *object, QScriptNameIdImpl *lhs, const QString &rhs);
     inline void newArguments(QScriptValueImpl *object, const QScriptValueImpl &activation,
                       uint length, const QScriptValueImpl &callee);
     static inline QString convertToNativeString(const QScriptValueImpl &value);
@@ -320,6 +373,7 @@ public:
 #endif
 
     inline QScriptNameIdImpl *nameId(const QString &str, bool persistent = false);
+    inline QScriptNameIdImpl *nameId(const QChar *u, int s);
 
     inline QScriptNameIdImpl *intern(const QChar *u, int s);
 
@@ -342,9 +396,7 @@ public:
     QScriptValueImpl call(const QScriptValueImpl &callee, const QScriptValueImpl &thisObject,
                           const QScriptValueImpl &args, bool asConstructor);
 
-    void rehashStringRepository(bool resize = true);
-    inline QScriptNameIdImpl *toStringEntry(const QString &s);
-    QScriptNameIdImpl *insertStringEntry(const QString &s);
+    QScriptNameIdImpl *insertStringEntry(const QString &s, uint hash);
 
     QScriptValueImpl create(int type, const void *ptr);
     static bool convert(const QScriptValueImpl &value, int type, void *ptr,
@@ -376,12 +428,24 @@ public:
     QStringList importedExtensions() const;
 
     inline void maybeProcessEvents();
+
+    QScript::Profiler *profiler();
+    inline void maybeSample(QScriptContextPrivate *context);
+    void takeSample(QScriptContextPrivate *context);
     void setupProcessEvents();
     void processEvents();
 
 #ifndef QT_NO_QOBJECT
     QScriptQObjectData *qobjectData(QObject *object);
 
+    // how the emissions of a signal reach a script handler; see
+    // Function.prototype.connect()
+    enum SignalCoalescing {
+        NoCoalescing,    // each emission calls the handler
+        CoalesceLatest,  // once per event loop turn, with the latest arguments
+        CoalesceBatch    // once per event loop turn, with all of them in an array
+    };
+
     bool scriptConnect(QObject *sender, const char *signal,
                        const QScriptValueImpl &receiver,
                        const QScriptValueImpl &function,
@@ -394,7 +458,8 @@ public:
                        const QScriptValueImpl &receiver,
                        const QScriptValueImpl &function,
                        const QScriptValueImpl &senderWrapper,
-                       Qt::ConnectionType type);
+                       Qt::ConnectionType type,
+                       SignalCoalescing coalescing = NoCoalescing);
     bool scriptDisconnect(QObject *sender, int index,
                           const QScriptValueImpl &receiver,
                           const QScriptValueImpl &function);
@@ -402,7 +467,8 @@ public:
     bool scriptConnect(const QScriptValueImpl &signal,
                        const QScriptValueImpl &receiver,
                        const QScriptValueImpl &function,
-                       Qt::ConnectionType type);
+                       Qt::ConnectionType type,
+                       SignalCoalescing coalescing = NoCoalescing);
     bool scriptDisconnect(const QScriptValueImpl &signal,
                           const QScriptValueImpl &receiver,
                           const QScriptValueImpl &function);
@@ -460,19 +526,29 @@ public: // attributes
     int m_callDepth;
     int m_maxCallDepth;
     int m_gc_depth;
+    bool m_gc_minor;
     QList<QScriptValueImpl> m_markStack;
     QScriptValueImpl m_globalObject;
+    QScript::EngineSnapshot m_snapshot; // what init() starts from, if not null
+    QScript::Baseline *m_baseline;
     int m_oldStringRepositorySize;
     int m_oldTempStringRepositorySize;
     QVector<QScriptNameIdImpl*> m_stringRepository;
     int m_newAllocatedStringRepositoryChars;
     QVector<QScriptNameIdImpl*> m_tempStringRepository;
     int m_newAllocatedTempStringRepositoryChars;
-    QScriptNameIdImpl **m_string_hash_base;
-    int m_string_hash_size;
+    QScript::StringTable m_stringTable;
     QScript::GCAlloc<QScriptObject> objectAllocator;
     int m_objectGeneration;
-    QScript::Repository<QScriptContext, QScriptContextPrivate> m_frameRepository;
+
+    struct GCStatistics {
+        int minorCollections;
+        int majorCollections;
+        int promotedObjects;   // by minor collections
+        int rememberedObjects; // scanned by minor collections
+        int tenuredObjects;    // after the last collection
+    } m_gcStatistics;
+    QScript::FrameStack<QScriptContextPrivate> m_frameStack;
     QScriptContextPrivate *m_context;
     QScriptValueImpl *tempStackBegin;
     QScriptValueImpl *tempStackEnd;
@@ -494,10 +570,10 @@ public: // attributes
     QScript::Ecma::Array *arrayConstructor;
     QScript::Ecma::RegExp *regexpConstructor;
     QScript::Ecma::Error *errorConstructor;
-    QScript::Ext::Enumeration *enumerationConstructor;
-    QScript::Ext::Variant *variantConstructor;
-    QScript::ExtQObject *qobjectConstructor;
-    QScript::ExtQMetaObject *qmetaObjectConstructor;
+    QScript::Ext::Enumeration *m_enumerationConstructor;
+    QScript::Ext::Variant *m_variantConstructor;
+    QScript::ExtQObject *m_qobjectConstructor;
+    QScript::ExtQMetaObject *m_qmetaObjectConstructor;
 
     QHash<int, QScriptCustomTypeInfo> m_customTypes;
 
@@ -522,22 +598,34 @@ public: // attributes
                         QScriptStringPrivate> m_internedStringRepository;
     QHash<QScriptNameIdImpl*, QScriptStringPrivate*> m_internedStrings;
 
+    QSet<QScriptProgramPrivate*> m_compiledPrograms;
+    // code of programs that was discarded, maybe on another thread, and
+    // is freed by the engine; both guarded by QScriptProgramPrivate::engineMutex()
+    QList<QExplicitlySharedDataPointer<QScript::NodePool> > m_releasedPools;
+
     QSet<QScriptObject*> visitedArrayElements;
 
-#ifndef QT_NO_REGEXP
-    QHash<QString, QRegExp> m_regExpLiterals;
-#endif
+    QHash<QPair<QString, int>, QExplicitlySharedDataPointer<QScript::RegExpProgram> > m_regExpCache;
 
     QScript::IdTable m_id_table;
 
     QSet<QString> m_importedExtensions;
     QSet<QString> m_extensionsBeingImported;
 
+    QString m_codeCacheDirectory;
+
     int m_processEventsInterval;
     int m_nextProcessEvents;
     int m_processEventIncr;
     QTime m_processEventTracker;
 
+    QScript::Profiler *m_profiler;
+    QAtomicInt m_sampleTicks; // bumped by the profiler's thread
+
+#ifdef Q_SCRIPT_OPCODE_STATISTICS
+    QScript::OpcodeStatistics m_opcodeStatistics;
+#endif
+
     QList<QScriptEngineAgent*> m_agents;
     QScriptEngineAgent *m_agent;
 
@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptenginepool_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptcontext_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+EnginePool::EnginePool(const EngineSnapshot &snapshot)
+    : m_snapshot(snapshot), m_maximumIdleCount(8)
+{
+}
+
+EnginePool::~EnginePool()
+{
+    qDeleteAll(m_idle);
+}
+
+QScriptEngine *EnginePool::checkout()
+{
+    if (! m_idle.isEmpty())
+        return m_idle.takeLast();
+
+    QScriptEngine *engine = QScriptEnginePrivate::createEngine(m_snapshot);
+    QScriptEnginePrivate::get(engine)->recordBaseline();
+    return engine;
+}
+
+// the engine must not be evaluating anything, and whatever contexts
+// were pushed on it must have been popped
+void EnginePool::release(QScriptEngine *engine)
+{
+    QScriptEnginePrivate *eng_p = QScriptEnginePrivate::get(engine);
+    if (eng_p->m_evaluating || eng_p->currentContext()->parentContext()
+        || (m_idle.size() >= m_maximumIdleCount)) {
+        delete engine;
+        return;
+    }
+
+    eng_p->resetToBaseline();
+    m_idle.append(engine);
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTENGINEPOOL_P_H
+#define QSCRIPTENGINEPOOL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QList>
+
+#include "qscriptenginesnapshot_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QScriptEngine;
+
+namespace QScript {
+
+//
+// Hands out engines that start in the same state, for running many
+// short, independent scripts without creating an engine for each one.
+//
+// An engine is created (from the snapshot, if one is given) the first
+// time it is needed, and its state at that point is recorded as its
+// baseline. When the engine is released, it is reset to that baseline
+// (see QScriptEnginePrivate::resetToBaseline()) and kept for the next
+// checkout, so the cost of a release is proportional to what the script
+// changed rather than to the size of the engine.
+//
+// Like the engines themselves, a pool must only be used from one thread.
+//
+class EnginePool
+{
+public:
+    EnginePool(const EngineSnapshot &snapshot = EngineSnapshot());
+    ~EnginePool();
+
+    QScriptEngine *checkout();
+    void release(QScriptEngine *engine);
+
+    inline int idleCount() const { return m_idle.size(); }
+
+    inline int maximumIdleCount() const { return m_maximumIdleCount; }
+    inline void setMaximumIdleCount(int count) { m_maximumIdleCount = count; }
+
+private:
+    EngineSnapshot m_snapshot;
+    QList<QScriptEngine*> m_idle;
+    int m_maximumIdleCount;
+
+private:
+    Q_DISABLE_COPY(EnginePool)
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTENGINEPOOL_P_H
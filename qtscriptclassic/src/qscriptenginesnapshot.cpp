@@ -0,0 +1,898 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptenginesnapshot_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptcontext_p.h"
+#include "qscriptmember_p.h"
+#include "qscriptobject_p.h"
+#include "qscriptshape_p.h"
+#include "qscriptfunction_p.h"
+#include "qscriptast_p.h"
+#include "qscriptnodepool_p.h"
+#include "qscriptcodecache_p.h"
+#include "qscriptecmaerror_p.h"
+#include "qscriptecmaregexp_p.h"
+#include "qscriptextenumeration_p.h"
+
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QSet>
+#include <QVariant>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+namespace {
+
+struct SnapshotString
+{
+    QString string;
+    uint hash;
+    bool persistent;
+};
+
+struct SnapshotValue
+{
+    enum Kind {
+        Invalid,
+        Undefined,
+        Null,
+        Boolean,
+        Number,
+        String,
+        Object
+    };
+
+    SnapshotValue() : kind(Invalid), number(0), object(-1) { }
+
+    Kind kind;
+    qsreal number;
+    QString string;
+    int object; // index in EngineSnapshot::Data::objects
+};
+
+struct SnapshotMember
+{
+    int name; // index in EngineSnapshot::Data::strings
+    uint flags;
+    SnapshotValue value;
+};
+
+struct SnapshotObject
+{
+    enum Kind {
+        Builtin,
+        Plain,
+        Array,
+        Arguments,
+        NativeFunction,
+        NativeFunctionWithArg,
+        InternalFunction,
+        ScriptFunction,
+        RegExp,
+        Variant,
+        QObject
+    };
+
+    SnapshotObject()
+        : kind(Plain), index(-1), pool(-1), dictionary(false), function(0),
+          functionWithArg(0), internalFunction(0), argument(0), length(0), flags(0) { }
+
+    Kind kind;
+    int index;          // Builtin: see builtinObject(); ScriptFunction: in its pool
+    int pool;           // ScriptFunction: index in EngineSnapshot::Data::pools
+    QString className;  // InternalFunction: the class the function belongs to
+    QString name;       // InternalFunction; RegExp: the pattern
+    SnapshotValue prototype;
+    SnapshotValue scope;
+    SnapshotValue internalValue;
+    SnapshotValue activation; // Arguments
+    bool dictionary;    // whether the object has a layout of its own
+    QVector<SnapshotMember> members;
+    QVector<QPair<uint, SnapshotValue> > elements; // Array
+    QScriptFunctionSignature function;
+    QScriptFunctionWithArgSignature functionWithArg;
+    QScriptInternalFunctionSignature internalFunction;
+    void *argument;
+    uint length;        // Array, Arguments and functions
+    int flags;          // RegExp
+    QExplicitlySharedDataPointer<RegExpProgram> program;
+    QVariant variant;
+#ifndef QT_NO_QOBJECT
+    QPointer< ::QObject> qobject;
+    QScriptEngine::QObjectWrapOptions options;
+#endif
+};
+
+// the script functions recorded from one NodePool, as the contents of a
+// cache file (see QScript::CodeCache)
+struct SnapshotPool
+{
+    QString fileName;
+    QByteArray code;
+};
+
+} // anonymous namespace
+
+struct EngineSnapshot::Data: public QSharedData
+{
+    QVector<SnapshotString> strings;
+    QVector<SnapshotObject> objects;
+    QVector<SnapshotPool> pools;
+};
+
+namespace {
+
+// the objects that init() creates, and those of the constructors that
+// are created on first use, by an index that is the same in every engine
+enum {
+    GlobalObject,
+    EvalFunction,
+    PrintFunction,
+    MathObject,
+    JsonObject,
+    NativeErrorObjects, // the constructors, then the prototypes
+    ConstructorObjects = NativeErrorObjects + 12, // a constructor, then its prototype
+    ConstructorCount = 13,
+    BuiltinObjectCount = ConstructorObjects + 2 * ConstructorCount
+};
+
+static Ecma::Core *constructor(QScriptEnginePrivate *eng, int index, bool create)
+{
+    switch (index) {
+    case 0: return eng->objectConstructor;
+    case 1: return eng->functionConstructor;
+    case 2: return eng->numberConstructor;
+    case 3: return eng->booleanConstructor;
+    case 4: return eng->stringConstructor;
+    case 5: return eng->dateConstructor;
+    case 6: return eng->arrayConstructor;
+    case 7: return eng->regexpConstructor;
+    case 8: return eng->errorConstructor;
+    case 9:
+        if (create || eng->m_enumerationConstructor)
+            return eng->enumerationConstructor();
+        break;
+    case 10:
+        if (create || eng->m_variantConstructor)
+            return eng->variantConstructor();
+        break;
+#ifndef QT_NO_QOBJECT
+    case 11:
+        if (create || eng->m_qobjectConstructor)
+            return eng->qobjectConstructor();
+        break;
+    case 12:
+        if (create || eng->m_qmetaObjectConstructor)
+            return eng->qmetaObjectConstructor();
+        break;
+#endif
+    default:
+        break;
+    }
+    return 0;
+}
+
+// a member of the global object, without calling a getter
+static QScriptValueImpl globalMember(QScriptEnginePrivate *eng, const char *name)
+{
+    QScriptValueImpl result;
+    QScript::Member member;
+    QScriptValueImpl &global = eng->m_globalObject;
+    if (global.objectValue()->findMember(eng->nameId(QLatin1String(name)), &member)
+        && member.isObjectProperty() && ! member.isGetterOrSetter()) {
+        global.get(member, &result);
+    }
+    return result;
+}
+
+// returns an invalid value if the object doesn't exist, or if a script
+// has replaced the member of the global object that init() created
+static QScriptValueImpl builtinObject(QScriptEnginePrivate *eng, int index, bool create)
+{
+    switch (index) {
+    case GlobalObject:
+        return eng->m_globalObject;
+
+    case EvalFunction: {
+        const QScriptValueImpl v = globalMember(eng, "eval");
+        if (v.isFunction() && (v.toFunction() == eng->m_evalFunction))
+            return v;
+    }   return QScriptValueImpl();
+
+    case PrintFunction: {
+        const QScriptValueImpl v = globalMember(eng, "print");
+        if (v.isFunction() && (v.toFunction()->type() == QScriptFunction::Unknown)
+            && (v.toFunction()->functionName() == QLatin1String("print"))) {
+            return v;
+        }
+    }   return QScriptValueImpl();
+
+    case MathObject:
+    case JsonObject: {
+        const char *name = (index == MathObject) ? "Math" : "JSON";
+        const QScriptValueImpl v = globalMember(eng, name);
+        if (v.isObject() && v.objectData() && (v.classInfo()->name() == QLatin1String(name)))
+            return v;
+    }   return QScriptValueImpl();
+
+    default:
+        break;
+    }
+
+    if (index < ConstructorObjects) {
+        const Ecma::Error *error = eng->errorConstructor;
+        const QScriptValueImpl objects[] = {
+            error->evalErrorCtor, error->rangeErrorCtor, error->referenceErrorCtor,
+            error->syntaxErrorCtor, error->typeErrorCtor, error->uriErrorCtor,
+            error->evalErrorPrototype, error->rangeErrorPrototype, error->referenceErrorPrototype,
+            error->syntaxErrorPrototype, error->typeErrorPrototype, error->uriErrorPrototype
+        };
+        return objects[index - NativeErrorObjects];
+    }
+
+    if (index < BuiltinObjectCount) {
+        const int i = index - ConstructorObjects;
+        if (Ecma::Core *c = constructor(eng, i / 2, create))
+            return (i % 2) ? c->publicPrototype : c->ctor;
+    }
+    return QScriptValueImpl();
+}
+
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(QScriptEnginePrivate *eng, EngineSnapshot::Data *d)
+        : m_engine(eng), m_data(d) { }
+
+    void addBuiltins();
+    void writeObjects();
+    void writeCode();
+    void writeStrings();
+
+    inline bool hasError() const { return ! m_error.isNull(); }
+    inline QString errorMessage() const { return m_error; }
+
+private:
+    SnapshotValue value(const QScriptValueImpl &v);
+    bool describe(const QScriptValueImpl &object, SnapshotObject *o);
+    bool describeFunction(const QScriptValueImpl &object, SnapshotObject *o);
+    bool checkClass(QScriptClassInfo *classInfo);
+    void writeObject(const QScriptValueImpl &object, SnapshotObject *o);
+    int addObject(const QScriptValueImpl &object, const SnapshotObject &o);
+    int nameIndex(QScriptNameIdImpl *nameId);
+    void setError(const QString &message);
+
+    QScriptEnginePrivate *m_engine;
+    EngineSnapshot::Data *m_data;
+    QHash<QScriptObject*, int> m_indexes;
+    QList<QScriptValueImpl> m_pending;
+    QHash<QScriptNameIdImpl*, int> m_nameIndexes;
+    QSet<QScriptClassInfo*> m_classes; // those that aren't custom classes
+    QHash<NodePool*, int> m_poolIndexes;
+    QList<NodePool*> m_pools;
+    QList<QList<AST::FunctionExpression*> > m_functions; // of each pool
+    QHash<AST::FunctionExpression*, int> m_functionIndexes;
+    QString m_error;
+};
+
+void SnapshotWriter::setError(const QString &message)
+{
+    if (m_error.isNull())
+        m_error = message;
+}
+
+int SnapshotWriter::nameIndex(QScriptNameIdImpl *nameId)
+{
+    QHash<QScriptNameIdImpl*, int>::const_iterator it = m_nameIndexes.constFind(nameId);
+    if (it != m_nameIndexes.constEnd())
+        return it.value();
+
+    SnapshotString s;
+    s.string = nameId->s;
+    s.hash = nameId->h;
+    s.persistent = nameId->persistent;
+    const int index = m_data->strings.size();
+    m_data->strings.append(s);
+    m_nameIndexes.insert(nameId, index);
+    return index;
+}
+
+int SnapshotWriter::addObject(const QScriptValueImpl &object, const SnapshotObject &o)
+{
+    const int index = m_data->objects.size();
+    m_indexes.insert(object.objectValue(), index);
+    m_data->objects.append(o);
+    m_pending.append(object);
+    return index;
+}
+
+// records the built-in objects, which the other objects are found from
+void SnapshotWriter::addBuiltins()
+{
+    QScriptEnginePrivate *eng = m_engine;
+    m_classes << eng->m_class_object << eng->m_class_function << eng->m_class_activation
+              << eng->m_class_arguments << eng->m_class_with;
+    for (int i = 0; i < ConstructorCount; ++i) {
+        // don't create the extension constructors just to take a snapshot
+        if (Ecma::Core *c = constructor(eng, i, /*create=*/false))
+            m_classes.insert(c->classInfo());
+    }
+
+    for (int i = 0; i < BuiltinObjectCount; ++i) {
+        const QScriptValueImpl object = builtinObject(eng, i, /*create=*/false);
+        if (! object.isObject() || m_indexes.contains(object.objectValue()))
+            continue;
+        m_classes.insert(object.classInfo());
+        SnapshotObject o;
+        o.kind = SnapshotObject::Builtin;
+        o.index = i;
+        addObject(object, o);
+    }
+}
+
+bool SnapshotWriter::checkClass(QScriptClassInfo *classInfo)
+{
+    if (! classInfo || m_classes.contains(classInfo))
+        return true;
+    setError(QString::fromLatin1("an object of class %0 can't be part of a snapshot")
+             .arg(classInfo->name()));
+    return false;
+}
+
+SnapshotValue SnapshotWriter::value(const QScriptValueImpl &v)
+{
+    SnapshotValue result;
+    switch (v.type()) {
+    case QScript::InvalidType:
+        break;
+    case QScript::UndefinedType:
+        result.kind = SnapshotValue::Undefined;
+        break;
+    case QScript::NullType:
+        result.kind = SnapshotValue::Null;
+        break;
+    case QScript::BooleanType:
+        result.kind = SnapshotValue::Boolean;
+        result.number = v.boolValue() ? 1 : 0;
+        break;
+    case QScript::NumberType:
+    case QScript::IntegerType:
+        result.kind = SnapshotValue::Number;
+        result.number = v.toNumber();
+        break;
+    case QScript::StringType:
+    case QScript::LazyStringType:
+        result.kind = SnapshotValue::String;
+        result.string = v.toString();
+        break;
+    case QScript::ObjectType: {
+        QHash<QScriptObject*, int>::const_iterator it = m_indexes.constFind(v.objectValue());
+        if (it != m_indexes.constEnd()) {
+            result.kind = SnapshotValue::Object;
+            result.object = it.value();
+            break;
+        }
+        SnapshotObject o;
+        if (describe(v, &o)) {
+            result.kind = SnapshotValue::Object;
+            result.object = addObject(v, o);
+        }
+    }   break;
+    default:
+        setError(QLatin1String("the engine holds a value that can't be part of a snapshot"));
+        break;
+    }
+    return result;
+}
+
+// records how to create the object; its contents are recorded by
+// writeObject()
+bool SnapshotWriter::describe(const QScriptValueImpl &object, SnapshotObject *o)
+{
+    QScriptEnginePrivate *eng = m_engine;
+    QScriptClassInfo *classInfo = object.classInfo();
+    if (! checkClass(classInfo))
+        return false;
+    o->className = classInfo->name();
+
+    if (! object.objectData()) {
+        o->kind = SnapshotObject::Plain;
+    } else if (object.isFunction()) {
+        return describeFunction(object, o);
+    } else if (object.isArray()) {
+        o->kind = SnapshotObject::Array;
+    } else if (object.isRegExp()) {
+        Ecma::RegExp::Instance *rx = eng->regexpConstructor->get(object);
+        o->kind = SnapshotObject::RegExp;
+        o->name = rx->pattern;
+        o->flags = rx->flags;
+        o->program = rx->program;
+    } else if (classInfo == eng->m_class_arguments) {
+        o->kind = SnapshotObject::Arguments;
+        o->length = static_cast<ArgumentsObjectData*>(object.objectData())->length;
+    } else if (object.isVariant()) {
+        o->kind = SnapshotObject::Variant;
+        o->variant = object.variantValue();
+#ifndef QT_NO_QOBJECT
+    } else if (object.isQObject()) {
+        ExtQObject::Instance *instance = eng->qobjectConstructor()->get(object);
+        o->kind = SnapshotObject::QObject;
+        o->qobject = instance->value;
+        o->options = instance->options;
+#endif
+    } else {
+        setError(QString::fromLatin1("an object of class %0 can't be part of a snapshot")
+                 .arg(classInfo->name()));
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotWriter::describeFunction(const QScriptValueImpl &object, SnapshotObject *o)
+{
+    QScriptFunction *fun = object.toFunction();
+    o->length = fun->length;
+
+    switch (fun->type()) {
+    case QScriptFunction::C:
+        o->kind = SnapshotObject::NativeFunction;
+        o->function = static_cast<CFunction*>(fun)->function();
+        return true;
+
+    case QScriptFunction::C2: {
+        C2Function *c = static_cast<C2Function*>(fun);
+        if (! checkClass(c->classInfo()))
+            return false;
+        o->kind = SnapshotObject::InternalFunction;
+        o->className = c->classInfo() ? c->classInfo()->name() : QString();
+        o->internalFunction = c->function();
+        o->name = c->name();
+    }   return true;
+
+    case QScriptFunction::C3: {
+        C3Function *c = static_cast<C3Function*>(fun);
+        o->kind = SnapshotObject::NativeFunctionWithArg;
+        o->functionWithArg = c->function();
+        o->argument = c->argument();
+    }   return true;
+
+    case QScriptFunction::Script: {
+        QScript::ScriptFunction *script = static_cast<QScript::ScriptFunction*>(fun);
+        NodePool *pool = script->astPool();
+        int poolIndex = m_poolIndexes.value(pool, -1);
+        if (poolIndex == -1) {
+            poolIndex = m_pools.size();
+            m_poolIndexes.insert(pool, poolIndex);
+            m_pools.append(pool);
+            m_functions.append(QList<AST::FunctionExpression*>());
+        }
+
+        // closures created by the same expression share its code
+        AST::FunctionExpression *definition = script->definition();
+        int index = m_functionIndexes.value(definition, -1);
+        if (index == -1) {
+            index = m_functions.at(poolIndex).size();
+            m_functions[poolIndex].append(definition);
+            m_functionIndexes.insert(definition, index);
+        }
+
+        o->kind = SnapshotObject::ScriptFunction;
+        o->pool = poolIndex;
+        o->index = index;
+    }   return true;
+
+    default:
+        // QObject methods, and functions of the engine that aren't
+        // reachable from the built-in objects
+        break;
+    }
+
+    setError(QString::fromLatin1("the function %0 can't be part of a snapshot")
+             .arg(fun->functionName()));
+    return false;
+}
+
+void SnapshotWriter::writeObject(const QScriptValueImpl &object, SnapshotObject *o)
+{
+    QScriptObject *instance = object.objectValue();
+    o->prototype = value(instance->m_prototype);
+    o->scope = value(instance->m_scope);
+    o->internalValue = value(instance->m_internalValue);
+    if (o->kind == SnapshotObject::Arguments)
+        o->activation = value(static_cast<ArgumentsObjectData*>(instance->m_data)->activation);
+
+    const Shape *shape = instance->m_shape;
+    o->dictionary = shape && shape->isDictionary();
+    const int count = instance->memberCount();
+    o->members.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QScript::Member &member = shape->at(i);
+        // the members of a QObject wrapper are found again on demand
+        if (! member.isValid() || member.testFlags(QScriptValue::QObjectMember))
+            continue;
+        QScriptValueImpl v;
+        instance->get(member, &v);
+        SnapshotMember m;
+        m.name = nameIndex(member.nameId());
+        m.flags = member.flags() & ~QScript::Member::ObjectProperty;
+        m.value = value(v);
+        o->members.append(m);
+    }
+
+    if (Ecma::Array::Instance *instance = m_engine->arrayConstructor->get(object)) {
+        const QScript::Array &array = instance->value;
+        o->length = array.count();
+        if (array.mode() == QScript::Array::HashMode) {
+            const QList<uint> keys = array.keys();
+            // the last key is the length of the array
+            for (int i = 0; i < keys.size() - 1; ++i)
+                o->elements.append(qMakePair(keys.at(i), value(array.at(keys.at(i)))));
+        } else {
+            for (uint i = 0; i < array.count(); ++i) {
+                const QScriptValueImpl e = array.at(i);
+                if (e.isValid())
+                    o->elements.append(qMakePair(i, value(e)));
+            }
+        }
+    }
+}
+
+// records the contents of the objects found so far, which may find
+// more objects
+void SnapshotWriter::writeObjects()
+{
+    while (! m_pending.isEmpty() && ! hasError()) {
+        const QScriptValueImpl object = m_pending.takeFirst();
+        const int index = m_indexes.value(object.objectValue());
+
+        SnapshotObject o = m_data->objects.at(index);
+        writeObject(object, &o);
+        m_data->objects[index] = o;
+    }
+}
+
+// records the compiled code of the script functions, compiling the
+// ones that haven't been called yet
+void SnapshotWriter::writeCode()
+{
+    // the code is only ever loaded from the snapshot, so there is no
+    // source code to check it against
+    const CodeCache cache(QString(), QString(), /*firstLineNumber=*/0);
+    for (int i = 0; (i < m_pools.size()) && ! hasError(); ++i) {
+        SnapshotPool p;
+        p.fileName = m_pools.at(i)->fileName();
+        p.code = cache.serialize(m_pools.at(i), m_functions.at(i));
+        if (p.code.isEmpty()) {
+            setError(QString::fromLatin1("the functions of %0 can't be compiled for a snapshot")
+                     .arg(p.fileName));
+        }
+        m_data->pools.append(p);
+    }
+}
+
+// adds the persistent interned strings, which compiled code may refer
+// to, to the names that the objects use; the other strings are left to
+// the garbage collector of the engine the snapshot is taken of
+void SnapshotWriter::writeStrings()
+{
+    const QVector<QScriptNameIdImpl*> &repository = m_engine->m_stringRepository;
+    for (int i = 0; i < repository.size(); ++i) {
+        QScriptNameIdImpl *entry = repository.at(i);
+        if (entry->persistent)
+            nameIndex(entry);
+    }
+}
+
+static QScriptValueImpl toImpl(const SnapshotValue &v, const QVector<QScriptValueImpl> &objects,
+                               QScriptEnginePrivate *eng)
+{
+    switch (v.kind) {
+    case SnapshotValue::Invalid:
+        break;
+    case SnapshotValue::Undefined:
+        return eng->undefinedValue();
+    case SnapshotValue::Null:
+        return eng->nullValue();
+    case SnapshotValue::Boolean:
+        return QScriptValueImpl(v.number != 0);
+    case SnapshotValue::Number:
+        return QScriptValueImpl(v.number);
+    case SnapshotValue::String:
+        return QScriptValueImpl(eng, v.string);
+    case SnapshotValue::Object:
+        return objects.at(v.object);
+    }
+    return QScriptValueImpl();
+}
+
+static QScriptValueImpl createObject(QScriptEnginePrivate *eng, const SnapshotObject &o,
+                                     const QHash<QString, QScriptClassInfo*> &classes,
+                                     const QVector<SnapshotPool> &pools,
+                                     QVector<QExplicitlySharedDataPointer<NodePool> > *loadedPools)
+{
+    QScriptValueImpl result;
+    switch (o.kind) {
+    case SnapshotObject::Builtin:
+        break;
+    case SnapshotObject::Plain:
+        eng->newObject(&result, classes.value(o.className));
+        break;
+    case SnapshotObject::Array:
+        result = eng->newArray(0);
+        break;
+    case SnapshotObject::Arguments: {
+        ArgumentsObjectData *data = new ArgumentsObjectData();
+        data->length = o.length;
+        eng->newObject(&result, eng->m_class_arguments);
+        result.setObjectData(data);
+    }   break;
+    case SnapshotObject::NativeFunction:
+        result = eng->createFunction(new QScript::CFunction(o.function, o.length));
+        break;
+    case SnapshotObject::NativeFunctionWithArg:
+        result = eng->createFunction(new QScript::C3Function(o.functionWithArg, o.argument,
+                                                             o.length));
+        break;
+    case SnapshotObject::InternalFunction:
+        result = eng->createFunction(o.internalFunction, o.length,
+                                     o.className.isNull() ? 0 : classes.value(o.className),
+                                     o.name);
+        break;
+    case SnapshotObject::ScriptFunction: {
+        // the functions of a pool share the pool their code is loaded into
+        QExplicitlySharedDataPointer<NodePool> &pool = (*loadedPools)[o.pool];
+        if (! pool) {
+            const SnapshotPool &p = pools.at(o.pool);
+            const CodeCache cache(QString(), QString(), /*firstLineNumber=*/0);
+            if (! cache.load(eng, p.code, p.fileName, &pool)) {
+                Q_ASSERT_X(false, "EngineSnapshot::installObjects", "invalid code");
+                break;
+            }
+        }
+        AST::FunctionExpression *expr = pool->cacheFile()->functions.at(o.index).expression;
+        QScript::ScriptFunction *function = new QScript::ScriptFunction(expr, pool.data());
+        for (AST::FormalParameterList *it = expr->formals; it != 0; it = it->next)
+            function->formals.append(it->name);
+        function->length = function->formals.count();
+        eng->functionConstructor->newFunction(&result, function);
+    }   break;
+    case SnapshotObject::RegExp:
+        eng->regexpConstructor->newRegExp(&result, o.name, o.flags, o.program.data());
+        break;
+    case SnapshotObject::Variant:
+        eng->newVariant(&result, o.variant);
+        break;
+    case SnapshotObject::QObject:
+#ifndef QT_NO_QOBJECT
+        // the object may end up in any number of engines, so none of them
+        // can own it
+        eng->newQObject(&result, o.qobject, QScriptEngine::QtOwnership, o.options);
+#endif
+        break;
+    }
+    return result;
+}
+
+// gives the object the members it has in the snapshot, replacing those
+// it was created with; the layout is built from the recorded names and
+// flags, and the values are stored in place
+static void installMembers(QScriptEnginePrivate *eng, QScriptObject *object,
+                           const SnapshotObject &o, const QVector<QScriptValueImpl> &objects)
+{
+    const int count = o.members.size();
+    if ((count == 0) && ! object->m_shape)
+        return;
+
+    // the snapshot's strings are the first entries of the repository
+    const QVector<QScriptNameIdImpl*> &names = eng->m_stringRepository;
+    Shape *shape;
+    if (o.dictionary) {
+        shape = Shape::createDictionary(0);
+        for (int i = 0; i < count; ++i)
+            shape->appendMember(names.at(o.members.at(i).name), o.members.at(i).flags);
+    } else {
+        shape = object->m_class->rootShape();
+        for (int i = 0; i < count; ++i)
+            shape = shape->addTransition(names.at(o.members.at(i).name), o.members.at(i).flags);
+    }
+    object->setShape(shape);
+
+    for (int i = 0; i < count; ++i) {
+        QScriptValueImpl v = toImpl(o.members.at(i).value, objects, eng);
+        if (! v.isValid())
+            v = eng->undefinedValue();
+        object->m_values[i] = v;
+        object->writeBarrier(v);
+    }
+}
+
+static void installObject(QScriptEnginePrivate *eng, const QScriptValueImpl &object,
+                          const SnapshotObject &o, const QVector<QScriptValueImpl> &objects)
+{
+    QScriptObject *instance = object.objectValue();
+    instance->m_prototype = toImpl(o.prototype, objects, eng);
+    instance->m_scope = toImpl(o.scope, objects, eng);
+    instance->m_internalValue = toImpl(o.internalValue, objects, eng);
+    if (o.kind == SnapshotObject::Arguments) {
+        ArgumentsObjectData *data = static_cast<ArgumentsObjectData*>(instance->m_data);
+        data->activation = toImpl(o.activation, objects, eng);
+    }
+
+    installMembers(eng, instance, o, objects);
+
+    if (Ecma::Array::Instance *array = eng->arrayConstructor->get(object)) {
+        QScript::Array elements(eng);
+        for (int i = 0; i < o.elements.size(); ++i) {
+            const QScriptValueImpl e = toImpl(o.elements.at(i).second, objects, eng);
+            if (e.isValid())
+                elements.assign(o.elements.at(i).first, e);
+        }
+        elements.resize(o.length);
+        array->value = elements;
+    }
+}
+
+} // anonymous namespace
+
+EngineSnapshot::EngineSnapshot()
+{
+}
+
+EngineSnapshot::EngineSnapshot(const EngineSnapshot &other)
+    : d(other.d)
+{
+}
+
+EngineSnapshot::~EngineSnapshot()
+{
+}
+
+EngineSnapshot &EngineSnapshot::operator=(const EngineSnapshot &other)
+{
+    d = other.d;
+    return *this;
+}
+
+EngineSnapshot EngineSnapshot::capture(QScriptEnginePrivate *eng, QString *errorMessage)
+{
+    EngineSnapshot snapshot;
+    Data *d = new Data;
+    snapshot.d = d;
+
+    SnapshotWriter writer(eng, d);
+    writer.addBuiltins();
+    writer.writeObjects();
+    writer.writeCode();
+    if (writer.hasError()) {
+        if (errorMessage)
+            *errorMessage = writer.errorMessage();
+        return EngineSnapshot();
+    }
+
+    // the strings last, so that the names used by the objects come first
+    writer.writeStrings();
+
+    return snapshot;
+}
+
+void EngineSnapshot::loadStrings(QScriptEnginePrivate *eng) const
+{
+    QVector<QScriptNameIdImpl*> &repository = eng->m_stringRepository;
+    Q_ASSERT(repository.isEmpty());
+
+    repository.reserve(d->strings.size());
+    for (int i = 0; i < d->strings.size(); ++i) {
+        const SnapshotString &s = d->strings.at(i);
+        QScriptNameIdImpl *entry = new QScriptNameIdImpl(s.string);
+        entry->unique = true;
+        entry->h = s.hash;
+        entry->persistent = s.persistent;
+        repository.append(entry);
+    }
+    eng->m_stringTable.rebuild(repository);
+
+    // these were alive in the engine the snapshot was taken of, so they
+    // don't count towards the next collection
+    eng->m_oldStringRepositorySize = repository.size();
+}
+
+void EngineSnapshot::installObjects(QScriptEnginePrivate *eng) const
+{
+    Q_ASSERT(eng->objectAllocator.blocked());
+
+    const int count = d->objects.size();
+    QVector<QScriptValueImpl> objects(count);
+
+    // the built-in objects first, which also creates the constructors
+    // that the engine the snapshot was taken of had created
+    for (int i = 0; i < count; ++i) {
+        const SnapshotObject &o = d->objects.at(i);
+        if (o.kind == SnapshotObject::Builtin)
+            objects[i] = builtinObject(eng, o.index, /*create=*/true);
+    }
+
+    // the classes the snapshot can refer to are registered before any
+    // custom class, so they come first among the classes with their name
+    QHash<QString, QScriptClassInfo*> classes;
+    for (int i = eng->m_allocated_classes.size() - 1; i >= 0; --i) {
+        QScriptClassInfo *classInfo = eng->m_allocated_classes.at(i);
+        classes.insert(classInfo->name(), classInfo);
+    }
+
+    QVector<QExplicitlySharedDataPointer<NodePool> > pools(d->pools.size());
+    for (int i = 0; i < count; ++i) {
+        const SnapshotObject &o = d->objects.at(i);
+        if (o.kind != SnapshotObject::Builtin)
+            objects[i] = createObject(eng, o, classes, d->pools, &pools);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (objects.at(i).isObject())
+            installObject(eng, objects.at(i), d->objects.at(i), objects);
+    }
+}
+
+} // namespace QScript
+
+// for the benchmarks, which can't reach the private API of the library:
+// takes one snapshot of \a engine and creates \a count engines from it
+Q_SCRIPT_EXPORT void qt_scriptCreateEnginesFromSnapshot(QScriptEngine *engine, int count,
+                                                        QList<QScriptEngine*> *engines)
+{
+    QString errorMessage;
+    const QScript::EngineSnapshot snapshot
+        = QScriptEnginePrivate::get(engine)->takeSnapshot(&errorMessage);
+    if (snapshot.isNull()) {
+        qWarning("qt_scriptCreateEnginesFromSnapshot: %s", qPrintable(errorMessage));
+        return;
+    }
+    for (int i = 0; i < count; ++i)
+        engines->append(QScriptEnginePrivate::createEngine(snapshot));
+}
+
+QT_END_NAMESPACE
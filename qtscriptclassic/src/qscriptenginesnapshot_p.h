@@ -0,0 +1,121 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTENGINESNAPSHOT_P_H
+#define QSCRIPTENGINESNAPSHOT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qshareddata.h>
+#include <qstring.h>
+
+QT_BEGIN_NAMESPACE
+
+class QScriptEnginePrivate;
+
+namespace QScript {
+
+//
+// An immutable record of the state of an engine that new engines can be
+// created from (see QScriptEnginePrivate::createEngine()). It describes
+// every object reachable from the built-in objects of the engine, which
+// includes the global object, along with the interned strings of the
+// engine. A new engine loads the strings in bulk before init(), so that
+// the table is built once at its final size and the names don't need to
+// be hashed again. init() then only creates the built-in objects and
+// constructors without their members, and installObjects() creates the
+// other objects and gives every object the members, prototype and scope
+// it has in the snapshot; the layout of an object is built in one go
+// from the recorded names, without looking up each member.
+//
+// The objects of an engine can't be shared with another engine, so they
+// are kept as a description that doesn't refer to the engine: built-in
+// objects by their place in the engine, native functions by their
+// function pointer, and the other objects by their class and private
+// data. Script functions, including closures, are recorded with their
+// scope and with their compiled code in the format of QScript::CodeCache,
+// so a new engine neither parses nor compiles them again. Objects that
+// can't be described this way, such as those of a custom QScriptClass,
+// make capture() fail.
+//
+// A snapshot is implicitly shared and never changes once captured.
+//
+class EngineSnapshot
+{
+public:
+    EngineSnapshot();
+    EngineSnapshot(const EngineSnapshot &other);
+    ~EngineSnapshot();
+
+    EngineSnapshot &operator=(const EngineSnapshot &other);
+
+    inline bool isNull() const { return !d; }
+
+    // returns a null snapshot, and sets errorMessage, if an object can't
+    // be described
+    static EngineSnapshot capture(QScriptEnginePrivate *eng, QString *errorMessage = 0);
+
+    // must be called before eng->init() creates any string
+    void loadStrings(QScriptEnginePrivate *eng) const;
+
+    // must be called by eng->init() once it has created the built-in
+    // objects, with the garbage collector blocked
+    void installObjects(QScriptEnginePrivate *eng) const;
+
+    struct Data;
+
+private:
+    QExplicitlySharedDataPointer<Data> d;
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTENGINESNAPSHOT_P_H
@@ -52,6 +52,7 @@
 #include "qscriptextqobject_p.h"
 
 #include <QtDebug>
+#include <QCoreApplication>
 #include <QMetaMethod>
 #include <QRegExp>
 #include <QVarLengthArray>
@@ -101,9 +102,7 @@ public:
 class QtPropertyFunction: public QScriptFunction
 {
 public:
-    QtPropertyFunction(const QMetaObject *meta, int index)
-        : m_meta(meta), m_index(index)
-        { }
+    QtPropertyFunction(const QMetaObject *meta, int index);
 
     ~QtPropertyFunction() { }
 
@@ -114,8 +113,21 @@ public:
     virtual QString functionName() const;
 
 private:
+    bool readProperty(QScriptEnginePrivate *eng, QObject *qobject,
+                      QScriptValueImpl *result) const;
+    bool writeProperty(QScriptEnginePrivate *eng, QObject *qobject,
+                       const QScriptValueImpl &value) const;
+
     const QMetaObject *m_meta;
     int m_index;
+
+    // how the property is accessed without going through
+    // QMetaProperty and QVariant; m_type is QMetaType::Void if
+    // the property has to go through them
+    int m_type;
+    bool m_isEnum;
+    bool m_isWritable;
+    bool m_maybeScriptable;
 };
 
 class QObjectPrototype : public QObject
@@ -258,13 +270,184 @@ static QMetaMethod metaMethod(const QMetaObject *meta,
         return meta->constructor(index);
 }
     
+#ifndef Q_SCRIPT_NO_QMETAOBJECT_CACHE
+enum ArgumentKind {
+    UndefinedArgument = 1,
+    NullArgument,
+    BooleanArgument,
+    NumberArgument,
+    StringArgument
+};
+
+// describes the types of the arguments of a call, for looking the
+// method up in a QScriptMetaCallCache; a QObject is described by its
+// meta-object. Returns false if the overload chosen for the arguments
+// may depend on more than that
+static bool argumentSignature(QScriptContextPrivate *context,
+                              QVarLengthArray<quintptr, 8> *signature)
+{
+    const int argc = context->argumentCount();
+    signature->resize(argc);
+    for (int i = 0; i < argc; ++i) {
+        const QScriptValueImpl actual = context->argument(i);
+        quintptr kind;
+        if (actual.isNumber()) {
+            kind = NumberArgument;
+        } else if (actual.isString()) {
+            kind = StringArgument;
+        } else if (actual.isBoolean()) {
+            kind = BooleanArgument;
+        } else if (actual.isUndefined()) {
+            kind = UndefinedArgument;
+        } else if (actual.isNull()) {
+            kind = NullArgument;
+        } else if (actual.isQObject()) {
+            QObject *qobj = actual.toQObject();
+            if (!qobj)
+                return false;
+            kind = quintptr(qobj->metaObject());
+        } else {
+            return false;
+        }
+        (*signature)[i] = kind;
+    }
+    return true;
+}
+
+// converts the arguments for a method that an earlier call with the
+// same argument types resolved to
+static bool convertArguments(QScriptContextPrivate *context, const QScriptMetaMethod &method,
+                             QVarLengthArray<QVariant, 9> *args)
+{
+    QScriptEnginePrivate *engine = context->engine();
+    args->resize(method.count());
+    (*args)[0] = QVariant(method.returnType().typeId(), (void *)0); // the result
+    for (int i = 0; i < method.argumentCount(); ++i) {
+        QScriptValueImpl actual = context->argument(i);
+        QScriptMetaType argType = method.argumentType(i);
+        QVariant &v = (*args)[i+1];
+        if (argType.isUnresolved()) {
+            v = QVariant(QMetaType::QObjectStar, (void *)0);
+            if (!engine->convertToNativeQObject(actual, argType.name(),
+                                                reinterpret_cast<void* *>(v.data()))) {
+                return false;
+            }
+        } else if (argType.isVariant()) {
+            v = actual.toVariant();
+            if (!v.isValid() && !actual.isUndefined() && !actual.isNull())
+                return false;
+        } else {
+            v = QVariant(argType.typeId(), (void *)0);
+            if (!QScriptEnginePrivate::convert(actual, argType.typeId(), v.data(), engine))
+                return false;
+        }
+    }
+    return true;
+}
+#endif
+
+static QScriptValueImpl invokeQtMethod(QScriptContextPrivate *context, QMetaMethod::MethodType callType,
+                                       QObject *thisQObject, const QMetaObject *meta,
+                                       int index, const QScriptMetaMethod &method,
+                                       QVarLengthArray<QVariant, 9> &args)
+{
+    QScriptEnginePrivate *engine = context->engine();
+    context->calleeMetaIndex = index;
+
+    QVarLengthArray<void*, 9> array(args.count());
+    void **params = array.data();
+    for (int i = 0; i < args.count(); ++i) {
+        const QVariant &v = args[i];
+        switch (method.type(i).kind()) {
+        case QScriptMetaType::Variant:
+            params[i] = const_cast<QVariant*>(&v);
+            break;
+        case QScriptMetaType::MetaType:
+        case QScriptMetaType::MetaEnum:
+        case QScriptMetaType::Unresolved:
+            params[i] = const_cast<void*>(v.constData());
+            break;
+        default:
+            Q_ASSERT(0);
+        }
+    }
+
+    QScriptable *scriptable = 0;
+    if (thisQObject)
+        scriptable = scriptableFromQObject(thisQObject);
+    QScriptEngine *oldEngine = 0;
+    if (scriptable) {
+        oldEngine = QScriptablePrivate::get(scriptable)->engine;
+        QScriptablePrivate::get(scriptable)->engine = QScriptEnginePrivate::get(engine);
+    }
+
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+    engine->notifyFunctionEntry(context);
+#endif
+
+    if (callType == QMetaMethod::Constructor) {
+        Q_ASSERT(meta != 0);
+        meta->static_metacall(QMetaObject::CreateInstance, index, params);
+    } else {
+        Q_ASSERT(thisQObject != 0);
+        QMetaObject::metacall(thisQObject, QMetaObject::InvokeMetaMethod, index, params);
+    }
+
+    if (scriptable)
+        QScriptablePrivate::get(scriptable)->engine = oldEngine;
+
+    if (context->state() == QScriptContext::ExceptionState)
+        return context->returnValue(); // propagate
+
+    QScriptValueImpl result;
+    QScriptMetaType retType = method.returnType();
+    if (retType.isVariant()) {
+        result = engine->valueFromVariant(*(QVariant *)params[0]);
+    } else if (retType.typeId() != 0) {
+        result = engine->create(retType.typeId(), params[0]);
+        if (!result.isValid())
+            engine->newVariant(&result, QVariant(retType.typeId(), params[0]));
+    } else {
+        result = engine->undefinedValue();
+    }
+    return result;
+}
+
 static void callQtMethod(QScriptContextPrivate *context, QMetaMethod::MethodType callType,
                          QObject *thisQObject, const QMetaObject *meta, int initialIndex,
-                         bool maybeOverloaded)
+                         bool maybeOverloaded, QScriptMetaCallCache *callCache = 0)
 {
     QScriptValueImpl result;
     QScriptEnginePrivate *engine = context->engine();
 
+#ifndef Q_SCRIPT_NO_QMETAOBJECT_CACHE
+    QVarLengthArray<quintptr, 8> signature;
+    bool cacheable = callCache && argumentSignature(context, &signature);
+    if (cacheable) {
+        const QScriptMetaCallCache::Entry *entry;
+        entry = callCache->find(meta, signature.constData(), signature.size());
+        if (entry) {
+            // copied, since the slot may call back into the cache
+            const QScriptMetaMethod method = entry->method;
+            const int index = entry->index;
+            QVarLengthArray<QVariant, 9> args;
+            if (convertArguments(context, method, &args)) {
+                context->m_result = invokeQtMethod(context, callType, thisQObject, meta,
+                                                   index, method, args);
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+                engine->notifyFunctionExit(context);
+#endif
+                return;
+            }
+            if (engine->hasUncaughtException())
+                return;
+            // resolve the call again
+        }
+    }
+#else
+    Q_UNUSED(callCache);
+#endif
+
     int limit;
 #ifndef Q_SCRIPT_NO_QMETAOBJECT_CACHE
     int lastFoundIndex = initialIndex;
@@ -435,6 +618,10 @@ static void callQtMethod(QScriptContextPrivate *context, QMetaMethod::MethodType
                             m = meta->enumerator(mi);
                     }
                     if (m.isValid()) {
+#ifndef Q_SCRIPT_NO_QMETAOBJECT_CACHE
+                        // whether this matches depends on the value
+                        cacheable = false;
+#endif
                         if (actual.isNumber()) {
                             int ival = actual.toInt32();
                             if (m.valueToKey(ival) != 0) {
@@ -696,65 +883,14 @@ static void callQtMethod(QScriptContextPrivate *context, QMetaMethod::MethodType
         }
 
         if (chosenIndex != -1) {
-            // call it
-            context->calleeMetaIndex = chosenIndex;
-
-            QVarLengthArray<void*, 9> array(args.count());
-            void **params = array.data();
-            for (int i = 0; i < args.count(); ++i) {
-                const QVariant &v = args[i];
-                switch (chosenMethod.type(i).kind()) {
-                case QScriptMetaType::Variant:
-                    params[i] = const_cast<QVariant*>(&v);
-                    break;
-                case QScriptMetaType::MetaType:
-                case QScriptMetaType::MetaEnum:
-                case QScriptMetaType::Unresolved:
-                    params[i] = const_cast<void*>(v.constData());
-                    break;
-                default:
-                    Q_ASSERT(0);
-                }
-            }
-
-            QScriptable *scriptable = 0;
-            if (thisQObject)
-                scriptable = scriptableFromQObject(thisQObject);
-            QScriptEngine *oldEngine = 0;
-            if (scriptable) {
-                oldEngine = QScriptablePrivate::get(scriptable)->engine;
-                QScriptablePrivate::get(scriptable)->engine = QScriptEnginePrivate::get(engine);
+#ifndef Q_SCRIPT_NO_QMETAOBJECT_CACHE
+            if (cacheable) {
+                callCache->insert(meta, signature.constData(), signature.size(),
+                                  chosenIndex, chosenMethod);
             }
-
-#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
-            engine->notifyFunctionEntry(context);
 #endif
-
-            if (callType == QMetaMethod::Constructor) {
-                Q_ASSERT(meta != 0);
-                meta->static_metacall(QMetaObject::CreateInstance, chosenIndex, params);
-            } else {
-                Q_ASSERT(thisQObject != 0);
-                QMetaObject::metacall(thisQObject, QMetaObject::InvokeMetaMethod, chosenIndex, params);
-            }
-
-            if (scriptable)
-                QScriptablePrivate::get(scriptable)->engine = oldEngine;
-
-            if (context->state() == QScriptContext::ExceptionState) {
-                result = context->returnValue(); // propagate
-            } else {
-                QScriptMetaType retType = chosenMethod.returnType();
-                if (retType.isVariant()) {
-                    result = engine->valueFromVariant(*(QVariant *)params[0]);
-                } else if (retType.typeId() != 0) {
-                    result = engine->create(retType.typeId(), params[0]);
-                    if (!result.isValid())
-                        engine->newVariant(&result, QVariant(retType.typeId(), params[0]));
-                } else {
-                    result = engine->undefinedValue();
-                }
-            }
+            result = invokeQtMethod(context, callType, thisQObject, meta,
+                                    chosenIndex, chosenMethod, args);
         }
     }
 
@@ -1369,15 +1505,30 @@ private:
 
 struct QObjectConnection
 {
+    enum { VariantArgument = -1 };
+
     int slotIndex;
     QScriptValueImpl receiver;
     QScriptValueImpl slot;
     QScriptValueImpl senderWrapper;
+    // meta-type ids of the signal's parameters, VariantArgument for
+    // QVariant and 0 for types that aren't registered
+    QVector<int> argumentTypes;
+    QScriptEnginePrivate::SignalCoalescing coalescing;
+    // arguments of the emissions that haven't been delivered yet; a
+    // coalescing connection delivers them once per event loop turn
+    QVector<QScriptValueImpl> pendingArguments;
+    int pendingCount;
+    bool baseline; // made before the engine's baseline was recorded
 
     QObjectConnection(int i, const QScriptValueImpl &r, const QScriptValueImpl &s,
-               const QScriptValueImpl &sw)
-        : slotIndex(i), receiver(r), slot(s), senderWrapper(sw) {}
-    QObjectConnection() : slotIndex(-1) {}
+               const QScriptValueImpl &sw, const QVector<int> &types,
+               QScriptEnginePrivate::SignalCoalescing c)
+        : slotIndex(i), receiver(r), slot(s), senderWrapper(sw), argumentTypes(types),
+          coalescing(c), pendingCount(0), baseline(false) {}
+    QObjectConnection()
+        : slotIndex(-1), coalescing(QScriptEnginePrivate::NoCoalescing),
+          pendingCount(0), baseline(false) {}
 
     bool hasTarget(const QScriptValueImpl &r, const QScriptValueImpl &s) const
     {
@@ -1407,6 +1558,8 @@ struct QObjectConnection
             receiver.mark(generation);
         if (slot.isValid())
             slot.mark(generation);
+        for (int i = 0; i < pendingArguments.size(); ++i)
+            pendingArguments.at(i).mark(generation);
     }
 };
 
@@ -1420,7 +1573,8 @@ public:
         const QScriptValueImpl &receiver,
         const QScriptValueImpl &slot,
         const QScriptValueImpl &senderWrapper,
-        Qt::ConnectionType type);
+        Qt::ConnectionType type,
+        QScriptEnginePrivate::SignalCoalescing coalescing);
     bool removeSignalHandler(
         QObject *sender, int signalIndex,
         const QScriptValueImpl &receiver,
@@ -1435,9 +1589,26 @@ public:
 
     void mark(int generation);
 
+    void markBaseline();
+    void resetToBaseline(QObject *sender);
+
+protected:
+    virtual void customEvent(QEvent *event);
+
 private:
+    QObjectConnection *findConnection(int slotIndex, int *signalIndex);
+    QScriptValueImpl argumentValue(QScriptEnginePrivate *eng, int signalIndex,
+                                   int index, int type, void *arg) const;
+    void invoke(const QObjectConnection &c, int signalIndex, void **argv,
+                const QScriptValueImpl *values, int count);
+    void queue(QObjectConnection *c, int signalIndex, void **argv);
+    void deliverPending();
+
     int m_slotCounter;
     QVector<QVector<QObjectConnection> > connections;
+    QHash<int, int> m_slotSignals; // slot index -> signal index
+    QObject *m_sender; // the object the manager belongs to
+    bool m_deliveryPosted;
 };
 
 } // ::QScript
@@ -1605,35 +1776,52 @@ int QScript::QObjectConnectionManager::qt_metacall(QMetaObject::Call _c, int _id
     return _id;
 }
 
-void QScript::QObjectConnectionManager::execute(int slotIndex, void **argv)
+QScript::QObjectConnection *QScript::QObjectConnectionManager::findConnection(
+    int slotIndex, int *signalIndex)
 {
-    QScriptValueImpl receiver;
-    QScriptValueImpl slot;
-    QScriptValueImpl senderWrapper;
-    int signalIndex = -1;
-    for (int i = 0; i < connections.size(); ++i) {
-        const QVector<QObjectConnection> &cs = connections.at(i);
-        for (int j = 0; j < cs.size(); ++j) {
-            const QObjectConnection &c = cs.at(j);
-            if (c.slotIndex == slotIndex) {
-                receiver = c.receiver;
-                slot = c.slot;
-                senderWrapper = c.senderWrapper;
-                signalIndex = i;
-                break;
-            }
+    QHash<int, int>::const_iterator it = m_slotSignals.constFind(slotIndex);
+    if (it == m_slotSignals.constEnd())
+        return 0;
+    QVector<QObjectConnection> &cs = connections[it.value()];
+    for (int i = 0; i < cs.size(); ++i) {
+        if (cs.at(i).slotIndex == slotIndex) {
+            *signalIndex = it.value();
+            return &cs[i];
         }
     }
-    Q_ASSERT(slot.isValid());
+    return 0;
+}
 
-    QScriptEnginePrivate *eng = slot.engine();
+QScriptValueImpl QScript::QObjectConnectionManager::argumentValue(
+    QScriptEnginePrivate *eng, int signalIndex, int index, int type, void *arg) const
+{
+    if (type == QObjectConnection::VariantArgument)
+        return eng->valueFromVariant(*reinterpret_cast<QVariant*>(arg));
+    if (type)
+        return eng->create(type, arg);
+    const QMetaObject *meta = m_sender->metaObject();
+    const QMetaMethod method = meta->method(signalIndex);
+    qWarning("QScriptEngine: Unable to handle unregistered datatype '%s' "
+             "when invoking handler of signal %s::%s",
+             method.parameterTypes().at(index).constData(),
+             meta->className(), method.signature());
+    return eng->undefinedValue();
+}
 
-    if (eng->isCollecting()) {
-        // we can't do a script function call during GC,
-        // so we're forced to ignore this signal
-        return;
-    }
+// calls the handler of the given connection; the arguments are either
+// converted from the signal's argument vector, or given as script values
+// when the call was coalesced
+void QScript::QObjectConnectionManager::invoke(const QObjectConnection &c, int signalIndex,
+                                               void **argv, const QScriptValueImpl *values,
+                                               int count)
+{
+    // the handler may change the connections, so don't hold on to c
+    QScriptValueImpl receiver = c.receiver;
+    QScriptValueImpl slot = c.slot;
+    QScriptValueImpl senderWrapper = c.senderWrapper;
+    QVector<int> argumentTypes = c.argumentTypes;
 
+    QScriptEnginePrivate *eng = slot.engine();
     QScriptFunction *fun = eng->convertToNativeFunction(slot);
     if (fun == 0) {
         // the signal handler has been GC'ed. This can only happen when
@@ -1643,11 +1831,7 @@ void QScript::QObjectConnectionManager::execute(int slotIndex, void **argv)
         return;
     }
 
-    const QMetaObject *meta = sender()->metaObject();
-    const QMetaMethod method = meta->method(signalIndex);
-
-    QList<QByteArray> parameterTypes = method.parameterTypes();
-    int argc = parameterTypes.count();
+    int argc = argv ? argumentTypes.size() : count;
 
     QScriptValueImpl activation;
     eng->newActivation(&activation);
@@ -1656,38 +1840,17 @@ void QScript::QObjectConnectionManager::execute(int slotIndex, void **argv)
 
     int formalCount = fun->formals.count();
     int mx = qMax(formalCount, argc);
-    activation_data->m_members.resize(mx + 1);
-    activation_data->m_values.resize(mx + 1);
+    activation_data->setShape(fun->activationShape(activation_data->m_class, mx,
+                                                   QScriptValue::Undeletable
+                                                   | QScriptValue::SkipInEnumeration));
+    QScriptValueImpl *actuals = activation_data->m_values.data();
     for (int i = 0; i < mx; ++i) {
-        QScriptNameIdImpl *nameId;
-        if (i < formalCount)
-            nameId = fun->formals.at(i);
+        if (i >= argc)
+            actuals[i] = eng->undefinedValue();
+        else if (argv)
+            actuals[i] = argumentValue(eng, signalIndex, i, argumentTypes.at(i), argv[i + 1]);
         else
-            nameId = 0;
-        activation_data->m_members[i].object(nameId, i,
-                                             QScriptValue::Undeletable
-                                             | QScriptValue::SkipInEnumeration);
-        QScriptValueImpl actual;
-        if (i < argc) {
-            void *arg = argv[i + 1];
-            QByteArray typeName = parameterTypes.at(i);
-            int argType = QMetaType::type(typeName);
-            if (!argType) {
-                if (typeName == "QVariant") {
-                    actual = eng->valueFromVariant(*reinterpret_cast<QVariant*>(arg));
-                } else {
-                    qWarning("QScriptEngine: Unable to handle unregistered datatype '%s' "
-                             "when invoking handler of signal %s::%s",
-                             typeName.constData(), meta->className(), method.signature());
-                    actual = eng->undefinedValue();
-                }
-            } else {
-                actual = eng->create(argType, arg);
-            }
-        } else {
-            actual = eng->undefinedValue();
-        }
-        activation_data->m_values[i] = actual;
+            actuals[i] = values[i];
     }
 
     QScriptValueImpl senderObject;
@@ -1695,11 +1858,12 @@ void QScript::QObjectConnectionManager::execute(int slotIndex, void **argv)
         senderObject = senderWrapper;
     } else {
         QScriptEngine::QObjectWrapOptions opt = QScriptEngine::PreferExistingWrapperObject;
-        eng->newQObject(&senderObject, sender(), QScriptEngine::QtOwnership, opt);
+        eng->newQObject(&senderObject, m_sender, QScriptEngine::QtOwnership, opt);
     }
-    activation_data->m_members[mx].object(eng->idTable()->id___qt_sender__, mx,
-                                          QScriptValue::SkipInEnumeration);
-    activation_data->m_values[mx] = senderObject;
+    QScript::Member senderMember;
+    activation_data->createMember(eng->idTable()->id___qt_sender__, &senderMember,
+                                  QScriptValue::SkipInEnumeration);
+    activation_data->put(senderMember, senderObject);
 
     QScriptValueImpl thisObject;
     if (receiver.isObject())
@@ -1721,8 +1885,121 @@ void QScript::QObjectConnectionManager::execute(int slotIndex, void **argv)
         eng->emitSignalHandlerException();
 }
 
+// the type of the event that delivers the pending emissions; registered
+// once so that it can't collide with the application's own user events
+static QEvent::Type deliveryEventType()
+{
+    static int type = QEvent::registerEventType();
+    return QEvent::Type(type);
+}
+
+// records the arguments of an emission of a coalescing connection, and
+// makes sure that the pending calls are delivered when control returns
+// to the event loop
+void QScript::QObjectConnectionManager::queue(QObjectConnection *c, int signalIndex, void **argv)
+{
+    QScriptEnginePrivate *eng = c->slot.engine();
+    const int argc = c->argumentTypes.size();
+    int offset = 0;
+    if (c->coalescing == QScriptEnginePrivate::CoalesceBatch) {
+        offset = c->pendingCount * argc;
+        c->pendingArguments.resize(offset + argc);
+    } else if (c->pendingArguments.size() != argc) {
+        c->pendingArguments.resize(argc);
+    }
+    for (int i = 0; i < argc; ++i) {
+        c->pendingArguments[offset + i] = argumentValue(eng, signalIndex, i,
+                                                        c->argumentTypes.at(i), argv[i + 1]);
+    }
+    ++c->pendingCount;
+
+    if (!m_deliveryPosted) {
+        m_deliveryPosted = true;
+        QCoreApplication::postEvent(this, new QEvent(deliveryEventType()));
+    }
+}
+
+void QScript::QObjectConnectionManager::customEvent(QEvent *event)
+{
+    if (event->type() != deliveryEventType()) {
+        QObject::customEvent(event);
+        return;
+    }
+    m_deliveryPosted = false;
+    deliverPending();
+}
+
+// calls the handlers of the coalescing connections that have pending
+// emissions; a "latest" handler gets the arguments of the last emission,
+// a "batch" handler gets an array with an entry per emission (the
+// argument itself for single-argument signals, else an array of them)
+void QScript::QObjectConnectionManager::deliverPending()
+{
+    QVector<int> pendingSlots;
+    for (int i = 0; i < connections.size(); ++i) {
+        const QVector<QObjectConnection> &cs = connections.at(i);
+        for (int j = 0; j < cs.size(); ++j) {
+            if (cs.at(j).pendingCount)
+                pendingSlots.append(cs.at(j).slotIndex);
+        }
+    }
+
+    for (int i = 0; i < pendingSlots.size(); ++i) {
+        int signalIndex = -1;
+        QObjectConnection *c = findConnection(pendingSlots.at(i), &signalIndex);
+        if (!c || !c->pendingCount)
+            continue; // disconnected by an earlier handler
+        QScriptEnginePrivate *eng = c->slot.engine();
+
+        const int emissions = c->pendingCount;
+        QVector<QScriptValueImpl> pending = c->pendingArguments;
+        c->pendingArguments.clear();
+        c->pendingCount = 0;
+
+        if (c->coalescing == QScriptEnginePrivate::CoalesceLatest) {
+            invoke(*c, signalIndex, 0, pending.constData(), pending.size());
+            continue;
+        }
+
+        const int argc = c->argumentTypes.size();
+        QScript::Array batch(eng);
+        for (int j = 0; j < emissions; ++j) {
+            if (argc == 1) {
+                batch.assign(j, pending.at(j));
+            } else {
+                QScript::Array args(eng);
+                for (int k = 0; k < argc; ++k)
+                    args.assign(k, pending.at(j * argc + k));
+                batch.assign(j, eng->newArray(args));
+            }
+        }
+        QScriptValueImpl batchValue = eng->newArray(batch);
+        invoke(*c, signalIndex, 0, &batchValue, 1);
+    }
+}
+
+void QScript::QObjectConnectionManager::execute(int slotIndex, void **argv)
+{
+    int signalIndex = -1;
+    QObjectConnection *c = findConnection(slotIndex, &signalIndex);
+    Q_ASSERT(c != 0);
+
+    QScriptEnginePrivate *eng = c->slot.engine();
+
+    if (eng->isCollecting()) {
+        // we can't do a script function call during GC,
+        // so we're forced to ignore this signal
+        return;
+    }
+
+    if (c->coalescing != QScriptEnginePrivate::NoCoalescing)
+        queue(c, signalIndex, argv);
+    else
+        invoke(*c, signalIndex, argv, 0, 0);
+}
+
 QScript::QObjectConnectionManager::QObjectConnectionManager()
-    : m_slotCounter(0)
+    : m_slotCounter(0), m_sender(0), m_deliveryPosted(false)
 {
 }
 
@@ -1742,7 +2019,7 @@ void QScript::QObjectConnectionManager::mark(int generation)
 bool QScript::QObjectConnectionManager::addSignalHandler(
     QObject *sender, int signalIndex, const QScriptValueImpl &receiver,
     const QScriptValueImpl &function, const QScriptValueImpl &senderWrapper,
-    Qt::ConnectionType type)
+    Qt::ConnectionType type, QScriptEnginePrivate::SignalCoalescing coalescing)
 {
     if (connections.size() <= signalIndex)
         connections.resize(signalIndex+1);
@@ -1750,8 +2027,21 @@ bool QScript::QObjectConnectionManager::addSignalHandler(
     int absSlotIndex = m_slotCounter + metaObject()->methodOffset();
     bool ok = QMetaObject::connect(sender, signalIndex, this, absSlotIndex, type);
     if (ok) {
-        cs.append(QScript::QObjectConnection(m_slotCounter++, receiver, function, senderWrapper));
+        m_sender = sender;
         QMetaMethod signal = sender->metaObject()->method(signalIndex);
+        // resolve the parameter types once, rather than on every emission
+        QList<QByteArray> parameterTypes = signal.parameterTypes();
+        QVector<int> argumentTypes(parameterTypes.size());
+        for (int i = 0; i < parameterTypes.size(); ++i) {
+            const QByteArray &typeName = parameterTypes.at(i);
+            int argType = QMetaType::type(typeName);
+            if (!argType && typeName == "QVariant")
+                argType = QObjectConnection::VariantArgument;
+            argumentTypes[i] = argType;
+        }
+        m_slotSignals.insert(m_slotCounter, signalIndex);
+        cs.append(QScript::QObjectConnection(m_slotCounter++, receiver, function, senderWrapper,
+                                             argumentTypes, coalescing));
         QByteArray signalString;
         signalString.append('2'); // signal code
         signalString.append(signal.signature());
@@ -1760,6 +2050,39 @@ bool QScript::QObjectConnectionManager::addSignalHandler(
     return ok;
 }
 
+void QScript::QObjectConnectionManager::markBaseline()
+{
+    for (int i = 0; i < connections.size(); ++i) {
+        QVector<QObjectConnection> &cs = connections[i];
+        for (int j = 0; j < cs.size(); ++j)
+            cs[j].baseline = true;
+    }
+}
+
+// removes the connections that were made since the baseline was
+// recorded; the ones of the baseline that were removed since stay removed
+void QScript::QObjectConnectionManager::resetToBaseline(QObject *sender)
+{
+    for (int i = 0; i < connections.size(); ++i) {
+        QVector<QObjectConnection> &cs = connections[i];
+        for (int j = cs.size() - 1; j >= 0; --j) {
+            const QObjectConnection &c = cs.at(j);
+            if (c.baseline)
+                continue;
+            int absSlotIndex = c.slotIndex + metaObject()->methodOffset();
+            if (QMetaObject::disconnect(sender, i, this, absSlotIndex)) {
+                QMetaMethod signal = sender->metaObject()->method(i);
+                QByteArray signalString;
+                signalString.append('2'); // signal code
+                signalString.append(signal.signature());
+                static_cast<QScript::QObjectNotifyCaller*>(sender)->callDisconnectNotify(signalString);
+            }
+            m_slotSignals.remove(c.slotIndex);
+            cs.remove(j);
+        }
+    }
+}
+
 bool QScript::QObjectConnectionManager::removeSignalHandler(
     QObject *sender, int signalIndex,
     const QScriptValueImpl &receiver,
@@ -1774,6 +2097,7 @@ bool QScript::QObjectConnectionManager::removeSignalHandler(
             int absSlotIndex = c.slotIndex + metaObject()->methodOffset();
             bool ok = QMetaObject::disconnect(sender, signalIndex, this, absSlotIndex);
             if (ok) {
+                m_slotSignals.remove(c.slotIndex);
                 cs.remove(i);
                 QMetaMethod signal = sender->metaObject()->method(signalIndex);
                 QByteArray signalString;
@@ -1789,6 +2113,110 @@ bool QScript::QObjectConnectionManager::removeSignalHandler(
 
 
 
+QScript::QtPropertyFunction::QtPropertyFunction(const QMetaObject *meta, int index)
+    : m_meta(meta), m_index(index), m_type(QMetaType::Void),
+      m_isEnum(false), m_isWritable(false), m_maybeScriptable(true)
+{
+    QMetaProperty prop = meta->property(index);
+    if (!prop.isValid())
+        return;
+    // enums and flags that aren't registered as meta-types are stored as int
+    switch (prop.userType()) {
+    case QMetaType::Int:
+    case QMetaType::Double:
+    case QMetaType::Bool:
+    case QMetaType::QString:
+    case QMetaType::QObjectStar:
+        m_type = prop.userType();
+        break;
+    default:
+        break;
+    }
+    m_isEnum = prop.isEnumType();
+    m_isWritable = prop.isWritable();
+}
+
+template <typename T>
+static inline QScriptValueImpl readTypedProperty(QScriptEnginePrivate *eng, QObject *qobject,
+                                                 int index, int type)
+{
+    T value = T();
+    QVariant variant;
+    int status = -1;
+    void *argv[] = { &value, &variant, &status };
+    QMetaObject::metacall(qobject, QMetaObject::ReadProperty, index, argv);
+    if (status != -1) // filled in by a dynamic meta-object
+        return eng->valueFromVariant(variant);
+    return eng->create(type, argv[0]);
+}
+
+template <typename T>
+static inline bool writeTypedProperty(QScriptEnginePrivate *eng, QObject *qobject,
+                                      int index, int type, const QScriptValueImpl &arg)
+{
+    T value = T();
+    if (!QScriptEnginePrivate::convert(arg, type, &value, eng))
+        return false;
+    QVariant variant;
+    int status = -1;
+    int flags = 0;
+    void *argv[] = { &value, &variant, &status, &flags };
+    QMetaObject::metacall(qobject, QMetaObject::WriteProperty, index, argv);
+    return true;
+}
+
+bool QScript::QtPropertyFunction::readProperty(QScriptEnginePrivate *eng, QObject *qobject,
+                                               QScriptValueImpl *result) const
+{
+    switch (m_type) {
+    case QMetaType::Int:
+        *result = readTypedProperty<int>(eng, qobject, m_index, m_type);
+        return true;
+    case QMetaType::Double:
+        *result = readTypedProperty<double>(eng, qobject, m_index, m_type);
+        return true;
+    case QMetaType::Bool:
+        *result = readTypedProperty<bool>(eng, qobject, m_index, m_type);
+        return true;
+    case QMetaType::QString:
+        *result = readTypedProperty<QString>(eng, qobject, m_index, m_type);
+        return true;
+    case QMetaType::QObjectStar:
+        *result = readTypedProperty<QObject*>(eng, qobject, m_index, m_type);
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+// returns false if the value has to be written through QMetaProperty,
+// which knows how to reset the property or turn a name into an enum value
+bool QScript::QtPropertyFunction::writeProperty(QScriptEnginePrivate *eng, QObject *qobject,
+                                                const QScriptValueImpl &value) const
+{
+    if (!m_isWritable)
+        return true;
+    if (m_isEnum && value.isString())
+        return false;
+
+    switch (m_type) {
+    case QMetaType::Int:
+        return writeTypedProperty<int>(eng, qobject, m_index, m_type, value);
+    case QMetaType::Double:
+        return writeTypedProperty<double>(eng, qobject, m_index, m_type, value);
+    case QMetaType::Bool:
+        return writeTypedProperty<bool>(eng, qobject, m_index, m_type, value);
+    case QMetaType::QString:
+        return writeTypedProperty<QString>(eng, qobject, m_index, m_type, value);
+    case QMetaType::QObjectStar:
+        return writeTypedProperty<QObject*>(eng, qobject, m_index, m_type, value);
+    default:
+        break;
+    }
+    return false;
+}
+
 QString QScript::QtPropertyFunction::functionName() const
 {
     QMetaProperty prop = m_meta->property(m_index);
@@ -1814,6 +2242,48 @@ void QScript::QtPropertyFunction::execute(QScriptContextPrivate *context)
     }
     Q_ASSERT(qobject);
 
+    if (m_type != QMetaType::Void) {
+        // qobject is an instance of m_meta's class, so if one of them
+        // isn't a QScriptable, none of them is
+        QScriptable *scriptable = 0;
+        if (m_maybeScriptable) {
+            scriptable = scriptableFromQObject(qobject);
+            if (!scriptable)
+                m_maybeScriptable = false;
+        }
+        QScriptEngine *oldEngine = 0;
+        if (scriptable) {
+            oldEngine = QScriptablePrivate::get(scriptable)->engine;
+            QScriptablePrivate::get(scriptable)->engine = QScriptEnginePrivate::get(eng_p);
+        }
+
+        bool done;
+        if (context->argumentCount() == 0) {
+            done = readProperty(eng_p, qobject, &result);
+        } else {
+            done = writeProperty(eng_p, qobject, context->argument(0));
+            result = context->argument(0);
+        }
+
+        if (scriptable)
+            QScriptablePrivate::get(scriptable)->engine = oldEngine;
+
+        if (done) {
+            if (!eng_p->hasUncaughtException())
+                context->m_result = result;
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+            eng_p->notifyFunctionExit(context);
+#endif
+            return;
+        }
+        if (eng_p->hasUncaughtException()) {
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+            eng_p->notifyFunctionExit(context);
+#endif
+            return;
+        }
+    }
+
     QMetaProperty prop = m_meta->property(m_index);
     Q_ASSERT(prop.isScriptable());
     if (context->argumentCount() == 0) {
@@ -1883,6 +2353,11 @@ void QScript::QtFunction::mark(QScriptEnginePrivate *engine, int generation)
     QScriptFunction::mark(engine, generation);
 }
 
+QScript::QtFunction::~QtFunction()
+{
+    delete m_callCache;
+}
+
 void QScript::QtFunction::execute(QScriptContextPrivate *context)
 {
     QScriptEnginePrivate *eng_p = context->engine();
@@ -1922,8 +2397,10 @@ void QScript::QtFunction::execute(QScriptContextPrivate *context)
         thisQObject = qobj;
     }
 
+    if (!m_callCache)
+        m_callCache = new QScriptMetaCallCache;
     callQtMethod(context, QMetaMethod::Method, thisQObject,
-                 meta, m_initialIndex, m_maybeOverloaded);
+                 meta, m_initialIndex, m_maybeOverloaded, m_callCache);
 }
 
 int QScript::QtFunction::mostGeneralMethod(QMetaMethod *out) const
@@ -2096,10 +2573,13 @@ bool ExtQMetaObjectData::put(QScriptValueImpl *object, const Member &member,
     QScriptEnginePrivate *eng_p = object->engine();
     if (eng_p->idTable()->id_prototype == member.nameId()) {
         ExtQMetaObject::Instance *inst = ExtQMetaObject::Instance::get(*object, m_classInfo);
-        if (inst->ctor.isFunction())
+        if (inst->ctor.isFunction()) {
             inst->ctor.setProperty(eng_p->idTable()->id_prototype, value);
-        else
+        } else {
+            object->objectValue()->aboutToChange();
             inst->prototype = value;
+            object->objectValue()->writeBarrier(value);
+        }
     }
 
     return true;
@@ -2145,7 +2625,7 @@ void QScript::ExtQMetaObject::newQMetaObject(QScriptValueImpl *result, const QMe
         instance->ctor = ctor;
     } else {
         instance->prototype = engine()->newObject();
-        instance->prototype.setPrototype(engine()->qobjectConstructor->publicPrototype);
+        instance->prototype.setPrototype(engine()->qobjectConstructor()->publicPrototype);
     }
 
     engine()->newObject(result, publicPrototype, classInfo());
@@ -2178,12 +2658,13 @@ bool QScriptQObjectData::addSignalHandler(QObject *sender,
                                           const QScriptValueImpl &receiver,
                                           const QScriptValueImpl &slot,
                                           const QScriptValueImpl &senderWrapper,
-                                          Qt::ConnectionType type)
+                                          Qt::ConnectionType type,
+                                          QScriptEnginePrivate::SignalCoalescing coalescing)
 {
     if (!m_connectionManager)
         m_connectionManager = new QScript::QObjectConnectionManager();
     return m_connectionManager->addSignalHandler(
-        sender, signalIndex, receiver, slot, senderWrapper, type);
+        sender, signalIndex, receiver, slot, senderWrapper, type, coalescing);
 }
 
 bool QScriptQObjectData::removeSignalHandler(QObject *sender,
@@ -2197,6 +2678,18 @@ bool QScriptQObjectData::removeSignalHandler(QObject *sender,
         sender, signalIndex, receiver, slot);
 }
 
+void QScriptQObjectData::markBaseline()
+{
+    if (m_connectionManager)
+        m_connectionManager->markBaseline();
+}
+
+void QScriptQObjectData::resetToBaseline(QObject *sender)
+{
+    if (m_connectionManager)
+        m_connectionManager->resetToBaseline(sender);
+}
+
 bool QScriptQObjectData::findWrapper(QScriptEngine::ValueOwnership ownership,
                                      const QScriptEngine::QObjectWrapOptions &options,
                                      QScriptValueImpl *out)
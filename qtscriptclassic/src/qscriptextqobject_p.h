@@ -61,17 +61,22 @@
 #include "qscriptclassdata_p.h"
 #include "qscriptfunction_p.h"
 #include "qscriptengine.h"
+#include "qscriptenginefwd_p.h"
 #include "qscriptmemberfwd_p.h"
 
 #include <QHash>
+#include <QList>
 #include <QPointer>
 #include <QObject>
 #include <QVariant>
 #include <QVarLengthArray>
 #include <QVector>
+#include <QtAlgorithms>
 
 QT_BEGIN_NAMESPACE
 
+class QScriptMetaCallCache;
+
 namespace QScript {
 
 class QObjectConnectionManager;
@@ -116,10 +121,10 @@ class QtFunction: public QScriptFunction
 public:
     QtFunction(const QScriptValueImpl &object, int initialIndex, bool maybeOverloaded)
         : m_object(object), m_initialIndex(initialIndex),
-          m_maybeOverloaded(maybeOverloaded)
+          m_maybeOverloaded(maybeOverloaded), m_callCache(0)
         { }
 
-    virtual ~QtFunction() { }
+    virtual ~QtFunction();
 
     virtual void execute(QScriptContextPrivate *context);
 
@@ -156,6 +161,7 @@ private:
     QScriptValueImpl m_object;
     int m_initialIndex;
     bool m_maybeOverloaded;
+    QScriptMetaCallCache *m_callCache;
 };
 
 class ExtQMetaObject: public Ecma::Core
@@ -216,12 +222,16 @@ public:
                           const QScriptValueImpl &receiver,
                           const QScriptValueImpl &slot,
                           const QScriptValueImpl &senderWrapper,
-                          Qt::ConnectionType type);
+                          Qt::ConnectionType type,
+                          QScriptEnginePrivate::SignalCoalescing coalescing);
     bool removeSignalHandler(QObject *sender,
                              int signalIndex,
                              const QScriptValueImpl &receiver,
                              const QScriptValueImpl &slot);
 
+    void markBaseline();
+    void resetToBaseline(QObject *sender);
+
     bool findWrapper(QScriptEngine::ValueOwnership ownership,
                      const QScriptEngine::QObjectWrapOptions &options,
                      QScriptValueImpl *out);
@@ -439,6 +449,54 @@ private:
     QHash<QScriptNameIdImpl*, QScript::Member> m_members;
 };
 
+// the overloads that earlier calls of a QtFunction resolved to, keyed
+// on the types of the arguments (see argumentSignature()), so that a
+// call with the same types converts its arguments for the right method
+// straight away
+class QScriptMetaCallCache
+{
+public:
+    enum { MaxEntries = 4 };
+
+    struct Entry
+    {
+        const QMetaObject *meta;
+        QVector<quintptr> signature;
+        int index;
+        QScriptMetaMethod method;
+    };
+
+    inline const Entry *find(const QMetaObject *meta,
+                             const quintptr *signature, int count) const
+    {
+        for (int i = 0; i < m_entries.size(); ++i) {
+            const Entry &e = m_entries.at(i);
+            if ((e.meta == meta) && (e.signature.size() == count)
+                && qEqual(signature, signature + count, e.signature.constBegin())) {
+                return &e;
+            }
+        }
+        return 0;
+    }
+
+    inline void insert(const QMetaObject *meta, const quintptr *signature, int count,
+                       int index, const QScriptMetaMethod &method)
+    {
+        if (m_entries.size() == MaxEntries)
+            m_entries.removeLast();
+        Entry e;
+        e.meta = meta;
+        e.signature.resize(count);
+        qCopy(signature, signature + count, e.signature.begin());
+        e.index = index;
+        e.method = method;
+        m_entries.prepend(e);
+    }
+
+private:
+    QList<Entry> m_entries;
+};
+
 #endif // QT_NO_QOBJECT
 
 QT_END_NAMESPACE
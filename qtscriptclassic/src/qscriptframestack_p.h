@@ -0,0 +1,119 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTFRAMESTACK_P_H
+#define QSCRIPTFRAMESTACK_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qscriptbuffer_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+// The call frames of an engine, kept in the order of the calls.
+// Frames are laid out contiguously in segments that are allocated the
+// first time the call depth reaches them and never moved, so a frame
+// keeps its address, and pushing or popping one is a matter of moving
+// the top of the stack.
+template <typename Frame>
+class FrameStack
+{
+public:
+    enum { SegmentSize = 64 };
+
+    inline FrameStack() : m_depth(0) {}
+
+    inline ~FrameStack()
+    {
+        for (int i = 0; i < m_segments.size(); ++i)
+            delete[] m_segments.at(i);
+    }
+
+    inline Frame *push()
+    {
+        const int segment = m_depth / SegmentSize;
+        if (segment == m_segments.size())
+            m_segments.append(new Frame[SegmentSize]);
+        Frame *frame = m_segments.at(segment) + (m_depth % SegmentSize);
+        ++m_depth;
+        return frame;
+    }
+
+    inline void pop()
+    {
+        Q_ASSERT(m_depth > 0);
+        --m_depth;
+    }
+
+    inline int depth() const
+    { return m_depth; }
+
+    // the frames that have been allocated, including the ones above the
+    // top, which keep what the last call in them left
+    inline int capacity() const
+    { return m_segments.size() * SegmentSize; }
+
+    inline Frame *at(int index) const
+    { return m_segments.at(index / SegmentSize) + (index % SegmentSize); }
+
+private:
+    Buffer<Frame*> m_segments;
+    int m_depth;
+
+private:
+    Q_DISABLE_COPY(FrameStack)
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif
@@ -52,6 +52,8 @@ QT_BEGIN_NAMESPACE
 
 QScriptFunction::~QScriptFunction()
 {
+    if (m_activationShape)
+        m_activationShape->deref();
 }
 
 QString QScriptFunction::toString(QScriptContextPrivate *) const
@@ -87,6 +89,37 @@ void QScriptFunction::mark(QScriptEnginePrivate *engine, int generation)
         engine->markString(formals.at(i), generation);
 }
 
+// returns the layout of an activation object holding count arguments;
+// the last one built is kept so that calls don't walk the transitions
+QScript::Shape *QScriptFunction::activationShape(QScriptClassInfo *classInfo,
+                                                 int count, uint flags)
+{
+    if (m_activationShape && (m_activationShape->size() == count)
+        && (m_activationFlags == flags)) {
+        return m_activationShape;
+    }
+
+    const int formalCount = formals.count();
+
+    if (count > QScript::Shape::MaxTransitionMembers) {
+        QScript::Shape *shape = QScript::Shape::createDictionary(0);
+        for (int i = 0; i < count; ++i)
+            shape->appendMember((i < formalCount) ? formals.at(i) : 0, flags);
+        return shape;
+    }
+
+    QScript::Shape *shape = classInfo->rootShape();
+    for (int i = 0; i < count; ++i)
+        shape = shape->addTransition((i < formalCount) ? formals.at(i) : 0, flags);
+
+    shape->ref();
+    if (m_activationShape)
+        m_activationShape->deref();
+    m_activationShape = shape;
+    m_activationFlags = flags;
+    return shape;
+}
+
 // public API function
 void QScript::CFunction::execute(QScriptContextPrivate *context)
 {
@@ -71,6 +71,11 @@ QT_BEGIN_NAMESPACE
 class QScriptContext;
 class QScriptContextPrivate;
 class QScriptNameIdImpl;
+class QScriptClassInfo;
+
+namespace QScript {
+    class Shape;
+}
 
 class QScriptFunction: public QScriptObjectData
 {
@@ -86,7 +91,7 @@ public:
     };
 
     QScriptFunction(int len = 0)
-        : length(len)
+        : length(len), m_activationShape(0), m_activationFlags(0)
         { }
     virtual ~QScriptFunction();
 
@@ -106,9 +111,15 @@ public:
 
     virtual void mark(QScriptEnginePrivate *engine, int generation);
 
+    QScript::Shape *activationShape(QScriptClassInfo *classInfo, int count, uint flags);
+
 public: // ### private
     int length;
     QList<QScriptNameIdImpl*> formals;
+
+private:
+    QScript::Shape *m_activationShape;
+    uint m_activationFlags;
 };
 
 namespace QScript {
@@ -129,6 +140,9 @@ public:
 
     virtual QString functionName() const;
 
+    inline QScriptFunctionSignature function() const
+    { return m_funPtr; }
+
 private:
     QScriptFunctionSignature m_funPtr;
 };
@@ -151,6 +165,15 @@ public:
 
     virtual QString functionName() const;
 
+    inline QScriptInternalFunctionSignature function() const
+    { return m_funPtr; }
+
+    inline QScriptClassInfo *classInfo() const
+    { return m_classInfo; }
+
+    inline QString name() const
+    { return m_name; }
+
 private:
     QScriptInternalFunctionSignature m_funPtr;
     QScriptClassInfo *m_classInfo;
@@ -170,6 +193,12 @@ public:
 
     virtual Type type() const { return QScriptFunction::C3; }
 
+    inline QScriptFunctionWithArgSignature function() const
+    { return m_funPtr; }
+
+    inline void *argument() const
+    { return m_arg; }
+
 private:
     QScriptFunctionWithArgSignature m_funPtr;
     void *m_arg;
@@ -203,6 +232,12 @@ public:
 
     virtual int endLineNumber() const;
 
+    inline AST::FunctionExpression *definition() const
+    { return m_definition; }
+
+    inline NodePool *astPool() const
+    { return m_astPool.data(); }
+
 private:
     AST::FunctionExpression *m_definition;
     QExplicitlySharedDataPointer<NodePool> m_astPool;
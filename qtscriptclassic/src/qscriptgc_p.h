@@ -61,6 +61,7 @@
 
 
 #include <QtDebug>
+#include <QVector>
 #include <new>
 
 #include "qscriptmemorypool_p.h"
@@ -72,16 +73,20 @@ namespace QScript {
 class GCBlock
 {
 public:
+    enum { GenerationMask = 0x3fffffff };
+
     GCBlock *next;
 
-    union {
-        int generation;
-        uint flags;
-    };
+    uint generation: 30;
+    uint tenured: 1;        // survived a collection
+    uint remembered: 1;     // tenured and in the remembered set
+    uint baseline: 1;       // part of the engine's recorded baseline
+    uint journaled: 1;      // baseline state saved since the last reset
 
 public:
     inline GCBlock(GCBlock *n):
-        next(n), flags(0) {}
+        next(n), generation(0), tenured(0), remembered(0),
+        baseline(0), journaled(0) {}
 
     inline void *data()
     { return reinterpret_cast<char *>(this) + sizeof(GCBlock); }
@@ -100,11 +105,17 @@ private:
     int m_new_allocated_blocks;
     int m_free_blocks;
     int m_new_allocated_extra_bytes;
+    int m_young_blocks;
+    int m_tenured_blocks;
+    int m_promoted_blocks;
     GCBlock *m_head;
     GCBlock *m_current;
     GCBlock *m_free;
+    GCBlock *m_last_tenured;
+    QVector<GCBlock*> m_remembered;
     bool m_blocked_gc;
     bool m_force_gc;
+    bool m_force_major_gc;
     bool m_sweeping;
     MemoryPool pool;
     _Tp trivial;
@@ -112,17 +123,23 @@ private:
 public:
     enum { MaxNumberOfBlocks = 1 << 14 };
     enum { MaxNumberOfExtraBytes = 0x800000 };
+    enum { MaxNumberOfYoungBlocks = 1 << 12 };
 
 public:
     inline GCAlloc():
         m_new_allocated_blocks(0),
         m_free_blocks(0),
         m_new_allocated_extra_bytes(0),
+        m_young_blocks(0),
+        m_tenured_blocks(0),
+        m_promoted_blocks(0),
         m_head(0),
         m_current(0),
         m_free(0),
+        m_last_tenured(0),
         m_blocked_gc(false),
         m_force_gc(false),
+        m_force_major_gc(false),
         m_sweeping(false) {
         trivial.reset();
     }
@@ -158,6 +175,9 @@ public:
 
     inline int newAllocatedBlocks() const { return m_new_allocated_blocks; }
     inline int freeBlocks() const { return m_free_blocks; }
+    inline int youngBlocks() const { return m_young_blocks; }
+    inline int tenuredBlocks() const { return m_tenured_blocks; }
+    inline int rememberedBlocks() const { return m_remembered.size(); }
 
     inline _Tp *operator()(int generation)
     {
@@ -173,11 +193,9 @@ public:
             --m_free_blocks;
             where = m_free;
             m_free = m_free->next;
-
-            if (! m_free)
-                m_force_gc = true;
         }
 
+        ++m_young_blocks;
         m_current = new (where) GCBlock(0);
 
         if (! previous) {
@@ -186,7 +204,7 @@ public:
         } else {
             previous->next = m_current;
         }
-        m_current->generation = generation;
+        m_current->generation = generation & GCBlock::GenerationMask;
 
         return reinterpret_cast<_Tp*> (m_current->data());
     }
@@ -211,6 +229,7 @@ public:
     inline void requestGC()
     {
         m_force_gc = true;
+        m_force_major_gc = true;
     }
 
     inline void adjustBytesAllocated(int bytes)
@@ -226,31 +245,99 @@ public:
             return true;
         }
 
-        else if (m_free && ! m_free->next)
-            return true;
-
-        return (m_new_allocated_blocks >= MaxNumberOfBlocks)
+        return (m_young_blocks >= MaxNumberOfYoungBlocks)
+            || (m_new_allocated_blocks >= MaxNumberOfBlocks)
             || ((m_new_allocated_extra_bytes >= MaxNumberOfExtraBytes)
-                && (m_new_allocated_blocks > 0));
+                && (m_young_blocks > 0));
+    }
+
+    // a major collection is due when it was asked for explicitly, or
+    // when the tenured space has doubled since the last one
+    inline bool pollMajor() const
+    {
+        return m_force_major_gc
+            || (m_promoted_blocks >= qMax(int(MaxNumberOfBlocks),
+                                          m_tenured_blocks - m_promoted_blocks));
     }
 
     inline int generation(_Tp *ptr) const
     { return GCBlock::get(ptr)->generation; }
 
+    inline bool isTenured(_Tp *ptr) const
+    { return GCBlock::get(ptr)->tenured; }
+
     inline GCBlock *head() const
     { return m_head; }
 
-    void sweep(int generation)
+    // the blocks allocated since the last collection; they always
+    // follow the tenured ones in the list
+    inline GCBlock *nursery() const
+    { return m_last_tenured ? m_last_tenured->next : m_head; }
+
+    // records a tenured object that may now refer to young objects
+    inline void remember(_Tp *ptr)
+    {
+        GCBlock *blk = GCBlock::get(ptr);
+        Q_ASSERT(blk->tenured);
+        if (! blk->remembered) {
+            blk->remembered = 1;
+            m_remembered.append(blk);
+        }
+    }
+
+    inline const QVector<GCBlock*> &rememberedSet() const
+    { return m_remembered; }
+
+    inline GCBlock *lastTenured() const
+    { return m_last_tenured; }
+
+    // turns the blocks tenured after \a last back into nursery blocks
+    // and forgets the remembered set, so that the next minor collection
+    // frees whatever was allocated after \a last and is no longer
+    // reachable from outside the tenured blocks up to \a last
+    inline void untenureAfter(GCBlock *last)
+    {
+        for (int i = 0; i < m_remembered.size(); ++i)
+            m_remembered.at(i)->remembered = 0;
+        m_remembered.clear();
+
+        GCBlock *nurseryBegin = nursery();
+        for (GCBlock *blk = last ? last->next : m_head; blk != nurseryBegin; blk = blk->next) {
+            blk->tenured = 0;
+            --m_tenured_blocks;
+            ++m_young_blocks;
+            if (m_promoted_blocks > 0)
+                --m_promoted_blocks;
+        }
+        m_last_tenured = last;
+    }
+
+    // frees the unmarked blocks, of the nursery only if \a minor is
+    // true, and tenures the ones that survive
+    void sweep(int generation, bool minor = false)
     {
         m_sweeping = true;
-        GCBlock *blk = m_head;
-        m_current = 0;
+
+        for (int i = 0; i < m_remembered.size(); ++i)
+            m_remembered.at(i)->remembered = 0;
+        m_remembered.clear();
+
+        GCBlock *blk = minor ? nursery() : m_head;
+        m_current = minor ? m_last_tenured : 0;
+
+        generation &= GCBlock::GenerationMask;
+
+        if (! minor) {
+            m_tenured_blocks = 0;
+            m_force_major_gc = false;
+        }
 
         m_new_allocated_blocks = 0;
         m_new_allocated_extra_bytes = 0;
+        m_young_blocks = 0;
 
         while (blk != 0) {
-            if (blk->generation != generation) {
+            if (int(blk->generation) != generation) {
                 if (m_current)
                     m_current->next = blk->next;
 
@@ -268,13 +355,22 @@ public:
                 data->finalize();
                 tmp->~GCBlock();
             } else {
+                if (! blk->tenured) {
+                    blk->tenured = 1;
+                    ++m_promoted_blocks;
+                }
+                ++m_tenured_blocks;
                 m_current = blk;
                 blk = blk->next;
             }
         }
 
+        if (! minor)
+            m_promoted_blocks = 0;
+
         if (! m_current)
             m_head = m_current;
+        m_last_tenured = m_current;
         m_sweeping = false;
     }
 
@@ -0,0 +1,176 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qscriptinlinecache_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptmember_p.h"
+#include "qscriptobject_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+void InlineCache::update(QScriptObject *object, QScriptNameIdImpl *nameId, Link link,
+                         QScriptObject *holder, const Member &member,
+                         QScriptNameIdImpl *protoNameId)
+{
+    if ((m_misses > MaxMisses) || (nameId == protoNameId)
+        || ! member.isObjectProperty() || member.isGetterOrSetter()) {
+        return;
+    }
+
+    Entry e;
+    e.nameId = nameId;
+    e.transition = 0;
+    e.member = member;
+
+    QScriptObject *o = object;
+    int level = 0;
+    while (o != holder) {
+        if ((level == MaxDepth) || ! canSkip(o, link))
+            return;
+        const QScriptValueImpl &n = next(o, link);
+        if (! n.isObject())
+            return;
+        record(&e, level, o);
+        o = n.objectValue();
+        ++level;
+    }
+
+    // the member has to be one of the holder's own, and not something
+    // its class data handed out
+    Member own;
+    if (! o->findMember(nameId, &own) || (own.id() != member.id()))
+        return;
+
+    record(&e, level, o);
+    e.depth = level;
+    insert(e);
+}
+
+void InlineCache::updateTransition(QScriptObject *object, QScriptNameIdImpl *nameId,
+                                   Shape *oldShape, QScriptNameIdImpl *protoNameId)
+{
+    if ((m_misses > MaxMisses) || (nameId == protoNameId))
+        return;
+
+    // a tree shape keeps its parent alive, a dictionary one might not
+    Shape *shape = object->m_shape;
+    if (shape->isDictionary() || (oldShape && (shape->parent() != oldShape)))
+        return;
+
+    Entry e;
+    e.nameId = nameId;
+    e.transition = shape;
+    e.member = shape->at(shape->size() - 1);
+    e.shapes[0] = oldShape;
+    e.versions[0] = 0;
+
+    QScriptObject *o = object;
+    int level = 0;
+    for (;;) {
+        if (! canSkip(o, PrototypeLink))
+            return;
+        const QScriptValueImpl &n = o->m_prototype;
+        if (! n.isObject())
+            break;
+        if (level == MaxDepth)
+            return;
+        o = n.objectValue();
+        ++level;
+        record(&e, level, o);
+    }
+
+    e.depth = level;
+    insert(e);
+}
+
+void InlineCache::insert(const Entry &entry)
+{
+    if (! m_entries)
+        m_entries = new Entry[MaxEntries];
+
+    Entry *e;
+    if (m_count < MaxEntries) {
+        e = &m_entries[m_count++];
+    } else {
+        e = &m_entries[m_misses % MaxEntries];
+        for (int level = 0; level <= e->depth; ++level) {
+            if (e->shapes[level])
+                e->shapes[level]->deref();
+        }
+        if (e->transition)
+            e->transition->deref();
+        ++m_misses;
+    }
+
+    *e = entry;
+    for (int level = 0; level <= e->depth; ++level) {
+        if (e->shapes[level])
+            e->shapes[level]->ref();
+    }
+    if (e->transition)
+        e->transition->ref();
+}
+
+void InlineCache::clear()
+{
+    for (int i = 0; i < m_count; ++i) {
+        Entry &e = m_entries[i];
+        for (int level = 0; level <= e.depth; ++level) {
+            if (e.shapes[level])
+                e.shapes[level]->deref();
+        }
+        if (e.transition)
+            e.transition->deref();
+    }
+    delete[] m_entries;
+    m_entries = 0;
+    m_count = 0;
+    m_misses = 0;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,228 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QSCRIPTINLINECACHE_P_H
+#define QSCRIPTINLINECACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+
+
+#include "qscriptclassinfo_p.h"
+#include "qscriptmemberfwd_p.h"
+#include "qscriptobjectfwd_p.h"
+#include "qscriptshape_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+//
+// Remembers how a property access instruction was resolved the last
+// times it ran. An entry records the layout (shape and version) of every
+// object visited, from the receiver up to the object that holds the
+// member, so a later access on objects laid out the same way can read
+// or write the slot without a lookup. Each level is checked again on
+// every hit, which is what invalidates an entry once an object on the
+// path changes layout or gets another prototype or scope.
+//
+class InlineCache
+{
+public:
+    enum {
+        MaxEntries = 4,
+        MaxDepth = 3,
+        MaxMisses = 32 // become megamorphic after this many replacements
+    };
+
+    enum Link {
+        PrototypeLink,
+        ScopeLink
+    };
+
+    inline InlineCache();
+    inline ~InlineCache();
+
+    inline QScriptObject *lookup(QScriptObject *object, QScriptNameIdImpl *nameId,
+                                 Link link, Member *member) const;
+    inline Shape *lookupTransition(QScriptObject *object, QScriptNameIdImpl *nameId) const;
+
+    void update(QScriptObject *object, QScriptNameIdImpl *nameId, Link link,
+                QScriptObject *holder, const Member &member,
+                QScriptNameIdImpl *protoNameId);
+    void updateTransition(QScriptObject *object, QScriptNameIdImpl *nameId,
+                          Shape *oldShape, QScriptNameIdImpl *protoNameId);
+
+    void clear();
+
+private:
+    struct Entry {
+        QScriptNameIdImpl *nameId;
+        int depth;
+        Shape *shapes[MaxDepth + 1];
+        uint versions[MaxDepth + 1];
+        Shape *transition; // the layout after adding the member, if any
+        Member member;
+    };
+
+    static inline bool matches(const Shape *shape, uint version, const QScriptObject *object);
+    static inline const QScriptValueImpl &next(const QScriptObject *object, Link link);
+    static inline bool canSkip(const QScriptObject *object, Link link);
+    static inline void record(Entry *entry, int level, QScriptObject *object);
+
+    void insert(const Entry &entry);
+
+    Entry *m_entries;
+    int m_count;
+    int m_misses;
+
+private:
+    Q_DISABLE_COPY(InlineCache)
+};
+
+inline InlineCache::InlineCache()
+    : m_entries(0), m_count(0), m_misses(0)
+{
+}
+
+inline InlineCache::~InlineCache()
+{
+    clear();
+}
+
+inline bool InlineCache::matches(const Shape *shape, uint version, const QScriptObject *object)
+{
+    return (object->m_shape == shape)
+        && (! shape || (shape->version() == version));
+}
+
+inline const QScriptValueImpl &InlineCache::next(const QScriptObject *object, Link link)
+{
+    return (link == PrototypeLink) ? object->m_prototype : object->m_scope;
+}
+
+// whether the resolution continues past this object without
+// consulting anything but its own members
+inline bool InlineCache::canSkip(const QScriptObject *object, Link link)
+{
+    if (object->m_class->data() != 0)
+        return false;
+    if ((link == ScopeLink) && object->m_prototype.isObject())
+        return false;
+    return true;
+}
+
+// returns the object holding the member, or 0 if nothing was cached
+inline QScriptObject *InlineCache::lookup(QScriptObject *object, QScriptNameIdImpl *nameId,
+                                          Link link, Member *member) const
+{
+    for (int i = 0; i < m_count; ++i) {
+        const Entry &e = m_entries[i];
+        if ((e.nameId != nameId) || e.transition)
+            continue;
+
+        QScriptObject *o = object;
+        for (int level = 0; ; ++level) {
+            if (! matches(e.shapes[level], e.versions[level], o))
+                break;
+            if (level == e.depth) {
+                *member = e.member;
+                return o;
+            }
+            if (! canSkip(o, link))
+                break;
+            const QScriptValueImpl &n = next(o, link);
+            if (! n.isObject())
+                break;
+            o = n.objectValue();
+        }
+    }
+    return 0;
+}
+
+// returns the layout the object gets when the member is added to it,
+// or 0 if the member could already be found along the prototype chain
+inline Shape *InlineCache::lookupTransition(QScriptObject *object, QScriptNameIdImpl *nameId) const
+{
+    for (int i = 0; i < m_count; ++i) {
+        const Entry &e = m_entries[i];
+        if ((e.nameId != nameId) || ! e.transition)
+            continue;
+
+        QScriptObject *o = object;
+        for (int level = 0; ; ++level) {
+            if (! matches(e.shapes[level], e.versions[level], o) || ! canSkip(o, PrototypeLink))
+                break;
+            const QScriptValueImpl &n = o->m_prototype;
+            if (level == e.depth) {
+                if (n.isObject())
+                    break;
+                return e.transition;
+            }
+            if (! n.isObject())
+                break;
+            o = n.objectValue();
+        }
+    }
+    return 0;
+}
+
+inline void InlineCache::record(Entry *entry, int level, QScriptObject *object)
+{
+    entry->shapes[level] = object->m_shape;
+    entry->versions[level] = object->m_shape ? object->m_shape->version() : 0;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTINLINECACHE_P_H
@@ -0,0 +1,1143 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptjit_p.h"
+
+#ifdef Q_SCRIPT_JIT
+
+#include "qscriptasm_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptengine_p.h"
+#include "qscriptcontext_p.h"
+#include "qscriptmember_p.h"
+#include "qscriptobject_p.h"
+#include "qscriptinlinecache_p.h"
+#include "qscriptnodepool_p.h"
+
+#include <QByteArray>
+#include <qnumeric.h>
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+namespace {
+
+//
+// The helpers called by the native code. Each one either does all of its
+// instruction and returns true, or changes nothing and returns false, so
+// that the interpreter executes the instruction instead.
+//
+
+static inline bool arrayIndex(const QScriptValueImpl &v, quint32 *index)
+{
+    if (! v.isNumber())
+        return false;
+    const qsreal n = v.numberValue();
+    if (! (n >= 0) || (n >= qsreal(0xFFFFFFFF)))
+        return false;
+    *index = quint32(n);
+    return qsreal(*index) == n;
+}
+
+static inline Ecma::Array::Instance *arrayInstance(QScriptEnginePrivate *eng, QScriptObject *object)
+{
+    if (object->m_class != eng->arrayConstructor->classInfo())
+        return 0;
+    return static_cast<Ecma::Array::Instance*>(object->m_data);
+}
+
+static bool helperLine(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    QScriptEnginePrivate *eng = ctx->engine();
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+    if (eng->shouldNotify())
+        return false;
+#endif
+    ctx->iPtr = i;
+    eng->maybeGC();
+    eng->maybeProcessEvents();
+    eng->maybeSample(ctx);
+    if (ctx->hasUncaughtException() || eng->shouldAbort())
+        return false;
+    ctx->currentLine = i->operand[0].intValue();
+    ctx->currentColumn = i->operand[1].intValue();
+    return true;
+}
+
+static bool helperBranch(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    QScriptEnginePrivate *eng = ctx->engine();
+    ctx->iPtr = i;
+    eng->maybeProcessEvents();
+    eng->maybeSample(ctx);
+    return ! ctx->hasUncaughtException() && ! eng->shouldAbort();
+}
+
+static bool helperFetch(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    if (ctx->stackPtr + 1 >= ctx->engine()->tempStackEnd)
+        return false;
+    Member member;
+    QScriptObject *holder = ctx->m_code->inlineCaches[i->inlineCache].lookup(
+        ctx->m_scopeChain.objectValue(), i->operand[0].stringValue(),
+        InlineCache::ScopeLink, &member);
+    if (! holder)
+        return false;
+    holder->get(member, ++ctx->stackPtr);
+    return true;
+}
+
+// Fetch, LoadString, FetchField
+static bool helperFetchLocalField(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    if (ctx->stackPtr + 2 >= ctx->engine()->tempStackEnd)
+        return false;
+    const InlineCache *caches = ctx->m_code->inlineCaches;
+    Member member;
+    QScriptObject *holder = caches[i->inlineCache].lookup(
+        ctx->m_scopeChain.objectValue(), i->operand[0].stringValue(),
+        InlineCache::ScopeLink, &member);
+    if (! holder)
+        return false;
+    QScriptValueImpl object;
+    holder->get(member, &object);
+    if (! object.isObject())
+        return false;
+
+    const QScriptInstruction *field = i + 1;
+    holder = caches[field[1].inlineCache].lookup(
+        object.objectValue(), field->operand[0].stringValue(),
+        InlineCache::PrototypeLink, &member);
+    if (! holder)
+        return false;
+    holder->get(member, ++ctx->stackPtr);
+    return true;
+}
+
+static bool helperFetchField(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    QScriptValueImpl *sp = ctx->stackPtr;
+    if (! sp[-1].isObject())
+        return false;
+    QScriptObject *instance = sp[-1].objectValue();
+    const QScriptValueImpl &m = sp[0];
+
+    if (Ecma::Array::Instance *array = arrayInstance(ctx->engine(), instance)) {
+        quint32 pos;
+        if (! arrayIndex(m, &pos))
+            return false;
+        const QScriptValueImpl value = array->value.at(pos);
+        if (! value.isValid())
+            return false;
+        *--ctx->stackPtr = value;
+        return true;
+    }
+
+    if (! m.isString() || ! m.stringValue()->unique)
+        return false;
+    Member member;
+    QScriptObject *holder = ctx->m_code->inlineCaches[i->inlineCache].lookup(
+        instance, m.stringValue(), InlineCache::PrototypeLink, &member);
+    if (! holder)
+        return false;
+    holder->get(member, --ctx->stackPtr);
+    return true;
+}
+
+static bool helperAssign(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    QScriptValueImpl *sp = ctx->stackPtr;
+    if (! sp[-1].isReference() || ! sp[-3].isObject())
+        return false;
+    QScriptObject *instance = sp[-3].objectValue();
+    const QScriptValueImpl &m = sp[-2];
+    const QScriptValueImpl value = sp[0];
+
+    if (Ecma::Array::Instance *array = arrayInstance(ctx->engine(), instance)) {
+        quint32 pos;
+        if (! arrayIndex(m, &pos))
+            return false;
+        instance->aboutToChange();
+        array->value.assign(pos, value);
+        instance->writeBarrier(value);
+    } else {
+        if (! m.isString() || ! m.stringValue()->unique)
+            return false;
+        if (value.isString() && ! value.stringValue()->unique)
+            return false;
+        const bool isMemberAssignment = (instance != ctx->m_scopeChain.objectValue());
+        Member member;
+        QScriptObject *holder = ctx->m_code->inlineCaches[i->inlineCache].lookup(
+            instance, m.stringValue(),
+            isMemberAssignment ? InlineCache::PrototypeLink : InlineCache::ScopeLink, &member);
+        if (! holder || ! member.isWritable() || (isMemberAssignment && (holder != instance)))
+            return false;
+        holder->put(member, value);
+    }
+
+    ctx->stackPtr = sp - 3;
+    *ctx->stackPtr = value;
+    return true;
+}
+
+static bool helperPutField(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    QScriptValueImpl *sp = ctx->stackPtr;
+    if (! sp[-3].isObject())
+        return false;
+    QScriptObject *instance = sp[-3].objectValue();
+    QScriptNameIdImpl *memberName = sp[-2].stringValue();
+    const InlineCache &cache = ctx->m_code->inlineCaches[i->inlineCache];
+    Member member;
+    if (cache.lookup(instance, memberName, InlineCache::PrototypeLink, &member) != instance) {
+        Shape *transition = cache.lookupTransition(instance, memberName);
+        if (! transition)
+            return false;
+        instance->addMember(transition, &member);
+        ctx->engine()->adjustBytesAllocated(sizeof(Member) + sizeof(QScriptValueImpl));
+    }
+    instance->put(member, sp[0]);
+    ctx->stackPtr = sp - 4;
+    return true;
+}
+
+// the number stored in the given member of the head of the scope chain,
+// when it can be replaced without resolving the name
+static inline QScriptObject *localNumber(QScriptContextPrivate *ctx, QScriptObject *instance,
+                                         QScriptNameIdImpl *name, Member *member, qsreal *value)
+{
+    if (instance != ctx->m_scopeChain.objectValue())
+        return 0;
+    if (! instance->findMember(name, member) || ! member->isObjectProperty()
+        || member->isGetterOrSetter() || ! member->isWritable()) {
+        return 0;
+    }
+    QScriptValueImpl v;
+    instance->get(*member, &v);
+    if (! v.isNumber())
+        return 0;
+    *value = v.numberValue();
+    return instance;
+}
+
+// Resolve, [Post]Incr or [Post]Decr, Pop
+static inline bool updateLocal(QScriptContextPrivate *ctx, const QScriptInstruction *i, int delta)
+{
+    Member member;
+    qsreal value;
+    QScriptObject *instance = localNumber(ctx, ctx->m_scopeChain.objectValue(),
+                                          i->operand[0].stringValue(), &member, &value);
+    if (! instance)
+        return false;
+    instance->put(member, QScriptValueImpl(value + delta));
+    return true;
+}
+
+static bool helperIncrLocal(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    return updateLocal(ctx, i, 1);
+}
+
+static bool helperDecrLocal(QScriptContextPrivate *ctx, const QScriptInstruction *i)
+{
+    return updateLocal(ctx, i, -1);
+}
+
+// an in-place operator on a number stored in the head of the scope chain
+static inline bool inplaceLocal(QScriptContextPrivate *ctx, QScriptInstruction::Operator op)
+{
+    QScriptValueImpl *sp = ctx->stackPtr;
+    if (! sp[-1].isReference() || ! sp[-3].isObject() || ! sp[-2].isString() || ! sp[0].isNumber())
+        return false;
+    QScriptNameIdImpl *name = sp[-2].stringValue();
+    if (! name->unique)
+        return false;
+    Member member;
+    qsreal lhs;
+    QScriptObject *instance = localNumber(ctx, sp[-3].objectValue(), name, &member, &lhs);
+    if (! instance)
+        return false;
+
+    const qsreal rhs = sp[0].numberValue();
+    qsreal result;
+    switch (op) {
+    case QScriptInstruction::OP_InplaceAdd: result = lhs + rhs; break;
+    case QScriptInstruction::OP_InplaceSub: result = lhs - rhs; break;
+    case QScriptInstruction::OP_InplaceMul: result = lhs * rhs; break;
+    default: result = lhs / rhs; break;
+    }
+
+    const QScriptValueImpl value(result);
+    instance->put(member, value);
+    ctx->stackPtr = sp - 3;
+    *ctx->stackPtr = value;
+    return true;
+}
+
+static bool helperInplaceAdd(QScriptContextPrivate *ctx, const QScriptInstruction *)
+{
+    return inplaceLocal(ctx, QScriptInstruction::OP_InplaceAdd);
+}
+
+static bool helperInplaceSub(QScriptContextPrivate *ctx, const QScriptInstruction *)
+{
+    return inplaceLocal(ctx, QScriptInstruction::OP_InplaceSub);
+}
+
+static bool helperInplaceMul(QScriptContextPrivate *ctx, const QScriptInstruction *)
+{
+    return inplaceLocal(ctx, QScriptInstruction::OP_InplaceMul);
+}
+
+static bool helperInplaceDiv(QScriptContextPrivate *ctx, const QScriptInstruction *)
+{
+    return inplaceLocal(ctx, QScriptInstruction::OP_InplaceDiv);
+}
+
+typedef bool (*Helper)(QScriptContextPrivate *ctx, const QScriptInstruction *i);
+
+static inline quint64 bitsOf(const QScriptValueImpl &value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//
+// Encodes the few x86-64 instructions the templates are made of. Memory
+// operands are always [base + disp32].
+//
+class Assembler
+{
+public:
+    enum Register {
+        RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+        R12 = 12, R13 = 13, R14 = 14
+    };
+
+    enum XmmRegister { XMM0, XMM1, XMM2 };
+
+    enum Condition {
+        Below = 0x2, AboveOrEqual = 0x3, Equal = 0x4, NotEqual = 0x5,
+        Above = 0x7, Sign = 0x8, Parity = 0xA, NoParity = 0xB
+    };
+
+    enum ArithmeticOperation { Add = 0x01, Or = 0x09, And = 0x21, Xor = 0x31 };
+
+    enum ShiftOperation { ShiftLeft = 4, ShiftRight = 5, ShiftRightArithmetic = 7 };
+
+    enum ScalarOperation { AddScalar = 0x58, MulScalar = 0x59, SubScalar = 0x5C, DivScalar = 0x5E };
+
+    inline int offset() const { return m_code.size(); }
+    inline const QByteArray &code() const { return m_code; }
+
+    void push(Register r) { rex(false, 0, r); byte(0x50 + (r & 7)); }
+    void pop(Register r) { rex(false, 0, r); byte(0x58 + (r & 7)); }
+    void ret() { byte(0xC3); }
+
+    void move(Register dst, quint64 imm) { rex(true, 0, dst); byte(0xB8 + (dst & 7)); int64(imm); }
+    void move(Register dst, Register src) { rex(true, src, dst); byte(0x89); direct(src, dst); }
+    void move32(Register dst, Register src) { rex(false, src, dst); byte(0x89); direct(src, dst); }
+    void load(Register dst, Register base, int disp) { rex(true, dst, base); byte(0x8B); memory(dst, base, disp); }
+    void store(Register base, int disp, Register src) { rex(true, src, base); byte(0x89); memory(src, base, disp); }
+    void lea(Register dst, Register base, int disp) { rex(true, dst, base); byte(0x8D); memory(dst, base, disp); }
+
+    void add(Register r, int imm) { rex(true, 0, r); byte(0x81); direct(0, r); int32(imm); }
+    void sub(Register r, int imm) { rex(true, 0, r); byte(0x81); direct(5, r); int32(imm); }
+    void arithmetic(ArithmeticOperation op, Register dst, Register src, bool wide)
+    { rex(wide, src, dst); byte(op); direct(src, dst); }
+    void xor8(Register r, int imm) { rex(true, 0, r); byte(0x83); direct(6, r); byte(imm); }
+    void complementBit(Register r, int bit) { rex(true, 0, r); byte(0x0F); byte(0xBA); direct(7, r); byte(bit); }
+    void not32(Register r) { rex(false, 0, r); byte(0xF7); direct(2, r); }
+    void divide32(Register r) { rex(false, 0, r); byte(0xF7); direct(6, r); }
+    void shiftRight(Register r, int count) { rex(true, 0, r); byte(0xC1); direct(ShiftRight, r); byte(count); }
+    void shift32(ShiftOperation op, Register r) { rex(false, 0, r); byte(0xD3); direct(op, r); }
+
+    // the flags of a - b
+    void compare(Register a, Register b) { rex(true, b, a); byte(0x39); direct(b, a); }
+    void compare32(Register r, int imm) { rex(false, 0, r); byte(0x81); direct(7, r); int32(imm); }
+    void test(Register a, Register b, bool wide) { rex(wide, b, a); byte(0x85); direct(b, a); }
+    void testByte() { byte(0x84); direct(RAX, RAX); } // test al, al
+
+    // the low byte of RAX, RCX, RDX or RBX
+    void set(Condition cc, Register r) { byte(0x0F); byte(0x90 + cc); direct(0, r); }
+    void zeroExtend8(Register dst, Register src) { byte(0x0F); byte(0xB6); direct(dst, src); }
+    void and8(Register dst, Register src) { byte(0x20); direct(src, dst); }
+    void or8(Register dst, Register src) { byte(0x08); direct(src, dst); }
+
+    void moveToXmm(XmmRegister x, Register r) { byte(0x66); rex(true, x, r); byte(0x0F); byte(0x6E); direct(x, r); }
+    void moveFromXmm(Register r, XmmRegister x) { byte(0x66); rex(true, x, r); byte(0x0F); byte(0x7E); direct(x, r); }
+    void scalar(ScalarOperation op, XmmRegister dst, XmmRegister src) { byte(0xF2); byte(0x0F); byte(op); direct(dst, src); }
+    void compareScalar(XmmRegister a, XmmRegister b) { byte(0x66); byte(0x0F); byte(0x2E); direct(a, b); }
+    void truncate(Register dst, XmmRegister x) { byte(0xF2); rex(true, dst, x); byte(0x0F); byte(0x2C); direct(dst, x); }
+    void convert(XmmRegister x, Register src, bool wide) { byte(0xF2); rex(wide, x, src); byte(0x0F); byte(0x2A); direct(x, src); }
+
+    void call(Register r) { rex(false, 0, r); byte(0xFF); direct(2, r); }
+    void jump(Register r) { rex(false, 0, r); byte(0xFF); direct(4, r); }
+
+    // return the position of the displacement, for bind()
+    int jump() { byte(0xE9); int32(0); return offset() - 4; }
+    int jumpIf(Condition cc) { byte(0x0F); byte(0x80 + cc); int32(0); return offset() - 4; }
+    int shortJumpIf(Condition cc) { byte(0x70 + cc); byte(0); return offset() - 1; }
+
+    void bind(int position, int target)
+    {
+        const qint32 displacement = target - (position + 4);
+        memcpy(m_code.data() + position, &displacement, sizeof(displacement));
+    }
+
+    void bindShort(int position)
+    {
+        const int displacement = offset() - (position + 1);
+        Q_ASSERT(displacement < 128);
+        m_code[position] = char(displacement);
+    }
+
+private:
+    inline void byte(int b) { m_code.append(char(b)); }
+    inline void int32(qint32 v) { m_code.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    inline void int64(quint64 v) { m_code.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    void rex(bool wide, int reg, int rm)
+    {
+        const int prefix = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+        if (prefix != 0x40)
+            byte(prefix);
+    }
+
+    void direct(int reg, int rm) { byte(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+
+    void memory(int reg, int base, int disp)
+    {
+        byte(0x80 | ((reg & 7) << 3) | (base & 7));
+        if ((base & 7) == RSP)
+            byte(0x24);
+        int32(disp);
+    }
+
+    QByteArray m_code;
+};
+
+//
+// Generates the code of a JitCode. RBX holds the stack pointer of the
+// context, R12 the context, R13 the end of the temp stack and R14 the
+// smallest value that isn't a number.
+//
+class JitCompiler
+{
+public:
+    enum Comparison { Less, LessOrEqual, Greater, GreaterOrEqual, Equal, NotEqual };
+
+    JitCompiler(Code *code);
+
+    bool compile();
+
+    inline const QByteArray &code() const { return m_asm.code(); }
+    inline const QVector<int> &entries() const { return m_entries; }
+
+private:
+    static int width(const QScriptInstruction &instruction);
+
+    bool compileInstruction(int index);
+
+    void jumpTo(int position, int target);
+    void exitTo(int position, int index);
+    void checkStack(int index, int count);
+    void push(quint64 bits);
+    void loadNumber(Assembler::Register r, Assembler::XmmRegister x, int disp, int index);
+    void loadNumbers(int index);
+    void storeNumber(int disp);
+    void toInt32(Assembler::Register r, Assembler::XmmRegister x, int index);
+    void compareNumbers(Comparison comparison);
+    void storeBoolean(int disp);
+    void callHelper(Helper helper, int index);
+
+    struct Fixup
+    {
+        int position;
+        int target;
+        bool exit; // to the interpreter, even if the target has code
+    };
+
+    Code *m_code;
+    QScriptEnginePrivate *m_engine;
+    int m_count;
+    Assembler m_asm;
+    QVector<int> m_entries;
+    QVector<Fixup> m_fixups;
+
+    quint64 m_invalid;
+    quint64 m_false;
+    quint64 m_true;
+    quint64 m_nan;
+};
+
+JitCompiler::JitCompiler(Code *code)
+    : m_code(code), m_engine(code->astPool->engine()),
+      m_count(code->lastInstruction - code->firstInstruction),
+      m_entries(m_count, -1)
+{
+    Q_ASSERT(sizeof(QScriptValueImpl) == sizeof(quint64));
+    // the tagged values are above all the numbers, and the invalid value
+    // has the smallest tag
+    m_invalid = bitsOf(QScriptValueImpl());
+    m_false = bitsOf(QScriptValueImpl(false));
+    m_true = bitsOf(QScriptValueImpl(true));
+    Q_ASSERT(! (m_false & 1) && (m_true == m_false + 1));
+    m_nan = bitsOf(QScriptValueImpl(qQNaN()));
+}
+
+// how many instructions the template of the instruction covers, or 0 if
+// it has none
+int JitCompiler::width(const QScriptInstruction &instruction)
+{
+    switch (instruction.op) {
+    case QScriptInstruction::OP_FetchLocalField:
+    case QScriptInstruction::OP_IncrLocal:
+    case QScriptInstruction::OP_DecrLocal:
+        return 3;
+
+    case QScriptInstruction::OP_AddNumber:
+    case QScriptInstruction::OP_SubNumber:
+    case QScriptInstruction::OP_MulNumber:
+    case QScriptInstruction::OP_LessThanNumber:
+    case QScriptInstruction::OP_LessOrEqualNumber:
+    case QScriptInstruction::OP_GreatThanNumber:
+    case QScriptInstruction::OP_GreatOrEqualNumber:
+    case QScriptInstruction::OP_LessThanBranchFalse:
+    case QScriptInstruction::OP_LessOrEqualBranchFalse:
+    case QScriptInstruction::OP_GreatThanBranchFalse:
+    case QScriptInstruction::OP_GreatOrEqualBranchFalse:
+    case QScriptInstruction::OP_EqualBranchFalse:
+    case QScriptInstruction::OP_NotEqualBranchFalse:
+    case QScriptInstruction::OP_StrictEqualBranchFalse:
+    case QScriptInstruction::OP_StrictNotEqualBranchFalse:
+        return 2;
+
+    case QScriptInstruction::OP_Nop:
+    case QScriptInstruction::OP_LoadUndefined:
+    case QScriptInstruction::OP_LoadTrue:
+    case QScriptInstruction::OP_LoadFalse:
+    case QScriptInstruction::OP_LoadNull:
+    case QScriptInstruction::OP_LoadNumber:
+    case QScriptInstruction::OP_LoadString:
+    case QScriptInstruction::OP_LoadThis:
+    case QScriptInstruction::OP_LoadActivation:
+    case QScriptInstruction::OP_Duplicate:
+    case QScriptInstruction::OP_Swap:
+    case QScriptInstruction::OP_Pop:
+    case QScriptInstruction::OP_Add:
+    case QScriptInstruction::OP_Sub:
+    case QScriptInstruction::OP_Mul:
+    case QScriptInstruction::OP_Div:
+    case QScriptInstruction::OP_Mod:
+    case QScriptInstruction::OP_UnaryMinus:
+    case QScriptInstruction::OP_UnaryPlus:
+    case QScriptInstruction::OP_BitAnd:
+    case QScriptInstruction::OP_BitOr:
+    case QScriptInstruction::OP_BitXor:
+    case QScriptInstruction::OP_BitNot:
+    case QScriptInstruction::OP_LeftShift:
+    case QScriptInstruction::OP_RightShift:
+    case QScriptInstruction::OP_URightShift:
+    case QScriptInstruction::OP_LessThan:
+    case QScriptInstruction::OP_LessOrEqual:
+    case QScriptInstruction::OP_GreatThan:
+    case QScriptInstruction::OP_GreatOrEqual:
+    case QScriptInstruction::OP_Equal:
+    case QScriptInstruction::OP_NotEqual:
+    case QScriptInstruction::OP_StrictEqual:
+    case QScriptInstruction::OP_StrictNotEqual:
+    case QScriptInstruction::OP_Not:
+    case QScriptInstruction::OP_Branch:
+    case QScriptInstruction::OP_BranchTrue:
+    case QScriptInstruction::OP_BranchFalse:
+    case QScriptInstruction::OP_Line:
+    case QScriptInstruction::OP_Resolve:
+    case QScriptInstruction::OP_Fetch:
+    case QScriptInstruction::OP_FetchField:
+    case QScriptInstruction::OP_Assign:
+    case QScriptInstruction::OP_PutField:
+    case QScriptInstruction::OP_InplaceAdd:
+    case QScriptInstruction::OP_InplaceSub:
+    case QScriptInstruction::OP_InplaceMul:
+    case QScriptInstruction::OP_InplaceDiv:
+        return 1;
+
+    default:
+        break;
+    }
+    return 0;
+}
+
+void JitCompiler::jumpTo(int position, int target)
+{
+    Fixup fixup = { position, target, false };
+    m_fixups.append(fixup);
+}
+
+void JitCompiler::exitTo(int position, int index)
+{
+    Fixup fixup = { position, index, true };
+    m_fixups.append(fixup);
+}
+
+// CHECK_TEMPSTACK; the interpreter raises the error
+void JitCompiler::checkStack(int index, int count)
+{
+    m_asm.lea(Assembler::RAX, Assembler::RBX, count * sizeof(QScriptValueImpl));
+    m_asm.compare(Assembler::RAX, Assembler::R13);
+    exitTo(m_asm.jumpIf(Assembler::AboveOrEqual), index);
+}
+
+void JitCompiler::push(quint64 bits)
+{
+    m_asm.move(Assembler::RAX, bits);
+    m_asm.store(Assembler::RBX, sizeof(QScriptValueImpl), Assembler::RAX);
+    m_asm.add(Assembler::RBX, sizeof(QScriptValueImpl));
+}
+
+void JitCompiler::loadNumber(Assembler::Register r, Assembler::XmmRegister x, int disp, int index)
+{
+    m_asm.load(r, Assembler::RBX, disp);
+    m_asm.compare(r, Assembler::R14);
+    exitTo(m_asm.jumpIf(Assembler::AboveOrEqual), index);
+    m_asm.moveToXmm(x, r);
+}
+
+// the left operand into XMM0 and RAX, the right one into XMM1 and RCX
+void JitCompiler::loadNumbers(int index)
+{
+    loadNumber(Assembler::RAX, Assembler::XMM0, -int(sizeof(QScriptValueImpl)), index);
+    loadNumber(Assembler::RCX, Assembler::XMM1, 0, index);
+}
+
+// stores XMM0, with NaN in the form QScriptValueImpl gives it
+void JitCompiler::storeNumber(int disp)
+{
+    m_asm.moveFromXmm(Assembler::RAX, Assembler::XMM0);
+    m_asm.compareScalar(Assembler::XMM0, Assembler::XMM0);
+    const int ordered = m_asm.shortJumpIf(Assembler::NoParity);
+    m_asm.move(Assembler::RAX, m_nan);
+    m_asm.bindShort(ordered);
+    m_asm.store(Assembler::RBX, disp, Assembler::RAX);
+}
+
+// truncating gives the same low 32 bits as ToInt32 for anything but NaN,
+// the infinities and numbers beyond 2^63, which are left to the interpreter
+void JitCompiler::toInt32(Assembler::Register r, Assembler::XmmRegister x, int index)
+{
+    m_asm.truncate(r, x);
+    m_asm.move(Assembler::RDX, Q_UINT64_C(0x8000000000000000));
+    m_asm.compare(r, Assembler::RDX);
+    exitTo(m_asm.jumpIf(Assembler::Equal), index);
+}
+
+// XMM0 against XMM1, into RCX as 0 or 1; an unordered comparison is
+// only true for NotEqual
+void JitCompiler::compareNumbers(Comparison comparison)
+{
+    switch (comparison) {
+    case Less:
+        m_asm.compareScalar(Assembler::XMM1, Assembler::XMM0);
+        m_asm.set(Assembler::Above, Assembler::RCX);
+        break;
+    case LessOrEqual:
+        m_asm.compareScalar(Assembler::XMM1, Assembler::XMM0);
+        m_asm.set(Assembler::AboveOrEqual, Assembler::RCX);
+        break;
+    case Greater:
+        m_asm.compareScalar(Assembler::XMM0, Assembler::XMM1);
+        m_asm.set(Assembler::Above, Assembler::RCX);
+        break;
+    case GreaterOrEqual:
+        m_asm.compareScalar(Assembler::XMM0, Assembler::XMM1);
+        m_asm.set(Assembler::AboveOrEqual, Assembler::RCX);
+        break;
+    case Equal:
+        m_asm.compareScalar(Assembler::XMM0, Assembler::XMM1);
+        m_asm.set(Assembler::Equal, Assembler::RCX);
+        m_asm.set(Assembler::NoParity, Assembler::RAX);
+        m_asm.and8(Assembler::RCX, Assembler::RAX);
+        break;
+    case NotEqual:
+        m_asm.compareScalar(Assembler::XMM0, Assembler::XMM1);
+        m_asm.set(Assembler::NotEqual, Assembler::RCX);
+        m_asm.set(Assembler::Parity, Assembler::RAX);
+        m_asm.or8(Assembler::RCX, Assembler::RAX);
+        break;
+    }
+    m_asm.zeroExtend8(Assembler::RCX, Assembler::RCX);
+}
+
+// stores the result of compareNumbers() as a boolean
+void JitCompiler::storeBoolean(int disp)
+{
+    m_asm.move(Assembler::RAX, m_false);
+    m_asm.arithmetic(Assembler::Add, Assembler::RAX, Assembler::RCX, /*wide=*/true);
+    m_asm.store(Assembler::RBX, disp, Assembler::RAX);
+}
+
+void JitCompiler::callHelper(Helper helper, int index)
+{
+    m_asm.store(Assembler::R12, offsetof(QScriptContextPrivate, stackPtr), Assembler::RBX);
+    m_asm.move(Assembler::RDI, Assembler::R12);
+    m_asm.move(Assembler::RSI, quint64(m_code->firstInstruction + index));
+    m_asm.move(Assembler::RAX, quint64(helper));
+    m_asm.call(Assembler::RAX);
+    m_asm.load(Assembler::RBX, Assembler::R12, offsetof(QScriptContextPrivate, stackPtr));
+    m_asm.testByte();
+    exitTo(m_asm.jumpIf(Assembler::Equal), index);
+}
+
+static JitCompiler::Comparison comparisonOf(QScriptInstruction::Operator op)
+{
+    switch (op) {
+    case QScriptInstruction::OP_LessThan:
+    case QScriptInstruction::OP_LessThanNumber:
+    case QScriptInstruction::OP_LessThanBranchFalse:
+        return JitCompiler::Less;
+    case QScriptInstruction::OP_LessOrEqual:
+    case QScriptInstruction::OP_LessOrEqualNumber:
+    case QScriptInstruction::OP_LessOrEqualBranchFalse:
+        return JitCompiler::LessOrEqual;
+    case QScriptInstruction::OP_GreatThan:
+    case QScriptInstruction::OP_GreatThanNumber:
+    case QScriptInstruction::OP_GreatThanBranchFalse:
+        return JitCompiler::Greater;
+    case QScriptInstruction::OP_GreatOrEqual:
+    case QScriptInstruction::OP_GreatOrEqualNumber:
+    case QScriptInstruction::OP_GreatOrEqualBranchFalse:
+        return JitCompiler::GreaterOrEqual;
+    case QScriptInstruction::OP_NotEqual:
+    case QScriptInstruction::OP_StrictNotEqual:
+    case QScriptInstruction::OP_NotEqualBranchFalse:
+    case QScriptInstruction::OP_StrictNotEqualBranchFalse:
+        return JitCompiler::NotEqual;
+    default:
+        break;
+    }
+    return JitCompiler::Equal;
+}
+
+// emits the template of the instruction; returns false if the template
+// ends with its own jumps
+bool JitCompiler::compileInstruction(int index)
+{
+    typedef Assembler A;
+    const int D = sizeof(QScriptValueImpl);
+    const QScriptInstruction &i = m_code->firstInstruction[index];
+
+    switch (i.op) {
+    case QScriptInstruction::OP_Nop:
+        break;
+
+    case QScriptInstruction::OP_LoadUndefined:
+    case QScriptInstruction::OP_LoadNull:
+    case QScriptInstruction::OP_LoadTrue:
+    case QScriptInstruction::OP_LoadFalse:
+    case QScriptInstruction::OP_LoadNumber:
+    case QScriptInstruction::OP_LoadString: {
+        QScriptValueImpl value;
+        switch (i.op) {
+        case QScriptInstruction::OP_LoadUndefined: value = m_engine->undefinedValue(); break;
+        case QScriptInstruction::OP_LoadNull: value = m_engine->nullValue(); break;
+        case QScriptInstruction::OP_LoadTrue: value = QScriptValueImpl(true); break;
+        case QScriptInstruction::OP_LoadFalse: value = QScriptValueImpl(false); break;
+        default: value = i.operand[0]; break;
+        }
+        checkStack(index, 1);
+        push(bitsOf(value));
+    }   break;
+
+    case QScriptInstruction::OP_LoadThis:
+    case QScriptInstruction::OP_LoadActivation:
+        checkStack(index, 1);
+        m_asm.load(A::RAX, A::R12, i.op == QScriptInstruction::OP_LoadThis
+                   ? offsetof(QScriptContextPrivate, m_thisObject)
+                   : offsetof(QScriptContextPrivate, m_activation));
+        m_asm.store(A::RBX, D, A::RAX);
+        m_asm.add(A::RBX, D);
+        break;
+
+    case QScriptInstruction::OP_Duplicate:
+        checkStack(index, 1);
+        m_asm.load(A::RAX, A::RBX, 0);
+        m_asm.store(A::RBX, D, A::RAX);
+        m_asm.add(A::RBX, D);
+        break;
+
+    case QScriptInstruction::OP_Swap:
+        m_asm.load(A::RAX, A::RBX, -D);
+        m_asm.load(A::RCX, A::RBX, 0);
+        m_asm.store(A::RBX, -D, A::RCX);
+        m_asm.store(A::RBX, 0, A::RAX);
+        break;
+
+    case QScriptInstruction::OP_Pop:
+        m_asm.sub(A::RBX, D);
+        break;
+
+    case QScriptInstruction::OP_Add:
+    case QScriptInstruction::OP_Sub:
+    case QScriptInstruction::OP_Mul:
+    case QScriptInstruction::OP_Div: {
+        A::ScalarOperation op = A::AddScalar;
+        if (i.op == QScriptInstruction::OP_Sub)
+            op = A::SubScalar;
+        else if (i.op == QScriptInstruction::OP_Mul)
+            op = A::MulScalar;
+        else if (i.op == QScriptInstruction::OP_Div)
+            op = A::DivScalar;
+        loadNumbers(index);
+        m_asm.scalar(op, A::XMM0, A::XMM1);
+        m_asm.sub(A::RBX, D);
+        storeNumber(0);
+    }   break;
+
+    case QScriptInstruction::OP_AddNumber:
+    case QScriptInstruction::OP_SubNumber:
+    case QScriptInstruction::OP_MulNumber: {
+        A::ScalarOperation op = A::AddScalar;
+        if (i.op == QScriptInstruction::OP_SubNumber)
+            op = A::SubScalar;
+        else if (i.op == QScriptInstruction::OP_MulNumber)
+            op = A::MulScalar;
+        loadNumber(A::RAX, A::XMM0, 0, index);
+        m_asm.move(A::RCX, bitsOf(i.operand[0]));
+        m_asm.moveToXmm(A::XMM1, A::RCX);
+        m_asm.scalar(op, A::XMM0, A::XMM1);
+        storeNumber(0);
+    }   break;
+
+    case QScriptInstruction::OP_Mod: {
+        // only the remainder of two integers that fit in 32 bits, the left
+        // one positive (or +0) and the right one not 0
+        loadNumbers(index);
+        m_asm.test(A::RAX, A::RAX, /*wide=*/true);
+        exitTo(m_asm.jumpIf(A::Sign), index);
+        m_asm.test(A::RCX, A::RCX, /*wide=*/true);
+        exitTo(m_asm.jumpIf(A::Sign), index);
+        const A::Register integer[] = { A::RAX, A::RCX };
+        const A::XmmRegister number[] = { A::XMM0, A::XMM1 };
+        for (int n = 0; n < 2; ++n) {
+            m_asm.truncate(integer[n], number[n]);
+            m_asm.convert(A::XMM2, integer[n], /*wide=*/true);
+            m_asm.compareScalar(A::XMM2, number[n]);
+            exitTo(m_asm.jumpIf(A::NotEqual), index);
+            exitTo(m_asm.jumpIf(A::Parity), index);
+            m_asm.move(A::RDX, integer[n]);
+            m_asm.shiftRight(A::RDX, 32);
+            m_asm.test(A::RDX, A::RDX, /*wide=*/true);
+            exitTo(m_asm.jumpIf(A::NotEqual), index);
+        }
+        m_asm.test(A::RCX, A::RCX, /*wide=*/false);
+        exitTo(m_asm.jumpIf(A::Equal), index);
+        m_asm.arithmetic(A::Xor, A::RDX, A::RDX, /*wide=*/false);
+        m_asm.divide32(A::RCX);
+        m_asm.convert(A::XMM0, A::RDX, /*wide=*/true);
+        m_asm.sub(A::RBX, D);
+        storeNumber(0);
+    }   break;
+
+    case QScriptInstruction::OP_UnaryMinus:
+        loadNumber(A::RAX, A::XMM0, 0, index);
+        m_asm.complementBit(A::RAX, 63);
+        m_asm.moveToXmm(A::XMM0, A::RAX);
+        storeNumber(0);
+        break;
+
+    case QScriptInstruction::OP_UnaryPlus:
+        loadNumber(A::RAX, A::XMM0, 0, index);
+        break;
+
+    case QScriptInstruction::OP_BitAnd:
+    case QScriptInstruction::OP_BitOr:
+    case QScriptInstruction::OP_BitXor:
+    case QScriptInstruction::OP_LeftShift:
+    case QScriptInstruction::OP_RightShift:
+    case QScriptInstruction::OP_URightShift:
+        loadNumbers(index);
+        toInt32(A::RAX, A::XMM0, index);
+        toInt32(A::RCX, A::XMM1, index);
+        switch (i.op) {
+        case QScriptInstruction::OP_BitAnd: m_asm.arithmetic(A::And, A::RAX, A::RCX, false); break;
+        case QScriptInstruction::OP_BitOr: m_asm.arithmetic(A::Or, A::RAX, A::RCX, false); break;
+        case QScriptInstruction::OP_BitXor: m_asm.arithmetic(A::Xor, A::RAX, A::RCX, false); break;
+        case QScriptInstruction::OP_LeftShift: m_asm.shift32(A::ShiftLeft, A::RAX); break;
+        case QScriptInstruction::OP_RightShift: m_asm.shift32(A::ShiftRightArithmetic, A::RAX); break;
+        default: m_asm.shift32(A::ShiftRight, A::RAX); break;
+        }
+        // the 32-bit operations clear the upper half of RAX, so an
+        // unsigned result is converted from all 64 bits
+        m_asm.convert(A::XMM0, A::RAX, i.op == QScriptInstruction::OP_URightShift);
+        m_asm.sub(A::RBX, D);
+        storeNumber(0);
+        break;
+
+    case QScriptInstruction::OP_BitNot:
+        loadNumber(A::RAX, A::XMM0, 0, index);
+        toInt32(A::RAX, A::XMM0, index);
+        m_asm.not32(A::RAX);
+        m_asm.convert(A::XMM0, A::RAX, /*wide=*/false);
+        storeNumber(0);
+        break;
+
+    case QScriptInstruction::OP_LessThan:
+    case QScriptInstruction::OP_LessOrEqual:
+    case QScriptInstruction::OP_GreatThan:
+    case QScriptInstruction::OP_GreatOrEqual:
+    case QScriptInstruction::OP_Equal:
+    case QScriptInstruction::OP_NotEqual:
+    case QScriptInstruction::OP_StrictEqual:
+    case QScriptInstruction::OP_StrictNotEqual:
+        loadNumbers(index);
+        compareNumbers(comparisonOf(i.op));
+        m_asm.sub(A::RBX, D);
+        storeBoolean(0);
+        break;
+
+    case QScriptInstruction::OP_LessThanNumber:
+    case QScriptInstruction::OP_LessOrEqualNumber:
+    case QScriptInstruction::OP_GreatThanNumber:
+    case QScriptInstruction::OP_GreatOrEqualNumber:
+        loadNumber(A::RAX, A::XMM0, 0, index);
+        m_asm.move(A::RCX, bitsOf(i.operand[0]));
+        m_asm.moveToXmm(A::XMM1, A::RCX);
+        compareNumbers(comparisonOf(i.op));
+        storeBoolean(0);
+        break;
+
+    case QScriptInstruction::OP_LessThanBranchFalse:
+    case QScriptInstruction::OP_LessOrEqualBranchFalse:
+    case QScriptInstruction::OP_GreatThanBranchFalse:
+    case QScriptInstruction::OP_GreatOrEqualBranchFalse:
+    case QScriptInstruction::OP_EqualBranchFalse:
+    case QScriptInstruction::OP_NotEqualBranchFalse:
+    case QScriptInstruction::OP_StrictEqualBranchFalse:
+    case QScriptInstruction::OP_StrictNotEqualBranchFalse:
+        loadNumbers(index);
+        compareNumbers(comparisonOf(i.op));
+        m_asm.sub(A::RBX, 2 * D);
+        m_asm.test(A::RCX, A::RCX, /*wide=*/false);
+        jumpTo(m_asm.jumpIf(A::NotEqual), index + 2);
+        jumpTo(m_asm.jump(), index + 1 + m_code->firstInstruction[index + 1].operand[0].intValue());
+        return false;
+
+    case QScriptInstruction::OP_Not: {
+        // false and true only differ in the lowest bit
+        m_asm.load(A::RAX, A::RBX, 0);
+        m_asm.move(A::RCX, m_true);
+        m_asm.compare(A::RAX, A::RCX);
+        const int isBoolean = m_asm.shortJumpIf(A::Equal);
+        m_asm.move(A::RCX, m_false);
+        m_asm.compare(A::RAX, A::RCX);
+        exitTo(m_asm.jumpIf(A::NotEqual), index);
+        m_asm.bindShort(isBoolean);
+        m_asm.xor8(A::RAX, 1);
+        m_asm.store(A::RBX, 0, A::RAX);
+    }   break;
+
+    case QScriptInstruction::OP_BranchTrue:
+    case QScriptInstruction::OP_BranchFalse: {
+        const int taken = index + i.operand[0].intValue();
+        const bool onTrue = (i.op == QScriptInstruction::OP_BranchTrue);
+        m_asm.load(A::RAX, A::RBX, 0);
+        m_asm.move(A::RCX, m_true);
+        m_asm.compare(A::RAX, A::RCX);
+        const int isTrue = m_asm.shortJumpIf(A::Equal);
+        m_asm.move(A::RCX, m_false);
+        m_asm.compare(A::RAX, A::RCX);
+        exitTo(m_asm.jumpIf(A::NotEqual), index);
+        m_asm.sub(A::RBX, D);
+        jumpTo(m_asm.jump(), onTrue ? index + 1 : taken);
+        m_asm.bindShort(isTrue);
+        m_asm.sub(A::RBX, D);
+        jumpTo(m_asm.jump(), onTrue ? taken : index + 1);
+    }   return false;
+
+    case QScriptInstruction::OP_Branch:
+        callHelper(helperBranch, index);
+        jumpTo(m_asm.jump(), index + i.operand[0].intValue());
+        return false;
+
+    case QScriptInstruction::OP_Line:
+        callHelper(helperLine, index);
+        break;
+
+    case QScriptInstruction::OP_Resolve: {
+        QScriptValueImpl reference;
+        m_engine->newReference(&reference, QScriptValue::ResolveScope);
+        checkStack(index, 3);
+        m_asm.load(A::RAX, A::R12, offsetof(QScriptContextPrivate, m_scopeChain));
+        m_asm.store(A::RBX, D, A::RAX);
+        m_asm.move(A::RAX, bitsOf(i.operand[0]));
+        m_asm.store(A::RBX, 2 * D, A::RAX);
+        m_asm.move(A::RAX, bitsOf(reference));
+        m_asm.store(A::RBX, 3 * D, A::RAX);
+        m_asm.add(A::RBX, 3 * D);
+    }   break;
+
+    case QScriptInstruction::OP_Fetch: callHelper(helperFetch, index); break;
+    case QScriptInstruction::OP_FetchLocalField: callHelper(helperFetchLocalField, index); break;
+    case QScriptInstruction::OP_FetchField: callHelper(helperFetchField, index); break;
+    case QScriptInstruction::OP_Assign: callHelper(helperAssign, index); break;
+    case QScriptInstruction::OP_PutField: callHelper(helperPutField, index); break;
+    case QScriptInstruction::OP_IncrLocal: callHelper(helperIncrLocal, index); break;
+    case QScriptInstruction::OP_DecrLocal: callHelper(helperDecrLocal, index); break;
+    case QScriptInstruction::OP_InplaceAdd: callHelper(helperInplaceAdd, index); break;
+    case QScriptInstruction::OP_InplaceSub: callHelper(helperInplaceSub, index); break;
+    case QScriptInstruction::OP_InplaceMul: callHelper(helperInplaceMul, index); break;
+    case QScriptInstruction::OP_InplaceDiv: callHelper(helperInplaceDiv, index); break;
+
+    default:
+        Q_ASSERT(0);
+        break;
+    }
+    return true;
+}
+
+bool JitCompiler::compile()
+{
+    typedef Assembler A;
+    const int stackPtrOffset = offsetof(QScriptContextPrivate, stackPtr);
+
+    // entered with the context and the entry point of the first instruction
+    m_asm.push(A::RBP);
+    m_asm.move(A::RBP, A::RSP);
+    m_asm.push(A::RBX);
+    m_asm.push(A::R12);
+    m_asm.push(A::R13);
+    m_asm.push(A::R14);
+    m_asm.move(A::R12, A::RDI);
+    m_asm.load(A::RBX, A::R12, stackPtrOffset);
+    m_asm.move(A::R13, quint64(&m_engine->tempStackEnd));
+    m_asm.load(A::R13, A::R13, 0);
+    m_asm.move(A::R14, m_invalid);
+    m_asm.jump(A::RSI);
+
+    // left with the instruction the interpreter goes on from in RAX
+    const int commonExit = m_asm.offset();
+    m_asm.store(A::R12, stackPtrOffset, A::RBX);
+    m_asm.pop(A::R14);
+    m_asm.pop(A::R13);
+    m_asm.pop(A::R12);
+    m_asm.pop(A::RBX);
+    m_asm.pop(A::RBP);
+    m_asm.ret();
+
+    bool compiled = false;
+    for (int k = 0; k < m_count; ++k) {
+        const int w = width(m_code->firstInstruction[k]);
+        if (w == 0)
+            continue;
+        m_entries[k] = m_asm.offset();
+        compiled = true;
+        if (! compileInstruction(k))
+            continue;
+        const int next = k + w;
+        if ((w > 1) || (next >= m_count) || (width(m_code->firstInstruction[next]) == 0))
+            jumpTo(m_asm.jump(), next);
+    }
+    if (! compiled)
+        return false;
+
+    QVector<int> exits(m_count + 1, -1);
+    for (int f = 0; f < m_fixups.size(); ++f) {
+        const Fixup &fixup = m_fixups.at(f);
+        const int t = fixup.target;
+        Q_ASSERT(t >= 0 && t <= m_count);
+        if (! fixup.exit && (t < m_count) && (m_entries.at(t) != -1)) {
+            m_asm.bind(fixup.position, m_entries.at(t));
+            continue;
+        }
+        if (exits.at(t) == -1) {
+            exits[t] = m_asm.offset();
+            m_asm.move(A::RAX, quint64(m_code->firstInstruction + t));
+            m_asm.bind(m_asm.jump(), commonExit);
+        }
+        m_asm.bind(fixup.position, exits.at(t));
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+JitCode::JitCode(uchar *memory, int size, const QScriptInstruction *firstInstruction,
+                 const QVector<int> &entries)
+    : m_memory(memory), m_size(size), m_firstInstruction(firstInstruction), m_entries(entries)
+{
+}
+
+JitCode::~JitCode()
+{
+    ::munmap(m_memory, m_size);
+}
+
+JitCode *JitCode::compile(Code *code)
+{
+    JitCompiler compiler(code);
+    if (! compiler.compile())
+        return 0;
+
+    const QByteArray &bytes = compiler.code();
+    void *memory = ::mmap(0, bytes.size(), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (memory == MAP_FAILED)
+        return 0;
+    ::memcpy(memory, bytes.constData(), bytes.size());
+    if (::mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+        ::munmap(memory, bytes.size());
+        return 0;
+    }
+    return new JitCode(static_cast<uchar*>(memory), bytes.size(),
+                       code->firstInstruction, compiler.entries());
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // Q_SCRIPT_JIT
@@ -0,0 +1,146 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTJIT_P_H
+#define QSCRIPTJIT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+
+#include "qscriptvalueimplfwd_p.h"
+
+// The generated code follows the System V calling convention of x86-64,
+// works on NaN-boxed values and is entered from the direct-threaded
+// interpreter; anywhere else, Q_SCRIPT_JIT has no effect
+#if defined(Q_SCRIPT_JIT) && (!defined(Q_CC_GNU) || !defined(__x86_64__) || !defined(Q_OS_UNIX) \
+                              || !defined(Q_SCRIPT_DIRECT_CODE) || defined(Q_SCRIPT_NO_NAN_BOXING))
+#  undef Q_SCRIPT_JIT
+#endif
+
+#ifdef Q_SCRIPT_JIT
+
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QScriptInstruction;
+class QScriptContextPrivate;
+
+namespace QScript {
+
+class Code;
+
+//
+// Native x86-64 code for the instructions of a QScript::Code, generated
+// from one machine code template per instruction once the code is hot,
+// i.e. once it has been entered or has branched backwards
+// HotnessThreshold times.
+//
+// This is only compiled in when Q_SCRIPT_JIT is defined. The templates
+// handle the common case of an instruction inline (numbers, booleans,
+// pushing constants, branches) or through a helper that hits an inline
+// cache; whenever that isn't enough, and for the instructions without a
+// template, the native code returns the instruction to the interpreter,
+// which executes it and enters the native code again at the next
+// instruction that has one. Exceptions are only ever raised by the
+// interpreter, so a helper that would have to throw leaves the
+// instruction to it as well.
+//
+class JitCode
+{
+public:
+    enum { HotnessThreshold = 16 };
+
+    // returns 0 if none of the instructions has a template
+    static JitCode *compile(Code *code);
+    ~JitCode();
+
+    inline bool hasEntry(const QScriptInstruction *instruction) const;
+
+    // runs the native code from the given instruction, and returns the
+    // instruction the interpreter must execute next
+    inline const QScriptInstruction *run(QScriptContextPrivate *context,
+                                         const QScriptInstruction *instruction) const;
+
+private:
+    typedef const QScriptInstruction *(*Function)(QScriptContextPrivate *context,
+                                                  const uchar *entry);
+
+    JitCode(uchar *memory, int size, const QScriptInstruction *firstInstruction,
+            const QVector<int> &entries);
+
+    uchar *m_memory;
+    int m_size;
+    const QScriptInstruction *m_firstInstruction;
+    QVector<int> m_entries; // offset of the code of each instruction, or -1
+
+    Q_DISABLE_COPY(JitCode)
+};
+
+inline bool JitCode::hasEntry(const QScriptInstruction *instruction) const
+{
+    return m_entries.at(instruction - m_firstInstruction) != -1;
+}
+
+inline const QScriptInstruction *JitCode::run(QScriptContextPrivate *context,
+                                              const QScriptInstruction *instruction) const
+{
+    Q_ASSERT(hasEntry(instruction));
+    const Function function = reinterpret_cast<Function>(m_memory);
+    return function(context, m_memory + m_entries.at(instruction - m_firstInstruction));
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // Q_SCRIPT_JIT
+
+#endif // QSCRIPTJIT_P_H
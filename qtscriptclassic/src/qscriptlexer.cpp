@@ -58,6 +58,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#if !defined(Q_SCRIPT_NO_SIMD) \
+    && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define Q_SCRIPT_LEXER_SSE2
+#  include <emmintrin.h>
+#endif
+
 QT_BEGIN_NAMESPACE
 
 extern double qstrtod(const char *s00, char const **se, bool *ok);
@@ -75,6 +81,202 @@ namespace QScript {
 extern qsreal integerFromString(const char *buf, int size, int radix);
 }
 
+namespace {
+
+//
+// The scanners below return the length of the run of characters at the
+// start of s that the lexer consumes without changing its state, so
+// that identifiers, string literals, comments and blanks don't go
+// through the state machine one character at a time. Where SSE2 is
+// available they test eight characters at once.
+//
+
+#ifdef Q_SCRIPT_LEXER_SSE2
+static inline uint countTrailingZeros(uint mask)
+{
+#if defined(Q_CC_GNU)
+    return __builtin_ctz(mask);
+#else
+    uint count = 0;
+    while (! (mask & 1)) {
+        mask >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+static inline __m128i inRange(__m128i chars, ushort first, ushort last)
+{
+    return _mm_and_si128(_mm_cmpgt_epi16(chars, _mm_set1_epi16(first - 1)),
+                         _mm_cmplt_epi16(chars, _mm_set1_epi16(last + 1)));
+}
+#endif
+
+// [A-Za-z0-9$_]
+static uint identifierRun(const ushort *s, uint n)
+{
+    uint i = 0;
+#ifdef Q_SCRIPT_LEXER_SSE2
+    for (; i + 8 <= n; i += 8) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i lower = _mm_or_si128(chars, _mm_set1_epi16(0x20));
+        __m128i ok = _mm_or_si128(inRange(lower, 'a', 'z'), inRange(chars, '0', '9'));
+        ok = _mm_or_si128(ok, _mm_cmpeq_epi16(chars, _mm_set1_epi16('_')));
+        ok = _mm_or_si128(ok, _mm_cmpeq_epi16(chars, _mm_set1_epi16('$')));
+        const uint mask = _mm_movemask_epi8(ok);
+        if (mask != 0xffff)
+            return i + countTrailingZeros(~mask) / 2;
+    }
+#endif
+    for (; i < n; ++i) {
+        const ushort c = s[i];
+        if (! QScript::Lexer::isIdentLetter(c) && ! QScript::Lexer::isDecimalDigit(c))
+            break;
+    }
+    return i;
+}
+
+// anything but c1, c2, a line terminator or the end of the input
+static uint runUntil(const ushort *s, uint n, ushort c1, ushort c2)
+{
+    uint i = 0;
+#ifdef Q_SCRIPT_LEXER_SSE2
+    const __m128i v1 = _mm_set1_epi16(c1);
+    const __m128i v2 = _mm_set1_epi16(c2);
+    const __m128i lf = _mm_set1_epi16('\n');
+    const __m128i cr = _mm_set1_epi16('\r');
+    for (; i + 8 <= n; i += 8) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi16(chars, v1), _mm_cmpeq_epi16(chars, v2));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi16(chars, lf));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi16(chars, cr));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi16(chars, _mm_setzero_si128()));
+        const uint mask = _mm_movemask_epi8(stop);
+        if (mask != 0)
+            return i + countTrailingZeros(mask) / 2;
+    }
+#endif
+    for (; i < n; ++i) {
+        const ushort c = s[i];
+        if (c == c1 || c == c2 || c == '\n' || c == '\r' || c == 0)
+            break;
+    }
+    return i;
+}
+
+// spaces and tabs
+static uint blankRun(const ushort *s, uint n)
+{
+    uint i = 0;
+#ifdef Q_SCRIPT_LEXER_SSE2
+    for (; i + 8 <= n; i += 8) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i ok = _mm_or_si128(_mm_cmpeq_epi16(chars, _mm_set1_epi16(' ')),
+                                        _mm_cmpeq_epi16(chars, _mm_set1_epi16('\t')));
+        const uint mask = _mm_movemask_epi8(ok);
+        if (mask != 0xffff)
+            return i + countTrailingZeros(~mask) / 2;
+    }
+#endif
+    while (i < n && (s[i] == ' ' || s[i] == '\t'))
+        ++i;
+    return i;
+}
+
+//
+// The keywords and future reserved words, at the index given by a
+// perfect hash of their length and their first, second and last
+// characters: (length + v[c0] + v[c1] + v[cN]) % 64, with v taken from
+// keywordHashValues.
+//
+struct KeywordEntry
+{
+    const char *name;
+    int length;
+    int token;
+};
+
+static const uchar keywordHashValues[128] = {
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0, 28, 48,  9, 52, 46, 35,  0, 47, 43,  0, 58, 27, 58, 33, 57,
+    14,  0, 52, 59, 55, 16, 22, 42, 36, 32,  0,  0,  0,  0,  0,  0
+};
+
+static const KeywordEntry keywordTable[64] = {
+    { "typeof", 6, QScriptGrammar::T_TYPEOF },
+    { "static", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "byte", 4, QScriptGrammar::T_RESERVED_WORD },
+    { "interface", 9, QScriptGrammar::T_RESERVED_WORD },
+    { "super", 5, QScriptGrammar::T_RESERVED_WORD },
+    { "volatile", 8, QScriptGrammar::T_RESERVED_WORD },
+    { "int", 3, QScriptGrammar::T_RESERVED_WORD },
+    { "void", 4, QScriptGrammar::T_VOID },
+    { "with", 4, QScriptGrammar::T_WITH },
+    { "return", 6, QScriptGrammar::T_RETURN },
+    { 0, 0, -1 },
+    { "abstract", 8, QScriptGrammar::T_RESERVED_WORD },
+    { "while", 5, QScriptGrammar::T_WHILE },
+    { "enum", 4, QScriptGrammar::T_RESERVED_WORD },
+    { "try", 3, QScriptGrammar::T_TRY },
+    { "export", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "null", 4, QScriptGrammar::T_NULL },
+    { "boolean", 7, QScriptGrammar::T_RESERVED_WORD },
+    { 0, 0, -1 },
+    { "for", 3, QScriptGrammar::T_FOR },
+    { "extends", 7, QScriptGrammar::T_RESERVED_WORD },
+    { "throw", 5, QScriptGrammar::T_THROW },
+    { "delete", 6, QScriptGrammar::T_DELETE },
+    { "case", 4, QScriptGrammar::T_CASE },
+    { "long", 4, QScriptGrammar::T_RESERVED_WORD },
+    { "catch", 5, QScriptGrammar::T_CATCH },
+    { "switch", 6, QScriptGrammar::T_SWITCH },
+    { "synchronized", 12, QScriptGrammar::T_RESERVED_WORD },
+    { "function", 8, QScriptGrammar::T_FUNCTION },
+    { "true", 4, QScriptGrammar::T_TRUE },
+    { "debugger", 8, QScriptGrammar::T_DEBUGGER },
+    { "package", 7, QScriptGrammar::T_RESERVED_WORD },
+    { "default", 7, QScriptGrammar::T_DEFAULT },
+    { "double", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "import", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "break", 5, QScriptGrammar::T_BREAK },
+    { "class", 5, QScriptGrammar::T_RESERVED_WORD },
+    { "this", 4, QScriptGrammar::T_THIS },
+    { "short", 5, QScriptGrammar::T_RESERVED_WORD },
+    { "throws", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "do", 2, QScriptGrammar::T_DO },
+    { "var", 3, QScriptGrammar::T_VAR },
+    { "implements", 10, QScriptGrammar::T_RESERVED_WORD },
+    { "transient", 9, QScriptGrammar::T_RESERVED_WORD },
+    { 0, 0, -1 },
+    { "public", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "final", 5, QScriptGrammar::T_RESERVED_WORD },
+    { "in", 2, QScriptGrammar::T_IN },
+    { "char", 4, QScriptGrammar::T_RESERVED_WORD },
+    { "native", 6, QScriptGrammar::T_RESERVED_WORD },
+    { "false", 5, QScriptGrammar::T_FALSE },
+    { "if", 2, QScriptGrammar::T_IF },
+    { 0, 0, -1 },
+    { "finally", 7, QScriptGrammar::T_FINALLY },
+    { "goto", 4, QScriptGrammar::T_RESERVED_WORD },
+    { "private", 7, QScriptGrammar::T_RESERVED_WORD },
+    { "continue", 8, QScriptGrammar::T_CONTINUE },
+    { "instanceof", 10, QScriptGrammar::T_INSTANCEOF },
+    { "float", 5, QScriptGrammar::T_RESERVED_WORD },
+    { "else", 4, QScriptGrammar::T_ELSE },
+    { "new", 3, QScriptGrammar::T_NEW },
+    { 0, 0, -1 },
+    { "const", 5, QScriptGrammar::T_CONST },
+    { "protected", 9, QScriptGrammar::T_RESERVED_WORD }
+};
+
+} // anonymous namespace
+
 QScript::Lexer::Lexer(QScriptEnginePrivate *eng)
     : driver(eng),
       yylineno(0),
@@ -89,7 +291,7 @@ QScript::Lexer::Lexer(QScriptEnginePrivate *eng)
       pos(0),
       code(0), length(0),
       yycolumn(0),
-      startlineno(0), startcolumn(0),
+      startlineno(0), startcolumn(0), startoffset(0),
       bol(true),
       current(0), next1(0), next2(0), next3(0),
       err(NoError),
@@ -113,11 +315,11 @@ QScript::Lexer::~Lexer()
     delete [] buffer16;
 }
 
-void QScript::Lexer::setCode(const QString &c, int lineno)
+void QScript::Lexer::setCode(const QString &c, int lineno, int column)
 {
     errmsg = QString();
     yylineno = lineno;
-    yycolumn = 1;
+    yycolumn = column;
     restrKeyword = false;
     delimited = false;
     stackToken = -1;
@@ -135,14 +337,23 @@ void QScript::Lexer::setCode(const QString &c, int lineno)
 
 void QScript::Lexer::shift(uint p)
 {
-    while (p--) {
-        ++pos;
-        ++yycolumn;
-        current = next1;
-        next1 = next2;
-        next2 = next3;
-        next3 = (pos + 3 < length) ? code[pos+3].unicode() : 0;
-    }
+    pos += p;
+    yycolumn += p;
+    current = (pos < length) ? code[pos].unicode() : 0;
+    next1 = (pos + 1 < length) ? code[pos+1].unicode() : 0;
+    next2 = (pos + 2 < length) ? code[pos+2].unicode() : 0;
+    next3 = (pos + 3 < length) ? code[pos+3].unicode() : 0;
+}
+
+// the characters following the current one
+inline const ushort *QScript::Lexer::rest() const
+{
+    return reinterpret_cast<const ushort*>(code + pos + 1);
+}
+
+inline uint QScript::Lexer::restLength() const
+{
+    return (pos < length) ? length - pos - 1 : 0;
 }
 
 void QScript::Lexer::setDone(State s)
@@ -153,290 +364,28 @@ void QScript::Lexer::setDone(State s)
 
 int QScript::Lexer::findReservedWord(const QChar *c, int size) const
 {
-    switch (size) {
-    case 2: {
-        if (c[0] == QLatin1Char('d') && c[1] == QLatin1Char('o'))
-            return QScriptGrammar::T_DO;
-        else if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('f'))
-            return QScriptGrammar::T_IF;
-        else if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('n'))
-            return QScriptGrammar::T_IN;
-    }   break;
-
-    case 3: {
-        if (c[0] == QLatin1Char('f') && c[1] == QLatin1Char('o') && c[2] == QLatin1Char('r'))
-            return QScriptGrammar::T_FOR;
-        else if (c[0] == QLatin1Char('n') && c[1] == QLatin1Char('e') && c[2] == QLatin1Char('w'))
-            return QScriptGrammar::T_NEW;
-        else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('r') && c[2] == QLatin1Char('y'))
-            return QScriptGrammar::T_TRY;
-        else if (c[0] == QLatin1Char('v') && c[1] == QLatin1Char('a') && c[2] == QLatin1Char('r'))
-            return QScriptGrammar::T_VAR;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('n') && c[2] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 4: {
-        if (c[0] == QLatin1Char('c') && c[1] == QLatin1Char('a')
-                && c[2] == QLatin1Char('s') && c[3] == QLatin1Char('e'))
-            return QScriptGrammar::T_CASE;
-        else if (c[0] == QLatin1Char('e') && c[1] == QLatin1Char('l')
-                && c[2] == QLatin1Char('s') && c[3] == QLatin1Char('e'))
-            return QScriptGrammar::T_ELSE;
-        else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('h')
-                && c[2] == QLatin1Char('i') && c[3] == QLatin1Char('s'))
-            return QScriptGrammar::T_THIS;
-        else if (c[0] == QLatin1Char('v') && c[1] == QLatin1Char('o')
-                && c[2] == QLatin1Char('i') && c[3] == QLatin1Char('d'))
-            return QScriptGrammar::T_VOID;
-        else if (c[0] == QLatin1Char('w') && c[1] == QLatin1Char('i')
-                && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('h'))
-            return QScriptGrammar::T_WITH;
-        else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('r')
-                && c[2] == QLatin1Char('u') && c[3] == QLatin1Char('e'))
-            return QScriptGrammar::T_TRUE;
-        else if (c[0] == QLatin1Char('n') && c[1] == QLatin1Char('u')
-                && c[2] == QLatin1Char('l') && c[3] == QLatin1Char('l'))
-            return QScriptGrammar::T_NULL;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('e') && c[1] == QLatin1Char('n')
-                    && c[2] == QLatin1Char('u') && c[3] == QLatin1Char('m'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('b') && c[1] == QLatin1Char('y')
-                    && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('l') && c[1] == QLatin1Char('o')
-                    && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('g'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('c') && c[1] == QLatin1Char('h')
-                    && c[2] == QLatin1Char('a') && c[3] == QLatin1Char('r'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('g') && c[1] == QLatin1Char('o')
-                    && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('o'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 5: {
-        if (c[0] == QLatin1Char('b') && c[1] == QLatin1Char('r')
-                && c[2] == QLatin1Char('e') && c[3] == QLatin1Char('a')
-                && c[4] == QLatin1Char('k'))
-            return QScriptGrammar::T_BREAK;
-        else if (c[0] == QLatin1Char('c') && c[1] == QLatin1Char('a')
-                && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('c')
-                && c[4] == QLatin1Char('h'))
-            return QScriptGrammar::T_CATCH;
-        else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('h')
-                && c[2] == QLatin1Char('r') && c[3] == QLatin1Char('o')
-                && c[4] == QLatin1Char('w'))
-            return QScriptGrammar::T_THROW;
-        else if (c[0] == QLatin1Char('w') && c[1] == QLatin1Char('h')
-                && c[2] == QLatin1Char('i') && c[3] == QLatin1Char('l')
-                && c[4] == QLatin1Char('e'))
-            return QScriptGrammar::T_WHILE;
-        else if (c[0] == QLatin1Char('c') && c[1] == QLatin1Char('o')
-                && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('s')
-                && c[4] == QLatin1Char('t'))
-            return QScriptGrammar::T_CONST;
-        else if (c[0] == QLatin1Char('f') && c[1] == QLatin1Char('a')
-                && c[2] == QLatin1Char('l') && c[3] == QLatin1Char('s')
-                && c[4] == QLatin1Char('e'))
-            return QScriptGrammar::T_FALSE;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('s') && c[1] == QLatin1Char('h')
-                    && c[2] == QLatin1Char('o') && c[3] == QLatin1Char('r')
-                    && c[4] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('s') && c[1] == QLatin1Char('u')
-                    && c[2] == QLatin1Char('p') && c[3] == QLatin1Char('e')
-                    && c[4] == QLatin1Char('r'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('f') && c[1] == QLatin1Char('i')
-                    && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('a')
-                    && c[4] == QLatin1Char('l'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('c') && c[1] == QLatin1Char('l')
-                    && c[2] == QLatin1Char('a') && c[3] == QLatin1Char('s')
-                    && c[4] == QLatin1Char('s'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('f') && c[1] == QLatin1Char('l')
-                    && c[2] == QLatin1Char('o') && c[3] == QLatin1Char('a')
-                    && c[4] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 6: {
-        if (c[0] == QLatin1Char('d') && c[1] == QLatin1Char('e')
-                && c[2] == QLatin1Char('l') && c[3] == QLatin1Char('e')
-                && c[4] == QLatin1Char('t') && c[5] == QLatin1Char('e'))
-            return QScriptGrammar::T_DELETE;
-        else if (c[0] == QLatin1Char('r') && c[1] == QLatin1Char('e')
-                && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('u')
-                && c[4] == QLatin1Char('r') && c[5] == QLatin1Char('n'))
-            return QScriptGrammar::T_RETURN;
-        else if (c[0] == QLatin1Char('s') && c[1] == QLatin1Char('w')
-                && c[2] == QLatin1Char('i') && c[3] == QLatin1Char('t')
-                && c[4] == QLatin1Char('c') && c[5] == QLatin1Char('h'))
-            return QScriptGrammar::T_SWITCH;
-        else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('y')
-                && c[2] == QLatin1Char('p') && c[3] == QLatin1Char('e')
-                && c[4] == QLatin1Char('o') && c[5] == QLatin1Char('f'))
-            return QScriptGrammar::T_TYPEOF;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('e') && c[1] == QLatin1Char('x')
-                    && c[2] == QLatin1Char('p') && c[3] == QLatin1Char('o')
-                    && c[4] == QLatin1Char('r') && c[5] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('s') && c[1] == QLatin1Char('t')
-                    && c[2] == QLatin1Char('a') && c[3] == QLatin1Char('t')
-                    && c[4] == QLatin1Char('i') && c[5] == QLatin1Char('c'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('d') && c[1] == QLatin1Char('o')
-                    && c[2] == QLatin1Char('u') && c[3] == QLatin1Char('b')
-                    && c[4] == QLatin1Char('l') && c[5] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('m')
-                    && c[2] == QLatin1Char('p') && c[3] == QLatin1Char('o')
-                    && c[4] == QLatin1Char('r') && c[5] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('p') && c[1] == QLatin1Char('u')
-                    && c[2] == QLatin1Char('b') && c[3] == QLatin1Char('l')
-                    && c[4] == QLatin1Char('i') && c[5] == QLatin1Char('c'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('n') && c[1] == QLatin1Char('a')
-                    && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('i')
-                    && c[4] == QLatin1Char('v') && c[5] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('h')
-                    && c[2] == QLatin1Char('r') && c[3] == QLatin1Char('o')
-                    && c[4] == QLatin1Char('w') && c[5] == QLatin1Char('s'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 7: {
-        if (c[0] == QLatin1Char('d') && c[1] == QLatin1Char('e')
-                && c[2] == QLatin1Char('f') && c[3] == QLatin1Char('a')
-                && c[4] == QLatin1Char('u') && c[5] == QLatin1Char('l')
-                && c[6] == QLatin1Char('t'))
-            return QScriptGrammar::T_DEFAULT;
-        else if (c[0] == QLatin1Char('f') && c[1] == QLatin1Char('i')
-                && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('a')
-                && c[4] == QLatin1Char('l') && c[5] == QLatin1Char('l')
-                && c[6] == QLatin1Char('y'))
-            return QScriptGrammar::T_FINALLY;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('b') && c[1] == QLatin1Char('o')
-                    && c[2] == QLatin1Char('o') && c[3] == QLatin1Char('l')
-                    && c[4] == QLatin1Char('e') && c[5] == QLatin1Char('a')
-                    && c[6] == QLatin1Char('n'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('e') && c[1] == QLatin1Char('x')
-                    && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('e')
-                    && c[4] == QLatin1Char('n') && c[5] == QLatin1Char('d')
-                    && c[6] == QLatin1Char('s'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('p') && c[1] == QLatin1Char('a')
-                    && c[2] == QLatin1Char('c') && c[3] == QLatin1Char('k')
-                    && c[4] == QLatin1Char('a') && c[5] == QLatin1Char('g')
-                    && c[6] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('p') && c[1] == QLatin1Char('r')
-                    && c[2] == QLatin1Char('i') && c[3] == QLatin1Char('v')
-                    && c[4] == QLatin1Char('a') && c[5] == QLatin1Char('t')
-                    && c[6] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 8: {
-        if (c[0] == QLatin1Char('c') && c[1] == QLatin1Char('o')
-                && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('t')
-                && c[4] == QLatin1Char('i') && c[5] == QLatin1Char('n')
-                && c[6] == QLatin1Char('u') && c[7] == QLatin1Char('e'))
-            return QScriptGrammar::T_CONTINUE;
-        else if (c[0] == QLatin1Char('f') && c[1] == QLatin1Char('u')
-                && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('c')
-                && c[4] == QLatin1Char('t') && c[5] == QLatin1Char('i')
-                && c[6] == QLatin1Char('o') && c[7] == QLatin1Char('n'))
-            return QScriptGrammar::T_FUNCTION;
-        else if (c[0] == QLatin1Char('d') && c[1] == QLatin1Char('e')
-                && c[2] == QLatin1Char('b') && c[3] == QLatin1Char('u')
-                && c[4] == QLatin1Char('g') && c[5] == QLatin1Char('g')
-                && c[6] == QLatin1Char('e') && c[7] == QLatin1Char('r'))
-            return QScriptGrammar::T_DEBUGGER;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('a') && c[1] == QLatin1Char('b')
-                    && c[2] == QLatin1Char('s') && c[3] == QLatin1Char('t')
-                    && c[4] == QLatin1Char('r') && c[5] == QLatin1Char('a')
-                    && c[6] == QLatin1Char('c') && c[7] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('v') && c[1] == QLatin1Char('o')
-                    && c[2] == QLatin1Char('l') && c[3] == QLatin1Char('a')
-                    && c[4] == QLatin1Char('t') && c[5] == QLatin1Char('i')
-                    && c[6] == QLatin1Char('l') && c[7] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 9: {
-        if (check_reserved) {
-            if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('n')
-                    && c[2] == QLatin1Char('t') && c[3] == QLatin1Char('e')
-                    && c[4] == QLatin1Char('r') && c[5] == QLatin1Char('f')
-                    && c[6] == QLatin1Char('a') && c[7] == QLatin1Char('c')
-                    && c[8] == QLatin1Char('e'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('t') && c[1] == QLatin1Char('r')
-                    && c[2] == QLatin1Char('a') && c[3] == QLatin1Char('n')
-                    && c[4] == QLatin1Char('s') && c[5] == QLatin1Char('i')
-                    && c[6] == QLatin1Char('e') && c[7] == QLatin1Char('n')
-                    && c[8] == QLatin1Char('t'))
-                return QScriptGrammar::T_RESERVED_WORD;
-            else if (c[0] == QLatin1Char('p') && c[1] == QLatin1Char('r')
-                    && c[2] == QLatin1Char('o') && c[3] == QLatin1Char('t')
-                    && c[4] == QLatin1Char('e') && c[5] == QLatin1Char('c')
-                    && c[6] == QLatin1Char('t') && c[7] == QLatin1Char('e')
-                    && c[8] == QLatin1Char('d'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 10: {
-        if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('n')
-                && c[2] == QLatin1Char('s') && c[3] == QLatin1Char('t')
-                && c[4] == QLatin1Char('a') && c[5] == QLatin1Char('n')
-                && c[6] == QLatin1Char('c') && c[7] == QLatin1Char('e')
-                && c[8] == QLatin1Char('o') && c[9] == QLatin1Char('f'))
-            return QScriptGrammar::T_INSTANCEOF;
-        else if (check_reserved) {
-            if (c[0] == QLatin1Char('i') && c[1] == QLatin1Char('m')
-                    && c[2] == QLatin1Char('p') && c[3] == QLatin1Char('l')
-                    && c[4] == QLatin1Char('e') && c[5] == QLatin1Char('m')
-                    && c[6] == QLatin1Char('e') && c[7] == QLatin1Char('n')
-                    && c[8] == QLatin1Char('t') && c[9] == QLatin1Char('s'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
-
-    case 12: {
-        if (check_reserved) {
-            if (c[0] == QLatin1Char('s') && c[1] == QLatin1Char('y')
-                    && c[2] == QLatin1Char('n') && c[3] == QLatin1Char('c')
-                    && c[4] == QLatin1Char('h') && c[5] == QLatin1Char('r')
-                    && c[6] == QLatin1Char('o') && c[7] == QLatin1Char('n')
-                    && c[8] == QLatin1Char('i') && c[9] == QLatin1Char('z')
-                    && c[10] == QLatin1Char('e') && c[11] == QLatin1Char('d'))
-                return QScriptGrammar::T_RESERVED_WORD;
-        }
-    }   break;
+    if (size < 2 || size > 12)
+        return -1;
+
+    const ushort c0 = c[0].unicode();
+    const ushort c1 = c[1].unicode();
+    const ushort cN = c[size - 1].unicode();
+    if (c0 >= 128 || c1 >= 128 || cN >= 128)
+        return -1;
 
-    } // switch
+    const KeywordEntry &entry = keywordTable[(size + keywordHashValues[c0]
+                                              + keywordHashValues[c1]
+                                              + keywordHashValues[cN]) % 64];
+    if (entry.length != size)
+        return -1;
+    for (int i = 0; i < size; ++i) {
+        if (c[i].unicode() != ushort(entry.name[i]))
+            return -1;
+    }
 
-    return -1;
+    if (entry.token == QScriptGrammar::T_RESERVED_WORD && ! check_reserved)
+        return -1;
+    return entry.token;
 }
 
 int QScript::Lexer::lex()
@@ -460,7 +409,7 @@ int QScript::Lexer::lex()
         switch (state) {
         case Start:
             if (isWhiteSpace()) {
-                // do nothing
+                shift(blankRun(rest(), restLength()));
             } else if (current == '/' && next1 == '/') {
                 recordStartPos();
                 shift(1);
@@ -541,7 +490,9 @@ int QScript::Lexer::lex()
             } else if (current == '\\') {
                 state = InEscapeSequence;
             } else {
-                record16(current);
+                const uint n = runUntil(rest(), restLength(), stringType, '\\');
+                record16(code + pos, n + 1);
+                shift(n);
             }
             break;
             // Escape Sequences inside of strings
@@ -626,6 +577,8 @@ int QScript::Lexer::lex()
                     state = Start;
             } else if (current == 0) {
                 setDone(Eof);
+            } else {
+                shift(runUntil(rest(), restLength(), '\n', '\n'));
             }
             break;
         case InMultiLineComment:
@@ -639,11 +592,15 @@ int QScript::Lexer::lex()
             } else if (current == '*' && next1 == '/') {
                 state = Start;
                 shift(1);
+            } else {
+                shift(runUntil(rest(), restLength(), '*', '*'));
             }
             break;
         case InIdentifier:
             if (isIdentLetter(current) || isDecimalDigit(current)) {
-                record16(current);
+                const uint n = identifierRun(rest(), restLength());
+                record16(code + pos, n + 1);
+                shift(n);
                 break;
             }
             setDone(Identifier);
@@ -1051,10 +1008,29 @@ void QScript::Lexer::record16(QChar c)
     buffer16[pos16++] = c;
 }
 
+void QScript::Lexer::record16(const QChar *c, uint count)
+{
+    // enlarge buffer if full
+    if (pos16 + count >= size16) {
+        uint newSize = 2 * size16;
+        while (pos16 + count >= newSize)
+            newSize *= 2;
+        QChar *tmp = new QChar[newSize];
+        memcpy(tmp, buffer16, size16 * sizeof(QChar));
+        delete [] buffer16;
+        buffer16 = tmp;
+        size16 = newSize;
+    }
+
+    memcpy(buffer16 + pos16, c, count * sizeof(QChar));
+    pos16 += count;
+}
+
 void QScript::Lexer::recordStartPos()
 {
     startlineno = yylineno;
     startcolumn = yycolumn;
+    startoffset = pos;
 }
 
 bool QScript::Lexer::scanRegExp(RegExpBodyPrefix prefix)
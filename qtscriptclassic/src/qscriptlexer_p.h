@@ -69,7 +69,7 @@ public:
     Lexer(QScriptEnginePrivate *eng);
     ~Lexer();
 
-    void setCode(const QString &c, int lineno);
+    void setCode(const QString &c, int lineno, int column = 1);
     int lex();
 
     int currentLineNo() const { return yylineno; }
@@ -77,6 +77,7 @@ public:
 
     int startLineNo() const { return startlineno; }
     int startColumnNo() const { return startcolumn; }
+    int startOffset() const { return startoffset; }
 
     int endLineNo() const { return currentLineNo(); }
     int endColumnNo() const
@@ -168,6 +169,8 @@ private:
     void setDone(State s);
     uint pos;
     void shift(uint p);
+    inline const ushort *rest() const;
+    inline uint restLength() const;
     int lookupKeyword(const char *);
 
     bool isWhiteSpace() const;
@@ -198,6 +201,7 @@ public:
 private:
     void record8(ushort c);
     void record16(QChar c);
+    void record16(const QChar *c, uint count);
     void recordStartPos();
 
     int findReservedWord(const QChar *buffer, int size) const;
@@ -209,6 +213,7 @@ private:
     int yycolumn;
     int startlineno;
     int startcolumn;
+    int startoffset;
     int bol;     // begin of line
 
     union {
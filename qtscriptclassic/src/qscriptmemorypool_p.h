@@ -104,6 +104,41 @@ public:
         return p;
     }
 
+    // the allocation state, to which the pool can go back to free what
+    // was allocated afterwards; see rewind()
+    struct Mark {
+        int blockIndex;
+        int currentIndex;
+    };
+
+    Mark mark() const {
+        Mark m;
+        m.blockIndex = m_blockIndex;
+        m.currentIndex = m_currentIndex;
+        return m;
+    }
+
+    // frees everything allocated since \a m was taken; the memory is
+    // cleared, so that it can be handed out again like fresh blocks
+    void rewind(const Mark &m) {
+        Q_ASSERT(m.blockIndex <= m_blockIndex);
+        for (int index = m.blockIndex + 1; index < m_blockIndex + 1; ++index)
+            qFree(m_storage[index]);
+
+        if (m.blockIndex == maxBlockCount) {
+            m_currentBlock = 0;
+            m_currentBlockSize = 0;
+        } else {
+            const int end = (m.blockIndex == m_blockIndex)
+                            ? m_currentIndex : (defaultBlockSize << m.blockIndex);
+            m_currentBlock = m_storage[m.blockIndex];
+            m_currentBlockSize = defaultBlockSize << m.blockIndex;
+            ::memset(m_currentBlock + m.currentIndex, 0, end - m.currentIndex);
+        }
+        m_blockIndex = m.blockIndex;
+        m_currentIndex = m.currentIndex;
+    }
+
     int bytesAllocated() const {
         int bytes = 0;
         for (int index = 0; index < m_blockIndex; ++index)
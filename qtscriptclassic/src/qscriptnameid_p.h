@@ -54,22 +54,62 @@
 //
 
 #include <qglobal.h>
+#include <qshareddata.h>
+#include <qstring.h>
 
 QT_BEGIN_NAMESPACE
 
+namespace QScript {
+
+// the characters of a chain of concatenated strings; each string of
+// the chain is a prefix of data
+class StringBuffer: public QSharedData
+{
+public:
+    QString data;
+};
+
+} // namespace QScript
+
 class QScriptNameIdImpl
 {
 public:
     QString s;
-    uint h;
-    QScriptNameIdImpl *next;
+    uint h; // the hash of s, for unique strings
     uint used: 1;
     uint persistent: 1;
     uint unique: 1;
     uint pad: 29;
 
+    // set for the result of a concatenation, which is the first
+    // length characters of buffer->data; s is only valid after
+    // flatten()
+    QExplicitlySharedDataPointer<QScript::StringBuffer> buffer;
+    int length;
+
     inline QScriptNameIdImpl(const QString &_s):
-        s(_s), h(0), next(0), used(0), persistent(0), unique(0), pad(0) { }
+        s(_s), h(0), used(0), persistent(0), unique(0), pad(0), length(0) { }
+
+    inline const QString &string()
+    {
+        if (buffer)
+            flatten();
+        return s;
+    }
+
+    inline int size() const
+    {
+        return buffer ? length : s.length();
+    }
+
+    inline void flatten()
+    {
+        if (length == buffer->data.length())
+            s = buffer->data;
+        else
+            s = buffer->data.left(length);
+        buffer = QExplicitlySharedDataPointer<QScript::StringBuffer>();
+    }
 };
 
 QT_END_NAMESPACE
@@ -66,10 +66,12 @@ namespace QScript {
 
 namespace AST {
 class Node;
+class FunctionExpression;
 } // namespace AST
 
 class Code;
 class CompilationUnit;
+class CodeCacheFile;
 
 template <typename NodeType>
 inline NodeType *makeAstNode(MemoryPool *storage)
@@ -113,6 +115,33 @@ public:
     virtual ~NodePool();
 
     Code *createCompiledCode(AST::Node *node, CompilationUnit &compilation);
+    inline Code *compiledCode(AST::Node *node);
+
+    // source text of a function that was restored without a syntax tree
+    inline QString functionText(AST::Node *node);
+    inline void setFunctionText(AST::Node *node, const QString &text)
+    { m_functionText.insert(node, text); }
+
+    // functions whose body was only checked for syntax errors when the
+    // source was parsed; parsedFunction() parses them again from the
+    // source, on their first call
+    inline void setSource(const QString &source) { m_source = source; }
+    inline void setLazyFunction(AST::FunctionExpression *function, int offset, int length,
+                                int line, int column);
+    inline void removeLazyFunction(AST::FunctionExpression *function)
+    { m_lazyFunctions.remove(function); }
+    inline AST::FunctionExpression *parsedFunction(AST::FunctionExpression *function);
+
+    // the cache file the functions were restored from; the pool takes
+    // ownership of it
+    inline bool isRestored() const { return m_cacheFile != 0; }
+    inline CodeCacheFile *cacheFile() const { return m_cacheFile; }
+    void setCacheFile(CodeCacheFile *file);
+
+    // whether the code compiled in the pool keeps all its Line
+    // instructions; see QScript::Optimizer
+    inline bool keepsLines() const { return m_keepLines; }
+    inline void setKeepLines(bool keep) { m_keepLines = keep; }
 
     inline QString fileName() const { return m_fileName; }
     inline QScriptEnginePrivate *engine() const { return m_engine; }
@@ -121,7 +150,26 @@ public:
 #endif
 
 private:
+    Code *loadCompiledCode(AST::Node *node);
+    QString loadFunctionText(AST::Node *node);
+    AST::FunctionExpression *parseFunction(AST::FunctionExpression *function);
+
+private:
+    struct LazyFunction
+    {
+        int offset;
+        int length;
+        int line;
+        int column;
+        AST::FunctionExpression *parsed;
+    };
+
     QHash<AST::Node*, Code*> m_codeCache;
+    QHash<AST::Node*, QString> m_functionText;
+    QString m_source;
+    QHash<AST::FunctionExpression*, LazyFunction> m_lazyFunctions;
+    CodeCacheFile *m_cacheFile;
+    bool m_keepLines;
     QString m_fileName;
     QScriptEnginePrivate *m_engine;
 #ifndef Q_SCRIPT_NO_EVENT_NOTIFY
@@ -132,6 +180,43 @@ private:
     Q_DISABLE_COPY(NodePool)
 };
 
+inline Code *NodePool::compiledCode(AST::Node *node)
+{
+    Code *code = m_codeCache.value(node);
+    if (! code && m_cacheFile)
+        code = loadCompiledCode(node);
+    return code;
+}
+
+inline void NodePool::setLazyFunction(AST::FunctionExpression *function, int offset, int length,
+                                      int line, int column)
+{
+    LazyFunction f;
+    f.offset = offset;
+    f.length = length;
+    f.line = line;
+    f.column = column;
+    f.parsed = 0;
+    m_lazyFunctions.insert(function, f);
+}
+
+inline AST::FunctionExpression *NodePool::parsedFunction(AST::FunctionExpression *function)
+{
+    if (m_lazyFunctions.isEmpty())
+        return function;
+    return parseFunction(function);
+}
+
+inline QString NodePool::functionText(AST::Node *node)
+{
+    QHash<AST::Node*, QString>::const_iterator it = m_functionText.constFind(node);
+    if (it != m_functionText.constEnd())
+        return it.value();
+    if (m_cacheFile)
+        return loadFunctionText(node);
+    return QString();
+}
+
 } // namespace QScript
 
 QT_END_NAMESPACE
@@ -43,6 +43,8 @@
 #define QSCRIPTOBJECT_P_H
 
 #include "qscriptobjectfwd_p.h"
+#include "qscriptgc_p.h"
+#include "qscriptshape_p.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -61,32 +63,27 @@ QT_BEGIN_NAMESPACE
 inline bool QScriptObject::findMember(QScriptNameIdImpl *nameId,
                        QScript::Member *m) const
 {
-    const QScript::Member *members = m_members.constData();
-    const int size = m_members.size();
+    if (! m_shape)
+        return false;
 
-    const QScript::Member *first = &members[-1];
-    const QScript::Member *last = &members[size - 1];
+    const int index = m_shape->find(nameId);
+    if (index == -1)
+        return false;
 
-    for (const QScript::Member *it = last; it != first; --it) {
-        if (it->nameId() == nameId && it->isValid()) {
-            *m = *it;
-            return true;
-        }
-    }
-
-    return false;
+    *m = m_shape->at(index);
+    return true;
 }
 
 // assumes that m already points to the setter
 inline bool QScriptObject::findGetter(QScript::Member *m) const
 {
-    const QScript::Member *members = m_members.constData();
-    const QScript::Member *first = &members[-1];
-    const QScript::Member *last = &members[m->id() - 1];
+    const QScript::Shape *shape = m_shape;
+    Q_ASSERT(shape != 0);
 
-    for (const QScript::Member *it = last; it != first; --it) {
-        if (it->nameId() == m->nameId() && it->isValid() && it->isGetter()) {
-            *m = *it;
+    for (int i = m->id() - 1; i >= 0; --i) {
+        const QScript::Member &it = shape->at(i);
+        if (it.nameId() == m->nameId() && it.isValid() && it.isGetter()) {
+            *m = it;
             return true;
         }
     }
@@ -97,13 +94,13 @@ inline bool QScriptObject::findGetter(QScript::Member *m) const
 // assumes that m already points to the getter
 inline bool QScriptObject::findSetter(QScript::Member *m) const
 {
-    const QScript::Member *members = m_members.constData();
-    const QScript::Member *first = &members[-1];
-    const QScript::Member *last = &members[m->id() - 1];
+    const QScript::Shape *shape = m_shape;
+    Q_ASSERT(shape != 0);
 
-    for (const QScript::Member *it = last; it != first; --it) {
-        if (it->nameId() == m->nameId() && it->isValid() && it->isSetter()) {
-            *m = *it;
+    for (int i = m->id() - 1; i >= 0; --i) {
+        const QScript::Member &it = shape->at(i);
+        if (it.nameId() == m->nameId() && it.isValid() && it.isSetter()) {
+            *m = it;
             return true;
         }
     }
@@ -113,29 +110,78 @@ inline bool QScriptObject::findSetter(QScript::Member *m) const
 
 inline int QScriptObject::memberCount() const
 {
-    return m_members.size();
+    return m_shape ? m_shape->size() : 0;
 }
 
 inline void QScriptObject::createMember(QScriptNameIdImpl *nameId,
                          QScript::Member *member, uint flags)
 {
-    member->object(nameId, m_values.size(), flags);
-    m_members.append(*member);
+    aboutToChange();
+    QScript::Shape *shape = m_shape ? m_shape : m_class->rootShape();
+
+    if (shape->isDictionary()) {
+        shape->appendMember(nameId, flags);
+    } else if (shape->size() < QScript::Shape::MaxTransitionMembers) {
+        changeShape(shape->addTransition(nameId, flags));
+    } else {
+        shape = QScript::Shape::createDictionary(shape);
+        shape->appendMember(nameId, flags);
+        changeShape(shape);
+    }
+
+    *member = m_shape->at(m_shape->size() - 1);
+    m_values.append(QScriptValueImpl());
+}
+
+// adds the member that the given layout has in addition to the
+// current one, as recorded by a transition
+inline void QScriptObject::addMember(QScript::Shape *shape, QScript::Member *member)
+{
+    Q_ASSERT(shape->size() == memberCount() + 1);
+    aboutToChange();
+    changeShape(shape);
+    *member = shape->at(shape->size() - 1);
     m_values.append(QScriptValueImpl());
 }
 
 inline void QScriptObject::member(int index, QScript::Member *member)
 {
-    *member = m_members[index];
+    *member = m_shape->at(index);
 }
 
 inline void QScriptObject::put(const QScript::Member &m, const QScriptValueImpl &v)
 {
+    aboutToChange();
     m_values[m.id()] = v;
+    writeBarrier(v);
+}
+
+// must be called whenever a value is stored into a tenured object, so
+// that minor collections can find the young objects it refers to
+inline void QScriptObject::writeBarrier(const QScriptValueImpl &value)
+{
+    if (! value.isObject())
+        return;
+
+    const QScript::GCBlock *block = QScript::GCBlock::get(this);
+    if (block->tenured && ! block->remembered
+        && ! QScript::GCBlock::get(value.objectValue())->tenured) {
+        remember();
+    }
+}
+
+// must be called before an object of the engine's baseline is changed,
+// so that QScriptEnginePrivate::resetToBaseline() can undo the change
+inline void QScriptObject::aboutToChange()
+{
+    const QScript::GCBlock *block = QScript::GCBlock::get(this);
+    if (block->baseline && ! block->journaled)
+        saveBaseline();
 }
 
 inline QScriptValueImpl &QScriptObject::reference(const QScript::Member &m)
 {
+    aboutToChange();
     return m_values[m.id()];
 }
 
@@ -147,10 +193,50 @@ inline void QScriptObject::get(const QScript::Member &m, QScriptValueImpl *v)
 
 inline void QScriptObject::removeMember(const QScript::Member &member)
 {
-    m_members[member.id()].invalidate();
+    aboutToChange();
+    detachShape()->removeMember(member.id());
     m_values[member.id()].invalidate();
 }
 
+inline void QScriptObject::setMemberFlags(const QScript::Member &member, uint flags)
+{
+    Q_ASSERT(member.isObjectProperty());
+    if (m_shape->at(member.id()).flags() == flags)
+        return;
+    aboutToChange();
+    detachShape()->setMemberFlags(member.id(), flags);
+}
+
+inline QScript::Shape *QScriptObject::shape() const
+{
+    return m_shape;
+}
+
+// replaces the layout of this object; the caller is expected to
+// (re)initialize all the values
+inline void QScriptObject::setShape(QScript::Shape *shape)
+{
+    aboutToChange();
+    changeShape(shape);
+    m_values.resize(shape->size());
+}
+
+// makes sure the layout is owned by this object, so it can be modified
+inline QScript::Shape *QScriptObject::detachShape()
+{
+    if (! m_shape || ! m_shape->isDictionary())
+        changeShape(QScript::Shape::createDictionary(m_shape));
+    return m_shape;
+}
+
+inline void QScriptObject::changeShape(QScript::Shape *shape)
+{
+    shape->ref();
+    if (m_shape)
+        m_shape->deref();
+    m_shape = shape;
+}
+
 inline QScriptObject::~QScriptObject()
 {
     finalize();
@@ -159,6 +245,10 @@ inline QScriptObject::~QScriptObject()
 inline void QScriptObject::finalize()
 {
     finalizeData();
+    if (m_shape) {
+        m_shape->deref();
+        m_shape = 0;
+    }
 }
 
 inline void QScriptObject::finalizeData()
@@ -175,7 +265,7 @@ inline void QScriptObject::reset()
     m_prototype.invalidate();
     m_scope.invalidate();
     m_internalValue.invalidate();
-    m_members.resize(0);
+    m_shape = 0;
     m_values.resize(0);
     m_data = 0;
 }
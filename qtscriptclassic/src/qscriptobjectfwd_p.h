@@ -64,6 +64,10 @@ QT_BEGIN_NAMESPACE
 
 class QScriptObjectData;
 
+namespace QScript {
+    class Shape;
+}
+
 class QScriptObject
 {
 public:
@@ -84,6 +88,8 @@ public:
     inline void createMember(QScriptNameIdImpl *nameId,
                              QScript::Member *member, uint flags);
 
+    inline void addMember(QScript::Shape *shape, QScript::Member *member);
+
     inline void member(int index, QScript::Member *member);
 
     inline void put(const QScript::Member &m, const QScriptValueImpl &v);
@@ -94,11 +100,24 @@ public:
 
     inline void removeMember(const QScript::Member &member);
 
+    inline void setMemberFlags(const QScript::Member &member, uint flags);
+
+    inline QScript::Shape *shape() const;
+    inline void setShape(QScript::Shape *shape);
+    inline QScript::Shape *detachShape();
+    inline void changeShape(QScript::Shape *shape);
+
+    inline void writeBarrier(const QScriptValueImpl &value);
+    void remember();
+
+    inline void aboutToChange();
+    void saveBaseline();
+
     QScriptValueImpl m_prototype;
     QScriptValueImpl m_scope;
     QScriptValueImpl m_internalValue; // [[value]]
     QScriptObjectData *m_data;
-    QScript::Buffer<QScript::Member> m_members;
+    QScript::Shape *m_shape;
     QScript::Buffer<QScriptValueImpl> m_values;
     qint64 m_id;
     QScriptClassInfo *m_class;
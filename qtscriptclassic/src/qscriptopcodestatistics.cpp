@@ -0,0 +1,151 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptopcodestatistics_p.h"
+
+#ifdef Q_SCRIPT_OPCODE_STATISTICS
+
+#include <QList>
+#include <QPair>
+#include <QTextStream>
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+OpcodeStatistics::OpcodeStatistics()
+    : m_enabled(false), m_countCycles(false), m_previous(-1), m_lastCycles(0)
+{
+}
+
+// the counters are kept when the statistics are disabled, until reset()
+void OpcodeStatistics::setEnabled(bool enabled)
+{
+    if (enabled && m_counts.isEmpty()) {
+        m_counts.fill(0, OpcodeCount);
+        m_pairs.fill(0, OpcodeCount * OpcodeCount);
+        m_cycles.fill(0, OpcodeCount);
+    }
+    m_enabled = enabled;
+    m_previous = -1;
+}
+
+void OpcodeStatistics::setCycleCountingEnabled(bool enabled)
+{
+    m_countCycles = enabled && isCycleCountingSupported();
+    m_previous = -1;
+}
+
+bool OpcodeStatistics::isCycleCountingSupported()
+{
+#if defined(Q_CC_GNU) && (defined(__i386__) || defined(__x86_64__))
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OpcodeStatistics::reset()
+{
+    if (! m_counts.isEmpty()) {
+        m_counts.fill(0);
+        m_pairs.fill(0);
+        m_cycles.fill(0);
+    }
+    m_previous = -1;
+}
+
+static bool greaterCount(const QPair<quint64, int> &a, const QPair<quint64, int> &b)
+{
+    return a.first > b.first;
+}
+
+// a table of the instructions by execution count, followed by the most
+// frequent pairs
+QString OpcodeStatistics::report(int maximumPairs) const
+{
+    QString result;
+    if (m_counts.isEmpty())
+        return result;
+
+    QTextStream out(&result);
+
+    QList<QPair<quint64, int> > ops;
+    quint64 total = 0;
+    for (int i = 0; i < OpcodeCount; ++i) {
+        if (m_counts.at(i)) {
+            ops.append(qMakePair(m_counts.at(i), i));
+            total += m_counts.at(i);
+        }
+    }
+    qStableSort(ops.begin(), ops.end(), greaterCount);
+
+    out << "opcode\tcount\t%\tcycles\tcycles/op" << endl;
+    for (int i = 0; i < ops.size(); ++i) {
+        const int op = ops.at(i).second;
+        const quint64 n = ops.at(i).first;
+        out << QScriptInstruction::opcode[op] << '\t' << n << '\t'
+            << (100.0 * n / total) << '\t' << m_cycles.at(op) << '\t'
+            << (double(m_cycles.at(op)) / n) << endl;
+    }
+
+    QList<QPair<quint64, int> > pairs;
+    for (int i = 0; i < m_pairs.size(); ++i) {
+        if (m_pairs.at(i))
+            pairs.append(qMakePair(m_pairs.at(i), i));
+    }
+    qStableSort(pairs.begin(), pairs.end(), greaterCount);
+
+    out << endl << "first\tsecond\tcount" << endl;
+    for (int i = 0; i < qMin(pairs.size(), maximumPairs); ++i) {
+        const int index = pairs.at(i).second;
+        out << QScriptInstruction::opcode[index / OpcodeCount] << '\t'
+            << QScriptInstruction::opcode[index % OpcodeCount] << '\t'
+            << pairs.at(i).first << endl;
+    }
+
+    return result;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // Q_SCRIPT_OPCODE_STATISTICS
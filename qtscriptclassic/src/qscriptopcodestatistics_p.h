@@ -0,0 +1,151 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTOPCODESTATISTICS_P_H
+#define QSCRIPTOPCODESTATISTICS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+
+#ifdef Q_SCRIPT_OPCODE_STATISTICS
+
+#include <QString>
+#include <QVector>
+
+#include "qscriptasm_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+//
+// Counts how often the interpreter dispatches each instruction, and each
+// pair of consecutive instructions, and optionally how many cycles of
+// the processor's time stamp counter elapse until the next dispatch.
+//
+// This is only compiled in when Q_SCRIPT_OPCODE_STATISTICS is defined;
+// even then, the interpreter only records anything while the statistics
+// of its engine are enabled. The cycles include the time spent in the
+// functions an instruction calls, and the overhead of the recording
+// itself.
+//
+class OpcodeStatistics
+{
+public:
+    enum { OpcodeCount = QScriptInstruction::OP_Dummy };
+
+    OpcodeStatistics();
+
+    inline bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    inline bool isCycleCountingEnabled() const { return m_countCycles; }
+    void setCycleCountingEnabled(bool enabled);
+    static bool isCycleCountingSupported();
+
+    inline void record(int op);
+
+    inline quint64 count(int op) const
+    { return m_counts.isEmpty() ? 0 : m_counts.at(op); }
+    inline quint64 pairCount(int first, int second) const
+    { return m_pairs.isEmpty() ? 0 : m_pairs.at(first * OpcodeCount + second); }
+    inline quint64 cycles(int op) const
+    { return m_cycles.isEmpty() ? 0 : m_cycles.at(op); }
+
+    void reset();
+
+    QString report(int maximumPairs = 32) const;
+
+    static inline quint64 readCycleCounter();
+
+private:
+    bool m_enabled;
+    bool m_countCycles;
+    int m_previous;
+    quint64 m_lastCycles;
+    QVector<quint64> m_counts;
+    QVector<quint64> m_pairs;
+    QVector<quint64> m_cycles;
+};
+
+inline quint64 OpcodeStatistics::readCycleCounter()
+{
+#if defined(Q_CC_GNU) && (defined(__i386__) || defined(__x86_64__))
+    uint lo, hi;
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return (quint64(hi) << 32) | lo;
+#else
+    return 0;
+#endif
+}
+
+inline void OpcodeStatistics::record(int op)
+{
+    ++m_counts[op];
+    if (m_previous != -1)
+        ++m_pairs[m_previous * OpcodeCount + op];
+
+    if (m_countCycles) {
+        const quint64 now = readCycleCounter();
+        if (m_previous != -1)
+            m_cycles[m_previous] += now - m_lastCycles;
+        m_lastCycles = now;
+    }
+
+    m_previous = op;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // Q_SCRIPT_OPCODE_STATISTICS
+
+#endif // QSCRIPTOPCODESTATISTICS_P_H
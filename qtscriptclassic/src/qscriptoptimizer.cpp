@@ -0,0 +1,289 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qscriptoptimizer_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+static inline bool isBranch(QScriptInstruction::Operator op)
+{
+    return (op == QScriptInstruction::OP_Branch)
+        || (op == QScriptInstruction::OP_BranchTrue)
+        || (op == QScriptInstruction::OP_BranchFalse);
+}
+
+// marks the instructions where a try block or a handler begins, or
+// where a try block ends; no code may be moved across them
+static QVector<bool> regionBoundaries(int count, const QVector<ExceptionHandlerDescriptor> &handlers)
+{
+    QVector<bool> boundaries(count + 1, false);
+    for (int i = 0; i < handlers.size(); ++i) {
+        const ExceptionHandlerDescriptor &e = handlers.at(i);
+        boundaries[qBound(0, e.startInstruction(), count)] = true;
+        boundaries[qBound(0, e.endInstruction() + 1, count)] = true;
+        boundaries[qBound(0, e.handlerInstruction(), count)] = true;
+    }
+    return boundaries;
+}
+
+Optimizer::Optimizer(QScriptEnginePrivate *eng, bool keepLines):
+    m_eng(eng), m_keepLines(keepLines)
+{
+}
+
+void Optimizer::operator () (QVector<QScriptInstruction> *instructions,
+                             QVector<ExceptionHandlerDescriptor> *exceptionHandlers)
+{
+    removeRedundantInstructions(instructions, exceptionHandlers);
+    fuseInstructions(instructions, *exceptionHandlers);
+}
+
+//
+// Nops are always removed. Every Line is kept when an agent is
+// attached, since it reports every statement, and when the code is
+// shared or cached, since an agent may be attached before it runs
+// again; otherwise a Line is removed when it is directly followed by
+// another Line, or when it is in the same basic block as a previous Line
+// for the same line number. In both cases the Line that is kept runs
+// whenever the removed one would have, so the current line, garbage
+// collection and event processing are unaffected.
+//
+void Optimizer::removeRedundantInstructions(QVector<QScriptInstruction> *instructions,
+                                            QVector<ExceptionHandlerDescriptor> *exceptionHandlers)
+{
+    const int count = instructions->size();
+#ifndef Q_SCRIPT_NO_EVENT_NOTIFY
+    const bool keepLines = m_keepLines || m_eng->shouldNotify();
+#else
+    const bool keepLines = m_keepLines;
+#endif
+
+    QVector<bool> blockStarts = regionBoundaries(count, *exceptionHandlers);
+    for (int i = 0; i < count; ++i) {
+        const QScriptInstruction &ins = instructions->at(i);
+        if (isBranch(ins.op))
+            blockStarts[qBound(0, i + ins.operand[0].intValue(), count)] = true;
+    }
+
+    // newIndex[i] is the index of instruction i after the removal, or of
+    // the next instruction that is kept if i is removed
+    QVector<int> newIndex(count + 1);
+    QVector<bool> keep(count, true);
+    int kept = 0;
+    int lastLine = -1;
+    for (int i = 0; i < count; ++i) {
+        newIndex[i] = kept;
+        const QScriptInstruction &ins = instructions->at(i);
+
+        if (blockStarts.at(i))
+            lastLine = -1;
+
+        if (ins.op == QScriptInstruction::OP_Nop) {
+            keep[i] = false;
+        } else if ((ins.op == QScriptInstruction::OP_Line) && ! keepLines) {
+            const int line = ins.operand[0].intValue();
+            if ((i + 1 < count) && (instructions->at(i + 1).op == QScriptInstruction::OP_Line))
+                keep[i] = false;
+            else if (line == lastLine)
+                keep[i] = false;
+            else
+                lastLine = line;
+        }
+
+        if (keep.at(i))
+            ++kept;
+    }
+    newIndex[count] = kept;
+
+    if (kept == count)
+        return;
+
+    QVector<QScriptInstruction> result;
+    result.reserve(kept);
+    for (int i = 0; i < count; ++i) {
+        if (! keep.at(i))
+            continue;
+        QScriptInstruction ins = instructions->at(i);
+        if (isBranch(ins.op)) {
+            const int target = qBound(0, i + ins.operand[0].intValue(), count);
+            m_eng->newInteger(&ins.operand[0], newIndex.at(target) - newIndex.at(i));
+        }
+        result.append(ins);
+    }
+    *instructions = result;
+
+    for (int i = 0; i < exceptionHandlers->size(); ++i) {
+        const ExceptionHandlerDescriptor &e = exceptionHandlers->at(i);
+        const int start = qBound(0, e.startInstruction(), count);
+        const int end = qBound(0, e.endInstruction() + 1, count);
+        const int handler = qBound(0, e.handlerInstruction(), count);
+        (*exceptionHandlers)[i] = ExceptionHandlerDescriptor(
+            newIndex.at(start), newIndex.at(end) - 1, newIndex.at(handler));
+    }
+}
+
+//
+// The sequences are
+//   Fetch, LoadString, FetchField           -> FetchLocalField
+//   LoadNumber, <arithmetic or relational>  -> <op>Number
+//   <comparison>, BranchFalse               -> <op>BranchFalse
+//   Resolve, [Post]Incr, Pop                -> IncrLocal
+//   Resolve, [Post]Decr, Pop                -> DecrLocal
+// A sequence never spans the boundary of a try block, so that an
+// exception is always handled as it would be without the pass.
+//
+void Optimizer::fuseInstructions(QVector<QScriptInstruction> *instructions,
+                                 const QVector<ExceptionHandlerDescriptor> &exceptionHandlers)
+{
+    const int count = instructions->size();
+    const QVector<bool> boundaries = regionBoundaries(count, exceptionHandlers);
+
+    for (int i = 0; i < count; ++i) {
+        QScriptInstruction &ins = (*instructions)[i];
+
+        QScriptInstruction::Operator next = QScriptInstruction::OP_Dummy;
+        QScriptInstruction::Operator nextButOne = QScriptInstruction::OP_Dummy;
+        if ((i + 1 < count) && ! boundaries.at(i + 1)) {
+            next = instructions->at(i + 1).op;
+            if ((i + 2 < count) && ! boundaries.at(i + 2))
+                nextButOne = instructions->at(i + 2).op;
+        }
+
+        switch (ins.op) {
+        case QScriptInstruction::OP_Fetch:
+            if ((next == QScriptInstruction::OP_LoadString)
+                && (nextButOne == QScriptInstruction::OP_FetchField)) {
+                ins.op = QScriptInstruction::OP_FetchLocalField;
+            }
+            break;
+
+        case QScriptInstruction::OP_LoadNumber:
+            switch (next) {
+            case QScriptInstruction::OP_Add:
+                ins.op = QScriptInstruction::OP_AddNumber;
+                break;
+            case QScriptInstruction::OP_Sub:
+                ins.op = QScriptInstruction::OP_SubNumber;
+                break;
+            case QScriptInstruction::OP_Mul:
+                ins.op = QScriptInstruction::OP_MulNumber;
+                break;
+            case QScriptInstruction::OP_LessThan:
+                ins.op = QScriptInstruction::OP_LessThanNumber;
+                break;
+            case QScriptInstruction::OP_LessOrEqual:
+                ins.op = QScriptInstruction::OP_LessOrEqualNumber;
+                break;
+            case QScriptInstruction::OP_GreatThan:
+                ins.op = QScriptInstruction::OP_GreatThanNumber;
+                break;
+            case QScriptInstruction::OP_GreatOrEqual:
+                ins.op = QScriptInstruction::OP_GreatOrEqualNumber;
+                break;
+            default:
+                break;
+            }
+            break;
+
+        case QScriptInstruction::OP_LessThan:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_LessThanBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_LessOrEqual:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_LessOrEqualBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_GreatThan:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_GreatThanBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_GreatOrEqual:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_GreatOrEqualBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_Equal:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_EqualBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_NotEqual:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_NotEqualBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_StrictEqual:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_StrictEqualBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_StrictNotEqual:
+            if (next == QScriptInstruction::OP_BranchFalse)
+                ins.op = QScriptInstruction::OP_StrictNotEqualBranchFalse;
+            break;
+
+        case QScriptInstruction::OP_Resolve:
+            if (nextButOne != QScriptInstruction::OP_Pop)
+                break;
+            if ((next == QScriptInstruction::OP_Incr) || (next == QScriptInstruction::OP_PostIncr))
+                ins.op = QScriptInstruction::OP_IncrLocal;
+            else if ((next == QScriptInstruction::OP_Decr) || (next == QScriptInstruction::OP_PostDecr))
+                ins.op = QScriptInstruction::OP_DecrLocal;
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QSCRIPTOPTIMIZER_P_H
+#define QSCRIPTOPTIMIZER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+
+#include <qvector.h>
+
+#include "qscriptasm_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QScriptEnginePrivate;
+
+namespace QScript {
+
+//
+// Peephole pass over the instructions generated by the compiler. It
+// removes instructions that have no effect and replaces the first
+// instruction of frequent sequences by a superinstruction that executes
+// the whole sequence with a single dispatch. The instructions that
+// follow a superinstruction are left in place: the superinstruction
+// reads its operands from them, falls back to the original first
+// instruction when its fast path doesn't apply, and branches into the
+// sequence still work.
+//
+class Optimizer
+{
+public:
+    Optimizer(QScriptEnginePrivate *eng, bool keepLines = false);
+
+    void operator () (QVector<QScriptInstruction> *instructions,
+                      QVector<ExceptionHandlerDescriptor> *exceptionHandlers);
+
+private:
+    void removeRedundantInstructions(QVector<QScriptInstruction> *instructions,
+                                     QVector<ExceptionHandlerDescriptor> *exceptionHandlers);
+    void fuseInstructions(QVector<QScriptInstruction> *instructions,
+                          const QVector<ExceptionHandlerDescriptor> &exceptionHandlers);
+
+private:
+    QScriptEnginePrivate *m_eng;
+    bool m_keepLines;
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTOPTIMIZER_P_H
@@ -82,6 +82,7 @@
 ****************************************************************************/
 
 #include <QtDebug>
+#include <QVarLengthArray>
 
 
 #include <string.h>
@@ -129,7 +130,12 @@ QScriptParser::QScriptParser():
     state_stack(0),
     location_stack(0),
     error_lineno(0),
-    error_column(0)
+    error_column(0),
+    lazy_pool(0),
+    lazy_depth(0),
+    lazy_offset(0),
+    lazy_length(0),
+    shifted_offset(-1)
 {
 }
 
@@ -149,9 +155,81 @@ static inline QScriptParser::Location location(QScript::Lexer *lexer)
     loc.startColumn = lexer->startColumnNo();
     loc.endLine = lexer->endLineNo();
     loc.endColumn = lexer->endColumnNo();
+    loc.startOffset = lexer->startOffset();
     return loc;
 }
 
+// records the start of a function, so that the syntax tree of its body
+// can be dropped once it has been checked; a function that follows an
+// opening parenthesis is usually called right away, so it is kept
+void QScriptParser::beginFunction(QScriptEnginePrivate *driver, bool eager)
+{
+    Function f;
+    f.offset = shifted_offset;
+    f.line = location_stack [tos].startLine;
+    f.column = location_stack [tos].startColumn;
+    f.eager = eager;
+    f.mark = driver->nodePool()->mark();
+    f.lazyCount = lazy_functions.size();
+    function_stack.append(f);
+}
+
+// called when the last token shifted was a keyword that is used as a
+// property name, in case it was `function'
+void QScriptParser::discardFunction()
+{
+    if (! function_stack.isEmpty() && function_stack.last().offset == shifted_offset)
+        function_stack.removeLast();
+}
+
+// frees the syntax tree of a function that has been parsed, if its body
+// is to be parsed again on the first call; the formals are kept. The
+// last token shifted is the closing brace of the function
+bool QScriptParser::dropFunctionBody(QScriptEnginePrivate *driver,
+                                     QScript::AST::FormalParameterList **formals,
+                                     QScript::AST::FunctionBody **body)
+{
+    Q_ASSERT(! function_stack.isEmpty());
+    Function f = function_stack.last();
+    function_stack.removeLast();
+
+    if (! lazy_pool || f.eager || ! *body || (function_stack.size() + 1 <= lazy_depth))
+        return false;
+
+    lazy_function = f;
+    lazy_length = shifted_offset + 1 - f.offset;
+
+    QVarLengthArray<QScriptNameIdImpl*, 8> names;
+    for (QScript::AST::FormalParameterList *it = *formals; it != 0; it = it->next)
+        names.append(it->name);
+
+    // the functions nested in this one go away with its syntax tree
+    for (int i = f.lazyCount; i < lazy_functions.size(); ++i)
+        lazy_pool->removeLazyFunction(lazy_functions.at(i));
+    lazy_functions.resize(f.lazyCount);
+
+    QScript::MemoryPool *pool = driver->nodePool();
+    pool->rewind(f.mark);
+
+    QScript::AST::FormalParameterList *rebuilt = 0;
+    for (int i = 0; i < names.size(); ++i) {
+        if (! rebuilt)
+            rebuilt = QScript::makeAstNode<QScript::AST::FormalParameterList> (pool, names.at(i));
+        else
+            rebuilt = QScript::makeAstNode<QScript::AST::FormalParameterList> (pool, rebuilt, names.at(i));
+    }
+    *formals = rebuilt ? rebuilt->finish () : 0;
+    *body = QScript::makeAstNode<QScript::AST::FunctionBody> (pool, static_cast<QScript::AST::SourceElements*>(0));
+    return true;
+}
+
+void QScriptParser::finishFunction(QScript::AST::FunctionExpression *function)
+{
+    lazy_pool->setLazyFunction(function, lazy_offset + lazy_function.offset, lazy_length,
+                               lazy_function.line, lazy_function.column);
+    lazy_functions.append(function);
+}
+
 bool QScriptParser::parse(QScriptEnginePrivate *driver)
 {
   const int INITIAL_STATE = 0;
@@ -159,6 +237,7 @@ bool QScriptParser::parse(QScriptEnginePrivate *driver)
 
   int yytoken = -1;
   int saved_yytoken = -1;
+  int previous_yytoken = -1;
 
   reallocateStack();
 
@@ -195,6 +274,10 @@ bool QScriptParser::parse(QScriptEnginePrivate *driver)
           sym_stack [tos].dval = lexer->dval ();
           state_stack [tos] = act;
           location_stack [tos] = location(lexer);
+          shifted_offset = location_stack [tos].startOffset;
+          if (yytoken == T_FUNCTION)
+            beginFunction(driver, previous_yytoken == T_LPAREN);
+          previous_yytoken = yytoken;
           yytoken = -1;
         }
 
@@ -420,6 +503,7 @@ case 56:
 
 case 57:
 {
+  discardFunction();
   sym(1).sval = driver->intern(lexer->characterBuffer(), lexer->characterCount());
 } break;
 
@@ -1057,13 +1141,19 @@ case 249: {
 } break;
 
 case 250: {
+  bool lazy = dropFunctionBody(driver, &sym(4).FormalParameterList, &sym(7).FunctionBody);
   sym(1).Node = QScript::makeAstNode<QScript::AST::FunctionDeclaration> (driver->nodePool(), sym(2).sval, sym(4).FormalParameterList, sym(7).FunctionBody);
   Q_SCRIPT_UPDATE_POSITION(sym(1).Node, loc(1), loc(8));
+  if (lazy)
+    finishFunction(sym(1).FunctionDeclaration);
 } break;
 
 case 251: {
+  bool lazy = dropFunctionBody(driver, &sym(4).FormalParameterList, &sym(7).FunctionBody);
   sym(1).Node = QScript::makeAstNode<QScript::AST::FunctionExpression> (driver->nodePool(), sym(2).sval, sym(4).FormalParameterList, sym(7).FunctionBody);
   Q_SCRIPT_UPDATE_POSITION(sym(1).Node, loc(1), loc(8));
+  if (lazy)
+    finishFunction(static_cast<QScript::AST::FunctionExpression*>(sym(1).Node));
 } break;
 
 case 252: {
@@ -1136,6 +1226,9 @@ case 266: {
               location_stack[tos - 1].endLine = location_stack[tos + rhs[r] - 2].endLine;
               location_stack[tos - 1].endColumn = location_stack[tos + rhs[r] - 2].endColumn;
               location_stack[tos] = location_stack[tos + rhs[r] - 1];
+          } else if (rhs[r] == 0) {
+              // the empty symbol takes the slot of the lookahead token
+              location_stack[tos] = location_stack[tos - 1];
           }
         }
 
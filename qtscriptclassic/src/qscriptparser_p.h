@@ -64,6 +64,9 @@
 
 
 #include "qscriptastfwd_p.h"
+#include "qscriptmemorypool_p.h"
+
+#include <qvector.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -71,6 +74,10 @@ class QString;
 class QScriptEnginePrivate;
 class QScriptNameIdImpl;
 
+namespace QScript {
+    class NodePool;
+}
+
 class QScriptParser: protected QScriptGrammar
 {
 public:
@@ -107,6 +114,7 @@ public:
       int startColumn;
       int endLine;
       int endColumn;
+      int startOffset;
     };
 
 public:
@@ -115,6 +123,13 @@ public:
 
     bool parse(QScriptEnginePrivate *driver);
 
+    // makes the parser only check the bodies of functions nested more
+    // than \a depth levels deep for syntax errors, and record them in
+    // \a pool to be parsed again on their first call; \a offset is the
+    // position of the parsed text in the source of the pool
+    inline void setLazyFunctions(QScript::NodePool *pool, int depth, int offset)
+    { lazy_pool = pool; lazy_depth = depth; lazy_offset = offset; }
+
     inline QString errorMessage() const
     { return error_message; }
     inline int errorLineNumber() const
@@ -131,6 +146,13 @@ protected:
     inline Location &loc(int index)
     { return location_stack [tos + index - 2]; }
 
+    void beginFunction(QScriptEnginePrivate *driver, bool eager);
+    void discardFunction();
+    bool dropFunctionBody(QScriptEnginePrivate *driver,
+                          QScript::AST::FormalParameterList **formals,
+                          QScript::AST::FunctionBody **body);
+    void finishFunction(QScript::AST::FunctionExpression *function);
+
 protected:
     int tos;
     int stack_size;
@@ -140,6 +162,24 @@ protected:
     QString error_message;
     int error_lineno;
     int error_column;
+
+    // the functions being parsed, innermost last
+    struct Function {
+        int offset;
+        int line;
+        int column;
+        bool eager;
+        QScript::MemoryPool::Mark mark;
+        int lazyCount;
+    };
+    QVector<Function> function_stack;
+    QVector<QScript::AST::FunctionExpression*> lazy_functions;
+    QScript::NodePool *lazy_pool;
+    int lazy_depth;
+    int lazy_offset;
+    Function lazy_function;
+    int lazy_length;
+    int shifted_offset;
 };
 
 inline void QScriptParser::reallocateStack()
@@ -0,0 +1,207 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptprofiler_p.h"
+
+
+#include "qscriptengine_p.h"
+#include "qscriptvalueimpl_p.h"
+#include "qscriptcontext_p.h"
+#include "qscriptfunction_p.h"
+
+#include <QStringList>
+#ifndef QT_NO_THREAD
+# include <QThread>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+#ifndef QT_NO_THREAD
+
+class ProfilerThread: public QThread
+{
+public:
+    ProfilerThread(QAtomicInt *ticks, int interval)
+        : m_ticks(ticks), m_interval(interval), m_stop(0) { }
+
+    inline void requestStop()
+    { m_stop.fetchAndStoreOrdered(1); }
+
+protected:
+    virtual void run()
+    {
+        while (! m_stop) {
+            usleep(m_interval);
+            m_ticks->ref();
+        }
+    }
+
+private:
+    QAtomicInt *m_ticks;
+    int m_interval;
+    QAtomicInt m_stop;
+};
+
+#else
+
+class ProfilerThread
+{
+};
+
+#endif // QT_NO_THREAD
+
+Profiler::Profiler(QScriptEnginePrivate *engine)
+    : m_engine(engine), m_thread(0), m_interval(0),
+      m_granularity(FunctionGranularity), m_sampleCount(0)
+{
+}
+
+Profiler::~Profiler()
+{
+    stop();
+}
+
+void Profiler::start(int intervalMicroseconds)
+{
+    stop();
+    m_interval = qMax(intervalMicroseconds, 1);
+#ifndef QT_NO_THREAD
+    m_thread = new ProfilerThread(&m_engine->m_sampleTicks, m_interval);
+    m_thread->start(QThread::TimeCriticalPriority);
+#else
+    qWarning("QScript::Profiler: sampling requires thread support");
+#endif
+}
+
+void Profiler::stop()
+{
+    if (! m_thread)
+        return;
+#ifndef QT_NO_THREAD
+    m_thread->requestStop();
+    m_thread->wait();
+#endif
+    delete m_thread;
+    m_thread = 0;
+    // drop the ticks that weren't sampled yet
+    m_engine->m_sampleTicks.fetchAndStoreRelaxed(0);
+}
+
+bool Profiler::isActive() const
+{
+    return (m_thread != 0);
+}
+
+void Profiler::reset()
+{
+    m_stacks.clear();
+    m_sampleCount = 0;
+}
+
+QString Profiler::frameName(QScriptContextPrivate *context) const
+{
+    QString name = context->functionName();
+    QScriptFunction *fun = context->callee().isFunction() ? context->callee().toFunction() : 0;
+
+    if (name.isEmpty()) {
+        if (! context->parentContext())
+            name = QLatin1String("<global>");
+        else if (fun && (fun->type() != QScriptFunction::Script))
+            name = QLatin1String("<native>");
+        else
+            name = QLatin1String("<anonymous>");
+    }
+
+    if (! context->m_code)
+        return name;
+
+    int line = context->currentLine;
+    if ((m_granularity == FunctionGranularity) && fun && (fun->type() == QScriptFunction::Script))
+        line = fun->startLineNumber();
+    else if (m_granularity == FunctionGranularity)
+        line = -1;
+
+    QString fileName = context->fileName();
+    if (fileName.isEmpty() && (line == -1))
+        return name;
+
+    name += QLatin1String(" (");
+    name += fileName.isEmpty() ? QString::fromLatin1("<anonymous script>") : fileName;
+    if (line != -1) {
+        name += QLatin1Char(':');
+        name += QString::number(line);
+    }
+    name += QLatin1Char(')');
+    return name;
+}
+
+// records the stack of \a context, the innermost context
+void Profiler::sample(QScriptContextPrivate *context, int weight)
+{
+    QStringList frames;
+    for (QScriptContextPrivate *ctx = context; ctx != 0; ctx = ctx->parentContext()) {
+        QString name = frameName(ctx);
+        // ';' separates the frames in the collapsed format
+        name.replace(QLatin1Char(';'), QLatin1Char(','));
+        frames.prepend(name);
+    }
+
+    m_stacks[frames.join(QLatin1String(";"))] += weight;
+    m_sampleCount += weight;
+}
+
+QByteArray Profiler::collapsedStacks() const
+{
+    QByteArray result;
+    QHash<QString, int>::const_iterator it;
+    for (it = m_stacks.constBegin(); it != m_stacks.constEnd(); ++it) {
+        result += it.key().toUtf8();
+        result += ' ';
+        result += QByteArray::number(it.value());
+        result += '\n';
+    }
+    return result;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,132 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTPROFILER_P_H
+#define QSCRIPTPROFILER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+
+class QScriptEnginePrivate;
+class QScriptContextPrivate;
+
+namespace QScript {
+
+class ProfilerThread;
+
+//
+// A sampling profiler for the script code run by an engine.
+//
+// While the profiler is active, a thread wakes up at the configured
+// interval and bumps a tick counter of the engine. The interpreter looks
+// at the counter at the points where it already polls for events (each
+// Line and Branch instruction), and when it's set, records the stack of
+// the current context chain once, weighted by the number of ticks that
+// have elapsed. The cost for code that isn't being sampled is one load
+// per such instruction; unlike a QScriptEngineAgent, nothing is done on
+// every function entry and exit.
+//
+// Time spent in native code is attributed to the script position that
+// is reached next, which is normally in the function that called it.
+//
+// The samples are aggregated per distinct stack and can be exported in
+// the "collapsed stack" format (one "root;caller;callee count" line per
+// stack), which flame graph tools read directly.
+//
+class Profiler
+{
+public:
+    enum Granularity {
+        FunctionGranularity, // a frame is a function
+        LineGranularity      // a frame is a line of a function
+    };
+
+    Profiler(QScriptEnginePrivate *engine);
+    ~Profiler();
+
+    void start(int intervalMicroseconds = 1000);
+    void stop();
+    bool isActive() const;
+
+    inline int interval() const { return m_interval; }
+
+    inline Granularity granularity() const { return m_granularity; }
+    inline void setGranularity(Granularity granularity) { m_granularity = granularity; }
+
+    inline int sampleCount() const { return m_sampleCount; }
+    void reset();
+
+    void sample(QScriptContextPrivate *context, int weight);
+
+    QByteArray collapsedStacks() const;
+
+private:
+    QString frameName(QScriptContextPrivate *context) const;
+
+    QScriptEnginePrivate *m_engine;
+    ProfilerThread *m_thread;
+    int m_interval;
+    Granularity m_granularity;
+    int m_sampleCount;
+    QHash<QString, int> m_stacks;
+
+private:
+    Q_DISABLE_COPY(Profiler)
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTPROFILER_P_H
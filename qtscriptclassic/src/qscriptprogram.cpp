@@ -0,0 +1,320 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qscriptprogram.h"
+
+
+#include "qscriptprogram_p.h"
+#include "qscriptengine_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+  \class QScriptProgram
+
+  \brief The QScriptProgram class encapsulates a Qt Script program.
+
+  \ingroup script
+
+  QScriptProgram retains the compiled representation of the script if
+  possible. Thus, QScriptProgram can be used to evaluate the same script
+  multiple times more efficiently than passing the source code to
+  QScriptEngine::evaluate() each time.
+
+  \code
+  QScriptProgram program("1 + 2");
+  QScriptEngine engine;
+  for (int i = 0; i < 1000; ++i)
+      engine.evaluate(program);
+  \endcode
+
+  The program is compiled the first time it is evaluated by an engine;
+  later evaluations by the same engine only execute the compiled
+  code. The compiled code refers to strings that belong to the engine,
+  so every engine that evaluates the program compiles it once and keeps
+  its own copy. When the engine is destroyed, its compiled code is
+  discarded.
+
+  To keep the thread of an engine from blocking while a large script
+  is compiled, call compile() on another thread first, for example
+  with QtConcurrent::run(). An engine that evaluates the program
+  afterwards only has to load the result.
+
+  \sa QScriptEngine::evaluate()
+*/
+
+Q_GLOBAL_STATIC(QMutex, programEngineMutex)
+
+/*!
+  \internal
+*/
+QScriptProgramPrivate::QScriptProgramPrivate(const QString &src,
+                                             const QString &fn,
+                                             int ln)
+    : sourceCode(src), fileName(fn), firstLineNumber(ln)
+{
+    ref = 0;
+}
+
+/*!
+  \internal
+*/
+QScriptProgramPrivate::~QScriptProgramPrivate()
+{
+    releaseAll();
+}
+
+/*!
+  \internal
+*/
+QScriptProgramPrivate *QScriptProgramPrivate::get(const QScriptProgram &q)
+{
+    return const_cast<QScriptProgramPrivate*>(q.d_func());
+}
+
+/*!
+  \internal
+
+  Discards the code compiled for every engine. This may happen on a
+  thread other than the ones of the engines, so the code is handed back
+  to each engine, which frees it on its own thread.
+*/
+void QScriptProgramPrivate::releaseAll()
+{
+    QMutexLocker locker(engineMutex());
+    QHash<QScriptEnginePrivate*, Compiled>::const_iterator it;
+    for (it = compiled.constBegin(); it != compiled.constEnd(); ++it) {
+        QScriptEnginePrivate *eng = it.key();
+        eng->m_compiledPrograms.remove(this);
+        if (it.value().pool)
+            eng->m_releasedPools.append(it.value().pool);
+    }
+    compiled.clear();
+}
+
+/*!
+  \internal
+
+  Discards the code that programs have compiled for \a eng, which is
+  being destroyed. Called on the thread of \a eng.
+*/
+void QScriptProgramPrivate::releaseAll(QScriptEnginePrivate *eng)
+{
+    QList<QExplicitlySharedDataPointer<QScript::NodePool> > pools;
+    {
+        QMutexLocker locker(engineMutex());
+        QSet<QScriptProgramPrivate*>::const_iterator it;
+        for (it = eng->m_compiledPrograms.constBegin(); it != eng->m_compiledPrograms.constEnd(); ++it) {
+            QScriptProgramPrivate *program = *it;
+            pools.append(program->compiled.take(eng).pool);
+        }
+        eng->m_compiledPrograms.clear();
+        pools += eng->m_releasedPools;
+        eng->m_releasedPools.clear();
+    }
+    // the pools are freed here, outside the lock
+}
+
+/*!
+  \internal
+*/
+QMutex *QScriptProgramPrivate::engineMutex()
+{
+    return programEngineMutex();
+}
+
+/*!
+  Constructs a null QScriptProgram.
+*/
+QScriptProgram::QScriptProgram()
+    : d_ptr(0)
+{
+}
+
+/*!
+  Constructs a new QScriptProgram with the given \a sourceCode, \a
+  fileName and \a firstLineNumber.
+*/
+QScriptProgram::QScriptProgram(const QString &sourceCode,
+                               const QString &fileName,
+                               int firstLineNumber)
+    : d_ptr(new QScriptProgramPrivate(sourceCode, fileName, firstLineNumber))
+{
+    d_ptr->ref.ref();
+}
+
+/*!
+  Constructs a new QScriptProgram that is a copy of \a other.
+*/
+QScriptProgram::QScriptProgram(const QScriptProgram &other)
+    : d_ptr(other.d_ptr)
+{
+    if (d_ptr)
+        d_ptr->ref.ref();
+}
+
+/*!
+  Destroys this QScriptProgram.
+*/
+QScriptProgram::~QScriptProgram()
+{
+    if (d_ptr && !d_ptr->ref.deref()) {
+        delete d_ptr;
+        d_ptr = 0;
+    }
+}
+
+/*!
+  Assigns the \a other value to this QScriptProgram.
+*/
+QScriptProgram &QScriptProgram::operator=(const QScriptProgram &other)
+{
+    if (d_ptr == other.d_ptr)
+        return *this;
+    if (d_ptr && !d_ptr->ref.deref()) {
+        delete d_ptr;
+        d_ptr = 0;
+    }
+    d_ptr = other.d_ptr;
+    if (d_ptr)
+        d_ptr->ref.ref();
+    return *this;
+}
+
+/*!
+  Returns true if this QScriptProgram is null; otherwise
+  returns false.
+*/
+bool QScriptProgram::isNull() const
+{
+    Q_D(const QScriptProgram);
+    return (d == 0);
+}
+
+/*!
+  Returns the source code of this program.
+*/
+QString QScriptProgram::sourceCode() const
+{
+    Q_D(const QScriptProgram);
+    if (!d)
+        return QString();
+    return d->sourceCode;
+}
+
+/*!
+  Returns the filename associated with this program.
+*/
+QString QScriptProgram::fileName() const
+{
+    Q_D(const QScriptProgram);
+    if (!d)
+        return QString();
+    return d->fileName;
+}
+
+/*!
+  Returns the line number associated with this program.
+*/
+int QScriptProgram::firstLineNumber() const
+{
+    Q_D(const QScriptProgram);
+    if (!d)
+        return -1;
+    return d->firstLineNumber;
+}
+
+/*!
+  Compiles this program into a form that doesn't belong to any
+  engine, and returns true if successful; otherwise (e.g. if the
+  program has a syntax error) returns false.
+
+  Unlike the other functions of QScriptEngine and QScriptProgram, this
+  function can be called from any thread, also while an engine
+  evaluates the program. Later evaluations by any engine load the
+  compiled form instead of parsing the source code; the names used in
+  the program are only interned in the engine at that point.
+
+  \sa QScriptEngine::evaluate()
+*/
+bool QScriptProgram::compile()
+{
+    Q_D(QScriptProgram);
+    if (!d)
+        return false;
+    {
+        QMutexLocker locker(&d->mutex);
+        if (!d->precompiled.isEmpty())
+            return true;
+    }
+
+    const QByteArray data = QScriptEnginePrivate::precompile(
+        d->sourceCode, d->fileName, d->firstLineNumber);
+
+    QMutexLocker locker(&d->mutex);
+    d->precompiled = data;
+    return !data.isEmpty();
+}
+
+/*!
+  Returns true if this QScriptProgram is equal to \a other;
+  otherwise returns false.
+*/
+bool QScriptProgram::operator==(const QScriptProgram &other) const
+{
+    Q_D(const QScriptProgram);
+    if (d == other.d_func())
+        return true;
+    return (sourceCode() == other.sourceCode())
+        && (fileName() == other.fileName())
+        && (firstLineNumber() == other.firstLineNumber());
+}
+
+/*!
+  Returns true if this QScriptProgram is not equal to \a other;
+  otherwise returns false.
+*/
+bool QScriptProgram::operator!=(const QScriptProgram &other) const
+{
+    return !operator==(other);
+}
+
+QT_END_NAMESPACE
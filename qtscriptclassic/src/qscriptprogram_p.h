@@ -0,0 +1,119 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTPROGRAM_P_H
+#define QSCRIPTPROGRAM_P_H
+
+#include <qatomic.h>
+#include <qbytearray.h>
+#include <qhash.h>
+#include <qmutex.h>
+#include <qshareddata.h>
+#include <qstring.h>
+
+#include "qscriptnodepool_p.h"
+
+
+QT_BEGIN_NAMESPACE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+class QScriptEnginePrivate;
+class QScriptProgram;
+
+namespace QScript {
+    class Code;
+}
+
+class QScriptProgramPrivate
+{
+public:
+    QScriptProgramPrivate(const QString &sourceCode,
+                          const QString &fileName,
+                          int firstLineNumber);
+    ~QScriptProgramPrivate();
+
+    static QScriptProgramPrivate *get(const QScriptProgram &q);
+
+    void releaseAll();
+    static void releaseAll(QScriptEnginePrivate *engine);
+    static QMutex *engineMutex();
+
+    QBasicAtomicInt ref;
+    QString sourceCode;
+    QString fileName;
+    int firstLineNumber;
+
+    // the program compiled for one engine; code is 0 if the source has
+    // a syntax error
+    struct Compiled
+    {
+        Compiled() : code(0), errorLineNumber(-1) {}
+        QExplicitlySharedDataPointer<QScript::NodePool> pool;
+        QScript::Code *code;
+        QString errorMessage;
+        int errorLineNumber;
+    };
+
+    // the compiled form refers to strings of the engine, so every engine
+    // that evaluates the program keeps its own. The last reference to a
+    // program may be dropped on any thread, so this hash and the programs
+    // of every engine are guarded by engineMutex()
+    QHash<QScriptEnginePrivate*, Compiled> compiled;
+
+    // the code compiled by QScriptProgram::compile(), which doesn't
+    // belong to any engine; it may be set from another thread
+    QMutex mutex;
+    QByteArray precompiled;
+};
+
+QT_END_NAMESPACE
+
+
+#endif
@@ -0,0 +1,1513 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptregexpcompiler_p.h"
+
+#if !defined(Q_SCRIPT_NO_SIMD) \
+    && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#  define Q_SCRIPT_REGEXP_SSE2
+#  include <emmintrin.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+namespace {
+
+enum OpCode {
+    OpChar,             // arg0: character, canonicalized when ignoring case
+    OpAny,              // any character but a line terminator
+    OpClass,            // arg0: class
+    OpSplit,            // try arg0 first, then arg1
+    OpJump,             // arg0: target
+    OpSave,             // arg0: capture slot
+    OpResetCaptures,    // arg0, arg1: first and last group
+    OpAssertStart,
+    OpAssertEnd,
+    OpWordBoundary,
+    OpNotWordBoundary,
+    OpBackReference,    // arg0: group
+    OpLookahead,        // arg0: negated, arg1: target after the OpLookaheadEnd
+    OpLookaheadEnd,
+    OpRepeatStart,      // arg0: counter
+    OpRepeatGreedy,     // arg0: counter, arg1: min, arg2: max or -1, arg3: exit
+    OpRepeatLazy,
+    OpRepeatEnd,        // arg0: counter, arg1: position, arg2: min, arg3: target
+    OpMark,             // arg0: position
+    OpAtomGreedy,       // arg0: OpChar, OpAny or OpClass, arg1: its argument,
+    OpAtomLazy,         // arg2: min, arg3: max or -1
+    OpMatch
+};
+
+enum NodeType {
+    EmptyNode,
+    CharNode,           // value: character
+    AnyNode,
+    ClassNode,          // value: class
+    SequenceNode,
+    AlternativeNode,
+    GroupNode,          // value: group, or -1 if not capturing
+    LookaheadNode,      // value: negated
+    AssertionNode,      // value: OpAssertStart, OpAssertEnd or a boundary
+    BackReferenceNode,  // value: group
+    RepeatNode
+};
+
+enum {
+    MaxNestingDepth = 256,
+    MaxBacktrackEntries = 1 << 20
+};
+
+inline bool isLineTerminator(ushort ch)
+{
+    return (ch == 0x0a) || (ch == 0x0d) || (ch == 0x2028) || (ch == 0x2029);
+}
+
+inline bool isWordCharacter(ushort ch)
+{
+    return ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z'))
+        || ((ch >= '0') && (ch <= '9')) || (ch == '_');
+}
+
+// ECMA-262 15.10.2.8
+inline ushort canonicalize(ushort ch)
+{
+    if (ch < 0x80)
+        return ((ch >= 'a') && (ch <= 'z')) ? ushort(ch - 'a' + 'A') : ch;
+    uint u = QChar::toUpper(uint(ch));
+    if ((u > 0xffff) || (u < 0x80))
+        return ch;
+    return ushort(u);
+}
+
+inline int hexDigit(ushort ch)
+{
+    if ((ch >= '0') && (ch <= '9'))
+        return ch - '0';
+    if ((ch >= 'a') && (ch <= 'f'))
+        return ch - 'a' + 10;
+    if ((ch >= 'A') && (ch <= 'F'))
+        return ch - 'A' + 10;
+    return -1;
+}
+
+#ifdef Q_SCRIPT_REGEXP_SSE2
+inline uint countTrailingZeros(uint mask)
+{
+#if defined(Q_CC_GNU)
+    return __builtin_ctz(mask);
+#else
+    uint count = 0;
+    while (! (mask & 1)) {
+        mask >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+#endif
+
+const ushort digitRanges[] = { '0', '9' };
+const ushort wordRanges[] = { '0', '9', 'A', 'Z', '_', '_', 'a', 'z' };
+const ushort spaceRanges[] = {
+    0x09, 0x0d, 0x20, 0x20, 0xa0, 0xa0, 0x1680, 0x1680, 0x180e, 0x180e,
+    0x2000, 0x200a, 0x2028, 0x2029, 0x202f, 0x202f, 0x205f, 0x205f,
+    0x3000, 0x3000, 0xfeff, 0xfeff
+};
+
+inline bool rangesContain(const QVector<ushort> &ranges, ushort ch)
+{
+    for (int i = 0; i < ranges.size(); i += 2) {
+        if ((ch >= ranges.at(i)) && (ch <= ranges.at(i + 1)))
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool RegExpProgram::CharacterClass::contains(ushort ch) const
+{
+    if (ch < 0x100)
+        return (latin1[ch >> 5] & (1u << (ch & 31))) != 0;
+    bool found = rangesContain(ranges, ch);
+    if (! found && ignoreCase) {
+        found = rangesContain(ranges, ushort(QChar::toUpper(uint(ch))))
+                || rangesContain(ranges, ushort(QChar::toLower(uint(ch))));
+    }
+    return found != negated;
+}
+
+//
+// Parses a pattern into a tree of nodes, then generates the instructions
+// and works out the prefilter from the tree.
+//
+class RegExpCompiler
+{
+public:
+    RegExpCompiler(RegExpProgram *program);
+
+    bool compile();
+    inline QString errorMessage() const { return m_errorMessage; }
+
+private:
+    struct Node {
+        int type;
+        int value;
+        int min;
+        int max;
+        bool greedy;
+        int firstGroup;
+        int lastGroup;
+        QVector<int> children;
+    };
+
+    int newNode(int type, int value = 0);
+    bool error(const char *message);
+
+    inline bool atEnd() const { return m_pos == m_end; }
+    inline ushort peek(int offset = 0) const
+        { return (m_pos + offset < m_end) ? m_pattern[m_pos + offset] : 0; }
+
+    int countGroups() const;
+    int parseDisjunction(int depth);
+    int parseAlternative(int depth);
+    int parseTerm(int depth);
+    int parseAtomEscape();
+    int parseClass();
+    ushort parseCharacterEscape();
+    int parseOctalEscape();
+    bool parseQuantifier(int *min, int *max);
+    bool isQuantifierAhead();
+
+    void addRange(QVector<ushort> *ranges, ushort first, ushort last);
+    void addBuiltinClass(QVector<ushort> *ranges, ushort escape);
+    int newClass(const QVector<ushort> &ranges, bool negated);
+
+    int emit(int op, int arg0 = 0, int arg1 = 0, int arg2 = 0, int arg3 = 0);
+    void generate(int node);
+    bool isSingleCharacter(int node, int *op, int *arg) const;
+
+    bool addFirstCharacters(int node, bool *any);
+    void addFirstCharacter(ushort ch);
+    void computePrefilter(int root);
+
+private:
+    RegExpProgram *m_program;
+    const ushort *m_pattern;
+    int m_pos;
+    int m_end;
+    bool m_ignoreCase;
+    int m_groupCount;
+    int m_totalGroups;
+    QVector<Node> m_nodes;
+    QString m_errorMessage;
+};
+
+RegExpCompiler::RegExpCompiler(RegExpProgram *program)
+    : m_program(program), m_pattern(program->m_pattern.utf16()),
+      m_pos(0), m_end(program->m_pattern.length()),
+      m_ignoreCase((program->m_flags & RegExpProgram::IgnoreCase) != 0),
+      m_groupCount(0), m_totalGroups(0)
+{
+}
+
+bool RegExpCompiler::compile()
+{
+    m_totalGroups = countGroups();
+    int root = parseDisjunction(0);
+    if (root == -1)
+        return false;
+    if (! atEnd())
+        return error("unmatched ) in regular expression");
+
+    m_program->m_captureCount = m_groupCount;
+    m_program->m_registerCount = 2 * (m_groupCount + 1);
+    generate(root);
+    emit(OpMatch);
+    computePrefilter(root);
+    return true;
+}
+
+int RegExpCompiler::newNode(int type, int value)
+{
+    Node node;
+    node.type = type;
+    node.value = value;
+    node.min = 1;
+    node.max = 1;
+    node.greedy = true;
+    node.firstGroup = 0;
+    node.lastGroup = 0;
+    m_nodes.append(node);
+    return m_nodes.size() - 1;
+}
+
+bool RegExpCompiler::error(const char *message)
+{
+    if (m_errorMessage.isEmpty())
+        m_errorMessage = QString::fromLatin1(message);
+    return false;
+}
+
+// the number of capturing groups, which decides whether \N is a back
+// reference or an octal escape
+int RegExpCompiler::countGroups() const
+{
+    int count = 0;
+    bool inClass = false;
+    for (int i = 0; i < m_end; ++i) {
+        ushort ch = m_pattern[i];
+        if (ch == '\\')
+            ++i;
+        else if (ch == '[')
+            inClass = true;
+        else if (ch == ']')
+            inClass = false;
+        else if (! inClass && (ch == '(') && ((i + 1 == m_end) || (m_pattern[i + 1] != '?')))
+            ++count;
+    }
+    return count;
+}
+
+int RegExpCompiler::parseDisjunction(int depth)
+{
+    if (depth > MaxNestingDepth) {
+        error("regular expression too deeply nested");
+        return -1;
+    }
+    int first = parseAlternative(depth);
+    if ((first == -1) || (peek() != '|'))
+        return first;
+    int node = newNode(AlternativeNode);
+    m_nodes[node].children.append(first);
+    while (! atEnd() && (peek() == '|')) {
+        ++m_pos;
+        int alternative = parseAlternative(depth);
+        if (alternative == -1)
+            return -1;
+        m_nodes[node].children.append(alternative);
+    }
+    return node;
+}
+
+int RegExpCompiler::parseAlternative(int depth)
+{
+    int node = newNode(SequenceNode);
+    while (! atEnd() && (peek() != '|') && (peek() != ')')) {
+        int term = parseTerm(depth);
+        if (term == -1)
+            return -1;
+        m_nodes[node].children.append(term);
+    }
+    return node;
+}
+
+int RegExpCompiler::parseTerm(int depth)
+{
+    int atom = -1;
+    int groupsBefore = m_groupCount;
+    ushort ch = peek();
+    switch (ch) {
+    case '^':
+        ++m_pos;
+        atom = newNode(AssertionNode, OpAssertStart);
+        break;
+    case '$':
+        ++m_pos;
+        atom = newNode(AssertionNode, OpAssertEnd);
+        break;
+    case '.':
+        ++m_pos;
+        atom = newNode(AnyNode);
+        break;
+    case '(': {
+        ++m_pos;
+        int type = GroupNode;
+        int value = -1;
+        if (peek() == '?') {
+            ushort kind = peek(1);
+            if ((kind == '=') || (kind == '!')) {
+                type = LookaheadNode;
+                value = (kind == '!');
+            } else if (kind != ':') {
+                error("invalid group in regular expression");
+                return -1;
+            }
+            m_pos += 2;
+        } else {
+            value = ++m_groupCount;
+        }
+        int child = parseDisjunction(depth + 1);
+        if (child == -1)
+            return -1;
+        if (peek() != ')') {
+            error("missing ) in regular expression");
+            return -1;
+        }
+        ++m_pos;
+        atom = newNode(type, value);
+        m_nodes[atom].children.append(child);
+    }   break;
+    case '[':
+        ++m_pos;
+        atom = parseClass();
+        break;
+    case '\\':
+        ++m_pos;
+        if (atEnd()) {
+            error("\\ at end of regular expression");
+            return -1;
+        }
+        if ((peek() == 'b') || (peek() == 'B')) {
+            atom = newNode(AssertionNode, (peek() == 'b') ? OpWordBoundary : OpNotWordBoundary);
+            ++m_pos;
+        } else {
+            atom = parseAtomEscape();
+        }
+        break;
+    case '*':
+    case '+':
+    case '?':
+        error("nothing to repeat in regular expression");
+        return -1;
+    case '{':
+        if (isQuantifierAhead()) {
+            error("nothing to repeat in regular expression");
+            return -1;
+        }
+        ++m_pos;
+        atom = newNode(CharNode, m_ignoreCase ? canonicalize(ch) : ch);
+        break;
+    default:
+        ++m_pos;
+        atom = newNode(CharNode, m_ignoreCase ? canonicalize(ch) : ch);
+        break;
+    }
+    if (atom == -1)
+        return -1;
+
+    int min;
+    int max;
+    if (! parseQuantifier(&min, &max))
+        return m_errorMessage.isEmpty() ? atom : -1;
+    if (m_nodes.at(atom).type == AssertionNode) {
+        error("nothing to repeat in regular expression");
+        return -1;
+    }
+    int node = newNode(RepeatNode);
+    Node &repeat = m_nodes[node];
+    repeat.min = min;
+    repeat.max = max;
+    repeat.greedy = true;
+    repeat.firstGroup = groupsBefore + 1;
+    repeat.lastGroup = m_groupCount;
+    repeat.children.append(atom);
+    if (peek() == '?') {
+        ++m_pos;
+        m_nodes[node].greedy = false;
+    }
+    return node;
+}
+
+// true if the { at the current position starts a quantifier rather than
+// standing for itself
+bool RegExpCompiler::isQuantifierAhead()
+{
+    int pos = m_pos;
+    int min;
+    int max;
+    bool result = (peek() == '{') && parseQuantifier(&min, &max);
+    m_pos = pos;
+    return result;
+}
+
+bool RegExpCompiler::parseQuantifier(int *min, int *max)
+{
+    ushort ch = peek();
+    if (atEnd())
+        return false;
+    if (ch == '*') {
+        *min = 0;
+        *max = -1;
+    } else if (ch == '+') {
+        *min = 1;
+        *max = -1;
+    } else if (ch == '?') {
+        *min = 0;
+        *max = 1;
+    } else if (ch == '{') {
+        int pos = m_pos + 1;
+        qint64 values[2] = { -1, -1 };
+        bool comma = false;
+        for (int i = 0; i < 2; ++i) {
+            qint64 value = -1;
+            while ((pos < m_end) && (m_pattern[pos] >= '0') && (m_pattern[pos] <= '9')) {
+                value = qMax(value, qint64(0)) * 10 + (m_pattern[pos++] - '0');
+                value = qMin(value, qint64(INT_MAX));
+            }
+            values[i] = value;
+            if ((i == 0) && (pos < m_end) && (m_pattern[pos] == ',')) {
+                comma = true;
+                ++pos;
+            } else {
+                break;
+            }
+        }
+        // not a quantifier; the { stands for itself
+        if ((values[0] == -1) || (pos == m_end) || (m_pattern[pos] != '}'))
+            return false;
+        *min = int(values[0]);
+        *max = comma ? int(values[1]) : *min;
+        if ((*max != -1) && (*max < *min))
+            return error("numbers out of order in {} quantifier");
+        m_pos = pos;
+    } else {
+        return false;
+    }
+    ++m_pos;
+    return true;
+}
+
+int RegExpCompiler::parseAtomEscape()
+{
+    ushort ch = peek();
+    switch (ch) {
+    case 'd': case 'D':
+    case 'w': case 'W':
+    case 's': case 'S': {
+        ++m_pos;
+        QVector<ushort> ranges;
+        addBuiltinClass(&ranges, ch);
+        return newNode(ClassNode, newClass(ranges, /*negated=*/false));
+    }
+    case '0':
+        if ((peek(1) < '0') || (peek(1) > '9')) {
+            ++m_pos;
+            return newNode(CharNode, 0);
+        }
+        return newNode(CharNode, parseOctalEscape());
+    default:
+        break;
+    }
+    if ((ch >= '1') && (ch <= '9')) {
+        int pos = m_pos;
+        int group = 0;
+        while (! atEnd() && (peek() >= '0') && (peek() <= '9') && (group <= m_totalGroups))
+            group = group * 10 + (m_pattern[m_pos++] - '0');
+        if (group <= m_totalGroups)
+            return newNode(BackReferenceNode, group);
+        // not a back reference; an octal escape or the digit itself
+        m_pos = pos;
+        if (ch >= '8') {
+            ++m_pos;
+            return newNode(CharNode, ch);
+        }
+        int value = parseOctalEscape();
+        return newNode(CharNode, m_ignoreCase ? canonicalize(value) : value);
+    }
+    ushort value = parseCharacterEscape();
+    return newNode(CharNode, m_ignoreCase ? canonicalize(value) : value);
+}
+
+int RegExpCompiler::parseOctalEscape()
+{
+    int value = 0;
+    for (int i = 0; (i < 3) && (peek() >= '0') && (peek() <= '7'); ++i) {
+        int next = value * 8 + (peek() - '0');
+        if (next > 0377)
+            break;
+        value = next;
+        ++m_pos;
+    }
+    return value;
+}
+
+ushort RegExpCompiler::parseCharacterEscape()
+{
+    ushort ch = m_pattern[m_pos++];
+    switch (ch) {
+    case 'f': return 0x0c;
+    case 'n': return 0x0a;
+    case 'r': return 0x0d;
+    case 't': return 0x09;
+    case 'v': return 0x0b;
+    case 'c': {
+        ushort letter = peek();
+        if (((letter >= 'a') && (letter <= 'z')) || ((letter >= 'A') && (letter <= 'Z'))) {
+            ++m_pos;
+            return letter % 32;
+        }
+        // \c without a letter is a backslash and a c
+        --m_pos;
+        return '\\';
+    }
+    case 'x':
+    case 'u': {
+        int digits = (ch == 'x') ? 2 : 4;
+        int value = 0;
+        for (int i = 0; i < digits; ++i) {
+            int digit = hexDigit(peek(i));
+            if (digit == -1)
+                return ch;
+            value = value * 16 + digit;
+        }
+        m_pos += digits;
+        return ushort(value);
+    }
+    default:
+        break;
+    }
+    return ch;
+}
+
+int RegExpCompiler::parseClass()
+{
+    bool negated = false;
+    if (peek() == '^') {
+        negated = true;
+        ++m_pos;
+    }
+    QVector<ushort> ranges;
+    while (true) {
+        if (atEnd()) {
+            error("missing ] in regular expression");
+            return -1;
+        }
+        ushort ch = m_pattern[m_pos++];
+        if (ch == ']')
+            break;
+        bool builtin = false;
+        if (ch == '\\') {
+            if (atEnd())
+                continue;
+            ushort escape = peek();
+            if ((escape == 'd') || (escape == 'D') || (escape == 'w')
+                || (escape == 'W') || (escape == 's') || (escape == 'S')) {
+                ++m_pos;
+                addBuiltinClass(&ranges, escape);
+                builtin = true;
+            } else if (escape == 'b') {
+                ++m_pos;
+                ch = 0x08;
+            } else if ((escape >= '0') && (escape <= '7')) {
+                ch = ushort(parseOctalEscape());
+            } else if ((escape == '8') || (escape == '9')) {
+                ch = m_pattern[m_pos++];
+            } else {
+                ch = parseCharacterEscape();
+            }
+        }
+        if (builtin)
+            continue;
+        if ((peek() == '-') && (peek(1) != ']') && (m_pos + 1 < m_end)) {
+            int pos = m_pos;
+            ++m_pos;
+            ushort last = m_pattern[m_pos++];
+            if (last == '\\') {
+                ushort escape = peek();
+                if ((escape == 'd') || (escape == 'D') || (escape == 'w')
+                    || (escape == 'W') || (escape == 's') || (escape == 'S')) {
+                    // not a range; the - stands for itself
+                    m_pos = pos;
+                    addRange(&ranges, ch, ch);
+                    continue;
+                } else if (escape == 'b') {
+                    ++m_pos;
+                    last = 0x08;
+                } else if ((escape >= '0') && (escape <= '7')) {
+                    last = ushort(parseOctalEscape());
+                } else if (atEnd()) {
+                    last = '\\';
+                } else {
+                    last = parseCharacterEscape();
+                }
+            }
+            if (last < ch) {
+                error("range out of order in character class");
+                return -1;
+            }
+            addRange(&ranges, ch, last);
+            continue;
+        }
+        addRange(&ranges, ch, ch);
+    }
+    return newNode(ClassNode, newClass(ranges, negated));
+}
+
+void RegExpCompiler::addRange(QVector<ushort> *ranges, ushort first, ushort last)
+{
+    ranges->append(first);
+    ranges->append(last);
+}
+
+void RegExpCompiler::addBuiltinClass(QVector<ushort> *ranges, ushort escape)
+{
+    const ushort *table;
+    int count;
+    switch (escape) {
+    case 'd': case 'D':
+        table = digitRanges;
+        count = sizeof(digitRanges) / sizeof(ushort);
+        break;
+    case 'w': case 'W':
+        table = wordRanges;
+        count = sizeof(wordRanges) / sizeof(ushort);
+        break;
+    default:
+        table = spaceRanges;
+        count = sizeof(spaceRanges) / sizeof(ushort);
+        break;
+    }
+    if ((escape == 'd') || (escape == 'w') || (escape == 's')) {
+        for (int i = 0; i < count; ++i)
+            ranges->append(table[i]);
+        return;
+    }
+    // the tables are sorted, so the complement is the gaps between them
+    int next = 0;
+    for (int i = 0; i < count; i += 2) {
+        if (table[i] > next)
+            addRange(ranges, ushort(next), ushort(table[i] - 1));
+        next = table[i + 1] + 1;
+    }
+    if (next <= 0xffff)
+        addRange(ranges, ushort(next), 0xffff);
+}
+
+int RegExpCompiler::newClass(const QVector<ushort> &ranges, bool negated)
+{
+    RegExpProgram::CharacterClass klass;
+    klass.ranges = ranges;
+    klass.negated = negated;
+    klass.ignoreCase = m_ignoreCase;
+    for (int i = 0; i < 8; ++i)
+        klass.latin1[i] = 0;
+    for (uint ch = 0; ch < 0x100; ++ch) {
+        bool found = rangesContain(ranges, ushort(ch));
+        if (! found && m_ignoreCase) {
+            found = rangesContain(ranges, ushort(QChar::toUpper(ch)))
+                    || rangesContain(ranges, ushort(QChar::toLower(ch)));
+        }
+        if (found != negated)
+            klass.latin1[ch >> 5] |= 1u << (ch & 31);
+    }
+    m_program->m_classes.append(klass);
+    return m_program->m_classes.size() - 1;
+}
+
+int RegExpCompiler::emit(int op, int arg0, int arg1, int arg2, int arg3)
+{
+    RegExpProgram::Instruction i;
+    i.op = op;
+    i.arg0 = arg0;
+    i.arg1 = arg1;
+    i.arg2 = arg2;
+    i.arg3 = arg3;
+    m_program->m_code.append(i);
+    return m_program->m_code.size() - 1;
+}
+
+bool RegExpCompiler::isSingleCharacter(int node, int *op, int *arg) const
+{
+    const Node &n = m_nodes.at(node);
+    switch (n.type) {
+    case CharNode:
+        *op = OpChar;
+        break;
+    case AnyNode:
+        *op = OpAny;
+        break;
+    case ClassNode:
+        *op = OpClass;
+        break;
+    case GroupNode:
+        if (n.value == -1)
+            return isSingleCharacter(n.children.at(0), op, arg);
+        return false;
+    case SequenceNode:
+        if (n.children.size() == 1)
+            return isSingleCharacter(n.children.at(0), op, arg);
+        return false;
+    default:
+        return false;
+    }
+    *arg = n.value;
+    return true;
+}
+
+void RegExpCompiler::generate(int node)
+{
+    const Node n = m_nodes.at(node);
+    QVector<RegExpProgram::Instruction> &code = m_program->m_code;
+    switch (n.type) {
+    case EmptyNode:
+        break;
+    case CharNode:
+        emit(OpChar, n.value);
+        break;
+    case AnyNode:
+        emit(OpAny);
+        break;
+    case ClassNode:
+        emit(OpClass, n.value);
+        break;
+    case SequenceNode:
+        for (int i = 0; i < n.children.size(); ++i)
+            generate(n.children.at(i));
+        break;
+    case AlternativeNode: {
+        QVector<int> jumps;
+        for (int i = 0; i < n.children.size(); ++i) {
+            int split = -1;
+            if (i + 1 < n.children.size())
+                split = emit(OpSplit, code.size() + 1);
+            generate(n.children.at(i));
+            if (split != -1) {
+                jumps.append(emit(OpJump));
+                code[split].arg1 = code.size();
+            }
+        }
+        for (int i = 0; i < jumps.size(); ++i)
+            code[jumps.at(i)].arg0 = code.size();
+    }   break;
+    case GroupNode:
+        if (n.value != -1)
+            emit(OpSave, 2 * n.value);
+        generate(n.children.at(0));
+        if (n.value != -1)
+            emit(OpSave, 2 * n.value + 1);
+        break;
+    case LookaheadNode: {
+        int start = emit(OpLookahead, n.value);
+        generate(n.children.at(0));
+        emit(OpLookaheadEnd);
+        code[start].arg1 = code.size();
+    }   break;
+    case AssertionNode:
+        if ((n.value == OpAssertStart) || (n.value == OpAssertEnd)
+            || (n.value == OpWordBoundary) || (n.value == OpNotWordBoundary)) {
+            emit(n.value);
+        }
+        break;
+    case BackReferenceNode:
+        emit(OpBackReference, n.value);
+        break;
+    case RepeatNode: {
+        if (n.max == 0)
+            break;
+        int atomOp;
+        int atomArg;
+        if ((n.min == 1) && (n.max == 1)) {
+            generate(n.children.at(0));
+        } else if (isSingleCharacter(n.children.at(0), &atomOp, &atomArg)) {
+            emit(n.greedy ? OpAtomGreedy : OpAtomLazy, atomOp, atomArg, n.min, n.max);
+        } else {
+            int counter = m_program->m_registerCount++;
+            int position = m_program->m_registerCount++;
+            emit(OpRepeatStart, counter);
+            int repeat = emit(n.greedy ? OpRepeatGreedy : OpRepeatLazy,
+                              counter, n.min, n.max);
+            emit(OpMark, position);
+            if (n.lastGroup >= n.firstGroup)
+                emit(OpResetCaptures, n.firstGroup, n.lastGroup);
+            generate(n.children.at(0));
+            emit(OpRepeatEnd, counter, position, n.min, repeat);
+            code[repeat].arg3 = code.size();
+        }
+    }   break;
+    default:
+        Q_ASSERT(0);
+    }
+}
+
+void RegExpCompiler::addFirstCharacter(ushort ch)
+{
+    RegExpProgram *p = m_program;
+    if (! m_ignoreCase) {
+        if (ch < 0x100)
+            p->m_firstLatin1[ch >> 5] |= 1u << (ch & 31);
+        else
+            p->m_firstNonLatin1 = true;
+        return;
+    }
+    // ch is canonicalized already
+    for (uint c = 0; c < 0x100; ++c) {
+        if (canonicalize(ushort(c)) == ch)
+            p->m_firstLatin1[c >> 5] |= 1u << (c & 31);
+    }
+    if (ch >= 0x80)
+        p->m_firstNonLatin1 = true;
+}
+
+// adds the characters that a match of node can start with; returns
+// true if node can match the empty string
+bool RegExpCompiler::addFirstCharacters(int node, bool *any)
+{
+    const Node &n = m_nodes.at(node);
+    switch (n.type) {
+    case CharNode:
+        addFirstCharacter(ushort(n.value));
+        return false;
+    case AnyNode:
+        *any = true;
+        return false;
+    case ClassNode: {
+        const RegExpProgram::CharacterClass &klass = m_program->m_classes.at(n.value);
+        for (int i = 0; i < 8; ++i)
+            m_program->m_firstLatin1[i] |= klass.latin1[i];
+        if (klass.negated || klass.ignoreCase) {
+            m_program->m_firstNonLatin1 = true;
+        } else {
+            for (int i = 1; i < klass.ranges.size(); i += 2) {
+                if (klass.ranges.at(i) >= 0x100)
+                    m_program->m_firstNonLatin1 = true;
+            }
+        }
+    }   return false;
+    case SequenceNode:
+        for (int i = 0; i < n.children.size(); ++i) {
+            if (! addFirstCharacters(n.children.at(i), any))
+                return false;
+        }
+        return true;
+    case AlternativeNode: {
+        bool nullable = false;
+        for (int i = 0; i < n.children.size(); ++i) {
+            if (addFirstCharacters(n.children.at(i), any))
+                nullable = true;
+        }
+        return nullable;
+    }
+    case GroupNode:
+        return addFirstCharacters(n.children.at(0), any);
+    case BackReferenceNode:
+        *any = true;
+        return true;
+    case RepeatNode:
+        if (n.max == 0)
+            return true;
+        return addFirstCharacters(n.children.at(0), any) || (n.min == 0);
+    default:
+        // assertions and lookaheads do not consume anything
+        return true;
+    }
+}
+
+void RegExpCompiler::computePrefilter(int root)
+{
+    RegExpProgram *p = m_program;
+    const Node &top = m_nodes.at(root);
+    if ((top.type == SequenceNode) && ! top.children.isEmpty()) {
+        const Node &first = m_nodes.at(top.children.at(0));
+        if ((first.type == AssertionNode) && (first.value == OpAssertStart)
+            && ! (p->m_flags & RegExpProgram::Multiline)) {
+            p->m_anchored = true;
+            return;
+        }
+        if (! m_ignoreCase) {
+            for (int i = 0; i < top.children.size(); ++i) {
+                const Node &n = m_nodes.at(top.children.at(i));
+                if (n.type != CharNode)
+                    break;
+                p->m_prefix.append(QChar(ushort(n.value)));
+            }
+            if (! p->m_prefix.isEmpty())
+                return;
+        }
+    }
+
+    bool any = false;
+    bool nullable = addFirstCharacters(root, &any);
+    p->m_hasFirstCharacters = ! nullable && ! any;
+    if (! p->m_hasFirstCharacters || p->m_firstNonLatin1)
+        return;
+
+    int count = 0;
+    for (uint c = 0; c < 0x100; ++c) {
+        if (! (p->m_firstLatin1[c >> 5] & (1u << (c & 31))))
+            continue;
+        if (count == RegExpProgram::MaxFirstCharacters)
+            return;
+        p->m_firstCharacters[count++] = ushort(c);
+    }
+    p->m_firstCharacterCount = count;
+}
+
+//
+// Runs the instructions of a program at one position of the input.
+// Choices that may have to be undone are kept on a stack of entries, as
+// are the old values of the captures and registers that an instruction
+// changes, so that failing restores them.
+//
+class RegExpMatcher
+{
+public:
+    RegExpMatcher(const RegExpProgram *program, const ushort *input,
+                  int length, int *state);
+
+    bool matchAt(int start);
+    int runEnd(const RegExpProgram::Instruction &atom, int pos) const;
+    inline bool overflowed() const { return m_overflow; }
+
+private:
+    enum EntryKind {
+        BranchEntry,    // resume at pc and pos
+        RestoreEntry,   // set register pc back to value
+        GreedyEntry,    // give back a character; pos down to value
+        LazyEntry,      // take another character at pos; value left
+        LookaheadEntry  // start of the lookahead at pc
+    };
+
+    struct Entry {
+        int kind;
+        int pc;
+        int pos;
+        int value;
+    };
+
+    inline bool push(int kind, int pc, int pos, int value);
+    inline bool set(int reg, int value);
+    inline bool matchesAtom(int op, int arg, ushort ch) const;
+
+private:
+    const RegExpProgram *m_program;
+    const RegExpProgram::Instruction *m_code;
+    const ushort *m_input;
+    int m_length;
+    int *m_state;
+    bool m_ignoreCase;
+    bool m_multiline;
+    bool m_overflow;
+    QVector<Entry> m_stack;
+    int m_top;
+};
+
+RegExpMatcher::RegExpMatcher(const RegExpProgram *program, const ushort *input,
+                             int length, int *state)
+    : m_program(program), m_code(program->m_code.constData()),
+      m_input(input), m_length(length), m_state(state),
+      m_ignoreCase((program->m_flags & RegExpProgram::IgnoreCase) != 0),
+      m_multiline((program->m_flags & RegExpProgram::Multiline) != 0),
+      m_overflow(false), m_top(0)
+{
+    m_stack.resize(64);
+}
+
+inline bool RegExpMatcher::push(int kind, int pc, int pos, int value)
+{
+    if (m_top == m_stack.size()) {
+        if (m_top >= MaxBacktrackEntries) {
+            m_overflow = true;
+            return false;
+        }
+        m_stack.resize(m_top * 2);
+    }
+    Entry &e = m_stack[m_top++];
+    e.kind = kind;
+    e.pc = pc;
+    e.pos = pos;
+    e.value = value;
+    return true;
+}
+
+inline bool RegExpMatcher::set(int reg, int value)
+{
+    if (m_state[reg] == value)
+        return true;
+    if (! push(RestoreEntry, reg, 0, m_state[reg]))
+        return false;
+    m_state[reg] = value;
+    return true;
+}
+
+inline bool RegExpMatcher::matchesAtom(int op, int arg, ushort ch) const
+{
+    switch (op) {
+    case OpChar:
+        return (m_ignoreCase ? canonicalize(ch) : ch) == arg;
+    case OpAny:
+        return ! isLineTerminator(ch);
+    default:
+        return m_program->m_classes.at(arg).contains(ch);
+    }
+}
+
+// the end of the run of characters at pos that a greedy atom takes
+int RegExpMatcher::runEnd(const RegExpProgram::Instruction &atom, int pos) const
+{
+    int end = m_length;
+    if ((atom.arg3 != -1) && (atom.arg3 < end - pos))
+        end = pos + atom.arg3;
+    int i = pos;
+    if (atom.arg0 == OpAny) {
+        while ((i < end) && ! isLineTerminator(m_input[i]))
+            ++i;
+    } else {
+        while ((i < end) && matchesAtom(atom.arg0, atom.arg1, m_input[i]))
+            ++i;
+    }
+    return i;
+}
+
+bool RegExpMatcher::matchAt(int start)
+{
+    const ushort *input = m_input;
+    const int length = m_length;
+    int pc = 0;
+    int pos = start;
+    m_top = 0;
+
+    while (true) {
+        const RegExpProgram::Instruction &i = m_code[pc];
+        switch (i.op) {
+        case OpChar:
+            if ((pos < length) && ((m_ignoreCase ? canonicalize(input[pos]) : input[pos]) == i.arg0)) {
+                ++pos;
+                ++pc;
+                continue;
+            }
+            break;
+
+        case OpAny:
+            if ((pos < length) && ! isLineTerminator(input[pos])) {
+                ++pos;
+                ++pc;
+                continue;
+            }
+            break;
+
+        case OpClass:
+            if ((pos < length) && m_program->m_classes.at(i.arg0).contains(input[pos])) {
+                ++pos;
+                ++pc;
+                continue;
+            }
+            break;
+
+        case OpSplit:
+            if (! push(BranchEntry, i.arg1, pos, 0))
+                return false;
+            pc = i.arg0;
+            continue;
+
+        case OpJump:
+            pc = i.arg0;
+            continue;
+
+        case OpSave:
+            if (! set(i.arg0, pos))
+                return false;
+            ++pc;
+            continue;
+
+        case OpResetCaptures: {
+            bool ok = true;
+            for (int g = i.arg0; ok && (g <= i.arg1); ++g)
+                ok = set(2 * g, -1) && set(2 * g + 1, -1);
+            if (! ok)
+                return false;
+            ++pc;
+        }   continue;
+
+        case OpAssertStart:
+            if ((pos == 0) || (m_multiline && isLineTerminator(input[pos - 1]))) {
+                ++pc;
+                continue;
+            }
+            break;
+
+        case OpAssertEnd:
+            if ((pos == length) || (m_multiline && isLineTerminator(input[pos]))) {
+                ++pc;
+                continue;
+            }
+            break;
+
+        case OpWordBoundary:
+        case OpNotWordBoundary: {
+            bool before = (pos > 0) && isWordCharacter(input[pos - 1]);
+            bool after = (pos < length) && isWordCharacter(input[pos]);
+            if ((before != after) == (i.op == OpWordBoundary)) {
+                ++pc;
+                continue;
+            }
+        }   break;
+
+        case OpBackReference: {
+            int s = m_state[2 * i.arg0];
+            int e = m_state[2 * i.arg0 + 1];
+            if ((s == -1) || (e == -1)) {
+                ++pc;
+                continue;
+            }
+            int n = e - s;
+            if (pos + n > length)
+                break;
+            int k = 0;
+            if (m_ignoreCase) {
+                while ((k < n) && (canonicalize(input[s + k]) == canonicalize(input[pos + k])))
+                    ++k;
+            } else {
+                while ((k < n) && (input[s + k] == input[pos + k]))
+                    ++k;
+            }
+            if (k < n)
+                break;
+            pos += n;
+            ++pc;
+        }   continue;
+
+        case OpLookahead:
+            if (! push(LookaheadEntry, pc, pos, 0))
+                return false;
+            ++pc;
+            continue;
+
+        case OpLookaheadEnd: {
+            int k = m_top - 1;
+            while (m_stack.at(k).kind != LookaheadEntry)
+                --k;
+            const Entry lookahead = m_stack.at(k);
+            if (! m_code[lookahead.pc].arg0) {
+                // a lookahead is not backtracked into, but the captures
+                // it made are undone when backtracking past it
+                int w = k;
+                for (int j = k + 1; j < m_top; ++j) {
+                    if (m_stack.at(j).kind == RestoreEntry)
+                        m_stack[w++] = m_stack.at(j);
+                }
+                m_top = w;
+                pos = lookahead.pos;
+                ++pc;
+                continue;
+            }
+            // a negative lookahead that matched fails
+            while (m_top > k + 1) {
+                const Entry &e = m_stack.at(--m_top);
+                if (e.kind == RestoreEntry)
+                    m_state[e.pc] = e.value;
+            }
+            m_top = k;
+        }   break;
+
+        case OpRepeatStart:
+            if (! set(i.arg0, 0))
+                return false;
+            ++pc;
+            continue;
+
+        case OpRepeatGreedy:
+        case OpRepeatLazy: {
+            int count = m_state[i.arg0];
+            if (count < i.arg1) {
+                ++pc;
+            } else if ((i.arg2 != -1) && (count >= i.arg2)) {
+                pc = i.arg3;
+            } else if (i.op == OpRepeatGreedy) {
+                if (! push(BranchEntry, i.arg3, pos, 0))
+                    return false;
+                ++pc;
+            } else {
+                if (! push(BranchEntry, pc + 1, pos, 0))
+                    return false;
+                pc = i.arg3;
+            }
+        }   continue;
+
+        case OpMark:
+            if (! set(i.arg0, pos))
+                return false;
+            ++pc;
+            continue;
+
+        case OpRepeatEnd: {
+            int count = m_state[i.arg0];
+            // an iteration that matches the empty string is only allowed
+            // to make up the minimum
+            if ((pos == m_state[i.arg1]) && (count >= i.arg2))
+                break;
+            if (! set(i.arg0, count + 1))
+                return false;
+            pc = i.arg3;
+        }   continue;
+
+        case OpAtomGreedy: {
+            int count = runEnd(i, pos) - pos;
+            if (count < i.arg2)
+                break;
+            if ((count > i.arg2) && ! push(GreedyEntry, pc + 1, pos + count, pos + i.arg2))
+                return false;
+            pos += count;
+            ++pc;
+        }   continue;
+
+        case OpAtomLazy: {
+            if (pos + i.arg2 > length)
+                break;
+            int count = 0;
+            while ((count < i.arg2) && matchesAtom(i.arg0, i.arg1, input[pos + count]))
+                ++count;
+            if (count < i.arg2)
+                break;
+            pos += count;
+            int left = (i.arg3 == -1) ? -1 : i.arg3 - i.arg2;
+            if ((left != 0) && ! push(LazyEntry, pc, pos, left))
+                return false;
+            ++pc;
+        }   continue;
+
+        case OpMatch:
+            m_state[0] = start;
+            m_state[1] = pos;
+            return true;
+
+        default:
+            Q_ASSERT(0);
+            return false;
+        }
+
+        // backtrack
+        while (true) {
+            if (m_top == 0)
+                return false;
+            Entry &e = m_stack[m_top - 1];
+            if (e.kind == RestoreEntry) {
+                m_state[e.pc] = e.value;
+                --m_top;
+                continue;
+            } else if (e.kind == BranchEntry) {
+                pc = e.pc;
+                pos = e.pos;
+                --m_top;
+            } else if (e.kind == GreedyEntry) {
+                int next = e.pos - 1;
+                const RegExpProgram::Instruction &n = m_code[e.pc];
+                if ((n.op == OpChar) && ! m_ignoreCase) {
+                    // skip the positions where what follows cannot match
+                    while ((next >= e.value) && (input[next] != n.arg0))
+                        --next;
+                }
+                if (next < e.value) {
+                    --m_top;
+                    continue;
+                }
+                pc = e.pc;
+                pos = next;
+                if (next == e.value)
+                    --m_top;
+                else
+                    e.pos = next;
+            } else if (e.kind == LazyEntry) {
+                const RegExpProgram::Instruction &atom = m_code[e.pc];
+                if ((e.pos >= length) || ! matchesAtom(atom.arg0, atom.arg1, input[e.pos])) {
+                    --m_top;
+                    continue;
+                }
+                pc = e.pc + 1;
+                pos = ++e.pos;
+                if ((e.value != -1) && (--e.value == 0))
+                    --m_top;
+            } else {
+                const Entry lookahead = e;
+                --m_top;
+                // a negative lookahead that failed to match succeeds
+                if (! m_code[lookahead.pc].arg0)
+                    continue;
+                pc = m_code[lookahead.pc].arg1;
+                pos = lookahead.pos;
+            }
+            break;
+        }
+    }
+}
+
+RegExpProgram::RegExpProgram(const QString &pattern, int flags)
+    : m_pattern(pattern), m_flags(flags & (IgnoreCase | Multiline)),
+      m_captureCount(0), m_registerCount(2), m_anchored(false),
+      m_hasFirstCharacters(false), m_firstNonLatin1(false),
+      m_firstCharacterCount(0)
+{
+    for (int i = 0; i < 8; ++i)
+        m_firstLatin1[i] = 0;
+    for (int i = 0; i < MaxFirstCharacters; ++i)
+        m_firstCharacters[i] = 0;
+}
+
+RegExpProgram::~RegExpProgram()
+{
+}
+
+RegExpProgram *RegExpProgram::compile(const QString &pattern, int flags,
+                                      QString *errorMessage)
+{
+    RegExpProgram *program = new RegExpProgram(pattern, flags);
+    RegExpCompiler compiler(program);
+    if (! compiler.compile()) {
+        if (errorMessage)
+            *errorMessage = compiler.errorMessage();
+        delete program;
+        return 0;
+    }
+    return program;
+}
+
+// the first position at or after from where a match can start, or -1
+int RegExpProgram::findCandidate(const ushort *input, int length, int from) const
+{
+    if (m_anchored)
+        return (from == 0) ? 0 : -1;
+
+    if (! m_prefix.isEmpty()) {
+        const ushort *prefix = m_prefix.utf16();
+        const int n = m_prefix.length();
+        const ushort first = prefix[0];
+        int i = from;
+#ifdef Q_SCRIPT_REGEXP_SSE2
+        // candidates are where the first two characters of the prefix
+        // are; the second load reads one character ahead, which is within
+        // the input as long as a prefix of two or more fits after it
+        const __m128i v1 = _mm_set1_epi16(first);
+        const __m128i v2 = _mm_set1_epi16((n > 1) ? prefix[1] : 0);
+        for (; i + 8 <= length - n + 1; i += 8) {
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i hit = _mm_cmpeq_epi16(chars, v1);
+            if (n > 1) {
+                const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 1));
+                hit = _mm_and_si128(hit, _mm_cmpeq_epi16(next, v2));
+            }
+            uint mask = _mm_movemask_epi8(hit);
+            while (mask) {
+                const int candidate = i + countTrailingZeros(mask) / 2;
+                int k = 1;
+                while ((k < n) && (input[candidate + k] == prefix[k]))
+                    ++k;
+                if (k == n)
+                    return candidate;
+                mask &= ~(3u << ((candidate - i) * 2));
+            }
+        }
+#endif
+        for (; i + n <= length; ++i) {
+            if (input[i] != first)
+                continue;
+            int k = 1;
+            while ((k < n) && (input[i + k] == prefix[k]))
+                ++k;
+            if (k == n)
+                return i;
+        }
+        return -1;
+    }
+
+    if (m_hasFirstCharacters) {
+        int i = from;
+#ifdef Q_SCRIPT_REGEXP_SSE2
+        if (m_firstCharacterCount > 0) {
+            // the unused slots repeat the first character
+            __m128i v[MaxFirstCharacters];
+            for (int k = 0; k < MaxFirstCharacters; ++k)
+                v[k] = _mm_set1_epi16(m_firstCharacters[(k < m_firstCharacterCount) ? k : 0]);
+            for (; i + 8 <= length; i += 8) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+                __m128i hit = _mm_or_si128(_mm_cmpeq_epi16(chars, v[0]), _mm_cmpeq_epi16(chars, v[1]));
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi16(chars, v[2]));
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi16(chars, v[3]));
+                const uint mask = _mm_movemask_epi8(hit);
+                if (mask != 0)
+                    return i + countTrailingZeros(mask) / 2;
+            }
+        }
+#endif
+        for (; i < length; ++i) {
+            const ushort ch = input[i];
+            if ((ch < 0x100) ? ((m_firstLatin1[ch >> 5] & (1u << (ch & 31))) != 0)
+                             : m_firstNonLatin1) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    return from;
+}
+
+int RegExpProgram::match(const QChar *input, int length, int from,
+                         QVector<int> *captures) const
+{
+    if (from < 0)
+        from = 0;
+    if (from > length)
+        return NoMatch;
+
+    const ushort *chars = reinterpret_cast<const ushort*>(input);
+    QVector<int> state(m_registerCount, -1);
+    RegExpMatcher matcher(this, chars, length, state.data());
+    // when the pattern starts with something like .* that failed to
+    // match, the starts inside the run it took cannot match either
+    const Instruction &first = m_code.at(0);
+    const bool skipRuns = (first.op == OpAtomGreedy) && (first.arg3 == -1);
+    for (int start = from; start <= length; ++start) {
+        start = findCandidate(chars, length, start);
+        if (start == -1)
+            break;
+        if (matcher.matchAt(start)) {
+            const int count = 2 * (m_captureCount + 1);
+            captures->resize(count);
+            for (int i = 0; i < count; ++i)
+                (*captures)[i] = state.at(i);
+            return start;
+        }
+        // the state is not restored when the matcher ran out of room,
+        // so no other start can be tried
+        if (matcher.overflowed())
+            return MatchOverflow;
+        if (m_anchored)
+            break;
+        if (skipRuns)
+            start = matcher.runEnd(first, start);
+    }
+    return NoMatch;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,163 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTREGEXPCOMPILER_P_H
+#define QSCRIPTREGEXPCOMPILER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qshareddata.h>
+#include <qstring.h>
+#include <qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+//
+// A regular expression in the syntax of ECMA-262 section 15.10, compiled
+// to instructions for a backtracking matcher. Single-character atoms
+// under a quantifier get instructions of their own that consume greedily
+// without a backtracking entry per character. Before a match is tried at
+// a position, the input is scanned for the literal prefix of the pattern
+// or, when there is no prefix, for a character that can start a match;
+// patterns anchored with ^ are only tried at the start of the input.
+// Where SSE2 is available, the scans test eight characters at once.
+//
+// Programs are immutable once compiled and may be shared by any number
+// of RegExp objects.
+//
+class RegExpProgram: public QSharedData
+{
+public:
+    enum Flag {
+        // same values as QScript::Ecma::RegExp::RegExpFlag
+        IgnoreCase = 0x02,
+        Multiline  = 0x04
+    };
+
+    struct Instruction {
+        int op;
+        int arg0;
+        int arg1;
+        int arg2;
+        int arg3;
+    };
+
+    // characters below 0x100 are looked up in a bitmap that already
+    // takes case and negation into account
+    struct CharacterClass {
+        uint latin1[8];
+        QVector<ushort> ranges; // pairs of first and last character
+        bool negated;
+        bool ignoreCase;
+
+        bool contains(ushort ch) const;
+    };
+
+    ~RegExpProgram();
+
+    static RegExpProgram *compile(const QString &pattern, int flags,
+                                  QString *errorMessage);
+
+    inline QString pattern() const { return m_pattern; }
+    inline int flags() const { return m_flags; }
+
+    // not counting the match itself
+    inline int captureCount() const { return m_captureCount; }
+
+    enum {
+        NoMatch = -1,
+        MatchOverflow = -2,
+        MaxFirstCharacters = 4
+    };
+
+    // Finds the first match at or after from. On success, returns its
+    // index and stores the start and end of the match and of every
+    // capture in captures, with -1 for captures that did not take part
+    // in the match; returns NoMatch otherwise, or MatchOverflow if the
+    // matcher ran out of room for backtracking before it could decide.
+    int match(const QChar *input, int length, int from,
+              QVector<int> *captures) const;
+    inline int match(const QString &input, int from,
+                     QVector<int> *captures) const
+        { return match(input.unicode(), input.length(), from, captures); }
+
+private:
+    RegExpProgram(const QString &pattern, int flags);
+
+    int findCandidate(const ushort *input, int length, int from) const;
+
+private:
+    friend class RegExpCompiler;
+    friend class RegExpMatcher;
+
+    QString m_pattern;
+    int m_flags;
+    int m_captureCount;
+    int m_registerCount;
+    QVector<Instruction> m_code;
+    QVector<CharacterClass> m_classes;
+
+    // prefilter
+    bool m_anchored;
+    QString m_prefix;
+    bool m_hasFirstCharacters;
+    uint m_firstLatin1[8];
+    bool m_firstNonLatin1;
+    // the same set, when it is that small, for the vectorized scan
+    int m_firstCharacterCount;
+    ushort m_firstCharacters[MaxFirstCharacters];
+};
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTREGEXPCOMPILER_P_H
@@ -0,0 +1,186 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qscriptshape_p.h"
+
+
+#include "qscriptvalue.h"
+#include "qscriptmember_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+Shape *Shape::createDictionary(const Shape *other)
+{
+    Shape *shape = new Shape();
+    shape->m_dictionary = true;
+    if (other) {
+        const int count = other->m_members.size();
+        shape->m_members.reserve(count + 1);
+        for (int i = 0; i < count; ++i)
+            shape->m_members.append(other->m_members.at(i));
+    }
+    return shape;
+}
+
+void Shape::destroy()
+{
+    Q_ASSERT(m_transitions.isEmpty());
+    if (m_parent) {
+        m_parent->m_transitions.remove(m_transitionKey);
+        m_parent->deref();
+    }
+    delete this;
+}
+
+Shape *Shape::addTransition(QScriptNameIdImpl *nameId, uint flags)
+{
+    Q_ASSERT(! m_dictionary);
+
+    const TransitionKey key(nameId, flags);
+    Shape *child = m_transitions.value(key);
+    if (child)
+        return child;
+
+    child = new Shape();
+    child->m_parent = this;
+    child->m_transitionKey = key;
+    ref();
+
+    const int count = m_members.size();
+    child->m_members.reserve(count + 1);
+    for (int i = 0; i < count; ++i)
+        child->m_members.append(m_members.at(i));
+
+    Member m;
+    m.object(nameId, count, flags);
+    child->m_members.append(m);
+
+    m_transitions.insert(key, child);
+    return child;
+}
+
+void Shape::appendMember(QScriptNameIdImpl *nameId, uint flags)
+{
+    Q_ASSERT(m_dictionary);
+    ++m_version;
+
+    Member m;
+    m.object(nameId, m_members.size(), flags);
+    m_members.append(m);
+
+    if (m_indexed)
+        m_index.insert(nameId, m.id());
+}
+
+void Shape::setMemberFlags(int index, uint flags)
+{
+    Q_ASSERT(m_dictionary);
+    ++m_version;
+
+    Member &m = m_members[index];
+    const bool wasValid = m.isValid();
+    m.resetFlags(flags);
+    if (wasValid != m.isValid())
+        m_indexed = false;
+}
+
+void Shape::removeMember(int index)
+{
+    Q_ASSERT(m_dictionary);
+    ++m_version;
+
+    Member &m = m_members[index];
+    QScriptNameIdImpl *nameId = m.nameId();
+    m.invalidate();
+
+    if (! m_indexed)
+        return;
+
+    QHash<QScriptNameIdImpl*, int>::iterator it = m_index.find(nameId);
+    if ((it == m_index.end()) || (it.value() != index))
+        return;
+
+    // fall back to a previous member with the same name (getter/setter pairs)
+    for (int i = index - 1; i >= 0; --i) {
+        const Member &other = m_members.at(i);
+        if (other.nameId() == nameId && other.isValid()) {
+            it.value() = i;
+            return;
+        }
+    }
+    m_index.erase(it);
+}
+
+void Shape::compact()
+{
+    Q_ASSERT(m_dictionary);
+    ++m_version;
+
+    int j = 0;
+    for (int i = 0; i < m_members.size(); ++i) {
+        const Member m = m_members.at(i);
+        if (! m.isValid())
+            continue;
+        if (i != j)
+            m_members[j].object(m.nameId(), j, m.flags());
+        ++j;
+    }
+    m_members.resize(j);
+    m_indexed = false;
+}
+
+void Shape::buildIndex() const
+{
+    m_index.clear();
+    m_index.reserve(m_members.size());
+    for (int i = 0; i < m_members.size(); ++i) {
+        const Member &m = m_members.at(i);
+        if (m.isValid())
+            m_index.insert(m.nameId(), i);
+    }
+    m_indexed = true;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,207 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QSCRIPTSHAPE_P_H
+#define QSCRIPTSHAPE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+
+
+#include <QtCore/qhash.h>
+#include <QtCore/qpair.h>
+
+#include "qscriptbuffer_p.h"
+#include "qscriptmemberfwd_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+//
+// A Shape describes the property layout of a QScriptObject, i.e. the
+// name and flags of the member stored in each slot of the object's
+// value buffer. Objects that get their members added in the same order
+// (with the same flags) share the same Shape; the shapes of a class form
+// a transition tree rooted at QScriptClassInfo::rootShape().
+//
+// Removing a member or changing its flags turns the object's layout into
+// a "dictionary" shape, which is owned by that object alone and is
+// modified in place.
+//
+class Shape
+{
+public:
+    enum {
+        // objects growing beyond this size leave the transition tree
+        MaxTransitionMembers = 64,
+        // layouts with more members than this are looked up through a hash
+        IndexThreshold = 8
+    };
+
+    inline Shape();
+
+    static Shape *createDictionary(const Shape *other);
+
+    inline void ref();
+    inline void deref();
+
+    inline bool isDictionary() const;
+    inline Shape *parent() const;
+    inline uint version() const;
+
+    inline int size() const;
+    inline const Member &at(int index) const;
+
+    inline int find(QScriptNameIdImpl *nameId) const;
+
+    Shape *addTransition(QScriptNameIdImpl *nameId, uint flags);
+
+    // dictionary shapes only
+    void appendMember(QScriptNameIdImpl *nameId, uint flags);
+    void setMemberFlags(int index, uint flags);
+    void removeMember(int index);
+    void compact();
+
+private:
+    typedef QPair<QScriptNameIdImpl*, uint> TransitionKey;
+
+    inline ~Shape();
+    void destroy();
+    void buildIndex() const;
+
+    int m_ref;
+    uint m_version;
+    bool m_dictionary;
+    mutable bool m_indexed;
+    Shape *m_parent;
+    TransitionKey m_transitionKey;
+    QHash<TransitionKey, Shape*> m_transitions;
+    Buffer<Member> m_members;
+    mutable QHash<QScriptNameIdImpl*, int> m_index;
+
+private:
+    Q_DISABLE_COPY(Shape)
+};
+
+inline Shape::Shape()
+    : m_ref(0), m_version(0), m_dictionary(false), m_indexed(false), m_parent(0),
+      m_transitionKey(0, 0)
+{
+}
+
+inline Shape::~Shape()
+{
+}
+
+inline void Shape::ref()
+{
+    ++m_ref;
+}
+
+inline void Shape::deref()
+{
+    Q_ASSERT(m_ref > 0);
+    if (! --m_ref)
+        destroy();
+}
+
+inline bool Shape::isDictionary() const
+{
+    return m_dictionary;
+}
+
+inline Shape *Shape::parent() const
+{
+    return m_parent;
+}
+
+// changes whenever a dictionary shape is modified in place
+inline uint Shape::version() const
+{
+    return m_version;
+}
+
+inline int Shape::size() const
+{
+    return m_members.size();
+}
+
+inline const Member &Shape::at(int index) const
+{
+    return m_members.at(index);
+}
+
+inline int Shape::find(QScriptNameIdImpl *nameId) const
+{
+    const int size = m_members.size();
+
+    if (size > IndexThreshold) {
+        if (! m_indexed)
+            buildIndex();
+        return m_index.value(nameId, -1);
+    }
+
+    const Member *members = m_members.constData();
+    for (int i = size - 1; i >= 0; --i) {
+        const Member &m = members[i];
+        if (m.nameId() == nameId && m.isValid())
+            return i;
+    }
+
+    return -1;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTSHAPE_P_H
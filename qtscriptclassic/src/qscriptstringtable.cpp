@@ -0,0 +1,171 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qscriptstringtable_p.h"
+
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+StringTable::StringTable()
+    : m_slots(0), m_capacity(0), m_shift(0), m_count(0),
+      m_oldSlots(0), m_oldCapacity(0), m_oldShift(0), m_migrated(0)
+{
+    allocate(MinimumCapacity);
+}
+
+StringTable::~StringTable()
+{
+    delete[] m_slots;
+    delete[] m_oldSlots;
+}
+
+void StringTable::allocate(int capacity)
+{
+    m_slots = new Slot[capacity];
+    memset(m_slots, 0, capacity * sizeof(Slot));
+    m_capacity = capacity;
+    m_shift = 32;
+    for (int c = capacity; c > 1; c >>= 1)
+        --m_shift;
+}
+
+void StringTable::insertInto(Slot *slots, int capacity, int shift,
+                             QScriptNameIdImpl *entry)
+{
+    const uint mask = capacity - 1;
+    uint i = indexOf(entry->h, shift);
+    while (slots[i].entry)
+        i = (i + 1) & mask;
+    slots[i].hash = entry->h;
+    slots[i].entry = entry;
+}
+
+void StringTable::insert(QScriptNameIdImpl *entry)
+{
+    Q_ASSERT(! find(entry->s.unicode(), entry->s.length(), entry->h));
+
+    if (m_oldSlots)
+        migrate(MigrationStep);
+
+    // keep the load factor at or below 1/2
+    if (2 * (m_count + 1) > m_capacity) {
+        if (m_oldSlots)
+            migrate(m_oldCapacity);
+        m_oldSlots = m_slots;
+        m_oldCapacity = m_capacity;
+        m_oldShift = m_shift;
+        m_migrated = 0;
+        allocate(m_capacity * 2);
+        migrate(MigrationStep);
+    }
+
+    insertInto(m_slots, m_capacity, m_shift, entry);
+    ++m_count;
+}
+
+void StringTable::remove(QScriptNameIdImpl *entry)
+{
+    if (m_oldSlots)
+        migrate(m_oldCapacity);
+
+    const uint mask = m_capacity - 1;
+    uint i = indexOf(entry->h, m_shift);
+    while (m_slots[i].entry != entry) {
+        Q_ASSERT(m_slots[i].entry != 0);
+        i = (i + 1) & mask;
+    }
+
+    // move the entries that follow in the same cluster back into the hole
+    // when their home slot allows it, so that lookups don't stop early
+    for (uint j = (i + 1) & mask; m_slots[j].entry; j = (j + 1) & mask) {
+        const uint home = indexOf(m_slots[j].hash, m_shift);
+        const bool between = (i <= j) ? (i < home && home <= j)
+                                      : (i < home || home <= j);
+        if (between)
+            continue;
+        m_slots[i] = m_slots[j];
+        i = j;
+    }
+    m_slots[i].hash = 0;
+    m_slots[i].entry = 0;
+    --m_count;
+}
+
+// moves up to count slots of the old table over to the current one
+void StringTable::migrate(int count)
+{
+    Q_ASSERT(m_oldSlots != 0);
+    const int end = qMin(m_migrated + count, m_oldCapacity);
+    for (int i = m_migrated; i < end; ++i) {
+        if (m_oldSlots[i].entry)
+            insertInto(m_slots, m_capacity, m_shift, m_oldSlots[i].entry);
+    }
+    m_migrated = end;
+
+    if (m_migrated == m_oldCapacity) {
+        delete[] m_oldSlots;
+        m_oldSlots = 0;
+        m_oldCapacity = 0;
+    }
+}
+
+void StringTable::rebuild(const QVector<QScriptNameIdImpl*> &entries)
+{
+    delete[] m_slots;
+    delete[] m_oldSlots;
+    m_oldSlots = 0;
+    m_oldCapacity = 0;
+    m_migrated = 0;
+
+    int capacity = MinimumCapacity;
+    while (capacity < 4 * entries.size())
+        capacity <<= 1;
+    allocate(capacity);
+
+    for (int i = 0; i < entries.size(); ++i)
+        insertInto(m_slots, m_capacity, m_shift, entries.at(i));
+    m_count = entries.size();
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
@@ -0,0 +1,181 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the Qt Solutions component.
+**
+** $QT_BEGIN_LICENSE:BSD$
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of Digia Plc and its Subsidiary(-ies) nor the names
+**     of its contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSCRIPTSTRINGTABLE_P_H
+#define QSCRIPTSTRINGTABLE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+
+
+#include <QtCore/qvector.h>
+
+#include "qscriptnameid_p.h"
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QScript {
+
+//
+// The table of interned (unique) strings. It is an open-addressing
+// hash table with linear probing that keeps the full hash of each
+// entry next to the pointer, so that most mismatches are rejected
+// without touching the string itself. Lookups work directly on a
+// QChar span, so the lexer doesn't need to build a QString for names
+// it has seen before.
+//
+// When the table grows, the entries of the old table are moved over a
+// few slots per insertion; until that is done lookups probe both.
+//
+class StringTable
+{
+public:
+    StringTable();
+    ~StringTable();
+
+    static inline uint hash(const QChar *u, int length);
+
+    inline QScriptNameIdImpl *find(const QChar *u, int length, uint hash) const;
+
+    // entry->h must be the hash of entry->s
+    void insert(QScriptNameIdImpl *entry);
+    void remove(QScriptNameIdImpl *entry);
+
+    // replaces the contents of the table with the given entries
+    void rebuild(const QVector<QScriptNameIdImpl*> &entries);
+
+    inline int count() const;
+
+private:
+    struct Slot {
+        uint hash;
+        QScriptNameIdImpl *entry;
+    };
+
+    enum {
+        MinimumCapacity = 1024,
+        // old slots moved over per insertion while growing
+        MigrationStep = 8
+    };
+
+    static inline uint indexOf(uint hash, int shift);
+    static inline QScriptNameIdImpl *findIn(const Slot *slots, int capacity, int shift,
+                                            const QChar *u, int length, uint hash);
+    static void insertInto(Slot *slots, int capacity, int shift,
+                           QScriptNameIdImpl *entry);
+    void allocate(int capacity);
+    void migrate(int count);
+
+    Slot *m_slots;
+    int m_capacity;
+    int m_shift;
+    int m_count;
+
+    Slot *m_oldSlots;
+    int m_oldCapacity;
+    int m_oldShift;
+    int m_migrated;
+
+private:
+    Q_DISABLE_COPY(StringTable)
+};
+
+inline uint StringTable::hash(const QChar *u, int length)
+{
+    // FNV-1a over the UTF-16 code units
+    uint h = 2166136261U;
+    for (int i = 0; i < length; ++i) {
+        h ^= u[i].unicode();
+        h *= 16777619U;
+    }
+    return h;
+}
+
+// Fibonacci hashing spreads the bits of the hash over the index
+inline uint StringTable::indexOf(uint hash, int shift)
+{
+    return (hash * 2654435769U) >> shift;
+}
+
+inline QScriptNameIdImpl *StringTable::findIn(const Slot *slots, int capacity, int shift,
+                                              const QChar *u, int length, uint hash)
+{
+    const uint mask = capacity - 1;
+    for (uint i = indexOf(hash, shift); ; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (! slot.entry)
+            return 0;
+        if ((slot.hash == hash) && (slot.entry->s.length() == length)
+            && (memcmp(slot.entry->s.unicode(), u, length * sizeof(QChar)) == 0)) {
+            return slot.entry;
+        }
+    }
+}
+
+inline QScriptNameIdImpl *StringTable::find(const QChar *u, int length, uint hash) const
+{
+    QScriptNameIdImpl *entry = findIn(m_slots, m_capacity, m_shift, u, length, hash);
+    if (! entry && m_oldSlots)
+        entry = findIn(m_oldSlots, m_oldCapacity, m_oldShift, u, length, hash);
+    return entry;
+}
+
+inline int StringTable::count() const
+{
+    return m_count;
+}
+
+} // namespace QScript
+
+QT_END_NAMESPACE
+
+#endif // QSCRIPTSTRINGTABLE_P_H
@@ -418,8 +418,7 @@ QScriptValue::QScriptValue(qsreal value)
 QScriptValue::QScriptValue(const QString &value)
     : d_ptr(new QScriptValuePrivate)
 {
-    d_ptr->value.m_type = QScript::LazyStringType;
-    d_ptr->value.m_lazy_string_value = new QString(value);
+    d_ptr->value.setLazyStringValue(new QString(value));
     d_ptr->ref.ref();
 }
 
@@ -431,8 +430,7 @@ QScriptValue::QScriptValue(const QString &value)
 QScriptValue::QScriptValue(const QLatin1String &value)
     : d_ptr(new QScriptValuePrivate)
 {
-    d_ptr->value.m_type = QScript::LazyStringType;
-    d_ptr->value.m_lazy_string_value = new QString(value);
+    d_ptr->value.setLazyStringValue(new QString(value));
     d_ptr->ref.ref();
 }
 
@@ -446,8 +444,7 @@ QScriptValue::QScriptValue(const QLatin1String &value)
 QScriptValue::QScriptValue(const char *value)
     : d_ptr(new QScriptValuePrivate)
 {
-    d_ptr->value.m_type = QScript::LazyStringType;
-    d_ptr->value.m_lazy_string_value = new QString(QString::fromAscii(value));
+    d_ptr->value.setLazyStringValue(new QString(QString::fromAscii(value)));
     d_ptr->ref.ref();
 }
 #endif
@@ -1591,7 +1588,7 @@ qint64 QScriptValue::objectId() const
     Q_D(const QScriptValue);
     if (!d || !d->value.isObject())
         return -1;
-    return d->value.m_object_value->m_id;
+    return d->value.objectValue()->m_id;
 }
 
 QT_END_NAMESPACE
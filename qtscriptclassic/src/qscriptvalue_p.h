@@ -67,7 +67,7 @@ inline QScriptValuePrivate::QScriptValuePrivate()
 inline QScriptValuePrivate::~QScriptValuePrivate()
 {
     if (value.type() == QScript::LazyStringType)
-        delete value.m_lazy_string_value;
+        delete value.lazyStringValue();
 }
 
 inline QScriptValuePrivate *QScriptValuePrivate::create()
@@ -59,10 +59,10 @@ static void dfs(QScriptObject *instance, QHash<QScriptObject*, int> &dfn, int n)
         return;
 
     if (instance->m_prototype.isObject())
-        dfs (instance->m_prototype.m_object_value, dfn, n + 1);
+        dfs (instance->m_prototype.objectValue(), dfn, n + 1);
 
     if (instance->m_scope.isObject())
-        dfs (instance->m_scope.m_object_value, dfn, n + 1);
+        dfs (instance->m_scope.objectValue(), dfn, n + 1);
 }
 
 
@@ -71,12 +71,12 @@ static bool checkCycle(QScriptObject *instance, const QHash<QScriptObject*, int>
     int n = dfn.value(instance);
 
     if (instance->m_prototype.isObject()) {
-        if (n >= dfn.value(instance->m_prototype.m_object_value))
+        if (n >= dfn.value(instance->m_prototype.objectValue()))
             return true;
     }
 
     if (instance->m_scope.isObject()) {
-        if (n >= dfn.value(instance->m_scope.m_object_value))
+        if (n >= dfn.value(instance->m_scope.objectValue()))
             return true;
     }
 
@@ -86,8 +86,8 @@ static bool checkCycle(QScriptObject *instance, const QHash<QScriptObject*, int>
 bool QScriptValueImpl::detectedCycle() const
 {
     QHash<QScriptObject*, int> dfn;
-    dfs(m_object_value, dfn, 0);
-    return checkCycle(m_object_value, dfn);
+    dfs(objectValue(), dfn, 0);
+    return checkCycle(objectValue(), dfn);
 }
 
 bool QScriptValueImpl::instanceOf(const QScriptValueImpl &value) const
@@ -132,13 +132,13 @@ bool QScriptValueImpl::hasInstance(const QScriptValueImpl &value) const
         return false;
     }
 
-    QScriptObject *target = proto.m_object_value;
+    QScriptObject *target = proto.objectValue();
     QScriptValueImpl v = value;
     while (true) {
         v = v.prototype();
         if (!v.isObject())
             break;
-        if (target == v.m_object_value)
+        if (target == v.objectValue())
             return true;
     }
     return false;
@@ -148,7 +148,7 @@ bool QScriptValueImpl::resolve_helper(QScriptNameIdImpl *nameId, QScript::Member
                                       QScriptValueImpl *object, QScriptValue::ResolveFlags mode,
                                       QScript::AccessMode access) const
 {
-    QScriptObject *object_data = m_object_value;
+    QScriptObject *object_data = objectValue();
 
     QScriptEnginePrivate *eng_p = engine();
 
@@ -213,7 +213,7 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
                 // the property we resolved is a setter
                 if (!(flags & QScriptValue::PropertySetter) && !member.isGetter()) {
                     // find the getter, if not, create one
-                    if (!m_object_value->findGetter(&member)) {
+                    if (!objectValue()->findGetter(&member)) {
                         if (!value.isValid())
                             return; // don't create property for invalid value
                         createMember(nameId, &member, flags);
@@ -223,7 +223,7 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
                 // the property we resolved is a getter
                 if (!(flags & QScriptValue::PropertyGetter)) {
                     // find the setter, if not, create one
-                    if (!m_object_value->findSetter(&member)) {
+                    if (!objectValue()->findSetter(&member)) {
                         if (!value.isValid())
                             return; // don't create property for invalid value
                         createMember(nameId, &member, flags);
@@ -233,8 +233,8 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
                 // the property is a normal property -- change the flags
                 uint newFlags = flags & ~QScript::Member::InternalRange;
                 newFlags |= QScript::Member::ObjectProperty;
+                base.objectValue()->setMemberFlags(member, newFlags);
                 member.resetFlags(newFlags);
-                base.m_object_value->m_members[member.id()].resetFlags(newFlags);
             }
             Q_ASSERT(member.isValid());
             if (!value.isValid()) {
@@ -248,7 +248,7 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
                 // call the setter
                 QScriptValueImpl setter;
                 if (member.isObjectProperty() && !member.isSetter()) {
-                    if (!base.m_object_value->findSetter(&member)) {
+                    if (!base.objectValue()->findSetter(&member)) {
                         qWarning("QScriptValue::setProperty() failed: "
                                  "property '%s' has a getter but no setter",
                                  qPrintable(nameId->s));
@@ -259,7 +259,7 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
                 setter.call(*this, QScriptValueImplList() << value);
                 return;
             } else {
-                if (base.m_object_value != m_object_value) {
+                if (base.objectValue() != objectValue()) {
                     if (!value.isValid())
                         return; // don't create property for invalid value
                     createMember(nameId, &member, flags);
@@ -280,7 +280,7 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
                     } else {
                         uint newFlags = member.flags() & QScript::Member::InternalRange;
                         newFlags |= flags & ~QScript::Member::InternalRange;
-                        base.m_object_value->m_members[member.id()].resetFlags(newFlags);
+                        base.objectValue()->setMemberFlags(member, newFlags);
                     }
                 }
             }
@@ -298,7 +298,7 @@ void QScriptValueImpl::setProperty(QScriptNameIdImpl *nameId,
 
 QVariant QScriptValueImpl::toVariant() const
 {
-    switch (m_type) {
+    switch (type()) {
     case QScript::InvalidType:
         return QVariant();
 
@@ -309,19 +309,19 @@ QVariant QScriptValueImpl::toVariant() const
         break;
 
     case QScript::BooleanType:
-        return QVariant(m_bool_value);
+        return QVariant(boolValue());
 
     case QScript::IntegerType:
-        return QVariant(m_int_value);
+        return QVariant(intValue());
 
     case QScript::NumberType:
-        return QVariant(m_number_value);
+        return QVariant(numberValue());
 
     case QScript::StringType:
-        return QVariant(m_string_value->s);
+        return QVariant(stringValue()->string());
 
     case QScript::LazyStringType:
-        return QVariant(*m_lazy_string_value);
+        return QVariant(*lazyStringValue());
 
     case QScript::ObjectType:
         if (isDate())
@@ -430,17 +430,15 @@ QDebug &operator<<(QDebug &d, const QScriptValueImpl &object)
 void QScriptValueImpl::destroyObjectData()
 {
     Q_ASSERT(isObject());
-    m_object_value->finalizeData();
+    objectValue()->finalizeData();
 }
 
 bool QScriptValueImpl::isMarked(int generation) const
 {
     if (isString())
-        return (m_string_value->used != 0);
-    else if (isObject()) {
-        QScript::GCBlock *block = QScript::GCBlock::get(m_object_value);
-        return (block->generation == generation);
-    }
+        return (stringValue()->used != 0);
+    else if (isObject())
+        return engine()->isMarked(objectValue(), generation);
     return false;
 }
 
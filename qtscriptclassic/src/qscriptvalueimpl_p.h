@@ -72,37 +72,88 @@ QT_BEGIN_NAMESPACE
 // We mean it.
 //
 
+#ifndef Q_SCRIPT_NO_NAN_BOXING
+inline void QScriptValueImpl::setTagged(QScript::Type type, quint64 payload)
+{
+    Q_ASSERT(type != QScript::NumberType);
+    Q_ASSERT((payload >> PayloadBits) == 0);
+    m_bits = (quint64(NumberTag + 1 + type) << PayloadBits) | payload;
+}
+
+inline void QScriptValueImpl::setNumber(qsreal number)
+{
+    m_number = number;
+    if (number != number) // NaN; make sure it can't be mistaken for a tag
+        m_bits = Q_UINT64_C(0x7FF8000000000000);
+}
+
+inline quint64 QScriptValueImpl::payload() const
+{
+    return m_bits & ((Q_UINT64_C(1) << PayloadBits) - 1);
+}
+
+inline uint QScriptValueImpl::tag() const
+{
+    return uint(m_bits >> PayloadBits);
+}
+#else
+inline void QScriptValueImpl::setTagged(QScript::Type type, quint64 payload)
+{
+    Q_ASSERT(type != QScript::NumberType);
+    m_tag = NumberTag + 1 + type;
+    m_payload = payload;
+}
+
+inline void QScriptValueImpl::setNumber(qsreal number)
+{
+    m_tag = NumberTag;
+    m_number = number;
+}
+
+inline quint64 QScriptValueImpl::payload() const
+{
+    return m_payload;
+}
+
+inline uint QScriptValueImpl::tag() const
+{
+    return m_tag;
+}
+#endif // Q_SCRIPT_NO_NAN_BOXING
+
 inline QScriptValueImpl::QScriptValueImpl()
-    : m_type(QScript::InvalidType) {}
+{
+    setTagged(QScript::InvalidType);
+}
 
 inline QScriptValueImpl::QScriptValueImpl(QScriptValue::SpecialValue val)
 {
     if (val == QScriptValue::NullValue)
-        m_type = QScript::NullType;
+        setTagged(QScript::NullType);
     else if (val == QScriptValue::UndefinedValue)
-        m_type = QScript::UndefinedType;
+        setTagged(QScript::UndefinedType);
     else
-        m_type = QScript::InvalidType;
+        setTagged(QScript::InvalidType);
 }
 
 inline QScriptValueImpl::QScriptValueImpl(bool val)
-    : m_type(QScript::BooleanType), m_bool_value(val)
 {
+    setTagged(QScript::BooleanType, val ? 1 : 0);
 }
 
 inline QScriptValueImpl::QScriptValueImpl(int val)
-    : m_type(QScript::NumberType), m_number_value(val)
 {
+    setNumber(val);
 }
 
 inline QScriptValueImpl::QScriptValueImpl(uint val)
-    : m_type(QScript::NumberType), m_number_value(val)
 {
+    setNumber(val);
 }
 
 inline QScriptValueImpl::QScriptValueImpl(qsreal val)
-    : m_type(QScript::NumberType), m_number_value(val)
 {
+    setNumber(val);
 }
 
 inline QScriptValueImpl::QScriptValueImpl(QScriptEnginePrivate *engine, const QString &val)
@@ -111,124 +162,184 @@ inline QScriptValueImpl::QScriptValueImpl(QScriptEnginePrivate *engine, const QS
 }
 
 inline QScriptValueImpl::QScriptValueImpl(QScriptNameIdImpl *val)
-    : m_type(QScript::StringType), m_string_value(val)
 {
+    setTagged(QScript::StringType, quintptr(val));
 }
 
 inline QScript::Type QScriptValueImpl::type() const
 {
-    return m_type;
+    const uint t = tag();
+    if (t <= NumberTag)
+        return QScript::NumberType;
+    return QScript::Type(t - NumberTag - 1);
 }
 
 inline QScriptEnginePrivate *QScriptValueImpl::engine() const
 {
     if (!isObject())
         return 0;
-    return m_object_value->m_class->engine();
+    return objectValue()->m_class->engine();
 }
 
 inline QScriptClassInfo *QScriptValueImpl::classInfo() const
 {
     if (!isObject())
         return 0;
-    return m_object_value->m_class;
+    return objectValue()->m_class;
 }
 
 inline void QScriptValueImpl::setClassInfo(QScriptClassInfo *cls)
 {
     Q_ASSERT(isObject());
-    m_object_value->m_class = cls;
+    objectValue()->m_class = cls;
+}
+
+// the payload accessors don't check the type; reading the payload of
+// a value of another type yields garbage (0 for undefined, null and
+// invalid values), just like reading the wrong member of a union
+
+inline bool QScriptValueImpl::boolValue() const
+{
+    return payload() != 0;
+}
+
+inline int QScriptValueImpl::intValue() const
+{
+    return int(quint32(payload()));
+}
+
+inline qsreal QScriptValueImpl::numberValue() const
+{
+    return m_number;
+}
+
+inline void *QScriptValueImpl::pointerValue() const
+{
+    return reinterpret_cast<void*>(quintptr(payload()));
 }
 
 inline QScriptNameIdImpl *QScriptValueImpl::stringValue() const
 {
-    Q_ASSERT(isString());
-    return m_string_value;
+    return reinterpret_cast<QScriptNameIdImpl*>(quintptr(payload()));
+}
+
+inline QString *QScriptValueImpl::lazyStringValue() const
+{
+    return reinterpret_cast<QString*>(quintptr(payload()));
 }
 
 inline QScriptObject *QScriptValueImpl::objectValue() const
 {
-    Q_ASSERT(isObject());
-    return m_object_value;
+    return reinterpret_cast<QScriptObject*>(quintptr(payload()));
+}
+
+inline void QScriptValueImpl::setObjectValue(QScriptObject *object)
+{
+    setTagged(QScript::ObjectType, quintptr(object));
+}
+
+inline void QScriptValueImpl::setStringValue(QScriptNameIdImpl *nameId)
+{
+    setTagged(QScript::StringType, quintptr(nameId));
+}
+
+inline void QScriptValueImpl::setLazyStringValue(QString *str)
+{
+    setTagged(QScript::LazyStringType, quintptr(str));
+}
+
+inline void QScriptValueImpl::setIntegerValue(int value)
+{
+    setTagged(QScript::IntegerType, quint32(value));
+}
+
+inline void QScriptValueImpl::setReferenceValue(int mode)
+{
+    setTagged(QScript::ReferenceType, quint32(mode));
+}
+
+inline void QScriptValueImpl::setPointerValue(void *ptr)
+{
+    setTagged(QScript::PointerType, quintptr(ptr));
 }
 
 inline void QScriptValueImpl::incr()
 {
-    ++m_number_value;
+    ++m_number;
 }
 
 inline void QScriptValueImpl::decr()
 {
-    --m_number_value;
+    --m_number;
 }
 
 inline void QScriptValueImpl::invalidate()
 {
-    m_type = QScript::InvalidType;
+    setTagged(QScript::InvalidType);
 }
 
 inline bool QScriptValueImpl::isValid() const
 {
-    return m_type != QScript::InvalidType;
+    return tag() != NumberTag + 1 + QScript::InvalidType;
 }
 
 inline bool QScriptValueImpl::isUndefined() const
 {
-    return (m_type == QScript::UndefinedType);
+    return tag() == NumberTag + 1 + QScript::UndefinedType;
 }
 
 inline bool QScriptValueImpl::isNull() const
 {
-    return (m_type == QScript::NullType);
+    return tag() == NumberTag + 1 + QScript::NullType;
 }
 
 inline bool QScriptValueImpl::isBoolean() const
 {
-    return (m_type == QScript::BooleanType);
+    return tag() == NumberTag + 1 + QScript::BooleanType;
 }
 
 inline bool QScriptValueImpl::isNumber() const
 {
-    return (m_type == QScript::NumberType);
+    return tag() <= NumberTag;
 }
 
 inline bool QScriptValueImpl::isString() const
 {
-    return (m_type == QScript::StringType)
-        || (m_type == QScript::LazyStringType);
+    return (tag() == NumberTag + 1 + QScript::StringType)
+        || (tag() == NumberTag + 1 + QScript::LazyStringType);
 }
 
 inline bool QScriptValueImpl::isReference() const
 {
-    return (m_type == QScript::ReferenceType);
+    return tag() == NumberTag + 1 + QScript::ReferenceType;
 }
 
 inline bool QScriptValueImpl::isObject() const
 {
-    return (m_type == QScript::ObjectType);
+    return tag() == NumberTag + 1 + QScript::ObjectType;
 }
 
 inline bool QScriptValueImpl::isFunction() const
 {
-    return (m_type == QScript::ObjectType)
+    return isObject()
         && (classInfo()->type() & QScriptClassInfo::FunctionBased);
 }
 
 inline bool QScriptValueImpl::isVariant() const
 {
-    return (m_type == QScript::ObjectType)
+    return isObject()
         && (classInfo()->type() == QScriptClassInfo::VariantType);
 }
 
 inline bool QScriptValueImpl::isQObject() const
 {
-    return (m_type == QScript::ObjectType)
+    return isObject()
         && (classInfo()->type() == QScriptClassInfo::QObjectType);
 }
 
 inline bool QScriptValueImpl::isQMetaObject() const
 {
-    return (m_type == QScript::ObjectType)
+    return isObject()
         && (classInfo()->type() == QScriptClassInfo::QMetaObjectType);
 }
 
@@ -333,7 +444,7 @@ inline QObject *QScriptValueImpl::toQObject() const
 {
 #ifndef QT_NO_QOBJECT
     if (isQObject()) {
-        QScript::ExtQObject *ctor = engine()->qobjectConstructor;
+        QScript::ExtQObject *ctor = engine()->qobjectConstructor();
         Q_ASSERT(ctor != 0);
 
         QScript::ExtQObject::Instance *data = ctor->get(*this);
@@ -353,7 +464,7 @@ inline const QMetaObject *QScriptValueImpl::toQMetaObject() const
 {
 #ifndef QT_NO_QOBJECT
     if (isQMetaObject()) {
-        QScript::ExtQMetaObject *ctor = engine()->qmetaObjectConstructor;
+        QScript::ExtQMetaObject *ctor = engine()->qmetaObjectConstructor();
         Q_ASSERT(ctor != 0);
 
         QScript::ExtQMetaObject::Instance *data = ctor->get(*this);
@@ -369,25 +480,28 @@ inline QScriptValueImpl QScriptValueImpl::prototype() const
 {
     if (!isObject())
         return QScriptValueImpl();
-    return m_object_value->m_prototype;
+    return objectValue()->m_prototype;
 }
 
 inline void QScriptValueImpl::setPrototype(const QScriptValueImpl &prototype)
 {
-    if (isObject())
-        m_object_value->m_prototype = prototype;
+    if (isObject()) {
+        objectValue()->aboutToChange();
+        objectValue()->m_prototype = prototype;
+        objectValue()->writeBarrier(prototype);
+    }
 }
 
 inline QScriptObjectData *QScriptValueImpl::objectData() const
 {
     Q_ASSERT(isObject());
-    return m_object_value->m_data;
+    return objectValue()->m_data;
 }
 
 inline void QScriptValueImpl::setObjectData(QScriptObjectData *data)
 {
     Q_ASSERT(isObject());
-    m_object_value->m_data = data;
+    objectValue()->m_data = data;
 }
 
 inline bool QScriptValueImpl::resolve(QScriptNameIdImpl *nameId, QScript::Member *member,
@@ -401,7 +515,7 @@ inline bool QScriptValueImpl::resolve(QScriptNameIdImpl *nameId, QScript::Member
 
     Q_ASSERT(nameId->unique);
 
-    QScriptObject *object_data = m_object_value;
+    QScriptObject *object_data = objectValue();
 
     // Search in properties...
     if (object_data->findMember(nameId, member)) {
@@ -424,9 +538,9 @@ inline void QScriptValueImpl::get(const QScript::Member &member, QScriptValueImp
     }
 
     Q_ASSERT(member.id() >= 0);
-    Q_ASSERT(member.id() < m_object_value->memberCount());
+    Q_ASSERT(member.id() < objectValue()->memberCount());
 
-    m_object_value->get(member, out);
+    objectValue()->get(member, out);
 }
 
 inline void QScriptValueImpl::get(QScriptNameIdImpl *nameId, QScriptValueImpl *out)
@@ -469,8 +583,8 @@ inline void QScriptValueImpl::put(const QScript::Member &member, const QScriptVa
     if (member.isObjectProperty()) {
         Q_ASSERT(member.nameId()->unique);
         Q_ASSERT(member.id() >= 0);
-        Q_ASSERT(member.id() < m_object_value->memberCount());
-        m_object_value->put(member, value);
+        Q_ASSERT(member.id() < objectValue()->memberCount());
+        objectValue()->put(member, value);
     }
 
     else if (member.nameId() == eng_p->idTable()->id___proto__) {
@@ -497,12 +611,13 @@ inline void QScriptValueImpl::setQObjectValue(QObject *object)
 #ifndef QT_NO_QOBJECT
     Q_ASSERT(isQObject());
 
-    QScript::ExtQObject *ctor = engine()->qobjectConstructor;
+    QScript::ExtQObject *ctor = engine()->qobjectConstructor();
     Q_ASSERT(ctor != 0);
 
     QScript::ExtQObject::Instance *data = ctor->get(*this);
     Q_ASSERT(data != 0);
 
+    objectValue()->aboutToChange();
     data->value = object;
 #else
     Q_UNUSED(object);
@@ -513,7 +628,7 @@ inline QVariant &QScriptValueImpl::variantValue() const
 {
     Q_ASSERT(isVariant());
 
-    QScript::Ext::Variant *ctor = engine()->variantConstructor;
+    QScript::Ext::Variant *ctor = engine()->variantConstructor();
     Q_ASSERT(ctor != 0);
 
     QScript::Ext::Variant::Instance *data = ctor->get(*this);
@@ -527,31 +642,34 @@ inline void QScriptValueImpl::setVariantValue(const QVariant &value)
     if (!isVariant())
         return;
 
-    QScript::Ext::Variant *ctor = engine()->variantConstructor;
+    QScript::Ext::Variant *ctor = engine()->variantConstructor();
     Q_ASSERT(ctor != 0);
 
     QScript::Ext::Variant::Instance *data = ctor->get(*this);
     Q_ASSERT(data != 0);
 
+    objectValue()->aboutToChange();
     data->value = value;
 }
 
 inline QScriptValueImpl QScriptValueImpl::internalValue() const
 {
     Q_ASSERT(isObject());
-    return m_object_value->m_internalValue;
+    return objectValue()->m_internalValue;
 }
 
 inline void QScriptValueImpl::setInternalValue(const QScriptValueImpl &internalValue)
 {
     Q_ASSERT(isObject());
-    m_object_value->m_internalValue = internalValue;
+    objectValue()->aboutToChange();
+    objectValue()->m_internalValue = internalValue;
+    objectValue()->writeBarrier(internalValue);
 }
 
 inline void QScriptValueImpl::removeMember(const QScript::Member &member)
 {
     if (member.isObjectProperty())
-        m_object_value->removeMember(member);
+        objectValue()->removeMember(member);
 
     else if (QScriptClassData *data = classInfo()->data())
         data->removeMember(*this, member);
@@ -562,7 +680,7 @@ inline void QScriptValueImpl::createMember(QScriptNameIdImpl *nameId,
 {
     Q_ASSERT(isObject());
 
-    QScriptObject *object_data = m_object_value;
+    QScriptObject *object_data = objectValue();
     object_data->createMember(nameId, member, flags);
     Q_ASSERT(member->isObjectProperty());
 }
@@ -570,27 +688,29 @@ inline void QScriptValueImpl::createMember(QScriptNameIdImpl *nameId,
 inline QScriptValueImpl QScriptValueImpl::scope() const
 {
     Q_ASSERT(isObject());
-    return m_object_value->m_scope;
+    return objectValue()->m_scope;
 }
 
 inline void QScriptValueImpl::setScope(const QScriptValueImpl &scope)
 {
     Q_ASSERT(isObject());
-    m_object_value->m_scope = scope;
+    objectValue()->aboutToChange();
+    objectValue()->m_scope = scope;
+    objectValue()->writeBarrier(scope);
 }
 
 inline int QScriptValueImpl::memberCount() const
 {
     Q_ASSERT(isObject());
-    return m_object_value->memberCount();
+    return objectValue()->memberCount();
 }
 
 inline void QScriptValueImpl::member(int index, QScript::Member *member) const
 {
     Q_ASSERT(isObject());
     Q_ASSERT(index >= 0);
-    Q_ASSERT(index < m_object_value->memberCount());
-    m_object_value->member(index, member);
+    Q_ASSERT(index < objectValue()->memberCount());
+    objectValue()->member(index, member);
 }
 
 inline QScriptFunction *QScriptValueImpl::toFunction() const
@@ -617,7 +737,7 @@ inline QScriptValueImpl QScriptValueImpl::property(QScriptNameIdImpl *nameId,
     if (member.isGetterOrSetter()) {
         QScriptValueImpl getter;
         if (member.isObjectProperty() && !member.isGetter()) {
-            if (!base.m_object_value->findGetter(&member))
+            if (!base.objectValue()->findGetter(&member))
                 return QScriptValueImpl();
         }
         base.get(member, &getter);
@@ -667,7 +787,9 @@ inline void QScriptValueImpl::setProperty(quint32 arrayIndex, const QScriptValue
     QScriptEnginePrivate *eng_p = engine();
     QScript::Ecma::Array::Instance *instance = eng_p->arrayConstructor->get(*this);
     if (instance && (arrayIndex != 0xFFFFFFFF)) {
+        objectValue()->aboutToChange();
         instance->value.assign(arrayIndex, value);
+        objectValue()->writeBarrier(value);
         return;
     }
 
@@ -772,7 +894,7 @@ inline void QScriptValueImpl::mark(int generation) const
         return;
 
     else if (isString())
-        engine()->markString(m_string_value, generation);
+        engine()->markString(stringValue(), generation);
 
     else if (isObject())
         engine()->markObject(*this, generation);
@@ -63,8 +63,13 @@ QT_BEGIN_NAMESPACE
 // We mean it.
 //
 
-#if defined(Q_OS_VXWORKS) && defined(m_type)
-#  undef m_type
+// NaN-boxing needs every pointer to fit in a 47-bit payload. That holds
+// where pointers are 32 bits, and on x86-64, where user space ends at
+// 2^47; other 64-bit targets (AArch64, for one, maps memory up to 2^48)
+// keep the type of a value next to an 8-byte payload instead
+#if !defined(Q_SCRIPT_NO_NAN_BOXING) && !(defined(QT_POINTER_SIZE) && (QT_POINTER_SIZE == 4)) \
+    && !defined(__x86_64__) && !defined(_M_X64)
+#  define Q_SCRIPT_NO_NAN_BOXING
 #endif
 
 class QScriptValueImpl;
@@ -104,8 +109,19 @@ public:
     inline QScriptEnginePrivate *engine() const;
     inline QScriptClassInfo *classInfo() const;
     inline void setClassInfo(QScriptClassInfo *cls);
+    inline bool boolValue() const;
+    inline int intValue() const;
+    inline qsreal numberValue() const;
+    inline void *pointerValue() const;
     inline QScriptNameIdImpl *stringValue() const;
+    inline QString *lazyStringValue() const;
     inline QScriptObject *objectValue() const;
+    inline void setObjectValue(QScriptObject *object);
+    inline void setStringValue(QScriptNameIdImpl *nameId);
+    inline void setLazyStringValue(QString *str);
+    inline void setIntegerValue(int value);
+    inline void setReferenceValue(int mode);
+    inline void setPointerValue(void *ptr);
     inline void incr();
     inline void decr();
 
@@ -221,16 +237,36 @@ public:
 
     bool detectedCycle() const;
 
-    QScript::Type m_type;
+private:
+    // A value is NaN-boxed into 64 bits. Numbers are stored as plain
+    // IEEE 754 doubles, with NaN in its canonical (positive, quiet)
+    // form; that leaves the negative quiet NaN space above TagBase free
+    // for everything else, which is encoded as a tag (the type plus
+    // one) in bits 47..50 and a 47-bit payload: a pointer, an int or a
+    // bool. With Q_SCRIPT_NO_NAN_BOXING the tag is a member of its own
+    // and the payload has 64 bits.
+    enum {
+        PayloadBits = 47,
+        NumberTag = 0x1FFF0
+    };
+
+    inline void setTagged(QScript::Type type, quint64 payload = 0);
+    inline void setNumber(qsreal number);
+    inline quint64 payload() const;
+    inline uint tag() const;
+
+#ifndef Q_SCRIPT_NO_NAN_BOXING
     union {
-        bool m_bool_value;
-        int m_int_value;
-        qsreal m_number_value;
-        void *m_ptr_value;
-        QScriptObject *m_object_value;
-        QScriptNameIdImpl *m_string_value;
-        QString *m_lazy_string_value;
+        quint64 m_bits;
+        qsreal m_number;
     };
+#else
+    uint m_tag;
+    union {
+        quint64 m_payload;
+        qsreal m_number;
+    };
+#endif
 };
 
 QT_END_NAMESPACE
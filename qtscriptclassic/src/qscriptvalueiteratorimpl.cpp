@@ -307,7 +307,7 @@ QScriptValueImpl QScriptValueIteratorImpl::value() const
         QScriptValueImpl getter;
         if (m_member.isObjectProperty() && !m_member.isGetter()) {
             QScript::Member mb;
-            QScriptObject *obj = m_object.m_object_value;
+            QScriptObject *obj = m_object.objectValue();
             mb.object(m_member.nameId(), obj->memberCount(), 0);
             if (!obj->findGetter(&mb))
                 return QScriptValueImpl();
@@ -329,7 +329,7 @@ void QScriptValueIteratorImpl::setValue(const QScriptValueImpl &value)
         QScriptValueImpl setter;
         if (m_member.isObjectProperty() && !m_member.isSetter()) {
             QScript::Member mb;
-            QScriptObject *obj = m_object.m_object_value;
+            QScriptObject *obj = m_object.objectValue();
             mb.object(m_member.nameId(), obj->memberCount(), 0);
             if (!obj->findSetter(&mb))
                 return;
@@ -5,6 +5,7 @@ SOURCES += \
     $$PWD/qscriptasm.cpp \
     $$PWD/qscriptast.cpp \
     $$PWD/qscriptastvisitor.cpp \
+    $$PWD/qscriptbaseline.cpp \
     $$PWD/qscriptcompiler.cpp \
     $$PWD/qscriptecmaarray.cpp \
     $$PWD/qscriptecmaboolean.cpp \
@@ -12,6 +13,7 @@ SOURCES += \
     $$PWD/qscriptecmadate.cpp \
     $$PWD/qscriptecmafunction.cpp \
     $$PWD/qscriptecmaglobal.cpp \
+    $$PWD/qscriptecmajson.cpp \
     $$PWD/qscriptecmamath.cpp \
     $$PWD/qscriptecmanumber.cpp \
     $$PWD/qscriptecmaobject.cpp \
@@ -22,19 +24,31 @@ SOURCES += \
     $$PWD/qscriptengine.cpp \
     $$PWD/qscriptengine_p.cpp \
     $$PWD/qscriptengineagent.cpp \
+    $$PWD/qscriptenginepool.cpp \
+    $$PWD/qscriptenginesnapshot.cpp \
     $$PWD/qscriptextenumeration.cpp \
     $$PWD/qscriptextvariant.cpp \
     $$PWD/qscriptcontext.cpp \
     $$PWD/qscriptcontextinfo.cpp \
     $$PWD/qscriptfunction.cpp \
     $$PWD/qscriptgrammar.cpp \
+    $$PWD/qscriptinlinecache.cpp \
+    $$PWD/qscriptjit.cpp \
     $$PWD/qscriptlexer.cpp \
+    $$PWD/qscriptopcodestatistics.cpp \
+    $$PWD/qscriptoptimizer.cpp \
     $$PWD/qscriptclassdata.cpp \
+    $$PWD/qscriptcodecache.cpp \
     $$PWD/qscriptparser.cpp \
     $$PWD/qscriptprettypretty.cpp \
+    $$PWD/qscriptprofiler.cpp \
+    $$PWD/qscriptprogram.cpp \
+    $$PWD/qscriptregexpcompiler.cpp \
+    $$PWD/qscriptshape.cpp \
     $$PWD/qscriptxmlgenerator.cpp \
     $$PWD/qscriptsyntaxchecker.cpp \
     $$PWD/qscriptstring.cpp \
+    $$PWD/qscriptstringtable.cpp \
     $$PWD/qscriptclass.cpp \
     $$PWD/qscriptclasspropertyiterator.cpp \
     $$PWD/qscriptvalueiteratorimpl.cpp \
@@ -48,6 +62,7 @@ HEADERS += \
     $$PWD/qscriptastfwd_p.h \
     $$PWD/qscriptast_p.h \
     $$PWD/qscriptastvisitor_p.h \
+    $$PWD/qscriptbaseline_p.h \
     $$PWD/qscriptbuffer_p.h \
     $$PWD/qscriptcompiler_p.h \
     $$PWD/qscriptcontext.h \
@@ -61,6 +76,7 @@ HEADERS += \
     $$PWD/qscriptecmadate_p.h \
     $$PWD/qscriptecmafunction_p.h \
     $$PWD/qscriptecmaglobal_p.h \
+    $$PWD/qscriptecmajson_p.h \
     $$PWD/qscriptecmamath_p.h \
     $$PWD/qscriptecmanumber_p.h \
     $$PWD/qscriptecmaobject_p.h \
@@ -72,14 +88,19 @@ HEADERS += \
     $$PWD/qscriptengine_p.h \
     $$PWD/qscriptengineagent.h \
     $$PWD/qscriptengineagent_p.h \
+    $$PWD/qscriptenginepool_p.h \
+    $$PWD/qscriptenginesnapshot_p.h \
     $$PWD/qscriptable.h \
     $$PWD/qscriptable_p.h \
     $$PWD/qscriptextenumeration_p.h \
     $$PWD/qscriptextvariant_p.h \
+    $$PWD/qscriptframestack_p.h \
     $$PWD/qscriptfunction_p.h \
     $$PWD/qscriptgc_p.h \
     $$PWD/qscriptglobals_p.h \
     $$PWD/qscriptgrammar_p.h \
+    $$PWD/qscriptinlinecache_p.h \
+    $$PWD/qscriptjit_p.h \
     $$PWD/qscriptobjectdata_p.h \
     $$PWD/qscriptobjectfwd_p.h \
     $$PWD/qscriptobject_p.h \
@@ -88,15 +109,24 @@ HEADERS += \
     $$PWD/qscriptmember_p.h \
     $$PWD/qscriptmemorypool_p.h \
     $$PWD/qscriptnodepool_p.h \
+    $$PWD/qscriptopcodestatistics_p.h \
+    $$PWD/qscriptoptimizer_p.h \
     $$PWD/qscriptclassinfo_p.h \
+    $$PWD/qscriptcodecache_p.h \
     $$PWD/qscriptparser_p.h \
     $$PWD/qscriptprettypretty_p.h \
+    $$PWD/qscriptprofiler_p.h \
+    $$PWD/qscriptprogram.h \
+    $$PWD/qscriptprogram_p.h \
+    $$PWD/qscriptregexpcompiler_p.h \
     $$PWD/qscriptsyntaxcheckresult_p.h \
     $$PWD/qscriptxmlgenerator_p.h \
     $$PWD/qscriptrepository_p.h \
+    $$PWD/qscriptshape_p.h \
     $$PWD/qscriptsyntaxchecker_p.h \
     $$PWD/qscriptstring.h \
     $$PWD/qscriptstring_p.h \
+    $$PWD/qscriptstringtable_p.h \
     $$PWD/qscriptclass.h \
     $$PWD/qscriptclass_p.h \
     $$PWD/qscriptclasspropertyiterator.h \